@@ -54,6 +54,11 @@ android {
         kotlinCompilerExtensionVersion = "1.5.4"
     }
     
+    // KTX textures are memory mapped straight out of the APK
+    androidResources {
+        noCompress += "ktx"
+    }
+    
     packaging {
         resources {
             excludes += "/META-INF/{AL2.0,LGPL2.1}"
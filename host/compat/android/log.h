@@ -0,0 +1,47 @@
+#pragma once
+
+// Host stand-in for the NDK logging API. Messages go to stderr; info and
+// below are dropped unless TRASH_HOST_LOG is set in the environment.
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT
+} android_LogPriority;
+
+inline bool __trash_host_log_enabled(int priority) {
+    static const bool verbose = std::getenv("TRASH_HOST_LOG") != nullptr;
+    return verbose || priority >= ANDROID_LOG_WARN;
+}
+
+inline int __android_log_vprint(int priority, const char* tag, const char* format, va_list args) {
+    if (!__trash_host_log_enabled(priority)) return 0;
+    static const char LEVELS[] = "??VDIWEFS";
+    char level = priority >= 0 && priority <= ANDROID_LOG_SILENT ? LEVELS[priority] : '?';
+    fprintf(stderr, "%c/%s: ", level, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    return 1;
+}
+
+inline int __android_log_print(int priority, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = __android_log_vprint(priority, tag, format, args);
+    va_end(args);
+    return result;
+}
+
+inline int __android_log_write(int priority, const char* tag, const char* text) {
+    return __android_log_print(priority, tag, "%s", text);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Host builds have no windows; the renderer only runs offscreen there.
+// Declared so the window lifecycle code compiles unchanged.
+
+struct ANativeWindow;
+
+inline void ANativeWindow_acquire(ANativeWindow*) {}
+inline void ANativeWindow_release(ANativeWindow*) {}
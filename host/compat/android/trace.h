@@ -0,0 +1,7 @@
+#pragma once
+
+// Host builds have no system tracer; sections are never enabled.
+
+inline bool ATrace_isEnabled() { return false; }
+inline void ATrace_beginSection(const char*) {}
+inline void ATrace_endSection() {}
@@ -0,0 +1,235 @@
+#include "PngImage.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace trashapp {
+namespace host {
+
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static void putUint32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static uint32_t getUint32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+static void writeChunk(FILE* file, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> header;
+    putUint32(header, static_cast<uint32_t>(data.size()));
+    header.insert(header.end(), type, type + 4);
+
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+    if (!data.empty()) {
+        crc = crc32(crc, data.data(), static_cast<uInt>(data.size()));
+    }
+    std::vector<uint8_t> footer;
+    putUint32(footer, static_cast<uint32_t>(crc));
+
+    fwrite(header.data(), 1, header.size(), file);
+    if (!data.empty()) {
+        fwrite(data.data(), 1, data.size(), file);
+    }
+    fwrite(footer.data(), 1, footer.size(), file);
+}
+
+bool writePng(const std::string& path, const Image& image) {
+    if (image.width <= 0 || image.height <= 0 ||
+        image.pixels.size() != static_cast<size_t>(image.width) * image.height * 4) {
+        return false;
+    }
+
+    // Up filter on every row: cheap and compresses rendered scenes well
+    size_t rowBytes = static_cast<size_t>(image.width) * 4;
+    std::vector<uint8_t> filtered((rowBytes + 1) * image.height);
+    for (int y = 0; y < image.height; y++) {
+        uint8_t* out = filtered.data() + y * (rowBytes + 1);
+        const uint8_t* row = image.pixels.data() + y * rowBytes;
+        out[0] = y == 0 ? 0 : 2;
+        for (size_t x = 0; x < rowBytes; x++) {
+            out[1 + x] = y == 0 ? row[x] : static_cast<uint8_t>(row[x] - row[x - rowBytes]);
+        }
+    }
+
+    uLongf compressedSize = compressBound(static_cast<uLong>(filtered.size()));
+    std::vector<uint8_t> compressed(compressedSize);
+    if (compress2(compressed.data(), &compressedSize, filtered.data(),
+                  static_cast<uLong>(filtered.size()), Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+    compressed.resize(compressedSize);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) return false;
+
+    std::vector<uint8_t> header;
+    putUint32(header, static_cast<uint32_t>(image.width));
+    putUint32(header, static_cast<uint32_t>(image.height));
+    header.push_back(8);   // bit depth
+    header.push_back(6);   // RGBA
+    header.push_back(0);   // deflate
+    header.push_back(0);   // adaptive filtering
+    header.push_back(0);   // no interlace
+
+    fwrite(PNG_SIGNATURE, 1, sizeof(PNG_SIGNATURE), file);
+    writeChunk(file, "IHDR", header);
+    writeChunk(file, "IDAT", compressed);
+    writeChunk(file, "IEND", std::vector<uint8_t>());
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+bool readPng(const std::string& path, Image& image, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    fclose(file);
+
+    if (data.size() < sizeof(PNG_SIGNATURE) || memcmp(data.data(), PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0) {
+        error = path + " is not a PNG";
+        return false;
+    }
+
+    uint32_t width = 0, height = 0;
+    int channels = 0;
+    std::vector<uint8_t> compressed;
+    size_t offset = sizeof(PNG_SIGNATURE);
+    while (offset + 12 <= data.size()) {
+        uint32_t length = getUint32(&data[offset]);
+        const char* type = reinterpret_cast<const char*>(&data[offset + 4]);
+        const uint8_t* payload = &data[offset + 8];
+        if (offset + 12 + static_cast<size_t>(length) > data.size()) break;
+
+        if (memcmp(type, "IHDR", 4) == 0 && length >= 13) {
+            width = getUint32(payload);
+            height = getUint32(payload + 4);
+            uint8_t depth = payload[8];
+            uint8_t colorType = payload[9];
+            uint8_t interlace = payload[12];
+            if (depth != 8 || (colorType != 2 && colorType != 6) || interlace != 0) {
+                error = path + ": only 8-bit non-interlaced RGB/RGBA is supported";
+                return false;
+            }
+            channels = colorType == 6 ? 4 : 3;
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            compressed.insert(compressed.end(), payload, payload + length);
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        offset += 12 + length;
+    }
+    if (width == 0 || height == 0 || channels == 0) {
+        error = path + ": missing header";
+        return false;
+    }
+
+    size_t stride = static_cast<size_t>(width) * channels;
+    std::vector<uint8_t> raw((stride + 1) * height);
+    uLongf rawSize = static_cast<uLongf>(raw.size());
+    if (uncompress(raw.data(), &rawSize, compressed.data(), static_cast<uLong>(compressed.size())) != Z_OK ||
+        rawSize != raw.size()) {
+        error = path + ": corrupt image data";
+        return false;
+    }
+
+    std::vector<uint8_t> rows(stride * height);
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t filter = raw[y * (stride + 1)];
+        const uint8_t* in = &raw[y * (stride + 1) + 1];
+        uint8_t* out = &rows[y * stride];
+        const uint8_t* up = y > 0 ? out - stride : nullptr;
+        for (size_t x = 0; x < stride; x++) {
+            int left = x >= static_cast<size_t>(channels) ? out[x - channels] : 0;
+            int above = up != nullptr ? up[x] : 0;
+            int corner = up != nullptr && x >= static_cast<size_t>(channels) ? up[x - channels] : 0;
+            int value = in[x];
+            switch (filter) {
+                case 0: break;
+                case 1: value += left; break;
+                case 2: value += above; break;
+                case 3: value += (left + above) / 2; break;
+                case 4: value += paeth(left, above, corner); break;
+                default:
+                    error = path + ": bad row filter";
+                    return false;
+            }
+            out[x] = static_cast<uint8_t>(value);
+        }
+    }
+
+    image.width = static_cast<int>(width);
+    image.height = static_cast<int>(height);
+    image.pixels.resize(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+        image.pixels[i * 4 + 0] = rows[i * channels + 0];
+        image.pixels[i * 4 + 1] = rows[i * channels + 1];
+        image.pixels[i * 4 + 2] = rows[i * channels + 2];
+        image.pixels[i * 4 + 3] = channels == 4 ? rows[i * channels + 3] : 255;
+    }
+    return true;
+}
+
+ImageDiff compareImages(const Image& expected, const Image& actual, int tolerance, Image* diffImage) {
+    ImageDiff diff = {};
+    size_t pixelCount = static_cast<size_t>(expected.width) * expected.height;
+    if (diffImage != nullptr) {
+        diffImage->width = expected.width;
+        diffImage->height = expected.height;
+        diffImage->pixels.assign(pixelCount * 4, 255);
+    }
+
+    for (size_t i = 0; i < pixelCount; i++) {
+        const uint8_t* a = &expected.pixels[i * 4];
+        const uint8_t* b = &actual.pixels[i * 4];
+        int delta = 0;
+        for (int c = 0; c < 4; c++) {
+            delta = std::max(delta, std::abs(static_cast<int>(a[c]) - static_cast<int>(b[c])));
+        }
+        diff.maxChannelDelta = std::max(diff.maxChannelDelta, delta);
+        bool different = delta > tolerance;
+        if (different) diff.differentPixels++;
+
+        if (diffImage != nullptr) {
+            uint8_t* out = &diffImage->pixels[i * 4];
+            if (different) {
+                out[0] = 255;
+                out[1] = 0;
+                out[2] = 0;
+            } else {
+                uint8_t grey = static_cast<uint8_t>((a[0] + a[1] + a[2]) / 6 + 64);
+                out[0] = out[1] = out[2] = grey;
+            }
+        }
+    }
+    diff.differentFraction = pixelCount > 0 ? static_cast<double>(diff.differentPixels) / pixelCount : 0.0;
+    return diff;
+}
+
+} // namespace host
+} // namespace trashapp
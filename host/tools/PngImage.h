@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trashapp {
+namespace host {
+
+// 8-bit RGBA image, top row first
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct ImageDiff {
+    uint64_t differentPixels;  // pixels with any channel beyond the tolerance
+    int maxChannelDelta;
+    double differentFraction;
+};
+
+// Writes RGBA. Reads 8-bit, non-interlaced RGB or RGBA; RGB is expanded to
+// opaque RGBA.
+bool writePng(const std::string& path, const Image& image);
+bool readPng(const std::string& path, Image& image, std::string& error);
+
+// Images must have the same size. When diffImage is given it is filled with
+// a grey copy of expected with differing pixels in red.
+ImageDiff compareImages(const Image& expected, const Image& actual, int tolerance, Image* diffImage);
+
+} // namespace host
+} // namespace trashapp
@@ -0,0 +1,423 @@
+// Checks of the audio mixers that need no output device.
+//
+//   audio_harness --validate-rates
+//   audio_harness --validate-events
+//   audio_harness --validate-layouts
+//
+// --validate-rates starts voices at out-of-range playback rates and checks
+// that zero and negative rates are clamped, so the voice still plays
+// through and frees its slot, and that NaN and infinite rates start
+// nothing.
+//
+// --validate-events sends bursts of triggers through the event dispatcher
+// and checks the voices they start, how loud those play, and which
+// triggers are merged or dropped by the start rate.
+//
+// --validate-layouts mixes known mono and stereo buffers into 1-, 2- and
+// 6-channel buses and checks every sample, and that the mono effects play
+// for as many frames as they hold. The mixer must refuse sounds of other
+// than one or two channels.
+//
+// Exits non-zero when any check fails.
+
+#include "AudioEvents.h"
+#include "AudioMemory.h"
+#include "AudioMixer.h"
+#include "SoundManager.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+using trashapp::audio::AudioEventConfig;
+using trashapp::audio::AudioEventDispatcher;
+using trashapp::audio::AudioEventStats;
+using trashapp::audio::AudioMixer;
+using trashapp::audio::Interpolation;
+using trashapp::audio::MAX_PLAYBACK_RATE;
+using trashapp::audio::MIN_PLAYBACK_RATE;
+using trashapp::audio::RealtimeScope;
+using trashapp::audio::SoundManager;
+using trashapp::audio::mixToBus;
+
+namespace {
+
+const int EXIT_FAILED = 1;
+const int EXIT_USAGE = 2;
+const int BLOCK_FRAMES = 256;
+// SoundManager's click
+const int CLICK_ID = 4;
+const int CLICK_FRAMES = 48000 * 50 / 1000;
+
+const int64_t NANOS_PER_MILLISECOND = 1000000LL;
+
+const float NAN_RATE = std::numeric_limits<float>::quiet_NaN();
+const float INFINITE_RATE = std::numeric_limits<float>::infinity();
+
+struct Options {
+    bool validateRates = false;
+    bool validateEvents = false;
+    bool validateLayouts = false;
+};
+
+void usage() {
+    fprintf(stderr, "usage: audio_harness [--validate-rates] [--validate-events] [--validate-layouts]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--validate-rates") {
+            options.validateRates = true;
+        } else if (arg == "--validate-events") {
+            options.validateEvents = true;
+        } else if (arg == "--validate-layouts") {
+            options.validateLayouts = true;
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return options.validateRates || options.validateEvents || options.validateLayouts;
+}
+
+bool check(bool condition, const char* what) {
+    printf("%s: %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// Blocks until the sound manager has no voices, up to maxBlocks; -1 if it
+// still has some then
+int blocksUntilIdle(SoundManager& sounds, int maxBlocks) {
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    for (int block = 0; block < maxBlocks; block++) {
+        if (sounds.getActiveSoundCount() == 0) return block;
+        RealtimeScope realtime;
+        sounds.mixAudio(output.data(), BLOCK_FRAMES);
+    }
+    return sounds.getActiveSoundCount() == 0 ? maxBlocks : -1;
+}
+
+// A voice at a clamped rate plays for the click's length at the slowest
+// rate, then frees its slot
+bool checkSoundManagerClamped(float rate, bool scheduled, const char* what) {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    if (scheduled) {
+        sounds.playSoundAt(CLICK_ID, 1.0f, 0.0f, sounds.getFramePosition(), rate);
+    } else {
+        sounds.playSound(CLICK_ID, 1.0f, 0.0f, rate);
+    }
+    const int slowestBlocks = static_cast<int>(CLICK_FRAMES / MIN_PLAYBACK_RATE) / BLOCK_FRAMES + 1;
+    bool started = sounds.isPlaying(CLICK_ID);
+    int blocks = blocksUntilIdle(sounds, slowestBlocks + 2);
+    return check(started && blocks >= slowestBlocks - 1 && blocks <= slowestBlocks + 1, what);
+}
+
+bool checkSoundManagerRejected(float rate, bool scheduled, const char* what) {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    if (scheduled) {
+        sounds.playSoundAt(CLICK_ID, 1.0f, 0.0f, sounds.getFramePosition(), rate);
+    } else {
+        sounds.playSound(CLICK_ID, 1.0f, 0.0f, rate);
+    }
+    return check(!sounds.isPlaying(CLICK_ID) && sounds.getActiveSoundCount() == 0, what);
+}
+
+// Frames the mixer produces sound for, from a constant mono source
+int mixerAudibleFrames(float rate) {
+    const int frames = 1000;
+    std::vector<float> samples(frames, 0.5f);
+    AudioMixer mixer;
+    mixer.loadSound(1, samples.data(), samples.size(), 1);
+    mixer.playSound(1, 1.0f, 0.0f, rate);
+
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    int audible = 0;
+    // Long enough for the slowest rate
+    const int maxBlocks = static_cast<int>(frames / MIN_PLAYBACK_RATE) / BLOCK_FRAMES + 2;
+    for (int block = 0; block < maxBlocks; block++) {
+        {
+            RealtimeScope realtime;
+            mixer.mix(output.data(), BLOCK_FRAMES);
+        }
+        for (int i = 0; i < BLOCK_FRAMES; i++) {
+            if (!std::isfinite(output[i * 2])) return -1;
+            if (output[i * 2] != 0.0f) audible++;
+        }
+    }
+    return audible;
+}
+
+int runRateValidation() {
+    bool passed = true;
+    passed &= checkSoundManagerClamped(0.0f, false, "SoundManager rate 0 clamped");
+    passed &= checkSoundManagerClamped(-1.0f, false, "SoundManager rate -1 clamped");
+    passed &= checkSoundManagerClamped(-1.0f, true, "SoundManager scheduled rate -1 clamped");
+    passed &= checkSoundManagerRejected(NAN_RATE, false, "SoundManager rate NaN rejected");
+    passed &= checkSoundManagerRejected(INFINITE_RATE, false, "SoundManager rate inf rejected");
+    passed &= checkSoundManagerRejected(NAN_RATE, true, "SoundManager scheduled rate NaN rejected");
+
+    // 1000 frames at the slowest rate: 16000, give or take the last frame
+    int slowest = mixerAudibleFrames(-2.0f);
+    passed &= check(std::abs(slowest - 16000) <= 16, "AudioMixer rate -2 clamped");
+    passed &= check(mixerAudibleFrames(0.0f) == slowest, "AudioMixer rate 0 clamped");
+    passed &= check(mixerAudibleFrames(NAN_RATE) == 0, "AudioMixer rate NaN rejected");
+    passed &= check(mixerAudibleFrames(1000.0f) == mixerAudibleFrames(MAX_PLAYBACK_RATE),
+                    "AudioMixer rate 1000 clamped");
+    return passed ? 0 : EXIT_FAILED;
+}
+
+// Frame of SoundManager's click at full volume
+float clickSample(int frame) {
+    return std::exp(-static_cast<float>(frame) / 48000.0f * 50.0f) * 0.7f;
+}
+
+bool nearly(float a, float b) {
+    return std::fabs(a - b) <= 1e-5f;
+}
+
+// The click as an event: merged within 35 ms, gain up to 2
+AudioEventConfig clickEvent(float maxPerSecond) {
+    AudioEventConfig config = AudioEventDispatcher::defaultConfig(CLICK_ID);
+    config.maxPerSecond = maxPerSecond;
+    return config;
+}
+
+// First frame mixed, left channel
+float mixFirstSample(SoundManager& sounds) {
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    RealtimeScope realtime;
+    sounds.mixAudio(output.data(), BLOCK_FRAMES);
+    return output[0];
+}
+
+void mixMilliseconds(SoundManager& sounds, int milliseconds) {
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    int blocks = 48000 * milliseconds / 1000 / BLOCK_FRAMES;
+    for (int block = 0; block < blocks; block++) {
+        RealtimeScope realtime;
+        sounds.mixAudio(output.data(), BLOCK_FRAMES);
+    }
+}
+
+// `count` triggers 3 ms apart, inside one window, play as one voice
+// sqrt(count) louder, up to the maximum gain
+bool checkWindowMerge(int count, float expectedGain, const char* what) {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    AudioEventDispatcher events(sounds);
+    events.registerEvent(1, clickEvent(0.0f));
+
+    bool firstStarted = events.trigger(1, 1.0f, 0.0f, 0) >= 0;
+    bool restMerged = true;
+    for (int i = 1; i < count; i++) {
+        restMerged &= events.trigger(1, 1.0f, 0.0f, i * 3 * NANOS_PER_MILLISECOND) < 0;
+    }
+    AudioEventStats stats = events.getStats();
+    float first = mixFirstSample(sounds);
+    return check(firstStarted && restMerged && stats.voicesStarted == 1 &&
+                 stats.coalesced == static_cast<uint64_t>(count - 1) &&
+                 sounds.getActiveSoundCount() == 1 && nearly(first, clickSample(0) * expectedGain),
+                 what);
+}
+
+// Past the window but inside the start interval, a trigger makes the voice
+// still playing louder rather than starting another
+bool checkRateMergeWhilePlaying() {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    AudioEventDispatcher events(sounds);
+    events.registerEvent(1, clickEvent(5.0f));
+
+    events.trigger(1, 1.0f, 0.0f, 0);
+    mixFirstSample(sounds);
+    bool merged = events.trigger(1, 1.0f, 0.0f, 50 * NANOS_PER_MILLISECOND) < 0;
+    AudioEventStats stats = events.getStats();
+    float next = mixFirstSample(sounds);
+    return check(merged && stats.voicesStarted == 1 && stats.rateLimited == 1 && stats.coalesced == 0 &&
+                 nearly(next, clickSample(BLOCK_FRAMES) * std::sqrt(2.0f)),
+                 "Event over the start rate merges while playing");
+}
+
+// A click lasts 50 ms, so at 5 starts a second clicks 100 ms apart find
+// the voice ended every other time; those are dropped, not started
+bool checkRateDropAfterEnd() {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    AudioEventDispatcher events(sounds);
+    events.registerEvent(1, clickEvent(5.0f));
+
+    for (int i = 0; i < 10; i++) {
+        events.trigger(1, 1.0f, 0.0f, i * 100 * NANOS_PER_MILLISECOND);
+        mixMilliseconds(sounds, 100);
+    }
+    AudioEventStats stats = events.getStats();
+    return check(stats.triggers == 10 && stats.voicesStarted == 5 && stats.rateLimited == 5 &&
+                 stats.coalesced == 0,
+                 "Events over the start rate dropped once the voice ended");
+}
+
+// Past both the window and the start interval a trigger starts a new
+// voice, even with the last one still playing: the sound restarts from its
+// first frame at a single trigger's gain
+bool checkNewVoiceAfterInterval() {
+    SoundManager sounds;
+    sounds.loadSound("click", CLICK_ID);
+    AudioEventDispatcher events(sounds);
+    events.registerEvent(1, clickEvent(5.0f));
+
+    events.trigger(1, 1.0f, 0.0f, 0);
+    events.trigger(1, 1.0f, 0.0f, 10 * NANOS_PER_MILLISECOND);
+    mixFirstSample(sounds);
+    bool started = events.trigger(1, 1.0f, 0.0f, 250 * NANOS_PER_MILLISECOND) >= 0;
+    AudioEventStats stats = events.getStats();
+    float next = mixFirstSample(sounds);
+    return check(started && stats.voicesStarted == 2 && stats.coalesced == 1 && stats.rateLimited == 0 &&
+                 sounds.getActiveSoundCount() == 1 && nearly(next, clickSample(0)),
+                 "Event past the window and interval starts a new voice");
+}
+
+int runEventValidation() {
+    bool passed = true;
+    passed &= checkWindowMerge(3, std::sqrt(3.0f), "Events in one window merge into one voice");
+    passed &= checkWindowMerge(9, 2.0f, "Merged gain capped at the maximum");
+    passed &= checkRateMergeWhilePlaying();
+    passed &= checkRateDropAfterEnd();
+    passed &= checkNewVoiceAfterInterval();
+    return passed ? 0 : EXIT_FAILED;
+}
+
+const int LAYOUT_FRAMES = 4;
+const float MONO_SOURCE[LAYOUT_FRAMES] = { 0.5f, -0.25f, 1.0f, 0.125f };
+const float STEREO_SOURCE[LAYOUT_FRAMES * 2] = { 0.2f, 0.4f, -0.6f, 0.8f, 1.0f, -1.0f, 0.0f, 0.5f };
+
+// Mixes a source at rate 1 into a silent bus and compares every sample
+// with expected(frame, channel)
+template <typename Expected>
+bool checkBus(const float* source, int channels, int busChannels, float leftGain, float rightGain,
+              Expected expected, const char* what) {
+    std::vector<float> bus(LAYOUT_FRAMES * busChannels, 0.0f);
+    double cursor = 0.0;
+    int mixed = mixToBus(Interpolation::Linear, source, LAYOUT_FRAMES, channels, cursor, 1.0f,
+                         bus.data(), busChannels, LAYOUT_FRAMES, leftGain, rightGain);
+    bool matches = mixed == LAYOUT_FRAMES && cursor == LAYOUT_FRAMES;
+    for (int frame = 0; frame < LAYOUT_FRAMES; frame++) {
+        for (int channel = 0; channel < busChannels; channel++) {
+            float got = bus[frame * busChannels + channel];
+            float want = expected(frame, channel);
+            if (!nearly(got, want)) {
+                printf("  frame %d channel %d: %f, expected %f\n", frame, channel, got, want);
+                matches = false;
+            }
+        }
+    }
+    return check(matches, what);
+}
+
+// A sound of an unsupported channel count loads nothing, so plays silence
+bool checkMixerRefusesChannels(int channels) {
+    std::vector<float> samples(LAYOUT_FRAMES * std::max(channels, 1), 0.5f);
+    AudioMixer mixer;
+    mixer.loadSound(1, samples.data(), samples.size(), channels);
+    mixer.playSound(1);
+
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    {
+        RealtimeScope realtime;
+        mixer.mix(output.data(), BLOCK_FRAMES);
+    }
+    bool silent = std::all_of(output.begin(), output.end(), [](float sample) { return sample == 0.0f; });
+    std::string what = "AudioMixer refuses a " + std::to_string(channels) + "-channel sound";
+    return check(silent, what.c_str());
+}
+
+// Frames of a SoundManager sound heard on a bus of `busChannels`
+int soundManagerAudibleFrames(const char* name, int soundId, int busChannels) {
+    SoundManager sounds;
+    sounds.setOutputChannels(busChannels);
+    sounds.loadSound(name, soundId);
+    sounds.playSound(soundId);
+
+    std::vector<float> output(BLOCK_FRAMES * busChannels);
+    int audible = 0;
+    for (int block = 0; block < 64 && sounds.getActiveSoundCount() > 0; block++) {
+        {
+            RealtimeScope realtime;
+            sounds.mixAudio(output.data(), BLOCK_FRAMES);
+        }
+        for (int i = 0; i < BLOCK_FRAMES; i++) {
+            if (output[i * busChannels] != 0.0f) audible++;
+        }
+    }
+    return audible;
+}
+
+int runLayoutValidation() {
+    const float* mono = MONO_SOURCE;
+    const float* stereo = STEREO_SOURCE;
+    bool passed = true;
+
+    // Mono is one channel panned to both sides
+    passed &= checkBus(mono, 1, 2, 0.25f, 0.75f, [=](int frame, int channel) {
+        return mono[frame] * (channel == 0 ? 0.25f : 0.75f);
+    }, "Mono to stereo, panned");
+    passed &= checkBus(mono, 1, 1, 0.25f, 0.75f, [=](int frame, int) {
+        return mono[frame] * 0.5f * (0.25f + 0.75f);
+    }, "Mono to mono");
+    passed &= checkBus(mono, 1, 6, 0.25f, 0.75f, [=](int frame, int channel) {
+        return channel > 1 ? 0.0f : mono[frame] * (channel == 0 ? 0.25f : 0.75f);
+    }, "Mono to 6 channels, front pair only");
+
+    passed &= checkBus(stereo, 2, 2, 0.5f, 1.0f, [=](int frame, int channel) {
+        return stereo[frame * 2 + channel] * (channel == 0 ? 0.5f : 1.0f);
+    }, "Stereo to stereo");
+    // A mono bus hears the average of the pair
+    passed &= checkBus(stereo, 2, 1, 1.0f, 1.0f, [=](int frame, int) {
+        return (stereo[frame * 2] + stereo[frame * 2 + 1]) * 0.5f;
+    }, "Stereo to mono, averaged");
+    passed &= checkBus(stereo, 2, 1, 0.5f, 1.0f, [=](int frame, int) {
+        return stereo[frame * 2] * 0.25f + stereo[frame * 2 + 1] * 0.5f;
+    }, "Stereo to mono, panned");
+    passed &= checkBus(stereo, 2, 6, 0.5f, 1.0f, [=](int frame, int channel) {
+        return channel > 1 ? 0.0f : stereo[frame * 2 + channel] * (channel == 0 ? 0.5f : 1.0f);
+    }, "Stereo to 6 channels, front pair only");
+
+    // The effects are generated as mono: a 50 ms click is 2400 frames on
+    // any bus, where a stereo buffer of the same samples played 1200
+    for (int busChannels : { 1, 2, 6 }) {
+        std::string what = "Mono click frames on a " + std::to_string(busChannels) + "-channel bus";
+        passed &= check(soundManagerAudibleFrames("click", CLICK_ID, busChannels) == CLICK_FRAMES,
+                        what.c_str());
+    }
+
+    for (int channels : { 0, 4, 6 }) {
+        passed &= checkMixerRefusesChannels(channels);
+    }
+    return passed ? 0 : EXIT_FAILED;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return EXIT_USAGE;
+    }
+
+    int status = 0;
+    if (options.validateRates) {
+        status = runRateValidation();
+    }
+    if (options.validateEvents && runEventValidation() != 0) {
+        status = EXIT_FAILED;
+    }
+    if (options.validateLayouts && runLayoutValidation() != 0) {
+        status = EXIT_FAILED;
+    }
+    return status;
+}
@@ -0,0 +1,676 @@
+// Microbenchmarks of the native audio and graphics hot paths, on Google
+// Benchmark. Audio mixes in 256-frame blocks, a typical Oboe burst.
+//
+//   native_bench [--benchmark_filter=Mix] --benchmark_out=bench.json --benchmark_out_format=json
+//   native_bench --baseline=previous.json [--max-regression=0.15]
+//   native_bench --cache=DIR
+//
+// Every Google Benchmark flag works; --benchmark_out writes the JSON results
+// to keep per commit. --baseline compares this run's real time per benchmark
+// against such a file and exits non-zero when any got slower by more than
+// --max-regression (a fraction). With --benchmark_repetitions the fastest
+// repetition counts on both sides. --cache names the shader binary cache
+// directory for the cache benchmark; it defaults to one under the system
+// temporary directory.
+//
+// Shader and batch benchmarks need an offscreen GL context (EGL_PLATFORM=
+// surfaceless on Mesa) and report an error instead of a time without one.
+//
+// Audio calls run inside a RealtimeScope, as on the audio thread; built with
+// TRASH_AUDIO_REALTIME_CHECKS, a heap call while mixing aborts the run.
+
+#include "AudioEvents.h"
+#include "AudioMemory.h"
+#include "AudioMixer.h"
+#include "JsonReader.h"
+#include "ParticleEffect.h"
+#include "RealtimeLog.h"
+#include "Renderer.h"
+#include "ShaderCache.h"
+#include "ShaderManager.h"
+#include "SoundManager.h"
+#include "SpatialAudio.h"
+#include "SpriteBatcher.h"
+#include <GLES3/gl3.h>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using trashapp::audio::AudioEventDispatcher;
+using trashapp::audio::AudioMixer;
+using trashapp::audio::Interpolation;
+using trashapp::audio::RealtimeLog;
+using trashapp::audio::RealtimeScope;
+using trashapp::audio::SoundManager;
+using trashapp::audio::SpatialAudio;
+using trashapp::graphics::BlendMode;
+using trashapp::graphics::EmitterHandle;
+using trashapp::graphics::JsonReader;
+using trashapp::graphics::JsonValue;
+using trashapp::graphics::ParticleEffect;
+using trashapp::graphics::Renderer;
+using trashapp::graphics::ShaderCache;
+using trashapp::graphics::ShaderManager;
+using trashapp::graphics::Sprite;
+using trashapp::graphics::SpriteBatcher;
+
+namespace {
+
+const int EXIT_FAILED = 1;
+const int EXIT_USAGE = 2;
+
+const int SAMPLE_RATE = 48000;
+const int BLOCK_FRAMES = 256;
+const float FRAME_DELTA = 1.0f / 60.0f;
+
+std::string gCacheDirectory;
+
+// --- Audio -----------------------------------------------------------------
+
+// Voices restart before their sounds run out so every block mixes all of
+// them. SoundManager's shortest sound, the 50 ms click, lasts 9 blocks.
+const int SOUND_MANAGER_RESTART_BLOCKS = 8;
+
+void startSoundManagerVoices(SoundManager& sounds, int voices) {
+    for (int id = 1; id <= voices; id++) {
+        float pan = voices > 1 ? -1.0f + 2.0f * (id - 1) / (voices - 1) : 0.0f;
+        sounds.playSound(id, 0.8f, pan);
+    }
+}
+
+void BM_SoundManagerMix(benchmark::State& state) {
+    const int voices = static_cast<int>(state.range(0));
+    SoundManager sounds;
+    // Ids past the built-in sounds get the click
+    for (int id = 1; id <= voices; id++) {
+        sounds.loadSound("bench", id);
+    }
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    startSoundManagerVoices(sounds, voices);
+
+    int blocks = 0;
+    for (auto _ : state) {
+        {
+            RealtimeScope realtime;
+            sounds.mixAudio(output.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(output.data());
+        if (++blocks == SOUND_MANAGER_RESTART_BLOCKS) {
+            state.PauseTiming();
+            startSoundManagerVoices(sounds, voices);
+            blocks = 0;
+            state.ResumeTiming();
+        }
+    }
+    // Items are voice frames
+    state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES * voices);
+}
+BENCHMARK(BM_SoundManagerMix)->RangeMultiplier(4)->Range(1, 64);
+
+// A burst of identical triggers each frame, as when coins land together,
+// then the block they play in. The dispatcher merges each burst into one
+// voice, so the cost should stay near one trigger and one voice's mix.
+void BM_AudioEventBurst(benchmark::State& state) {
+    const int burst = static_cast<int>(state.range(0));
+    SoundManager sounds;
+    sounds.loadSound("coin", 1);
+    AudioEventDispatcher events(sounds);
+    auto config = AudioEventDispatcher::defaultConfig(1);
+    config.timeJitterMilliseconds = 5.0f;
+    events.registerEvent(1, config);
+    std::vector<float> output(BLOCK_FRAMES * 2);
+
+    const int64_t frameNanos = static_cast<int64_t>(FRAME_DELTA * 1.0e9f);
+    int64_t now = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < burst; i++) {
+            events.trigger(1, 0.8f, 0.0f, now);
+        }
+        {
+            RealtimeScope realtime;
+            sounds.mixAudio(output.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(output.data());
+        now += frameNanos;
+    }
+    auto stats = events.getStats();
+    state.counters["voices_per_burst"] = static_cast<double>(stats.voicesStarted) / state.iterations();
+    state.SetItemsProcessed(state.iterations() * burst);
+}
+BENCHMARK(BM_AudioEventBurst)->Arg(1)->Arg(20);
+
+// One ten second stereo sound shared by every voice
+std::vector<float> mixerSound() {
+    const int frames = SAMPLE_RATE * 10;
+    std::vector<float> samples(frames * 2);
+    for (int i = 0; i < frames; i++) {
+        float t = static_cast<float>(i) / SAMPLE_RATE;
+        samples[i * 2] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 440.0f * t);
+        samples[i * 2 + 1] = 0.5f * std::sin(2.0f * static_cast<float>(M_PI) * 660.0f * t);
+    }
+    return samples;
+}
+
+const int MIXER_RESTART_BLOCKS = SAMPLE_RATE * 10 / BLOCK_FRAMES - 1;
+
+void startMixerVoices(AudioMixer& mixer, int voices) {
+    mixer.stopAll();
+    for (int v = 0; v < voices; v++) {
+        float pan = voices > 1 ? -1.0f + 2.0f * v / (voices - 1) : 0.0f;
+        mixer.playSound(1, 1.0f / voices, pan);
+    }
+}
+
+void BM_AudioMixerMix(benchmark::State& state) {
+    const int voices = static_cast<int>(state.range(0));
+    AudioMixer mixer;
+    std::vector<float> samples = mixerSound();
+    mixer.loadSound(1, samples.data(), samples.size());
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    startMixerVoices(mixer, voices);
+
+    int blocks = 0;
+    for (auto _ : state) {
+        {
+            RealtimeScope realtime;
+            mixer.mix(output.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(output.data());
+        if (++blocks == MIXER_RESTART_BLOCKS) {
+            state.PauseTiming();
+            startMixerVoices(mixer, voices);
+            blocks = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES * voices);
+}
+BENCHMARK(BM_AudioMixerMix)->RangeMultiplier(4)->Range(1, 64);
+
+// 16 voices read in place at rate 1 (0), or slightly off it so every frame
+// is interpolated: linear (1) or cubic (2). Below 1 so the restart interval
+// above still ends before the sound does.
+void BM_AudioMixerInterpolation(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    const int voices = 16;
+    const float rate = mode == 0 ? 1.0f : 0.97f;
+    AudioMixer mixer;
+    mixer.setInterpolation(mode == 2 ? Interpolation::Cubic : Interpolation::Linear);
+    std::vector<float> samples = mixerSound();
+    mixer.loadSound(1, samples.data(), samples.size());
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    auto start = [&] {
+        mixer.stopAll();
+        for (int v = 0; v < voices; v++) {
+            mixer.playSound(1, 1.0f / voices, 0.0f, rate);
+        }
+    };
+    start();
+
+    int blocks = 0;
+    for (auto _ : state) {
+        {
+            RealtimeScope realtime;
+            mixer.mix(output.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(output.data());
+        if (++blocks == MIXER_RESTART_BLOCKS) {
+            state.PauseTiming();
+            start();
+            blocks = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES * voices);
+}
+BENCHMARK(BM_AudioMixerInterpolation)->ArgName("interpolation")->DenseRange(0, 2);
+
+// 16 voices of a mono or stereo source panned onto a stereo bus; mono
+// reads half the samples per frame
+void BM_AudioMixerSourceChannels(benchmark::State& state) {
+    const int channels = static_cast<int>(state.range(0));
+    const int voices = 16;
+    AudioMixer mixer;
+    std::vector<float> stereo = mixerSound();
+    std::vector<float> samples(stereo.size() / 2 * channels);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = stereo[channels == 1 ? i * 2 : i];
+    }
+    mixer.loadSound(1, samples.data(), samples.size(), channels);
+    std::vector<float> output(BLOCK_FRAMES * 2);
+    startMixerVoices(mixer, voices);
+
+    int blocks = 0;
+    for (auto _ : state) {
+        {
+            RealtimeScope realtime;
+            mixer.mix(output.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(output.data());
+        if (++blocks == MIXER_RESTART_BLOCKS) {
+            state.PauseTiming();
+            startMixerVoices(mixer, voices);
+            blocks = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES * voices);
+    state.SetBytesProcessed(state.iterations() * BLOCK_FRAMES * voices * channels * sizeof(float));
+}
+BENCHMARK(BM_AudioMixerSourceChannels)->ArgName("channels")->Arg(1)->Arg(2);
+
+void BM_SpatialAudioProcess(benchmark::State& state) {
+    const int sources = static_cast<int>(state.range(0));
+    SpatialAudio spatial;
+    spatial.setListenerPosition(0.0f, 0.0f, 0.0f);
+    // Around the listener, near enough that none drops out as inaudible
+    for (int i = 0; i < sources; i++) {
+        float angle = 2.0f * static_cast<float>(M_PI) * i / sources;
+        float distance = 1.0f + static_cast<float>(i % 3);
+        spatial.playSound3D(i + 1, distance * std::sin(angle), 0.0f, distance * std::cos(angle), 1.0f);
+    }
+
+    // process() scales the block in place, so each iteration starts from
+    // fresh samples; the copy is a small part of the time
+    std::vector<float> input = mixerSound();
+    input.resize(BLOCK_FRAMES * 2);
+    std::vector<float> block(input.size());
+    for (auto _ : state) {
+        std::copy(input.begin(), input.end(), block.begin());
+        {
+            RealtimeScope realtime;
+            spatial.process(block.data(), BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(block.data());
+    }
+    state.SetItemsProcessed(state.iterations() * BLOCK_FRAMES * sources);
+}
+BENCHMARK(BM_SpatialAudioProcess)->RangeMultiplier(4)->Range(1, 64);
+
+// What a hot path pays per record; formatting happens in the untimed drain.
+// Info records are compiled in at every build type.
+void BM_RealtimeLogWrite(benchmark::State& state) {
+    RealtimeLog::flush();
+    int written = 0;
+    for (auto _ : state) {
+        {
+            RealtimeScope realtime;
+            TRASH_RT_LOG(ANDROID_LOG_INFO, "NativeBench", "Playing sound ID: %d, volume: %f, pan: %f",
+                         written, 0.8f, -0.25f);
+        }
+        if (++written == static_cast<int>(RealtimeLog::CAPACITY / 2)) {
+            state.PauseTiming();
+            RealtimeLog::flush();
+            written = 0;
+            state.ResumeTiming();
+        }
+    }
+    RealtimeLog::flush();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RealtimeLogWrite);
+
+// --- Particles -------------------------------------------------------------
+
+// Long enough that a whole second of updates keeps every particle alive
+const char* const BENCH_EMITTERS = R"({
+    "emitters": [
+        {
+            "name": "bench_burst",
+            "burst": 256,
+            "offsetX": [-400, 400],
+            "offsetY": [-200, 200],
+            "velocityX": [-100, 100],
+            "velocityY": [-50, 300],
+            "life": [1.5, 2.5],
+            "size": [6, 20],
+            "color": [1.0, [0.5, 1.0], 0.2, 1.0]
+        }
+    ]
+})";
+
+const int PARTICLE_RESTART_UPDATES = 60;
+
+std::unique_ptr<ParticleEffect> burstParticles(int count) {
+    auto particles = std::make_unique<ParticleEffect>();
+    particles->loadEmitters(BENCH_EMITTERS, strlen(BENCH_EMITTERS));
+    EmitterHandle handle = particles->findEmitter("bench_burst");
+    for (int spawned = 0; spawned < count; spawned += 256) {
+        particles->spawn(handle, 960.0f, 540.0f);
+    }
+    return particles;
+}
+
+void BM_ParticleUpdate(benchmark::State& state) {
+    const int count = static_cast<int>(state.range(0));
+    // CPU simulation needs no GL; the effect is never initialized
+    std::unique_ptr<ParticleEffect> particles = burstParticles(count);
+
+    int updates = 0;
+    for (auto _ : state) {
+        particles->update(FRAME_DELTA);
+        if (++updates == PARTICLE_RESTART_UPDATES) {
+            state.PauseTiming();
+            particles = burstParticles(count);
+            updates = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ParticleUpdate)->RangeMultiplier(4)->Range(256, 16384);
+
+// --- GL --------------------------------------------------------------------
+
+const char* const BENCH_FRAGMENT_SHADER = R"(#version 300 es
+precision mediump float;
+in vec2 vTexCoord;
+in vec4 vColor;
+uniform sampler2D uTexture;
+out vec4 fragColor;
+void main() {
+    fragColor = texture(uTexture, vTexCoord) * vColor;
+}
+)";
+
+// One small offscreen context shared by the GL benchmarks, made on first use
+struct GlContext {
+    Renderer renderer;
+    ShaderManager shaders;
+    SpriteBatcher sprites;
+    std::vector<GLuint> textures;
+    bool ready = false;
+
+    ~GlContext() {
+        if (!ready) return;
+        glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+        sprites.release();
+        shaders.release();
+        renderer.release();
+    }
+};
+
+GlContext* glContext() {
+    static std::unique_ptr<GlContext> context;
+    static bool attempted = false;
+    if (attempted) return context && context->ready ? context.get() : nullptr;
+    attempted = true;
+
+    context = std::make_unique<GlContext>();
+    if (!context->renderer.initialize(64, 64, 0, false, true)) return nullptr;
+    // Programs built from source here; the cache benchmark has its own
+    context->shaders.initialize();
+    context->sprites.initialize(context->shaders);
+    if (!context->shaders.loadShader("bench_sprite", SpriteBatcher::VERTEX_SHADER, BENCH_FRAGMENT_SHADER)) {
+        return nullptr;
+    }
+    context->shaders.pollShaders(true);
+    context->sprites.registerShader("bench_sprite");
+
+    context->textures.resize(4);
+    glGenTextures(static_cast<GLsizei>(context->textures.size()), context->textures.data());
+    const uint8_t white[4] = { 255, 255, 255, 255 };
+    for (GLuint texture : context->textures) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    context->ready = true;
+    return context.get();
+}
+
+void BM_ShaderCacheKey(benchmark::State& state) {
+    ShaderCache cache;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.computeKey(SpriteBatcher::VERTEX_SHADER, BENCH_FRAGMENT_SHADER,
+                                                  nullptr, 0));
+    }
+}
+BENCHMARK(BM_ShaderCacheKey);
+
+// The per-frame lookup renderers make by program name
+void BM_ShaderProgramLookup(benchmark::State& state) {
+    GlContext* gl = glContext();
+    if (gl == nullptr) {
+        state.SkipWithError("no offscreen GL context");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(gl->shaders.getProgram("bench_sprite"));
+    }
+}
+BENCHMARK(BM_ShaderProgramLookup);
+
+// A warm launch: the binary read back from disk and handed to the driver
+void BM_ShaderCacheLoad(benchmark::State& state) {
+    if (glContext() == nullptr) {
+        state.SkipWithError("no offscreen GL context");
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(gCacheDirectory, error);
+
+    // A cached manager's first build stores the binary
+    ShaderManager cachedShaders;
+    cachedShaders.initialize(gCacheDirectory);
+    cachedShaders.loadShader("bench_cached", SpriteBatcher::VERTEX_SHADER, BENCH_FRAGMENT_SHADER);
+
+    ShaderCache cache;
+    cache.initialize(gCacheDirectory);
+    uint64_t key = cache.computeKey(SpriteBatcher::VERTEX_SHADER, BENCH_FRAGMENT_SHADER, nullptr, 0);
+    GLuint probe = cache.load(key);
+    cachedShaders.release();
+    if (probe == 0) {
+        state.SkipWithError("driver cannot cache program binaries");
+        return;
+    }
+    glDeleteProgram(probe);
+
+    for (auto _ : state) {
+        GLuint program = cache.load(key);
+        state.PauseTiming();
+        glDeleteProgram(program);
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_ShaderCacheLoad)->Unit(benchmark::kMicrosecond);
+
+// Queueing, sorting and uploading a frame of sprites spread over textures,
+// layers and blend modes, and issuing the batcher's draw calls
+void BM_SpriteBatchBuild(benchmark::State& state) {
+    GlContext* gl = glContext();
+    if (gl == nullptr) {
+        state.SkipWithError("no offscreen GL context");
+        return;
+    }
+    const int count = static_cast<int>(state.range(0));
+    int shader = gl->sprites.registerShader("bench_sprite");
+
+    std::vector<Sprite> frame(count);
+    for (int i = 0; i < count; i++) {
+        Sprite& sprite = frame[i];
+        sprite.x = static_cast<float>((i * 37) % 1900);
+        sprite.y = static_cast<float>((i * 53) % 1060);
+        sprite.width = 20.0f;
+        sprite.height = 28.0f;
+        sprite.texture = gl->textures[(i * 7) % gl->textures.size()];
+        sprite.shader = i % 5 == 0 ? shader : SpriteBatcher::DEFAULT_SHADER;
+        sprite.blend = i % 3 == 0 ? BlendMode::Additive : BlendMode::Alpha;
+        sprite.layer = i % 2 == 0 ? SpriteBatcher::LAYER_TABLE : SpriteBatcher::LAYER_EFFECTS;
+    }
+
+    auto buildBatch = [&]() {
+        for (const Sprite& sprite : frame) {
+            gl->sprites.draw(sprite);
+        }
+        gl->sprites.flush();
+    };
+    // One frame pass around the whole run keeps the renderer's own frame
+    // work out of the timing. The first batch resolves the programs.
+    gl->renderer.beginFrame();
+    buildBatch();
+    glFinish();
+
+    for (auto _ : state) {
+        buildBatch();
+    }
+    gl->renderer.endFrame();
+    glFinish();
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SpriteBatchBuild)->RangeMultiplier(4)->Range(64, 16384)->Unit(benchmark::kMicrosecond);
+
+// --- Baseline comparison ---------------------------------------------------
+
+// Fastest real time per benchmark, in nanoseconds
+using Timings = std::map<std::string, double>;
+
+void addTiming(Timings& timings, const std::string& name, double nanoseconds) {
+    auto it = timings.find(name);
+    if (it == timings.end() || nanoseconds < it->second) {
+        timings[name] = nanoseconds;
+    }
+}
+
+class RecordingReporter : public benchmark::ConsoleReporter {
+public:
+    void ReportRuns(const std::vector<Run>& runs) override {
+        ConsoleReporter::ReportRuns(runs);
+        for (const Run& run : runs) {
+            if (run.error_occurred || run.run_type != Run::RT_Iteration) continue;
+            double seconds = run.GetAdjustedRealTime() / benchmark::GetTimeUnitMultiplier(run.time_unit);
+            addTiming(mTimings, run.benchmark_name(), seconds * 1e9);
+        }
+    }
+
+    const Timings& timings() const { return mTimings; }
+
+private:
+    Timings mTimings;
+};
+
+double nanosecondsPer(const std::string& unit) {
+    if (unit == "s") return 1e9;
+    if (unit == "ms") return 1e6;
+    if (unit == "us") return 1e3;
+    return 1.0;
+}
+
+bool readBaseline(const std::string& path, Timings& timings) {
+    std::string text;
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot read baseline %s\n", path.c_str());
+        return false;
+    }
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, read);
+    }
+    fclose(file);
+
+    JsonValue root;
+    std::string error;
+    if (!JsonReader::parse(text.data(), text.size(), root, error)) {
+        fprintf(stderr, "baseline %s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    const JsonValue* benchmarks = root.find("benchmarks");
+    if (benchmarks == nullptr || !benchmarks->isArray()) {
+        fprintf(stderr, "baseline %s has no benchmarks\n", path.c_str());
+        return false;
+    }
+    for (size_t i = 0; i < benchmarks->size(); i++) {
+        const JsonValue& entry = (*benchmarks)[i];
+        const JsonValue* name = entry.find("name");
+        const JsonValue* runType = entry.find("run_type");
+        const JsonValue* realTime = entry.find("real_time");
+        const JsonValue* timeUnit = entry.find("time_unit");
+        const JsonValue* errored = entry.find("error_occurred");
+        if (name == nullptr || realTime == nullptr || (errored != nullptr && errored->asBool())) continue;
+        if (runType != nullptr && runType->asString() != "iteration") continue;
+        double scale = timeUnit != nullptr ? nanosecondsPer(timeUnit->asString()) : 1.0;
+        addTiming(timings, name->asString(), realTime->asNumber() * scale);
+    }
+    return true;
+}
+
+// Benchmarks missing on either side are listed but never fail the run
+int compareWithBaseline(const Timings& current, const Timings& baseline, double maxRegression) {
+    int regressions = 0;
+    printf("\n%-44s %14s %14s %9s\n", "Benchmark", "Baseline ns", "Current ns", "Change");
+    for (const auto& pair : current) {
+        auto previous = baseline.find(pair.first);
+        if (previous == baseline.end()) {
+            printf("%-44s %14s %14.1f %9s\n", pair.first.c_str(), "-", pair.second, "new");
+            continue;
+        }
+        double change = previous->second > 0.0 ? pair.second / previous->second - 1.0 : 0.0;
+        bool regressed = change > maxRegression;
+        regressions += regressed ? 1 : 0;
+        printf("%-44s %14.1f %14.1f %+8.1f%%%s\n", pair.first.c_str(), previous->second, pair.second,
+               change * 100.0, regressed ? "  REGRESSED" : "");
+    }
+    for (const auto& pair : baseline) {
+        if (current.count(pair.first) == 0) {
+            printf("%-44s %14.1f %14s %9s\n", pair.first.c_str(), pair.second, "-", "missing");
+        }
+    }
+    printf("%d regression%s beyond %.0f%%\n", regressions, regressions == 1 ? "" : "s",
+           maxRegression * 100.0);
+    return regressions > 0 ? EXIT_FAILED : 0;
+}
+
+bool startsWith(const char* text, const char* prefix, const char*& value) {
+    size_t length = strlen(prefix);
+    if (strncmp(text, prefix, length) != 0) return false;
+    value = text + length;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+
+    // Google Benchmark has taken its flags; what is left is ours
+    std::string baseline;
+    double maxRegression = 0.15;
+    gCacheDirectory = (std::filesystem::temp_directory_path() / "trash_native_bench").string();
+    for (int i = 1; i < argc; i++) {
+        const char* value = nullptr;
+        if (startsWith(argv[i], "--baseline=", value)) {
+            baseline = value;
+        } else if (startsWith(argv[i], "--max-regression=", value)) {
+            maxRegression = atof(value);
+        } else if (startsWith(argv[i], "--cache=", value)) {
+            gCacheDirectory = value;
+        } else {
+            fprintf(stderr, "unknown option %s\n"
+                    "usage: native_bench [--benchmark_...] [--baseline=FILE [--max-regression=FRACTION]]"
+                    " [--cache=DIR]\n", argv[i]);
+            return EXIT_USAGE;
+        }
+    }
+
+    Timings previous;
+    if (!baseline.empty() && !readBaseline(baseline, previous)) {
+        return EXIT_USAGE;
+    }
+
+    RecordingReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    if (baseline.empty()) return 0;
+    return compareWithBaseline(reporter.timings(), previous, maxRegression);
+}
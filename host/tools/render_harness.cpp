@@ -0,0 +1,716 @@
+// Renders scripted scenes with the graphics engine on an offscreen target.
+//
+//   render_harness --scene cards --out cards.png
+//   render_harness --scene cards --golden golden/cards.png [--tolerance 8] [--max-diff 0.002]
+//   render_harness --scene table --bench 300 [--render-scale 0.5] [--msaa 4] [--max-batches 4]
+//   render_harness --validate-gpu-particles
+//   render_harness --validate-retained [--msaa 4]
+//   render_harness --bench-card-submit 300
+//   render_harness --scene table --bench 300 --profile table_trace.json
+//
+// Golden mode exits non-zero when more than --max-diff of the pixels differ
+// by more than --tolerance in any channel, and writes <out>.diff.png.
+// --update-golden rewrites the golden image instead of comparing. Bench mode
+// fails when any frame takes more than --max-batches sprite draw calls.
+// --bench-card-submit times queueing 100 cards a frame by name, by id and as
+// one packed record batch, and fails if the three frames differ. --profile
+// records the run with the frame profiler and writes a Chrome trace.
+
+#include "GraphicsEngine.h"
+#include "PngImage.h"
+#include <GLES3/gl3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using trashapp::graphics::BatchStats;
+using trashapp::graphics::CardRecord;
+using trashapp::graphics::GraphicsConfig;
+using trashapp::graphics::Easing;
+using trashapp::graphics::GraphicsEngine;
+using trashapp::graphics::ParticleBackend;
+using trashapp::graphics::ParticleValidationResult;
+using trashapp::graphics::ProfilerStats;
+using trashapp::graphics::SceneGraph;
+using trashapp::graphics::SceneStats;
+using trashapp::graphics::SpriteBatcher;
+using trashapp::host::Image;
+using trashapp::host::ImageDiff;
+
+namespace {
+
+const int EXIT_FAILED = 1;
+const int EXIT_USAGE = 2;
+const int EXIT_SKIPPED = 77;   // ctest SKIP_RETURN_CODE
+const float FRAME_DELTA = 1.0f / 60.0f;
+
+struct Scene {
+    const char* name;
+    int frames;   // rendered before the golden capture
+    ParticleBackend backend;
+    void (*update)(GraphicsEngine& engine, int frame);
+    void (*draw)(GraphicsEngine& engine, int frame);
+};
+
+// Scenes draw in the card renderer's 1920x1080 virtual space
+
+void drawDeck(GraphicsEngine& engine, int) {
+    // Every atlas cell: 52 faces, the joker and the back
+    for (int id = 0; id < 54; id++) {
+        float x = 60.0f + (id % 9) * 200.0f;
+        float y = 20.0f + (id / 9) * 175.0f;
+        engine.renderCardById(x, y, 112.0f, 157.0f, id, id != 53);
+    }
+}
+
+void updateTable(GraphicsEngine& engine, int frame) {
+    if (frame == 0) {
+        engine.addParticleEffect("gold_coin", 960.0f, 600.0f);
+        engine.addParticleEffect("dust", 400.0f, 200.0f);
+    }
+    if (frame == 10) {
+        engine.addParticleEffect("fire_spark", 1500.0f, 400.0f);
+    }
+    engine.updateParticles(FRAME_DELTA);
+}
+
+const char* const TABLE_HAND[][2] = {
+    { "HEARTS", "A" }, { "SPADES", "K" }, { "DIAMONDS", "10" }, { "CLUBS", "7" },
+    { "HEARTS", "Q" }, { "SPADES", "2" }, { "CLUBS", "J" }
+};
+
+void drawTable(GraphicsEngine& engine, int) {
+    for (int i = 0; i < 7; i++) {
+        engine.renderCard(520.0f + i * 130.0f, 60.0f, 180.0f, 252.0f, TABLE_HAND[i][0], TABLE_HAND[i][1], true);
+    }
+    // Draw pile and discard
+    for (int i = 0; i < 4; i++) {
+        engine.renderCardBack(700.0f + i * 3.0f, 500.0f + i * 3.0f, 180.0f, 252.0f);
+    }
+    engine.renderCard(1040.0f, 500.0f, 180.0f, 252.0f, "DIAMONDS", "Joker", true);
+}
+
+// The table above as retained scene nodes
+struct RetainedTable {
+    int hand[7];
+    int pile;
+    int discard;
+};
+
+RetainedTable buildRetainedTable(GraphicsEngine& engine) {
+    RetainedTable table = {};
+    int hand = engine.createSceneGroup(SceneGraph::ROOT, 520.0f, 60.0f);
+    for (int i = 0; i < 7; i++) {
+        int cardId = engine.getCardId(TABLE_HAND[i][0], TABLE_HAND[i][1]);
+        table.hand[i] = engine.createSceneCard(hand, i * 130.0f, 0.0f, 180.0f, 252.0f, cardId, true);
+    }
+    table.pile = engine.createSceneGroup(SceneGraph::ROOT, 700.0f, 500.0f);
+    for (int i = 0; i < 4; i++) {
+        engine.createSceneCard(table.pile, i * 3.0f, i * 3.0f, 180.0f, 252.0f, 0, false);
+    }
+    table.discard = engine.createSceneCard(SceneGraph::ROOT, 1040.0f, 500.0f, 180.0f, 252.0f,
+                                           engine.getCardId("DIAMONDS", "Joker"), true);
+    return table;
+}
+
+void updateRetainedTable(GraphicsEngine& engine, int frame) {
+    static RetainedTable table;
+    if (frame == 0) {
+        engine.clearScene();
+        table = buildRetainedTable(engine);
+    }
+    // Partial updates: a card lifted out of the hand, the pile moved over
+    if (frame == 20) {
+        engine.setSceneNodePosition(table.hand[2], 2 * 130.0f, 80.0f);
+        engine.setSceneNodePosition(table.pile, 640.0f, 520.0f);
+    }
+    updateTable(engine, frame);
+}
+
+// The hand dealt from the pile: each card slides out and turns over as it
+// lands. Captured mid-deal, with cards at rest, in flight, mid-flip and
+// still waiting on the pile.
+void updateAnimatedTable(GraphicsEngine& engine, int frame) {
+    if (frame != 0) return;
+    engine.clearScene();
+    int pile = engine.createSceneGroup(SceneGraph::ROOT, 700.0f, 500.0f);
+    for (int i = 0; i < 4; i++) {
+        engine.createSceneCard(pile, i * 3.0f, i * 3.0f, 180.0f, 252.0f, 0, false);
+    }
+    engine.createSceneCard(SceneGraph::ROOT, 1040.0f, 500.0f, 180.0f, 252.0f,
+                           engine.getCardId("DIAMONDS", "Joker"), true);
+    // Created after the pile so cards in flight cover it
+    int hand = engine.createSceneGroup(SceneGraph::ROOT, 520.0f, 60.0f);
+    for (int i = 0; i < 7; i++) {
+        int cardId = engine.getCardId(TABLE_HAND[i][0], TABLE_HAND[i][1]);
+        int card = engine.createSceneCard(hand, 189.0f, 449.0f, 180.0f, 252.0f, cardId, false);
+        float delay = i * 0.08f;
+        engine.moveSceneNode(card, i * 130.0f, 0.0f, 0.4f, delay, Easing::CubicOut);
+        engine.flipSceneCard(card, cardId, true, 0.2f, delay + 0.3f);
+    }
+}
+
+void updateParticles(GraphicsEngine& engine, int frame) {
+    if (frame % 8 == 0) {
+        engine.addParticleEffect("fire_spark", 480.0f + frame * 20.0f, 540.0f);
+        engine.addParticleEffect("gold_coin", 1440.0f - frame * 20.0f, 300.0f);
+    }
+    engine.updateParticles(FRAME_DELTA);
+}
+
+void drawText(GraphicsEngine& engine, int) {
+    const int layer = SpriteBatcher::LAYER_UI;
+    const uint32_t ink = 0xfff5deb3u;
+    const uint32_t red = 0xffc82828u;
+    const uint32_t black = 0xff1e1914u;
+
+    // One atlas from 24 to 480 units of cap height
+    engine.drawText("A 2 3 4 5 6 7 8 9 10 J Q K", 60.0f, 960.0f, 60.0f, ink, layer);
+    engine.drawText("x2 +15 -3 12:45 1/2 JOKER", 60.0f, 900.0f, 24.0f, ink, layer);
+    for (int suit = 0; suit < 5; suit++) {
+        engine.drawSuitPip(suit, 60.0f + suit * 130.0f, 720.0f, 100.0f, suit == 1 || suit == 3 ? red : ink, layer);
+    }
+    engine.drawText("10", 1100.0f, 140.0f, 480.0f, ink, layer);
+
+    // Index overlay on a card drawn larger than its atlas cell
+    engine.renderCard(120.0f, 80.0f, 360.0f, 504.0f, "SPADES", "Q", true);
+    engine.drawText("Q", 560.0f, 430.0f, 120.0f, black, layer);
+    engine.drawSuitPip(0, 560.0f, 280.0f, 120.0f, black, layer);
+}
+
+void drawNothing(GraphicsEngine&, int) {
+}
+
+void updateNothing(GraphicsEngine&, int) {
+}
+
+const Scene SCENES[] = {
+    { "cards", 1, ParticleBackend::Cpu, updateNothing, drawDeck },
+    { "table", 30, ParticleBackend::Cpu, updateTable, drawTable },
+    { "table_retained", 30, ParticleBackend::Cpu, updateRetainedTable, drawNothing },
+    { "table_animated", 26, ParticleBackend::Cpu, updateAnimatedTable, drawNothing },
+    { "particles", 40, ParticleBackend::Cpu, updateParticles, drawNothing },
+    { "text", 1, ParticleBackend::Cpu, updateNothing, drawText },
+    { "particles_gpu", 40, ParticleBackend::GpuTransformFeedback, updateParticles, drawNothing },
+};
+
+const Scene* findScene(const std::string& name) {
+    for (const Scene& scene : SCENES) {
+        if (name == scene.name) return &scene;
+    }
+    return nullptr;
+}
+
+struct Options {
+    std::string scene;
+    std::string out;
+    std::string golden;
+    std::string cacheDirectory;
+    std::string profile;
+    int width = 480;
+    int height = 270;
+    int tolerance = 8;
+    double maxDiff = 0.002;
+    int benchFrames = 0;
+    int cardSubmitFrames = 0;
+    int maxBatches = 0;   // 0: not checked
+    float renderScale = 1.0f;
+    int msaaSamples = 0;
+    bool updateGolden = false;
+    bool validateGpuParticles = false;
+    bool validateRetained = false;
+};
+
+void usage() {
+    fprintf(stderr,
+            "usage: render_harness --scene NAME [--out FILE] [--golden FILE [--update-golden]]\n"
+            "                      [--tolerance N] [--max-diff FRACTION] [--bench FRAMES [--max-batches N]]\n"
+            "                      [--size WxH] [--render-scale F] [--msaa N] [--cache DIR] [--profile FILE]\n"
+            "       render_harness --validate-gpu-particles\n"
+            "       render_harness --validate-retained [--msaa N] [--size WxH]\n"
+            "       render_harness --bench-card-submit FRAMES\n"
+            "scenes:");
+    for (const Scene& scene : SCENES) {
+        fprintf(stderr, " %s", scene.name);
+    }
+    fprintf(stderr, "\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "%s needs a value\n", name);
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (arg == "--scene") {
+            if ((v = value("--scene")) == nullptr) return false;
+            options.scene = v;
+        } else if (arg == "--out") {
+            if ((v = value("--out")) == nullptr) return false;
+            options.out = v;
+        } else if (arg == "--golden") {
+            if ((v = value("--golden")) == nullptr) return false;
+            options.golden = v;
+        } else if (arg == "--profile") {
+            if ((v = value("--profile")) == nullptr) return false;
+            options.profile = v;
+        } else if (arg == "--cache") {
+            if ((v = value("--cache")) == nullptr) return false;
+            options.cacheDirectory = v;
+        } else if (arg == "--tolerance") {
+            if ((v = value("--tolerance")) == nullptr) return false;
+            options.tolerance = atoi(v);
+        } else if (arg == "--max-diff") {
+            if ((v = value("--max-diff")) == nullptr) return false;
+            options.maxDiff = atof(v);
+        } else if (arg == "--bench") {
+            if ((v = value("--bench")) == nullptr) return false;
+            options.benchFrames = atoi(v);
+        } else if (arg == "--bench-card-submit") {
+            if ((v = value("--bench-card-submit")) == nullptr) return false;
+            options.cardSubmitFrames = atoi(v);
+        } else if (arg == "--max-batches") {
+            if ((v = value("--max-batches")) == nullptr) return false;
+            options.maxBatches = atoi(v);
+        } else if (arg == "--render-scale") {
+            if ((v = value("--render-scale")) == nullptr) return false;
+            options.renderScale = static_cast<float>(atof(v));
+        } else if (arg == "--msaa") {
+            if ((v = value("--msaa")) == nullptr) return false;
+            options.msaaSamples = atoi(v);
+        } else if (arg == "--size") {
+            if ((v = value("--size")) == nullptr) return false;
+            if (sscanf(v, "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0) {
+                fprintf(stderr, "bad --size %s\n", v);
+                return false;
+            }
+        } else if (arg == "--update-golden") {
+            options.updateGolden = true;
+        } else if (arg == "--validate-gpu-particles") {
+            options.validateGpuParticles = true;
+        } else if (arg == "--validate-retained") {
+            options.validateRetained = true;
+        } else {
+            fprintf(stderr, "unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return options.validateGpuParticles || options.validateRetained || options.cardSubmitFrames > 0 ||
+           !options.scene.empty();
+}
+
+bool initializeEngine(GraphicsEngine& engine, const Options& options) {
+    if (!options.cacheDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.cacheDirectory, error);
+        engine.setCacheDirectory(options.cacheDirectory.c_str());
+    }
+
+    GraphicsConfig config = {};
+    config.width = options.width;
+    config.height = options.height;
+    config.enableVSync = false;
+    config.msaaSamples = options.msaaSamples;
+    config.offscreen = true;
+    engine.initialize(config);
+    engine.setRenderScale(options.renderScale);
+    // Animations advance one frame's worth per frame, however long it took
+    engine.setAnimationTimeStep(FRAME_DELTA);
+
+    std::vector<uint8_t> probe;
+    if (!engine.readPixels(probe)) {
+        fprintf(stderr, "offscreen renderer unavailable\n");
+        return false;
+    }
+    return true;
+}
+
+// Scenes are compared after every program is ready, not mid-warmup
+bool waitForShaders(GraphicsEngine& engine) {
+    static const char* const PROGRAMS[] = { "sprite", "particle", "scene_layer", "sdf_glyph" };
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (const char* name : PROGRAMS) {
+        while (!engine.isShaderReady(name)) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                fprintf(stderr, "shader %s not ready\n", name);
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+void renderFrame(GraphicsEngine& engine, const Scene& scene, int frame) {
+    scene.update(engine, frame);
+    if (engine.beginFrame()) {
+        scene.draw(engine, frame);
+        engine.endFrame();
+    }
+}
+
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    return values[std::min(index, values.size() - 1)];
+}
+
+int runBenchmark(GraphicsEngine& engine, const Scene& scene, const Options& options) {
+    const int warmupFrames = 10;
+    for (int frame = 0; frame < warmupFrames; frame++) {
+        renderFrame(engine, scene, frame);
+    }
+    glFinish();
+
+    // Submit time is what the render thread pays; frame time waits for the
+    // GPU too, which on llvmpipe is CPU rasterisation
+    std::vector<double> submitTimes;
+    std::vector<double> frameTimes;
+    uint64_t sprites = 0;
+    uint64_t batches = 0;
+    uint32_t maxBatches = 0;
+    for (int frame = 0; frame < options.benchFrames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        renderFrame(engine, scene, warmupFrames + frame);
+        auto submitted = std::chrono::steady_clock::now();
+        glFinish();
+        auto finished = std::chrono::steady_clock::now();
+        submitTimes.push_back(std::chrono::duration<double, std::milli>(submitted - start).count());
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(finished - start).count());
+
+        BatchStats batchStats = engine.getSpriteBatchStats();
+        sprites += batchStats.sprites;
+        batches += batchStats.batches;
+        maxBatches = std::max(maxBatches, batchStats.batches);
+    }
+
+    double mean = 0.0;
+    double submitMean = 0.0;
+    for (size_t i = 0; i < frameTimes.size(); i++) {
+        mean += frameTimes[i];
+        submitMean += submitTimes[i];
+    }
+    if (!frameTimes.empty()) {
+        mean /= frameTimes.size();
+        submitMean /= frameTimes.size();
+    }
+
+    int frameCount = options.benchFrames;
+    auto timing = engine.getFrameTiming();
+    auto msaa = engine.getMsaaStats();
+    const auto& msaaCost = msaa.settings[msaa.activeSamples >= 4 ? 2 : msaa.activeSamples >= 2 ? 1 : 0];
+    auto passes = engine.getRenderPassStats();
+    printf("{\"scene\": \"%s\", \"width\": %d, \"height\": %d, \"frames\": %d, "
+           "\"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p95_ms\": %.3f, \"max_ms\": %.3f, "
+           "\"submit_mean_ms\": %.3f, \"gpu_average_ms\": %.3f, \"msaa\": %d, "
+           "\"msaa_target_bytes\": %llu, \"resolve_bytes_per_frame\": %llu, "
+           "\"pass_bytes_per_frame\": %llu, \"pass_bytes_saved_per_frame\": %llu, "
+           "\"sprites_per_frame\": %.1f, \"batches_per_frame\": %.2f, \"max_batches\": %u}\n",
+           scene.name, options.width, options.height, options.benchFrames,
+           mean, percentile(frameTimes, 0.5), percentile(frameTimes, 0.95),
+           percentile(frameTimes, 1.0), submitMean, timing.averageGpuMilliseconds, msaa.activeSamples,
+           static_cast<unsigned long long>(msaaCost.targetBytes),
+           static_cast<unsigned long long>(msaaCost.resolveBytesPerFrame),
+           static_cast<unsigned long long>(passes.bytesPerFrame),
+           static_cast<unsigned long long>(passes.bytesSavedPerFrame),
+           frameCount > 0 ? static_cast<double>(sprites) / frameCount : 0.0,
+           frameCount > 0 ? static_cast<double>(batches) / frameCount : 0.0, maxBatches);
+
+    if (options.maxBatches > 0 && maxBatches > static_cast<uint32_t>(options.maxBatches)) {
+        fprintf(stderr, "%s: %u sprite batches in one frame, limit %d\n",
+                scene.name, maxBatches, options.maxBatches);
+        return EXIT_FAILED;
+    }
+    return 0;
+}
+
+int runGolden(GraphicsEngine& engine, const Scene& scene, const Options& options) {
+    for (int frame = 0; frame < scene.frames; frame++) {
+        renderFrame(engine, scene, frame);
+    }
+
+    Image actual;
+    actual.width = options.width;
+    actual.height = options.height;
+    if (!engine.readPixels(actual.pixels)) {
+        fprintf(stderr, "readback failed\n");
+        return EXIT_FAILED;
+    }
+
+    std::string out = options.out.empty() ? std::string(scene.name) + ".png" : options.out;
+    if (!trashapp::host::writePng(out, actual)) {
+        fprintf(stderr, "cannot write %s\n", out.c_str());
+        return EXIT_FAILED;
+    }
+    if (options.golden.empty()) {
+        printf("%s: wrote %s\n", scene.name, out.c_str());
+        return 0;
+    }
+
+    if (options.updateGolden) {
+        if (!trashapp::host::writePng(options.golden, actual)) {
+            fprintf(stderr, "cannot write %s\n", options.golden.c_str());
+            return EXIT_FAILED;
+        }
+        printf("%s: updated %s\n", scene.name, options.golden.c_str());
+        return 0;
+    }
+
+    Image expected;
+    std::string error;
+    if (!trashapp::host::readPng(options.golden, expected, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILED;
+    }
+    if (expected.width != actual.width || expected.height != actual.height) {
+        fprintf(stderr, "%s: golden is %dx%d, rendered %dx%d\n", scene.name,
+                expected.width, expected.height, actual.width, actual.height);
+        return EXIT_FAILED;
+    }
+
+    Image diffImage;
+    ImageDiff diff = trashapp::host::compareImages(expected, actual, options.tolerance, &diffImage);
+    bool passed = diff.differentFraction <= options.maxDiff;
+    printf("%s: %llu pixels differ (%.4f%%), max channel delta %d -> %s\n", scene.name,
+           static_cast<unsigned long long>(diff.differentPixels), diff.differentFraction * 100.0,
+           diff.maxChannelDelta, passed ? "PASS" : "FAIL");
+    if (!passed) {
+        std::string diffPath = out + ".diff.png";
+        trashapp::host::writePng(diffPath, diffImage);
+        fprintf(stderr, "%s: differences written to %s\n", scene.name, diffPath.c_str());
+        return EXIT_FAILED;
+    }
+    return 0;
+}
+
+int runValidation(GraphicsEngine& engine) {
+    // One second of dust, which lives 1.5 s, so live positions are compared
+    ParticleValidationResult result = engine.validateParticleBackend(4096, 60);
+    if (result.particleCount == 0) {
+        printf("GPU particle backend unavailable, skipped\n");
+        return EXIT_SKIPPED;
+    }
+    printf("GPU particles: %u particles, max position error %.5f, max color error %.5f, "
+           "cpu %.2f ms, gpu %.2f ms -> %s\n",
+           result.particleCount, result.maxPositionError, result.maxColorError,
+           result.cpuMilliseconds, result.gpuMilliseconds, result.passed ? "PASS" : "FAIL");
+    return result.passed ? 0 : EXIT_FAILED;
+}
+
+// A partial layer update must leave exactly the pixels a full redraw would,
+// and an unchanged scene must not be drawn at all
+int runRetainedValidation(GraphicsEngine& engine, const Options& options) {
+    RetainedTable table = buildRetainedTable(engine);
+    for (int frame = 0; frame < 100 && engine.needsRender(); frame++) {
+        engine.render();
+    }
+
+    SceneStats before = engine.getSceneStats();
+    engine.render();
+    SceneStats idle = engine.getSceneStats();
+    bool skipped = idle.framesSkipped == before.framesSkipped + 1 && idle.layerUpdates == before.layerUpdates;
+
+    // Lift a card out of the hand and turn the discard over
+    engine.setSceneNodePosition(table.hand[3], 3 * 130.0f, 60.0f);
+    engine.setSceneCard(table.discard, 0, false);
+    engine.render();
+    SceneStats partial = engine.getSceneStats();
+    bool patched = partial.layerUpdates == idle.layerUpdates + 1 && partial.fullRedraws == idle.fullRedraws;
+
+    Image patchedImage;
+    patchedImage.width = options.width;
+    patchedImage.height = options.height;
+    Image fullImage = patchedImage;
+    bool readBack = engine.readPixels(patchedImage.pixels);
+    engine.invalidateScene();
+    engine.render();
+    readBack = readBack && engine.readPixels(fullImage.pixels);
+    if (!readBack) {
+        fprintf(stderr, "readback failed\n");
+        return EXIT_FAILED;
+    }
+
+    Image diffImage;
+    ImageDiff diff = trashapp::host::compareImages(fullImage, patchedImage, 0, &diffImage);
+    bool passed = skipped && patched && diff.differentPixels == 0;
+    printf("retained scene: idle frame %s, partial update of %u rects (%.1f%% of the layer, %u cards), "
+           "%llu pixels differ from a full redraw -> %s\n",
+           skipped ? "skipped" : "DRAWN", partial.lastDirtyRects, partial.lastDirtyFraction * 100.0f,
+           partial.lastCardsDrawn, static_cast<unsigned long long>(diff.differentPixels),
+           passed ? "PASS" : "FAIL");
+    if (!patched) {
+        fprintf(stderr, "expected a partial layer update, got %u updates and %u full redraws\n",
+                partial.layerUpdates - idle.layerUpdates, partial.fullRedraws - idle.fullRedraws);
+    }
+    if (diff.differentPixels != 0) {
+        std::string diffPath = (options.out.empty() ? std::string("retained.png") : options.out) + ".diff.png";
+        trashapp::host::writePng(diffPath, diffImage);
+        fprintf(stderr, "differences written to %s\n", diffPath.c_str());
+    }
+    return passed ? 0 : EXIT_FAILED;
+}
+
+// What the JNI entry points do with each card: renderCard resolves names,
+// renderCardById takes ids, renderCards reads packed records in place. The
+// JNI crossing itself is timed on device by benchmarkCardSubmission in Java.
+int runCardSubmitBenchmark(GraphicsEngine& engine, const Options& options) {
+    const int cardsPerFrame = 100;
+    const char* const suits[] = { "HEARTS", "SPADES", "DIAMONDS", "CLUBS" };
+    const char* const ranks[] = { "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K" };
+    std::vector<CardRecord> records(cardsPerFrame);
+    for (int i = 0; i < cardsPerFrame; i++) {
+        CardRecord& card = records[i];
+        card.x = 40.0f + (i % 18) * 100.0f;
+        card.y = 40.0f + (i / 18 % 7) * 140.0f;
+        card.width = 90.0f;
+        card.height = 126.0f;
+        card.cardId = engine.getCardId(suits[i % 4], ranks[i % 13]);
+        card.flags = CardRecord::FACE_UP;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    double totals[3] = {};
+    Image frames[3];
+    for (int frame = 0; frame < options.cardSubmitFrames; frame++) {
+        for (int path = 0; path < 3; path++) {
+            auto start = Clock::now();
+            if (path == 0) {
+                for (int i = 0; i < cardsPerFrame; i++) {
+                    const CardRecord& card = records[i];
+                    engine.renderCard(card.x, card.y, card.width, card.height, suits[i % 4],
+                                      ranks[i % 13], true);
+                }
+            } else if (path == 1) {
+                for (const CardRecord& card : records) {
+                    engine.renderCardById(card.x, card.y, card.width, card.height, card.cardId, true);
+                }
+            } else {
+                engine.renderCards(records.data(), records.size());
+            }
+            totals[path] += std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+            engine.render();
+
+            if (frame == options.cardSubmitFrames - 1) {
+                frames[path].width = options.width;
+                frames[path].height = options.height;
+                if (!engine.readPixels(frames[path].pixels)) {
+                    fprintf(stderr, "readback failed\n");
+                    return EXIT_FAILED;
+                }
+            }
+        }
+    }
+
+    uint64_t differing = 0;
+    for (int path = 1; path < 3; path++) {
+        differing += trashapp::host::compareImages(frames[0], frames[path], 0, nullptr).differentPixels;
+    }
+    double frameCount = static_cast<double>(options.cardSubmitFrames);
+    printf("{\"cards_per_frame\": %d, \"frames\": %d, \"by_name_us\": %.2f, \"by_id_us\": %.2f, "
+           "\"batch_us\": %.2f, \"differing_pixels\": %llu}\n",
+           cardsPerFrame, options.cardSubmitFrames, totals[0] / frameCount, totals[1] / frameCount,
+           totals[2] / frameCount, static_cast<unsigned long long>(differing));
+    if (differing != 0) {
+        fprintf(stderr, "card submission paths drew different frames\n");
+        return EXIT_FAILED;
+    }
+    return 0;
+}
+
+// Every frame must leave a "frame" scope, and GPU scopes when the timer
+// extension is there
+int exportProfile(GraphicsEngine& engine, const Options& options) {
+    ProfilerStats stats = engine.getProfilerStats();
+    if (!engine.exportProfile(options.profile.c_str())) {
+        fprintf(stderr, "cannot write %s\n", options.profile.c_str());
+        return EXIT_FAILED;
+    }
+    std::string trace;
+    if (FILE* file = fopen(options.profile.c_str(), "rb")) {
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            trace.append(buffer, read);
+        }
+        fclose(file);
+    }
+    bool hasFrames = trace.find("\"name\": \"frame\"") != std::string::npos;
+    bool passed = hasFrames && (!stats.gpuTimerSupported || stats.gpuScopes > 0);
+    printf("profile: %llu CPU scopes on %u threads, %llu GPU scopes (timer %s), %zu bytes -> %s %s\n",
+           static_cast<unsigned long long>(stats.cpuScopes), stats.threads,
+           static_cast<unsigned long long>(stats.gpuScopes),
+           stats.gpuTimerSupported ? "supported" : "unsupported", trace.size(),
+           options.profile.c_str(), passed ? "PASS" : "FAIL");
+    return passed ? 0 : EXIT_FAILED;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return EXIT_USAGE;
+    }
+
+    const Scene* scene = nullptr;
+    if (!options.scene.empty()) {
+        scene = findScene(options.scene);
+        if (scene == nullptr) {
+            fprintf(stderr, "unknown scene %s\n", options.scene.c_str());
+            usage();
+            return EXIT_USAGE;
+        }
+    }
+
+    GraphicsEngine& engine = GraphicsEngine::getInstance();
+    if (!initializeEngine(engine, options) || !waitForShaders(engine)) {
+        return EXIT_FAILED;
+    }
+
+    if (!options.profile.empty()) {
+        engine.setProfilingEnabled(true);
+    }
+
+    int status = 0;
+    if (options.validateGpuParticles) {
+        status = runValidation(engine);
+    }
+    if (status == 0 && options.validateRetained) {
+        status = runRetainedValidation(engine, options);
+    }
+    if (status == 0 && options.cardSubmitFrames > 0) {
+        status = runCardSubmitBenchmark(engine, options);
+    }
+    if (status == 0 && scene != nullptr) {
+        if (scene->backend != ParticleBackend::Cpu &&
+            !engine.setParticleBackend(scene->backend)) {
+            fprintf(stderr, "%s: particle backend unavailable\n", scene->name);
+            status = EXIT_SKIPPED;
+        } else if (options.benchFrames > 0) {
+            status = runBenchmark(engine, *scene, options);
+        } else {
+            status = runGolden(engine, *scene, options);
+        }
+    }
+
+    if (status == 0 && !options.profile.empty()) {
+        status = exportProfile(engine, options);
+    }
+
+    engine.release();
+    return status;
+}
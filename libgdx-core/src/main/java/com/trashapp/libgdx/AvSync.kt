@@ -0,0 +1,46 @@
+package com.trashapp.libgdx
+
+import com.trashapp.oboe.AudioEngine
+import com.trashapp.skia.GraphicsEngine
+
+/**
+ * Schedules a sound and a visual once, for one shared moment. Both engines
+ * predict presentation on the System.nanoTime() clock, the audio engine
+ * from Oboe's presentation timestamps and the graphics engine from the
+ * compositor's present times, so the two land on the same displayed frame
+ * instead of drifting by an audio buffer plus a frame.
+ *
+ * Call from the render thread, like the rest of GraphicsEngine.
+ */
+class AvSync(
+    private val audioEngine: AudioEngine = AudioEngine.getInstance(),
+    private val graphicsEngine: GraphicsEngine = GraphicsEngine.getInstance()
+) {
+
+    /** How much later a sound triggered now is heard than a visual requested now is seen */
+    val offsetNanos: Long
+        get() = audioEngine.nextPresentTimeNanos - graphicsEngine.nextPresentTimeNanos
+
+    /** The earliest moment both engines can still make */
+    fun nextPresentTimeNanos(): Long =
+        maxOf(audioEngine.nextPresentTimeNanos, graphicsEngine.nextPresentTimeNanos)
+
+    /**
+     * Plays a sound with a particle effect as soon as both can be presented
+     * together, optionally delayed; returns the presentation time used
+     */
+    fun playWithEffect(
+        soundId: Int,
+        effectType: String,
+        x: Float,
+        y: Float,
+        volume: Float = 1.0f,
+        pan: Float = 0.0f,
+        delayNanos: Long = 0L
+    ): Long {
+        val presentTime = nextPresentTimeNanos() + delayNanos
+        audioEngine.playSoundAt(soundId, volume, pan, presentTime)
+        graphicsEngine.addParticleEffectAt(effectType, x, y, presentTime)
+        return presentTime
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+// Heap accounting shared by the native modules. Each module names its
+// subsystems with an enum class ending in Count and books what their
+// containers hold under those tags.
+
+namespace trashapp {
+
+struct TaggedMemoryStats {
+    uint64_t bytes;          // held now
+    uint64_t peakBytes;
+    uint64_t allocations;    // since launch; flat once the subsystem is warm
+};
+
+// Counts what tagged containers take from the heap, per tag of Tag. Cheap
+// enough for every allocation: three relaxed atomic updates.
+template <typename Tag>
+class TaggedMemory {
+public:
+    static void onAllocate(Tag tag, size_t bytes) {
+        Counters& counters = sCounters[index(tag)];
+        uint64_t held = counters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        uint64_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+        while (held > peak &&
+               !counters.peakBytes.compare_exchange_weak(peak, held, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void onFree(Tag tag, size_t bytes) {
+        sCounters[index(tag)].bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    static TaggedMemoryStats getStats(Tag tag) {
+        const Counters& counters = sCounters[index(tag)];
+        TaggedMemoryStats stats = {};
+        stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+        stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+        stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> peakBytes{0};
+        std::atomic<uint64_t> allocations{0};
+    };
+
+    static size_t index(Tag tag) { return static_cast<size_t>(tag); }
+
+    static inline Counters sCounters[static_cast<size_t>(Tag::Count)];
+};
+
+// Standard allocator that books its storage under a tag
+template <typename T, auto Tag>
+class TaggedAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = TaggedAllocator<U, Tag>;
+    };
+
+    TaggedAllocator() = default;
+    template <typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+    T* allocate(size_t count) {
+        size_t bytes = count * sizeof(T);
+        T* items = static_cast<T*>(::operator new(bytes));
+        TaggedMemory<decltype(Tag)>::onAllocate(Tag, bytes);
+        return items;
+    }
+
+    void deallocate(T* items, size_t count) {
+        TaggedMemory<decltype(Tag)>::onFree(Tag, count * sizeof(T));
+        ::operator delete(items);
+    }
+
+    template <typename U>
+    bool operator==(const TaggedAllocator<U, Tag>&) const { return true; }
+    template <typename U>
+    bool operator!=(const TaggedAllocator<U, Tag>&) const { return false; }
+};
+
+template <typename T, auto Tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+
+template <typename Key, typename Value, auto Tag>
+using TaggedMap = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                     TaggedAllocator<std::pair<const Key, Value>, Tag>>;
+
+} // namespace trashapp
@@ -1,17 +1,32 @@
 #include "AudioEngine.h"
+#include "RealtimeLog.h"
 #include <android/log.h>
+#include <algorithm>
+#include <time.h>
 
 #define TAG "AudioEngine"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+// For paths that hold mMutex, which the audio callback takes
+#define RT_LOGD(...) TRASH_RT_LOG(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
 
 namespace trashapp {
 namespace audio {
 
+static const int64_t NANOS_PER_SECOND = 1000000000LL;
+
+static int64_t nowNanos() {
+    // Same clock as Oboe timestamps and Choreographer frame times
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * NANOS_PER_SECOND + now.tv_nsec;
+}
+
 AudioEngine::AudioEngine() {
     mMixer = std::make_unique<AudioMixer>();
     mSpatialAudio = std::make_unique<SpatialAudio>();
     mSoundManager = std::make_unique<SoundManager>();
+    mEvents = std::make_unique<AudioEventDispatcher>(*mSoundManager);
 }
 
 AudioEngine::~AudioEngine() {
@@ -29,6 +44,8 @@ void AudioEngine::initialize() {
         return;
     }
     
+    RealtimeLog::start();
+    
     auto result = openStream();
     if (result != oboe::Result::OK) {
         LOGE("Failed to open audio stream: %s", oboe::convertToText(result));
@@ -46,11 +63,23 @@ oboe::Result AudioEngine::openStream() {
     builder.setPerformanceMode(oboe::PerformanceMode::LowLatency);
     builder.setSharingMode(oboe::SharingMode::Exclusive);
     builder.setFormat(oboe::AudioFormat::Float);
-    builder.setChannelCount(oboe::ChannelCount::Stereo);
+    builder.setChannelCount(mRequestedChannels);
     builder.setSampleRate(48000);
     builder.setCallback(this);
     
-    return builder.openStream(mAudioStream);
+    auto result = builder.openStream(mAudioStream);
+    if (result != oboe::Result::OK) {
+        return result;
+    }
+    
+    // Mix straight into the layout the device granted
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOutputChannels = mAudioStream->getChannelCount();
+    mSoundManager->setOutputChannels(mOutputChannels);
+    mMixer->setOutputChannels(mOutputChannels);
+    mSpatialAudio->setOutputChannels(mOutputChannels);
+    LOGI("Output stream: %d channels (%d requested)", mOutputChannels, mRequestedChannels);
+    return result;
 }
 
 void AudioEngine::closeStream() {
@@ -114,6 +143,7 @@ void AudioEngine::release() {
     stop();
     closeStream();
     mInitialized = false;
+    RealtimeLog::stop();
 }
 
 void AudioEngine::loadSound(const char* filename, int soundId) {
@@ -129,11 +159,26 @@ void AudioEngine::loadMusic(const char* filename, int musicId) {
     LOGI("Loading music: %s (ID: %d)", filename, musicId);
 }
 
-void AudioEngine::playSound(int soundId, float volume, float pan) {
+void AudioEngine::playSound(int soundId, float volume, float pan, float rate) {
     std::lock_guard<std::mutex> lock(mMutex);
     float adjustedVolume = volume * mSfxVolume * mMasterVolume;
-    mSoundManager->playSound(soundId, adjustedVolume, pan);
-    LOGI("Playing sound ID: %d, volume: %f", soundId, adjustedVolume);
+    mSoundManager->playSound(soundId, adjustedVolume, pan, rate);
+    RT_LOGD("Playing sound ID: %d, volume: %f, rate: %f", soundId, adjustedVolume, rate);
+}
+
+void AudioEngine::setInterpolation(Interpolation mode) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSoundManager->setInterpolation(mode);
+}
+
+void AudioEngine::setOutputChannelCount(int channels) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRequestedChannels = std::clamp(channels, 1, 8);
+}
+
+int AudioEngine::getOutputChannelCount() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mOutputChannels;
 }
 
 void AudioEngine::stopSound(int soundId) {
@@ -150,7 +195,7 @@ void AudioEngine::playMusic(int musicId, float volume, bool loop) {
     std::lock_guard<std::mutex> lock(mMutex);
     float adjustedVolume = volume * mMusicVolume * mMasterVolume;
     mSoundManager->playSound(musicId, adjustedVolume, 0.0f);
-    LOGI("Playing music ID: %d, volume: %f, loop: %d", musicId, adjustedVolume, loop);
+    RT_LOGD("Playing music ID: %d, volume: %f, loop: %d", musicId, adjustedVolume, loop);
 }
 
 void AudioEngine::stopMusic() {
@@ -177,7 +222,108 @@ void AudioEngine::playSound3D(int soundId, float x, float y, float z, float volu
     std::lock_guard<std::mutex> lock(mMutex);
     float adjustedVolume = volume * mSfxVolume * mMasterVolume;
     mSpatialAudio->playSound3D(soundId, x, y, z, adjustedVolume);
-    LOGI("Playing 3D sound ID: %d at (%.2f, %.2f, %.2f), volume: %f", soundId, x, y, z, adjustedVolume);
+    RT_LOGD("Playing 3D sound ID: %d at (%.2f, %.2f, %.2f), volume: %f", soundId, x, y, z, adjustedVolume);
+}
+
+void AudioEngine::registerEvent(int eventId, const AudioEventConfig& config) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents->registerEvent(eventId, config);
+}
+
+int AudioEngine::triggerEvent(int eventId, float volume, float pan) {
+    int64_t now = nowNanos();
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEvents->trigger(eventId, volume * mSfxVolume * mMasterVolume, pan, now);
+}
+
+AudioEventStats AudioEngine::getEventStats() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEvents->getStats();
+}
+
+bool AudioEngine::getPresentationClock(int64_t& framePosition, int64_t& timeNanos) {
+    if (!mAudioStream) return false;
+    
+    auto timestamp = mAudioStream->getTimestamp(CLOCK_MONOTONIC);
+    if (timestamp) {
+        framePosition = timestamp.value().position;
+        timeNanos = timestamp.value().timestamp;
+        mTimestampSupported.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // No timestamp yet (or ever, on OpenSL ES): what is written now is heard
+    // after the stream's latency, or at worst after its whole buffer
+    mTimestampSupported.store(false, std::memory_order_relaxed);
+    int32_t sampleRate = mAudioStream->getSampleRate();
+    if (sampleRate <= 0) return false;
+    auto latency = mAudioStream->calculateLatencyMillis();
+    double latencyMilliseconds = latency ? latency.value()
+        : 1000.0 * mAudioStream->getBufferSizeInFrames() / sampleRate;
+    framePosition = mAudioStream->getFramesWritten();
+    timeNanos = nowNanos() + static_cast<int64_t>(latencyMilliseconds * 1.0e6);
+    return true;
+}
+
+int64_t AudioEngine::getNextPresentTimeNanos() {
+    int64_t position = 0;
+    int64_t time = 0;
+    if (!getPresentationClock(position, time)) return nowNanos();
+    
+    // The next callback renders from the frames written so far
+    int64_t written = mAudioStream->getFramesWritten();
+    int64_t presentTime = time + (written - position) * NANOS_PER_SECOND / mAudioStream->getSampleRate();
+    return std::max(presentTime, nowNanos());
+}
+
+void AudioEngine::playSoundAt(int soundId, float volume, float pan, int64_t presentTimeNanos) {
+    // Read the stream clock before locking; it may call into the HAL
+    int64_t position = 0;
+    int64_t time = 0;
+    bool clocked = getPresentationClock(position, time);
+    
+    std::lock_guard<std::mutex> lock(mMutex);
+    float adjustedVolume = volume * mSfxVolume * mMasterVolume;
+    if (!clocked) {
+        mSoundManager->playSound(soundId, adjustedVolume, pan);
+        return;
+    }
+    
+    int32_t sampleRate = mAudioStream->getSampleRate();
+    int64_t streamFrame = position + (presentTimeNanos - time) * sampleRate / NANOS_PER_SECOND;
+    int64_t startFrame = streamFrame - mStreamFrameOffset.load(std::memory_order_relaxed);
+    int64_t mixed = mSoundManager->getFramePosition();
+    mScheduledSounds++;
+    if (startFrame < mixed) {
+        mLateSounds++;
+        mLastLateMilliseconds = 1000.0 * (mixed - startFrame) / sampleRate;
+    }
+    mSoundManager->playSoundAt(soundId, adjustedVolume, pan, startFrame);
+    RT_LOGD("Scheduled sound ID: %d, %.1f ms ahead", soundId,
+            (presentTimeNanos - nowNanos()) / 1.0e6);
+}
+
+AudioSyncStats AudioEngine::getSyncStats() {
+    int64_t now = nowNanos();
+    int64_t present = getNextPresentTimeNanos();
+    
+    std::lock_guard<std::mutex> lock(mMutex);
+    AudioSyncStats stats = {};
+    stats.outputLatencyMilliseconds = (present - now) / 1.0e6;
+    stats.timestampSupported = mTimestampSupported.load(std::memory_order_relaxed);
+    stats.scheduledSounds = mScheduledSounds;
+    stats.lateSounds = mLateSounds;
+    stats.lastLateMilliseconds = mLastLateMilliseconds;
+    return stats;
+}
+
+AudioMemoryReport AudioEngine::getMemoryStats() {
+    AudioMemoryReport report = {};
+    for (int tag = 0; tag < static_cast<int>(AudioMemoryTag::Count); tag++) {
+        report.tags[tag] = AudioMemory::getStats(static_cast<AudioMemoryTag>(tag));
+    }
+    report.realtimeViolations = AudioMemory::getRealtimeViolations();
+    return report;
 }
 
 void AudioEngine::enableReverb(bool enable) {
@@ -195,6 +341,11 @@ oboe::DataCallbackResult AudioEngine::onAudioReady(
     void* audioData,
     int32_t numFrames
 ) {
+    // Everything below runs without touching the heap
+    RealtimeScope realtime;
+    // Keeps stream frames and mixed frames on one count for playSoundAt
+    mStreamFrameOffset.store(audioStream->getFramesWritten() - mSoundManager->getFramePosition(),
+                             std::memory_order_relaxed);
     auto* floatData = static_cast<float*>(audioData);
     processAudio(floatData, numFrames);
     return oboe::DataCallbackResult::Continue;
@@ -204,7 +355,7 @@ void AudioEngine::processAudio(float* audioData, int32_t numFrames) {
     std::lock_guard<std::mutex> lock(mMutex);
     
     // Clear buffer
-    memset(audioData, 0, sizeof(float) * numFrames * 2); // Stereo
+    memset(audioData, 0, sizeof(float) * numFrames * mOutputChannels);
     
     // Mix audio from sound manager
     mSoundManager->mixAudio(audioData, numFrames);
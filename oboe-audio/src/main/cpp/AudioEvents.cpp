@@ -0,0 +1,112 @@
+#include "AudioEvents.h"
+#include "RealtimeLog.h"
+#include <algorithm>
+#include <cmath>
+
+#define TAG "AudioEvents"
+#define RT_LOGD(...) TRASH_RT_LOG(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace audio {
+
+static const int SAMPLE_RATE = 48000;
+static const int64_t NANOS_PER_MILLISECOND = 1000000LL;
+static const int64_t NANOS_PER_SECOND = 1000000000LL;
+
+AudioEventDispatcher::AudioEventDispatcher(SoundManager& sounds)
+    : mSounds(sounds), mRandom(0x5eed) {
+}
+
+AudioEventConfig AudioEventDispatcher::defaultConfig(int soundId) {
+    AudioEventConfig config = {};
+    config.soundId = soundId;
+    config.volume = 1.0f;
+    // About two frames: what lands together sounds together
+    config.windowMilliseconds = 35.0f;
+    config.maxPerSecond = 0.0f;
+    config.maxGain = 2.0f;
+    config.timeJitterMilliseconds = 0.0f;
+    config.pitchVarianceSemitones = 0.0f;
+    config.hapticMilliseconds = 0;
+    return config;
+}
+
+void AudioEventDispatcher::registerEvent(int eventId, const AudioEventConfig& config) {
+    EventState& state = mEvents[eventId];
+    state = {};
+    state.config = config;
+}
+
+void AudioEventDispatcher::unregisterEvent(int eventId) {
+    mEvents.erase(eventId);
+}
+
+int AudioEventDispatcher::trigger(int eventId, float volume, float pan, int64_t nowNanos) {
+    auto it = mEvents.find(eventId);
+    if (it == mEvents.end()) {
+        it = mEvents.emplace(eventId, EventState{defaultConfig(eventId), 0, 0, 0, 0.0f}).first;
+    }
+    EventState& state = it->second;
+    const AudioEventConfig& config = state.config;
+    mStats.triggers++;
+
+    bool inWindow = state.count > 0 && nowNanos < state.windowEndNanos;
+    bool overRate = false;
+    if (state.count > 0 && config.maxPerSecond > 0.0f) {
+        int64_t interval = static_cast<int64_t>(NANOS_PER_SECOND / config.maxPerSecond);
+        overRate = nowNanos - state.lastStartNanos < interval;
+    }
+    bool playing = (inWindow || overRate) && mSounds.isPlaying(config.soundId);
+
+    if (inWindow && playing) {
+        mergeIntoVoice(state, volume);
+        mStats.coalesced++;
+        return -1;
+    }
+    // Over the start rate: louder if the voice is still going, else dropped,
+    // so a sound shorter than the interval cannot start more often
+    if (overRate) {
+        if (playing) {
+            mergeIntoVoice(state, volume);
+        }
+        mStats.rateLimited++;
+        return -1;
+    }
+    return startVoice(state, volume, pan, nowNanos);
+}
+
+void AudioEventDispatcher::mergeIntoVoice(EventState& state, float volume) {
+    // Louder, not doubled
+    const AudioEventConfig& config = state.config;
+    state.count++;
+    state.volume = std::max(state.volume, volume);
+    float gain = std::min(config.maxGain, std::sqrt(static_cast<float>(state.count)));
+    mSounds.setSoundVolume(config.soundId, config.volume * state.volume * gain);
+}
+
+int AudioEventDispatcher::startVoice(EventState& state, float volume, float pan, int64_t nowNanos) {
+    const AudioEventConfig& config = state.config;
+    state.count = 1;
+    state.volume = volume;
+    state.lastStartNanos = nowNanos;
+    state.windowEndNanos = nowNanos + static_cast<int64_t>(config.windowMilliseconds * NANOS_PER_MILLISECOND);
+
+    int64_t startFrame = mSounds.getFramePosition();
+    if (config.timeJitterMilliseconds > 0.0f) {
+        std::uniform_real_distribution<float> jitter(0.0f, config.timeJitterMilliseconds);
+        startFrame += static_cast<int64_t>(jitter(mRandom) * SAMPLE_RATE / 1000.0f);
+    }
+    float rate = 1.0f;
+    if (config.pitchVarianceSemitones > 0.0f) {
+        std::uniform_real_distribution<float> pitch(-config.pitchVarianceSemitones, config.pitchVarianceSemitones);
+        rate = semitonesToRate(pitch(mRandom));
+    }
+    mSounds.playSoundAt(config.soundId, config.volume * volume, pan, startFrame, rate);
+    mStats.voicesStarted++;
+    RT_LOGD("Event sound %d started at frame %lld, rate %f", config.soundId,
+            static_cast<long long>(startFrame), rate);
+    return config.hapticMilliseconds;
+}
+
+} // namespace audio
+} // namespace trashapp
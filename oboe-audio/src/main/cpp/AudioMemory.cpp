@@ -0,0 +1,114 @@
+#include "AudioMemory.h"
+#include <android/log.h>
+#include <cstdlib>
+
+#define TAG "AudioMemory"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace audio {
+
+namespace {
+
+thread_local bool tRealtime = false;
+
+} // namespace
+
+std::atomic<uint64_t> AudioMemory::sRealtimeViolations{0};
+
+const char* AudioMemory::tagName(AudioMemoryTag tag) {
+    switch (tag) {
+        case AudioMemoryTag::SoundManager: return "sound_manager";
+        case AudioMemoryTag::Mixer:        return "mixer";
+        case AudioMemoryTag::Spatial:      return "spatial";
+        case AudioMemoryTag::Events:       return "events";
+        default:                           return "unknown";
+    }
+}
+
+bool AudioMemory::isRealtimeThread() {
+    return tRealtime;
+}
+
+uint64_t AudioMemory::getRealtimeViolations() {
+    return sRealtimeViolations.load(std::memory_order_relaxed);
+}
+
+void AudioMemory::checkHeapCall(const char* what, size_t bytes) {
+    if (!tRealtime) return;
+    sRealtimeViolations.fetch_add(1, std::memory_order_relaxed);
+    // Logging may allocate itself; leave the scope first so it cannot recurse
+    tRealtime = false;
+    LOGE("%s of %zu bytes on the audio thread", what, bytes);
+    abort();
+}
+
+RealtimeScope::RealtimeScope() : mOuter(!tRealtime) {
+    tRealtime = true;
+}
+
+RealtimeScope::~RealtimeScope() {
+    if (mOuter) tRealtime = false;
+}
+
+} // namespace audio
+} // namespace trashapp
+
+#if TRASH_AUDIO_REALTIME_CHECKS
+
+// Checked replacements for the library's heap entry points. The aligned
+// forms are left to the runtime; nothing in the audio code over-aligns.
+
+void* operator new(size_t bytes) {
+    trashapp::audio::AudioMemory::checkHeapCall("operator new", bytes);
+    void* memory = malloc(bytes != 0 ? bytes : 1);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new[](size_t bytes) {
+    trashapp::audio::AudioMemory::checkHeapCall("operator new[]", bytes);
+    void* memory = malloc(bytes != 0 ? bytes : 1);
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    trashapp::audio::AudioMemory::checkHeapCall("operator new", bytes);
+    return malloc(bytes != 0 ? bytes : 1);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    trashapp::audio::AudioMemory::checkHeapCall("operator new[]", bytes);
+    return malloc(bytes != 0 ? bytes : 1);
+}
+
+void operator delete(void* memory) noexcept {
+    if (memory != nullptr) trashapp::audio::AudioMemory::checkHeapCall("operator delete", 0);
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    if (memory != nullptr) trashapp::audio::AudioMemory::checkHeapCall("operator delete[]", 0);
+    free(memory);
+}
+
+void operator delete(void* memory, size_t bytes) noexcept {
+    if (memory != nullptr) trashapp::audio::AudioMemory::checkHeapCall("operator delete", bytes);
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t bytes) noexcept {
+    if (memory != nullptr) trashapp::audio::AudioMemory::checkHeapCall("operator delete[]", bytes);
+    free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    free(memory);
+}
+
+#endif
@@ -1,12 +1,16 @@
-#include &quot;AudioMixer.h&quot;
+#include "AudioMixer.h"
+#include <android/log.h>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 
+#define LOG_TAG "AudioMixer"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
 namespace trashapp {
 namespace audio {
 
-AudioMixer::AudioMixer() {
+AudioMixer::AudioMixer() : mActiveSounds(MAX_VOICES) {
 }
 
 AudioMixer::~AudioMixer() {
@@ -15,92 +19,89 @@ AudioMixer::~AudioMixer() {
 
 void AudioMixer::mix(float* output, int32_t numFrames) {
     // Clear output buffer
-    memset(output, 0, sizeof(float) * numFrames * 2); // Stereo
+    const int32_t numSamples = numFrames * mOutputChannels;
+    memset(output, 0, sizeof(float) * numSamples);
     
     // Mix all active sounds
-    for (auto&amp; sound : mActiveSounds) {
-        if (sound.active) {
-            mixSound(sound, output, numFrames);
-        }
+    mActiveSounds.forEach([&](SoundInstance& sound) {
+        mixSound(sound, output, numFrames);
+    });
+    
+    // Clipping protection on the sum
+    for (int32_t i = 0; i < numSamples; i++) {
+        output[i] = std::clamp(output[i], -1.0f, 1.0f);
+    }
+    
+    // Finished ones go back to the pool; nothing is freed
+    mActiveSounds.releaseIf([](const SoundInstance& sound) { return !sound.active; });
+}
+
+void AudioMixer::loadSound(int soundId, const float* samples, size_t sampleCount, int channels) {
+    if (channels != 1 && channels != 2) {
+        LOGE("Sound %d not loaded: %d channels, expected 1 or 2", soundId, channels);
+        return;
     }
+    // Playing instances of the old sound stop with it
+    stopSound(soundId);
+    LoadedSound& sound = mLoadedSounds[soundId];
+    sound.samples.assign(samples, samples + sampleCount);
+    sound.channels = channels;
 }
 
-void AudioMixer::playSound(int soundId, float volume, float pan) {
-    SoundInstance sound;
-    sound.soundId = soundId;
-    sound.volume = volume;
-    sound.pan = pan;
-    sound.active = true;
-    sound.currentPosition = 0;
+void AudioMixer::playSound(int soundId, float volume, float pan, float rate) {
+    if (!clampPlaybackRate(rate, rate)) return;
+    SoundInstance* sound = mActiveSounds.acquire();
+    if (sound == nullptr) return;
     
-    mActiveSounds.push_back(sound);
+    sound->soundId = soundId;
+    sound->volume = volume;
+    sound->pan = pan;
+    sound->active = true;
+    sound->position = 0.0;
+    sound->rate = rate;
 }
 
 void AudioMixer::stopSound(int soundId) {
-    mActiveSounds.erase(
-        std::remove_if(mActiveSounds.begin(), mActiveSounds.end(),
-            [soundId](const SoundInstance&amp; sound) {
-                return sound.soundId == soundId;
-            }),
-        mActiveSounds.end()
-    );
+    mActiveSounds.releaseIf([soundId](const SoundInstance& sound) {
+        return sound.soundId == soundId;
+    });
 }
 
 void AudioMixer::stopAll() {
     mActiveSounds.clear();
 }
 
-void AudioMixer::mixSound(SoundInstance&amp; sound, float* output, int32_t numFrames) {
+void AudioMixer::mixSound(SoundInstance& sound, float* output, int32_t numFrames) {
     auto it = mLoadedSounds.find(sound.soundId);
     if (it == mLoadedSounds.end()) {
         sound.active = false;
         return;
     }
     
-    const auto&amp; soundData = it->second;
-    int samplesToMix = std::min(
-        static_cast<int>(soundData.size()) - sound.currentPosition,
-        numFrames
-    );
+    const LoadedSound& soundData = it->second;
     
-    if (samplesToMix <= 0) {
-        sound.active = false;
-        return;
-    }
+    // Stereo panning: -1 (left) to 1 (right)
+    float leftGain = sound.volume * (sound.pan < 0 ? 1.0f : 1.0f - sound.pan);
+    float rightGain = sound.volume * (sound.pan > 0 ? 1.0f : 1.0f + sound.pan);
     
-    // Mix stereo samples
-    for (int i = 0; i < samplesToMix; i++) {
-        int sampleIndex = sound.currentPosition + i;
-        float left = soundData[sampleIndex * 2];
-        float right = soundData[sampleIndex * 2 + 1];
-        
-        // Apply volume and pan
-        float volume = sound.volume;
-        float pan = sound.pan;
-        
-        // Stereo panning: -1 (left) to 1 (right)
-        float leftGain = volume * (pan < 0 ? 1.0f : 1.0f - pan);
-        float rightGain = volume * (pan > 0 ? 1.0f : 1.0f + pan);
-        
-        // Mix into output (simple additive mixing with clipping protection)
-        int outIndex = i * 2;
-        output[outIndex] += left * leftGain;
-        output[outIndex + 1] += right * rightGain;
-        
-        // Soft clipping
-        output[outIndex] = std::clamp(output[outIndex], -1.0f, 1.0f);
-        output[outIndex + 1] = std::clamp(output[outIndex + 1], -1.0f, 1.0f);
-    }
+    // Simple additive mixing; mix() clips the sum
+    int frames = static_cast<int>(soundData.samples.size()) / soundData.channels;
+    int mixed = mixToBus(mInterpolation, soundData.samples.data(), frames, soundData.channels,
+                         sound.position, sound.rate, output, mOutputChannels, numFrames,
+                         leftGain, rightGain);
     
-    sound.currentPosition += samplesToMix;
+    if (mixed == 0) {
+        sound.active = false;
+    }
 }
 
 void AudioMixer::applyPan(float* samples, int32_t numFrames, float pan) {
     float leftGain = pan < 0 ? 1.0f : 1.0f - pan;
     float rightGain = pan > 0 ? 1.0f : 1.0f + pan;
+    if (mOutputChannels < 2) return;
     
     for (int i = 0; i < numFrames; i++) {
-        int index = i * 2;
+        int index = i * mOutputChannels;
         samples[index] *= leftGain;
         samples[index + 1] *= rightGain;
     }
@@ -0,0 +1,216 @@
+#include "RealtimeLog.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace trashapp {
+namespace audio {
+
+namespace {
+
+// Bounded multi-producer queue (Vyukov): each slot's sequence says whether
+// it is free for the producer at that position or holds a record for the
+// consumer, so producers only contend on one counter.
+struct Slot {
+    std::atomic<size_t> sequence;
+    RealtimeLogRecord record;
+};
+
+static_assert((RealtimeLog::CAPACITY & (RealtimeLog::CAPACITY - 1)) == 0,
+              "capacity must be a power of two");
+
+const size_t MASK = RealtimeLog::CAPACITY - 1;
+const size_t MAX_LINE = 512;
+const auto DRAIN_INTERVAL = std::chrono::milliseconds(20);
+
+struct Ring {
+    Ring() {
+        for (size_t i = 0; i < RealtimeLog::CAPACITY; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Slot slots[RealtimeLog::CAPACITY];
+    std::atomic<size_t> enqueuePos{0};
+    size_t dequeuePos = 0;              // under drainMutex
+    std::atomic<uint64_t> dropped{0};
+    uint64_t droppedReported = 0;       // under drainMutex
+};
+
+Ring sRing;
+std::mutex sDrainMutex;
+
+std::mutex sThreadMutex;
+std::thread sThread;
+std::atomic<bool> sRunning{false};
+
+bool isFlag(char c) {
+    return c == '-' || c == '+' || c == ' ' || c == '#' || c == '.' || (c >= '0' && c <= '9');
+}
+
+bool isLength(char c) {
+    return c == 'h' || c == 'l' || c == 'L' || c == 'q' || c == 'j' || c == 'z' || c == 't';
+}
+
+// Appends one argument under a conversion. The record kept the argument's
+// own type, so the spec is rebuilt to match it rather than trusting the
+// length modifiers written for the caller's types.
+int formatArg(char* out, size_t size, const char* flags, size_t flagLength,
+              char conversion, const RealtimeLogArg& arg) {
+    char spec[32];
+    if (flagLength > sizeof(spec) - 5) flagLength = sizeof(spec) - 5;
+    spec[0] = '%';
+    memcpy(spec + 1, flags, flagLength);
+    char* end = spec + 1 + flagLength;
+
+    switch (conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c': {
+            long long value = arg.type == RealtimeLogArg::Double ? static_cast<long long>(arg.d)
+                            : arg.type == RealtimeLogArg::Uint ? static_cast<long long>(arg.u)
+                            : static_cast<long long>(arg.i);
+            if (conversion == 'c') {
+                *end++ = 'c';
+                *end = '\0';
+                return snprintf(out, size, spec, static_cast<int>(value));
+            }
+            *end++ = 'l';
+            *end++ = 'l';
+            *end++ = conversion;
+            *end = '\0';
+            return snprintf(out, size, spec, value);
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            double value = arg.type == RealtimeLogArg::Double ? arg.d
+                         : arg.type == RealtimeLogArg::Uint ? static_cast<double>(arg.u)
+                         : static_cast<double>(arg.i);
+            *end++ = conversion;
+            *end = '\0';
+            return snprintf(out, size, spec, value);
+        }
+        case 's':
+            *end++ = 's';
+            *end = '\0';
+            return snprintf(out, size, spec,
+                            arg.type == RealtimeLogArg::String && arg.s != nullptr ? arg.s : "(null)");
+        case 'p':
+            *end++ = 'p';
+            *end = '\0';
+            return snprintf(out, size, spec, arg.p);
+        default:
+            return snprintf(out, size, "%%%c", conversion);
+    }
+}
+
+void formatRecord(const RealtimeLogRecord& record, char* out, size_t size) {
+    size_t length = 0;
+    int next = 0;
+    const char* p = record.format;
+    while (*p != '\0' && length + 1 < size) {
+        if (*p != '%') {
+            out[length++] = *p++;
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            out[length++] = *p++;
+            continue;
+        }
+        const char* flags = p;
+        while (isFlag(*p)) p++;
+        size_t flagLength = static_cast<size_t>(p - flags);
+        while (isLength(*p)) p++;
+        if (*p == '\0') break;
+        char conversion = *p++;
+        if (next >= record.argCount) {
+            // More conversions than arguments; keep the text readable
+            int written = snprintf(out + length, size - length, "<?>");
+            length += written > 0 ? static_cast<size_t>(written) : 0;
+        } else {
+            int written = formatArg(out + length, size - length, flags, flagLength,
+                                    conversion, record.args[next++]);
+            length += written > 0 ? static_cast<size_t>(written) : 0;
+        }
+        if (length >= size) length = size - 1;
+    }
+    out[length] = '\0';
+}
+
+void drainLoop() {
+    while (sRunning.load(std::memory_order_acquire)) {
+        RealtimeLog::flush();
+        std::this_thread::sleep_for(DRAIN_INTERVAL);
+    }
+}
+
+} // namespace
+
+bool RealtimeLog::push(const RealtimeLogRecord& record) {
+    size_t pos = sRing.enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = sRing.slots[pos & MASK];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (sRing.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            sRing.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = sRing.enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+size_t RealtimeLog::flush() {
+    std::lock_guard<std::mutex> lock(sDrainMutex);
+    char line[MAX_LINE];
+    size_t count = 0;
+    for (;;) {
+        size_t pos = sRing.dequeuePos;
+        Slot& slot = sRing.slots[pos & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) break;
+        RealtimeLogRecord record = slot.record;
+        slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+        sRing.dequeuePos = pos + 1;
+
+        formatRecord(record, line, sizeof(line));
+        __android_log_write(record.priority, record.tag, line);
+        count++;
+    }
+
+    uint64_t dropped = sRing.dropped.load(std::memory_order_relaxed);
+    if (dropped > sRing.droppedReported) {
+        __android_log_print(ANDROID_LOG_WARN, "RealtimeLog", "Dropped %llu records; ring full",
+                            static_cast<unsigned long long>(dropped - sRing.droppedReported));
+        sRing.droppedReported = dropped;
+    }
+    return count;
+}
+
+uint64_t RealtimeLog::getDropped() {
+    return sRing.dropped.load(std::memory_order_relaxed);
+}
+
+void RealtimeLog::start() {
+    std::lock_guard<std::mutex> lock(sThreadMutex);
+    if (sRunning.load(std::memory_order_acquire)) return;
+    sRunning.store(true, std::memory_order_release);
+    sThread = std::thread(drainLoop);
+}
+
+void RealtimeLog::stop() {
+    std::lock_guard<std::mutex> lock(sThreadMutex);
+    if (!sRunning.load(std::memory_order_acquire)) return;
+    sRunning.store(false, std::memory_order_release);
+    sThread.join();
+    flush();
+}
+
+} // namespace audio
+} // namespace trashapp
@@ -1,19 +1,25 @@
 #include "SoundManager.h"
+#include "RealtimeLog.h"
 #include <cmath>
 #include <random>
 #include <algorithm>
+#include <utility>
 
 #define LOG_TAG "SoundManager"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+// For paths that hold mMutex, which the audio callback takes
+#define RT_LOGD(...) TRASH_RT_LOG(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define RT_LOGE(...) TRASH_RT_LOG(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 namespace trashapp {
 namespace audio {
 
 const int SAMPLE_RATE = 48000;
-const int CHANNELS = 2;
+// The generated effects are mono; the mixer pans them onto the output
+const int SFX_CHANNELS = 1;
 
-SoundManager::SoundManager() {
+SoundManager::SoundManager() : mVoices(MAX_VOICES) {
     LOGI("SoundManager created");
 }
 
@@ -32,8 +38,7 @@ int SoundManager::loadSound(const std::string& filename, int soundId) {
     
     SoundData sound;
     sound.sampleRate = SAMPLE_RATE;
-    sound.channels = CHANNELS;
-    sound.currentFrame = 0;
+    sound.channels = SFX_CHANNELS;
     sound.loop = false;
     sound.volume = 1.0f;
     sound.pan = 0.0f;
@@ -73,8 +78,8 @@ int SoundManager::loadSound(const std::string& filename, int soundId) {
             break;
     }
     
-    mLoadedSounds[soundId] = sound;
-    LOGI("Loaded sound: %s (ID: %d, frames: %zu)", filename.c_str(), soundId, sound.samples.size());
+    LOGI("Loaded sound: %s (ID: %d, frames: %zu)", filename.c_str(), soundId, sound.samples.size() / sound.channels);
+    mLoadedSounds.emplace(soundId, std::move(sound));
     
     return soundId;
 }
@@ -82,36 +87,60 @@ int SoundManager::loadSound(const std::string& filename, int soundId) {
 void SoundManager::unloadSound(int soundId) {
     std::lock_guard<std::mutex> lock(mMutex);
     
+    mVoices.releaseIf([soundId](const Voice& voice) { return voice.soundId == soundId; });
     mLoadedSounds.erase(soundId);
-    mActiveSounds.erase(soundId);
     LOGI("Unloaded sound ID: %d", soundId);
 }
 
 void SoundManager::unloadAllSounds() {
     std::lock_guard<std::mutex> lock(mMutex);
     
+    mVoices.clear();
     mLoadedSounds.clear();
-    mActiveSounds.clear();
     LOGI("Unloaded all sounds");
 }
 
-void SoundManager::playSound(int soundId, float volume, float pan) {
+void SoundManager::playSound(int soundId, float volume, float pan, float rate) {
     std::lock_guard<std::mutex> lock(mMutex);
     
     auto it = mLoadedSounds.find(soundId);
     if (it == mLoadedSounds.end()) {
-        LOGE("Sound %d not loaded", soundId);
+        RT_LOGE("Sound %d not loaded", soundId);
         return;
     }
+    if (!clampPlaybackRate(rate, rate)) {
+        RT_LOGE("Sound %d not played: rate is not finite", soundId);
+        return;
+    }
+    
+    Voice* voice = startVoice(soundId, it->second);
+    if (voice == nullptr) return;
+    voice->volume = volume;
+    voice->pan = pan;
+    voice->rate = rate;
+    RT_LOGD("Playing sound ID: %d, volume: %f, pan: %f, rate: %f", soundId, volume, pan, rate);
+}
+
+void SoundManager::playSoundAt(int soundId, float volume, float pan, int64_t startFrame, float rate) {
+    std::lock_guard<std::mutex> lock(mMutex);
     
-    // Create a copy of the sound for playback
-    SoundData playbackSound = it->second;
-    playbackSound.currentFrame = 0;
-    playbackSound.volume = volume;
-    playbackSound.pan = pan;
+    auto it = mLoadedSounds.find(soundId);
+    if (it == mLoadedSounds.end()) {
+        RT_LOGE("Sound %d not loaded", soundId);
+        return;
+    }
+    if (!clampPlaybackRate(rate, rate)) {
+        RT_LOGE("Sound %d not scheduled: rate is not finite", soundId);
+        return;
+    }
     
-    mActiveSounds[soundId] = playbackSound;
-    LOGI("Playing sound ID: %d, volume: %f, pan: %f", soundId, volume, pan);
+    Voice* voice = startVoice(soundId, it->second);
+    if (voice == nullptr) return;
+    voice->startFrame = startFrame;
+    voice->volume = volume;
+    voice->pan = pan;
+    voice->rate = rate;
+    RT_LOGD("Scheduled sound ID: %d at frame %lld", soundId, static_cast<long long>(startFrame));
 }
 
 void SoundManager::playSound3D(int soundId, float x, float y, float z, float volume) {
@@ -119,109 +148,157 @@ void SoundManager::playSound3D(int soundId, float x, float y, float z, float vol
     
     auto it = mLoadedSounds.find(soundId);
     if (it == mLoadedSounds.end()) {
-        LOGE("Sound %d not loaded", soundId);
+        RT_LOGE("Sound %d not loaded", soundId);
         return;
     }
     
-    // Create a copy of the sound for 3D playback
-    SoundData playbackSound = it->second;
-    playbackSound.currentFrame = 0;
-    playbackSound.volume = volume;
-    playbackSound.position[0] = x;
-    playbackSound.position[1] = y;
-    playbackSound.position[2] = z;
+    Voice* voice = startVoice(soundId, it->second);
+    if (voice == nullptr) return;
+    voice->volume = volume;
+    voice->position[0] = x;
+    voice->position[1] = y;
+    voice->position[2] = z;
     
     // Calculate pan based on 3D position
     float distance = sqrt(x*x + y*y + z*z);
-    float pan = std::max(-1.0f, std::min(1.0f, x / (distance + 0.1f)));
-    playbackSound.pan = pan;
+    voice->pan = std::max(-1.0f, std::min(1.0f, x / (distance + 0.1f)));
+    RT_LOGD("Playing 3D sound ID: %d at (%.2f, %.2f, %.2f), volume: %f", soundId, x, y, z, volume);
+}
+
+Voice* SoundManager::startVoice(int soundId, const SoundData& sound) {
+    // A sound plays once at a time; playing it again restarts it
+    Voice* voice = nullptr;
+    mVoices.forEach([&](Voice& candidate) {
+        if (candidate.soundId == soundId) voice = &candidate;
+    });
+    if (voice == nullptr) {
+        voice = mVoices.acquire();
+    }
+    if (voice == nullptr) {
+        RT_LOGE("No free voice for sound %d", soundId);
+        return nullptr;
+    }
     
-    mActiveSounds[soundId] = playbackSound;
-    LOGI("Playing 3D sound ID: %d at (%.2f, %.2f, %.2f), volume: %f", soundId, x, y, z, volume);
+    voice->soundId = soundId;
+    voice->sound = &sound;
+    voice->cursor = 0.0;
+    voice->rate = 1.0f;
+    voice->startFrame = 0;
+    voice->loop = sound.loop;
+    voice->volume = 1.0f;
+    voice->pan = 0.0f;
+    voice->position[0] = 0.0f;
+    voice->position[1] = 0.0f;
+    voice->position[2] = 0.0f;
+    return voice;
+}
+
+bool SoundManager::setSoundVolume(int soundId, float volume) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    bool found = false;
+    mVoices.forEach([&](Voice& voice) {
+        if (voice.soundId == soundId) {
+            voice.volume = volume;
+            found = true;
+        }
+    });
+    return found;
+}
+
+void SoundManager::setInterpolation(Interpolation mode) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mInterpolation = mode;
+}
+
+void SoundManager::setOutputChannels(int channels) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOutputChannels = std::max(1, channels);
 }
 
 void SoundManager::stopSound(int soundId) {
     std::lock_guard<std::mutex> lock(mMutex);
-    mActiveSounds.erase(soundId);
-    LOGI("Stopped sound ID: %d", soundId);
+    mVoices.releaseIf([soundId](const Voice& voice) { return voice.soundId == soundId; });
+    RT_LOGD("Stopped sound ID: %d", soundId);
 }
 
 void SoundManager::stopAllSounds() {
     std::lock_guard<std::mutex> lock(mMutex);
-    mActiveSounds.clear();
-    LOGI("Stopped all sounds");
+    mVoices.clear();
+    RT_LOGD("Stopped all sounds");
 }
 
 void SoundManager::mixAudio(float* output, int numFrames) {
     std::lock_guard<std::mutex> lock(mMutex);
     
     // Clear output buffer
-    std::fill(output, output + numFrames * CHANNELS, 0.0f);
+    std::fill(output, output + numFrames * mOutputChannels, 0.0f);
+    
+    const int64_t blockStart = mFramePosition.load(std::memory_order_relaxed);
     
     // Mix all active sounds
-    for (auto& pair : mActiveSounds) {
-        SoundData& sound = pair.second;
+    mVoices.forEach([&](Voice& voice) {
+        const SoundData& sound = *voice.sound;
+        const int frames = static_cast<int>(sound.samples.size()) / sound.channels;
         
-        if (sound.currentFrame >= (int)sound.samples.size()) {
-            continue; // Sound has finished
+        if (voice.cursor >= frames) {
+            return; // Sound has finished
         }
         
-        int framesToMix = std::min(numFrames, (int)sound.samples.size() - sound.currentFrame);
+        // A scheduled voice waits for its block, then starts partway into it
+        int offset = 0;
+        if (voice.startFrame > blockStart) {
+            if (voice.startFrame >= blockStart + numFrames) return;
+            offset = static_cast<int>(voice.startFrame - blockStart);
+        }
         
-        for (int i = 0; i < framesToMix; i++) {
-            int sampleIndex = sound.currentFrame + i;
-            float sample = sound.samples[sampleIndex] * sound.volume;
-            
-            // Apply stereo panning
-            float leftPan = 1.0f;
-            float rightPan = 1.0f;
-            
-            if (sound.pan < 0.0f) {
-                leftPan = 1.0f + sound.pan;
-                rightPan = 1.0f;
-            } else if (sound.pan > 0.0f) {
-                leftPan = 1.0f;
-                rightPan = 1.0f - sound.pan;
-            }
-            
-            // Apply 3D distance attenuation
-            float distance = sqrt(sound.position[0]*sound.position[0] + 
-                                  sound.position[1]*sound.position[1] + 
-                                  sound.position[2]*sound.position[2]);
-            float attenuation = 1.0f / (1.0f + distance * 2.0f);
-            sample *= attenuation;
-            
-            // Mix to stereo output
-            int outputIndex = i * CHANNELS;
-            output[outputIndex] += sample * leftPan;
-            output[outputIndex + 1] += sample * rightPan;
+        // Stereo panning
+        float leftPan = 1.0f;
+        float rightPan = 1.0f;
+        if (voice.pan < 0.0f) {
+            leftPan = 1.0f + voice.pan;
+        } else if (voice.pan > 0.0f) {
+            rightPan = 1.0f - voice.pan;
         }
         
-        sound.currentFrame += framesToMix;
+        // 3D distance attenuation
+        float distance = sqrt(voice.position[0]*voice.position[0] + 
+                              voice.position[1]*voice.position[1] + 
+                              voice.position[2]*voice.position[2]);
+        float gain = voice.volume / (1.0f + distance * 2.0f);
+        float leftGain = gain * leftPan;
+        float rightGain = gain * rightPan;
         
-        // Remove finished sounds
-        if (sound.currentFrame >= (int)sound.samples.size()) {
-            if (!sound.loop) {
-                mActiveSounds.erase(pair.first);
-            } else {
-                sound.currentFrame = 0;
-            }
+        mixToBus(mInterpolation, sound.samples.data(), frames, sound.channels, voice.cursor, voice.rate,
+                 output + offset * mOutputChannels, mOutputChannels, numFrames - offset, leftGain, rightGain);
+        
+        if (voice.cursor >= frames && voice.loop) {
+            voice.cursor -= frames;
         }
-    }
+    });
+    
+    // Finished voices go back to the pool; nothing is freed
+    mVoices.releaseIf([](const Voice& voice) {
+        return voice.cursor >= static_cast<int>(voice.sound->samples.size()) / voice.sound->channels;
+    });
+    mFramePosition.store(blockStart + numFrames, std::memory_order_release);
 }
 
 bool SoundManager::isPlaying(int soundId) const {
-    return mActiveSounds.find(soundId) != mActiveSounds.end();
+    bool playing = false;
+    mVoices.forEach([&](const Voice& voice) {
+        if (voice.soundId == soundId) playing = true;
+    });
+    return playing;
 }
 
 int SoundManager::getActiveSoundCount() const {
-    return mActiveSounds.size();
+    return static_cast<int>(mVoices.size());
 }
 
 // Sound generation functions
 void SoundManager::generateTone(SoundData& sound, float frequency, float duration) {
     int numFrames = (int)(SAMPLE_RATE * duration);
-    sound.samples.resize(numFrames * CHANNELS);
+    sound.samples.resize(numFrames * SFX_CHANNELS);
     
     for (int i = 0; i < numFrames; i++) {
         float t = (float)i / SAMPLE_RATE;
@@ -236,14 +313,13 @@ void SoundManager::generateTone(SoundData& sound, float frequency, float duratio
         }
         sample *= envelope;
         
-        sound.samples[i * CHANNELS] = sample;
-        sound.samples[i * CHANNELS + 1] = sample;
+        sound.samples[i] = sample;
     }
 }
 
 void SoundManager::generateNoise(SoundData& sound, float duration) {
     int numFrames = (int)(SAMPLE_RATE * duration);
-    sound.samples.resize(numFrames * CHANNELS);
+    sound.samples.resize(numFrames * SFX_CHANNELS);
     
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -260,27 +336,25 @@ void SoundManager::generateNoise(SoundData& sound, float duration) {
         }
         
         float sample = dist(gen) * envelope * 0.5f;
-        sound.samples[i * CHANNELS] = sample;
-        sound.samples[i * CHANNELS + 1] = sample;
+        sound.samples[i] = sample;
     }
 }
 
 void SoundManager::generateClick(SoundData& sound) {
     int numFrames = (int)(SAMPLE_RATE * 0.05f); // 50ms
-    sound.samples.resize(numFrames * CHANNELS);
+    sound.samples.resize(numFrames * SFX_CHANNELS);
     
     for (int i = 0; i < numFrames; i++) {
         float t = (float)i / SAMPLE_RATE;
         float envelope = exp(-t * 50.0f); // Fast decay
         float sample = envelope * 0.7f;
-        sound.samples[i * CHANNELS] = sample;
-        sound.samples[i * CHANNELS + 1] = sample;
+        sound.samples[i] = sample;
     }
 }
 
 void SoundManager::generateWhoosh(SoundData& sound) {
     int numFrames = (int)(SAMPLE_RATE * 0.15f); // 150ms
-    sound.samples.resize(numFrames * CHANNELS);
+    sound.samples.resize(numFrames * SFX_CHANNELS);
     
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -290,8 +364,7 @@ void SoundManager::generateWhoosh(SoundData& sound) {
         float t = (float)i / SAMPLE_RATE;
         float envelope = sin(M_PI * t / 0.15f) * 0.5f;
         float sample = dist(gen) * envelope;
-        sound.samples[i * CHANNELS] = sample;
-        sound.samples[i * CHANNELS + 1] = sample;
+        sound.samples[i] = sample;
     }
 }
 
@@ -1,11 +1,11 @@
-#include &quot;SpatialAudio.h&quot;
+#include "SpatialAudio.h"
 #include <cmath>
 #include <algorithm>
 
 namespace trashapp {
 namespace audio {
 
-SpatialAudio::SpatialAudio() : mListenerPosition(0, 0, 0) {
+SpatialAudio::SpatialAudio() : mListenerPosition(0, 0, 0), mActiveSounds(MAX_SOURCES) {
 }
 
 SpatialAudio::~SpatialAudio() {
@@ -16,20 +16,20 @@ void SpatialAudio::setListenerPosition(float x, float y, float z) {
 }
 
 void SpatialAudio::playSound3D(int soundId, float x, float y, float z, float volume, float maxDistance) {
-    Sound3D sound;
-    sound.soundId = soundId;
-    sound.position = Vector3(x, y, z);
-    sound.volume = volume;
-    sound.maxDistance = maxDistance;
-    sound.active = true;
+    Sound3D* sound = mActiveSounds.acquire();
+    if (sound == nullptr) return;
     
-    mActiveSounds.push_back(sound);
+    sound->soundId = soundId;
+    sound->position = Vector3(x, y, z);
+    sound->volume = volume;
+    sound->maxDistance = maxDistance;
+    sound->active = true;
 }
 
 void SpatialAudio::process(float* audioData, int32_t numFrames) {
     // Process each 3D sound and apply spatial effects
-    for (auto&amp; sound : mActiveSounds) {
-        if (!sound.active) continue;
+    mActiveSounds.forEach([&](Sound3D& sound) {
+        if (!sound.active) return;
         
         float distance = mListenerPosition.distanceTo(sound.position);
         float attenuation = calculateAttenuation(sound.position, sound.volume, sound.maxDistance);
@@ -41,7 +41,7 @@ void SpatialAudio::process(float* audioData, int32_t numFrames) {
             float azimuth = std::atan2(dx, dz) * 180.0f / M_PI;
             
             // Apply spatial effects
-            for (int i = 0; i < numFrames * 2; i++) {
+            for (int i = 0; i < numFrames * mOutputChannels; i++) {
                 audioData[i] *= attenuation;
             }
             
@@ -49,25 +49,17 @@ void SpatialAudio::process(float* audioData, int32_t numFrames) {
         } else {
             sound.active = false;
         }
-    }
+    });
     
-    // Remove inactive sounds
-    mActiveSounds.erase(
-        std::remove_if(mActiveSounds.begin(), mActiveSounds.end(),
-            [](const Sound3D&amp; sound) { return !sound.active; }),
-        mActiveSounds.end()
-    );
+    // Inactive sounds go back to the pool; nothing is freed
+    mActiveSounds.releaseIf([](const Sound3D& sound) { return !sound.active; });
 }
 
 void SpatialAudio::stopSound3D(int soundId) {
-    mActiveSounds.erase(
-        std::remove_if(mActiveSounds.begin(), mActiveSounds.end(),
-            [soundId](const Sound3D&amp; sound) { return sound.soundId == soundId; }),
-        mActiveSounds.end()
-    );
+    mActiveSounds.releaseIf([soundId](const Sound3D& sound) { return sound.soundId == soundId; });
 }
 
-float SpatialAudio::calculateAttenuation(const Vector3&amp; soundPos, float volume, float maxDistance) {
+float SpatialAudio::calculateAttenuation(const Vector3& soundPos, float volume, float maxDistance) {
     float distance = mListenerPosition.distanceTo(soundPos);
     
     if (distance >= maxDistance) {
@@ -82,7 +74,8 @@ float SpatialAudio::calculateAttenuation(const Vector3&amp; soundPos, float volu
 
 void SpatialAudio::applyHRTF(float* audioData, int32_t numFrames, float azimuth) {
     // Simple HRTF approximation using interaural time difference (ITD)
-    // and interaural level difference (ILD)
+    // and interaural level difference (ILD), on the front left and right
+    if (mOutputChannels < 2) return;
     
     float itd = (azimuth / 180.0f) * 0.001f; // Max 1ms delay
     int delaySamples = static_cast<int>(itd * 48000.0f); // Assuming 48kHz
@@ -95,7 +88,7 @@ void SpatialAudio::applyHRTF(float* audioData, int32_t numFrames, float azimuth)
     float rightGain = 1.0f + (levelDiff < 0 ? levelDiff : 0);
     
     for (int i = 0; i < numFrames; i++) {
-        int index = i * 2;
+        int index = i * mOutputChannels;
         audioData[index] *= leftGain;
         audioData[index + 1] *= rightGain;
     }
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <oboe/Oboe.h>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <mutex>
+#include "AudioEvents.h"
+#include "AudioMemory.h"
 #include "AudioMixer.h"
 #include "SpatialAudio.h"
 #include "SoundManager.h"
@@ -11,6 +15,19 @@
 namespace trashapp {
 namespace audio {
 
+struct AudioMemoryReport {
+    AudioMemoryStats tags[static_cast<int>(AudioMemoryTag::Count)];
+    uint64_t realtimeViolations;
+};
+
+struct AudioSyncStats {
+    double outputLatencyMilliseconds;   // now until a frame written now is heard
+    bool timestampSupported;            // latency measured by the stream, not estimated
+    uint64_t scheduledSounds;
+    uint64_t lateSounds;                // asked for a time already mixed
+    double lastLateMilliseconds;        // how late the newest of those started
+};
+
 class AudioEngine {
 public:
     static AudioEngine& getInstance();
@@ -25,9 +42,20 @@ public:
     
     // Audio management
     void loadSound(const char* filename, int soundId);
-    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f);
+    // rate resamples the sound: 2 plays it an octave up in half the time.
+    // It is clamped to 1/16..16; a NaN or infinite rate plays nothing.
+    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f, float rate = 1.0f);
     void stopSound(int soundId);
     void setMasterVolume(float volume);
+    // How sounds playing at a rate other than 1 are interpolated
+    void setInterpolation(Interpolation mode);
+    
+    // Output channels to ask for when the stream next opens; stereo by
+    // default. The device may grant another count, which the mixers then
+    // follow: stereo sounds land on the front pair, a mono device gets a
+    // downmix. getOutputChannelCount is what the open stream was granted.
+    void setOutputChannelCount(int channels);
+    int getOutputChannelCount();
     
     // Music
     void loadMusic(const char* filename, int musicId);
@@ -40,10 +68,28 @@ public:
     void setListenerPosition(float x, float y, float z);
     void playSound3D(int soundId, float x, float y, float z, float volume = 1.0f);
     
+    // Game events: identical triggers close together share one voice; see
+    // AudioEventDispatcher. triggerEvent returns the haptic pulse to play in
+    // milliseconds, or -1 when the trigger merged into a playing voice.
+    void registerEvent(int eventId, const AudioEventConfig& config);
+    int triggerEvent(int eventId, float volume = 1.0f, float pan = 0.0f);
+    AudioEventStats getEventStats();
+    
+    // A/V sync. Times are CLOCK_MONOTONIC nanoseconds (System.nanoTime()),
+    // the clock the graphics engine predicts frame presentation on.
+    // getNextPresentTimeNanos is when a sound started now would be heard;
+    // playSoundAt starts one so that its first frame is heard at the time.
+    int64_t getNextPresentTimeNanos();
+    void playSoundAt(int soundId, float volume, float pan, int64_t presentTimeNanos);
+    AudioSyncStats getSyncStats();
+    
     // Effects
     void enableReverb(bool enable);
     void setReverbLevel(float level);
     
+    // Native memory held by each subsystem
+    AudioMemoryReport getMemoryStats();
+    
 private:
     AudioEngine();
     ~AudioEngine();
@@ -72,10 +118,15 @@ private:
     // Audio processing
     void processAudio(float* audioData, int32_t numFrames);
     
+    // A frame of the stream and when it is heard, from the stream's
+    // presentation timestamp or, before it has one, its latency estimate
+    bool getPresentationClock(int64_t& framePosition, int64_t& timeNanos);
+    
     // Components
     std::unique_ptr<AudioMixer> mMixer;
     std::unique_ptr<SpatialAudio> mSpatialAudio;
     std::unique_ptr<SoundManager> mSoundManager;
+    std::unique_ptr<AudioEventDispatcher> mEvents;
     
     // State
     bool mInitialized = false;
@@ -84,7 +135,17 @@ private:
     float mMasterVolume = 1.0f;
     float mMusicVolume = 0.6f;
     float mSfxVolume = 0.9f;
+    int mRequestedChannels = 2;
+    int mOutputChannels = 2;
     std::mutex mMutex;
+    
+    // Stream frames written minus frames the sound manager has mixed; the
+    // stream restarts its count when reopened
+    std::atomic<int64_t> mStreamFrameOffset{0};
+    std::atomic<bool> mTimestampSupported{false};
+    uint64_t mScheduledSounds = 0;
+    uint64_t mLateSounds = 0;
+    double mLastLateMilliseconds = 0.0;
 };
 
 } // namespace audio
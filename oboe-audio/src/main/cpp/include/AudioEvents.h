@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include "AudioMemory.h"
+#include "SoundManager.h"
+
+namespace trashapp {
+namespace audio {
+
+struct AudioEventConfig {
+    int soundId;
+    float volume;                   // gain of a single trigger
+    float windowMilliseconds;       // triggers this close merge into one voice
+    float maxPerSecond;             // voice starts per second; 0 = unlimited
+    float maxGain;                  // merged triggers raise the gain by sqrt(count), up to this
+    float timeJitterMilliseconds;   // random start delay, so repeats never phase-lock
+    float pitchVarianceSemitones;   // random pitch shift of each voice, up or down; 0 = none
+    int hapticMilliseconds;         // pulse to play with each voice started; 0 = none
+};
+
+struct AudioEventStats {
+    uint64_t triggers;
+    uint64_t voicesStarted;
+    uint64_t coalesced;             // merged into a voice already playing
+    uint64_t rateLimited;           // over the start rate: merged, or dropped once the voice ended
+};
+
+// Game events in front of the sound manager. A burst of identical triggers
+// (twenty coins landing in one frame, a deal, a shuffle) becomes one voice
+// whose gain grows with the burst, instead of twenty voices stacking into
+// clipping. Callers hold the audio engine's lock; not for the audio thread.
+class AudioEventDispatcher {
+public:
+    explicit AudioEventDispatcher(SoundManager& sounds);
+
+    // Events not registered play the sound of the same id with the defaults
+    void registerEvent(int eventId, const AudioEventConfig& config);
+    void unregisterEvent(int eventId);
+    static AudioEventConfig defaultConfig(int soundId);
+
+    // Returns the haptic pulse in milliseconds when the trigger started a
+    // voice (0 without haptics), or -1 when it merged into one playing or
+    // was dropped by the start rate
+    int trigger(int eventId, float volume, float pan, int64_t nowNanos);
+
+    AudioEventStats getStats() const { return mStats; }
+
+private:
+    struct EventState {
+        AudioEventConfig config;
+        int64_t windowEndNanos;
+        int64_t lastStartNanos;
+        int count;                  // triggers merged into the current voice
+        float volume;               // loudest of them
+    };
+
+    int startVoice(EventState& state, float volume, float pan, int64_t nowNanos);
+    void mergeIntoVoice(EventState& state, float volume);
+
+    SoundManager& mSounds;
+    AudioMap<int, EventState, AudioMemoryTag::Events> mEvents;
+    std::minstd_rand mRandom;
+    AudioEventStats mStats = {};
+};
+
+} // namespace audio
+} // namespace trashapp
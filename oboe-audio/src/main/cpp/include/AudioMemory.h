@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "TaggedMemory.h"
+
+// Debug builds check that the audio thread never reaches the heap; see
+// RealtimeScope. Define as 0 or 1 to override.
+#ifndef TRASH_AUDIO_REALTIME_CHECKS
+#ifdef NDEBUG
+#define TRASH_AUDIO_REALTIME_CHECKS 0
+#else
+#define TRASH_AUDIO_REALTIME_CHECKS 1
+#endif
+#endif
+
+namespace trashapp {
+namespace audio {
+
+// Subsystems whose containers report what they hold
+enum class AudioMemoryTag {
+    SoundManager,
+    Mixer,
+    Spatial,
+    Events,
+    Count
+};
+
+using AudioMemoryStats = TaggedMemoryStats;
+
+// Heap held by the audio subsystems, counted by TaggedMemory, plus the
+// audio thread's rule: no heap calls while mixing.
+class AudioMemory : public TaggedMemory<AudioMemoryTag> {
+public:
+    static const char* tagName(AudioMemoryTag tag);
+
+    // True inside a RealtimeScope on this thread
+    static bool isRealtimeThread();
+    // Heap calls caught inside a RealtimeScope; only counted with checks on
+    static uint64_t getRealtimeViolations();
+    // Called by the checked operator new and delete
+    static void checkHeapCall(const char* what, size_t bytes);
+
+private:
+    friend class RealtimeScope;
+
+    static std::atomic<uint64_t> sRealtimeViolations;
+};
+
+// Marks the current thread as real-time for its lifetime. The audio
+// callback opens one around all of its work. With TRASH_AUDIO_REALTIME_CHECKS
+// the library's global operator new and delete log and abort when called
+// inside one, so a stray allocation fails loudly in debug builds rather
+// than as an occasional glitch in release.
+class RealtimeScope {
+public:
+    RealtimeScope();
+    ~RealtimeScope();
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+
+private:
+    bool mOuter;
+};
+
+template <typename T, AudioMemoryTag Tag>
+using AudioAllocator = TaggedAllocator<T, Tag>;
+
+template <typename T, AudioMemoryTag Tag>
+using AudioVector = TaggedVector<T, Tag>;
+
+template <typename Key, typename Value, AudioMemoryTag Tag>
+using AudioMap = TaggedMap<Key, Value, Tag>;
+
+// A fixed number of slots allocated up front. Acquiring and releasing never
+// touch the heap, so the audio thread may do both; acquire() returns null
+// when every slot is taken.
+template <typename T, AudioMemoryTag Tag>
+class FixedPool {
+public:
+    explicit FixedPool(size_t capacity) : mSlots(capacity), mLive(capacity, 0) {
+        mFree.reserve(capacity);
+        for (size_t i = capacity; i-- > 0;) {
+            mFree.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    T* acquire() {
+        if (mFree.empty()) return nullptr;
+        uint32_t slot = mFree.back();
+        mFree.pop_back();
+        mLive[slot] = 1;
+        mSlots[slot] = T();
+        mCount++;
+        return &mSlots[slot];
+    }
+
+    void release(T* item) {
+        size_t slot = static_cast<size_t>(item - mSlots.data());
+        if (slot >= mSlots.size() || !mLive[slot]) return;
+        mLive[slot] = 0;
+        mFree.push_back(static_cast<uint32_t>(slot));
+        mCount--;
+    }
+
+    // Live items in slot order
+    template <typename Fn>
+    void forEach(Fn fn) {
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            if (mLive[i]) fn(mSlots[i]);
+        }
+    }
+
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            if (mLive[i]) fn(mSlots[i]);
+        }
+    }
+
+    template <typename Predicate>
+    void releaseIf(Predicate predicate) {
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            if (mLive[i] && predicate(mSlots[i])) release(&mSlots[i]);
+        }
+    }
+
+    void clear() {
+        releaseIf([](const T&) { return true; });
+    }
+
+    size_t size() const { return mCount; }
+    size_t capacity() const { return mSlots.size(); }
+
+private:
+    AudioVector<T, Tag> mSlots;
+    AudioVector<uint8_t, Tag> mLive;
+    AudioVector<uint32_t, Tag> mFree;
+    size_t mCount = 0;
+};
+
+} // namespace audio
+} // namespace trashapp
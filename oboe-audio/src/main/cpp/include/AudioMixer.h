@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <memory>
+#include "AudioMemory.h"
+#include "Resampler.h"
 
 namespace trashapp {
 namespace audio {
@@ -12,24 +15,43 @@ struct SoundInstance {
     float volume;
     float pan;
     bool active;
-    int currentPosition;
+    double position;    // fractional frame
+    float rate;         // frames read per frame mixed
 };
 
 class AudioMixer {
 public:
+    // Sounds playing at once; starting another past this is dropped
+    static const size_t MAX_VOICES = 64;
+    
     AudioMixer();
     ~AudioMixer();
     
+    // Never allocates, so safe on the audio thread
     void mix(float* output, int32_t numFrames);
-    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f);
+    // Interleaved frames of one or two channels; replaces any sound already
+    // under the id. Other channel counts are refused and load nothing.
+    void loadSound(int soundId, const float* samples, size_t sampleCount, int channels = 2);
+    // Rates are clamped as by clampPlaybackRate(); a non-finite one plays nothing
+    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f, float rate = 1.0f);
     void stopSound(int soundId);
     void stopAll();
+    void setInterpolation(Interpolation mode) { mInterpolation = mode; }
+    // Channels per frame of the buffer mix() fills; stereo by default
+    void setOutputChannels(int channels) { mOutputChannels = channels > 0 ? channels : 1; }
     
 private:
-    std::vector<SoundInstance> mActiveSounds;
-    std::map<int, std::vector<float>> mLoadedSounds;
+    struct LoadedSound {
+        AudioVector<float, AudioMemoryTag::Mixer> samples;
+        int channels;
+    };
+    
+    FixedPool<SoundInstance, AudioMemoryTag::Mixer> mActiveSounds;
+    AudioMap<int, LoadedSound, AudioMemoryTag::Mixer> mLoadedSounds;
+    Interpolation mInterpolation = Interpolation::Linear;
+    int mOutputChannels = 2;
     
-    void mixSound(SoundInstance&amp; sound, float* output, int32_t numFrames);
+    void mixSound(SoundInstance& sound, float* output, int32_t numFrames);
     void applyPan(float* samples, int32_t numFrames, float pan);
 };
 
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <android/log.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Lowest priority compiled in, as an android_LogPriority. Records below it
+// cost nothing: the call and its arguments are discarded at compile time.
+#ifndef TRASH_AUDIO_LOG_LEVEL
+#ifdef NDEBUG
+#define TRASH_AUDIO_LOG_LEVEL ANDROID_LOG_INFO
+#else
+#define TRASH_AUDIO_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+// Queues a record with the real-time log, filtered by TRASH_AUDIO_LOG_LEVEL
+#define TRASH_RT_LOG(priority, tag, ...)                                        \
+    do {                                                                        \
+        if constexpr ((priority) >= TRASH_AUDIO_LOG_LEVEL) {                    \
+            ::trashapp::audio::RealtimeLog::write((priority), (tag), __VA_ARGS__); \
+        }                                                                       \
+    } while (0)
+
+namespace trashapp {
+namespace audio {
+
+struct RealtimeLogArg {
+    enum Type : uint8_t { Int, Uint, Double, String, Pointer };
+
+    Type type;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char* s;
+        const void* p;
+    };
+};
+
+struct RealtimeLogRecord {
+    static const int MAX_ARGS = 6;
+
+    const char* tag;
+    const char* format;
+    int priority;
+    int argCount;
+    RealtimeLogArg args[MAX_ARGS];
+};
+
+// Logging for code that must not block or allocate: the audio callback and
+// anything holding a lock it takes. write() copies the format pointer and
+// the raw arguments into a fixed ring without locking; a background thread
+// formats them and hands them to logcat. When the ring is full the record
+// is dropped and counted rather than waiting.
+//
+// Formats and string arguments are stored as pointers, so both must outlive
+// the flush; string literals do. printf conversions are supported apart
+// from '*' widths.
+class RealtimeLog {
+public:
+    static const size_t CAPACITY = 1024;     // records, a power of two
+
+    template <typename... Args>
+    static void write(int priority, const char* tag, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= RealtimeLogRecord::MAX_ARGS, "too many log arguments");
+        RealtimeLogRecord record;
+        record.tag = tag;
+        record.format = format;
+        record.priority = priority;
+        record.argCount = 0;
+        (addArg(record, args), ...);
+        push(record);
+    }
+
+    // Starts or stops the thread that drains the ring; stop() flushes
+    // what is left. Without the thread, call flush() to drain.
+    static void start();
+    static void stop();
+
+    // Formats and writes every queued record; returns how many
+    static size_t flush();
+
+    // Records lost to a full ring, since launch
+    static uint64_t getDropped();
+
+private:
+    template <typename T>
+    static void addArg(RealtimeLogRecord& record, T value) {
+        RealtimeLogArg& arg = record.args[record.argCount++];
+        if constexpr (std::is_floating_point<T>::value) {
+            arg.type = RealtimeLogArg::Double;
+            arg.d = static_cast<double>(value);
+        } else if constexpr (std::is_enum<T>::value || std::is_same<T, bool>::value) {
+            arg.type = RealtimeLogArg::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+            arg.type = RealtimeLogArg::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral<T>::value) {
+            arg.type = RealtimeLogArg::Uint;
+            arg.u = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_convertible<T, const char*>::value) {
+            arg.type = RealtimeLogArg::String;
+            arg.s = value;
+        } else {
+            static_assert(std::is_pointer<T>::value, "unsupported log argument");
+            arg.type = RealtimeLogArg::Pointer;
+            arg.p = static_cast<const void*>(value);
+        }
+    }
+
+    static bool push(const RealtimeLogRecord& record);
+};
+
+} // namespace audio
+} // namespace trashapp
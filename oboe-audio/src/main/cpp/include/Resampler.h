@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace trashapp {
+namespace audio {
+
+// How a voice reads between sample frames when it plays at a rate other
+// than 1. Voices at rate 1 on a whole frame skip interpolation entirely.
+enum class Interpolation {
+    Linear,     // two taps; cheap, slightly dull on upward shifts
+    Cubic       // four-tap Catmull-Rom; cleaner highs for about twice the work
+};
+
+// Rate for a pitch shift in semitones
+inline float semitonesToRate(float semitones) {
+    return std::exp2(semitones / 12.0f);
+}
+
+// Playback rates a voice accepts: four octaves down to four up
+const float MIN_PLAYBACK_RATE = 1.0f / 16.0f;
+const float MAX_PLAYBACK_RATE = 16.0f;
+
+// Checks a rate before a voice starts with it. resample() needs a cursor
+// that moves forward, so NaN and infinities are refused and anything else,
+// zero and negative rates included, is clamped into the accepted range.
+inline bool clampPlaybackRate(float rate, float& clamped) {
+    if (!std::isfinite(rate)) return false;
+    clamped = std::clamp(rate, MIN_PLAYBACK_RATE, MAX_PLAYBACK_RATE);
+    return true;
+}
+
+namespace detail {
+
+// Frames past the end read as silence, so a voice fades into its end
+// rather than clicking; frames before the start repeat the first
+inline float tap(const float* data, int frames, int channels, int index, int channel) {
+    if (index >= frames) return 0.0f;
+    return data[std::max(index, 0) * channels + channel];
+}
+
+inline float linear(const float* data, int frames, int channels, int index, int channel, float t) {
+    float a = data[index * channels + channel];
+    float b = tap(data, frames, channels, index + 1, channel);
+    return a + (b - a) * t;
+}
+
+inline float cubic(const float* data, int frames, int channels, int index, int channel, float t) {
+    float p0 = tap(data, frames, channels, index - 1, channel);
+    float p1 = data[index * channels + channel];
+    float p2 = tap(data, frames, channels, index + 1, channel);
+    float p3 = tap(data, frames, channels, index + 2, channel);
+    float a = -0.5f * p0 + 1.5f * p1 - 1.5f * p2 + 0.5f * p3;
+    float b = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+    float c = 0.5f * (p2 - p0);
+    return ((a * t + b) * t + c) * t + p1;
+}
+
+// A mono source interpolates one channel and hands it out as both
+template <Interpolation Mode, bool Mono, typename Emit>
+inline int resampleFrames(const float* data, int frames, int channels, double& cursor, float rate,
+                          int count, Emit emit) {
+    const int stride = Mono ? 1 : channels;
+    if (cursor >= frames) return 0;
+
+    if (rate == 1.0f && cursor == std::floor(cursor)) {
+        int start = static_cast<int>(cursor);
+        int n = std::min(count, frames - start);
+        const float* frame = data + start * stride;
+        for (int i = 0; i < n; i++, frame += stride) {
+            emit(i, frame[0], Mono ? frame[0] : frame[1]);
+        }
+        cursor += n;
+        return n;
+    }
+
+    int i = 0;
+    double position = cursor;
+    for (; i < count && position < frames; i++, position += rate) {
+        int index = static_cast<int>(position);
+        float t = static_cast<float>(position - index);
+        float left, right;
+        if (Mode == Interpolation::Cubic) {
+            left = cubic(data, frames, stride, index, 0, t);
+            right = Mono ? left : cubic(data, frames, stride, index, 1, t);
+        } else {
+            left = linear(data, frames, stride, index, 0, t);
+            right = Mono ? left : linear(data, frames, stride, index, 1, t);
+        }
+        emit(i, left, right);
+    }
+    cursor = position;
+    return i;
+}
+
+} // namespace detail
+
+// Reads up to `count` output frames from an interleaved sound of `frames`
+// frames, starting at the fractional frame `cursor` and stepping by `rate`.
+// Each frame goes to emit(outputFrame, left, right): the first two channels
+// of the sound, or its one channel as both. Advances the cursor and returns
+// the frames emitted, fewer than count when the sound ends.
+template <Interpolation Mode, typename Emit>
+inline int resample(const float* data, int frames, int channels, double& cursor, float rate,
+                    int count, Emit emit) {
+    if (channels == 1) {
+        return detail::resampleFrames<Mode, true>(data, frames, 1, cursor, rate, count, emit);
+    }
+    return detail::resampleFrames<Mode, false>(data, frames, channels, cursor, rate, count, emit);
+}
+
+// resample() with the interpolation chosen at run time
+template <typename Emit>
+inline int resample(Interpolation mode, const float* data, int frames, int channels, double& cursor,
+                    float rate, int count, Emit emit) {
+    if (mode == Interpolation::Cubic) {
+        return resample<Interpolation::Cubic>(data, frames, channels, cursor, rate, count, emit);
+    }
+    return resample<Interpolation::Linear>(data, frames, channels, cursor, rate, count, emit);
+}
+
+// Adds a sound, panned by the two gains, to `count` frames of an
+// interleaved output bus of `busChannels`. It lands on the first two
+// channels, front left and right; a mono bus gets the average of the pair
+// and further channels of a wider bus are left as they are.
+inline int mixToBus(Interpolation mode, const float* data, int frames, int channels, double& cursor,
+                    float rate, float* bus, int busChannels, int count, float leftGain, float rightGain) {
+    if (busChannels == 2) {
+        return resample(mode, data, frames, channels, cursor, rate, count, [=](int i, float left, float right) {
+            bus[i * 2] += left * leftGain;
+            bus[i * 2 + 1] += right * rightGain;
+        });
+    }
+    if (busChannels == 1) {
+        float halfLeft = 0.5f * leftGain;
+        float halfRight = 0.5f * rightGain;
+        return resample(mode, data, frames, channels, cursor, rate, count, [=](int i, float left, float right) {
+            bus[i] += left * halfLeft + right * halfRight;
+        });
+    }
+    return resample(mode, data, frames, channels, cursor, rate, count, [=](int i, float left, float right) {
+        float* frame = bus + i * busChannels;
+        frame[0] += left * leftGain;
+        frame[1] += right * rightGain;
+    });
+}
+
+} // namespace audio
+} // namespace trashapp
@@ -1,29 +1,49 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <memory>
 #include <mutex>
 #include <android/log.h>
+#include "AudioMemory.h"
+#include "Resampler.h"
 
 namespace trashapp {
 namespace audio {
 
 // Sound data structure
 struct SoundData {
-    std::vector<float> samples;
+    AudioVector<float, AudioMemoryTag::SoundManager> samples;   // interleaved
     int sampleRate;
-    int channels;
-    int currentFrame;
+    int channels;           // 1 or 2
     bool loop;
     float volume;
     float pan;
     float position[3]; // 3D position
 };
 
+// A playing sound. Reads the loaded samples in place, so starting and
+// finishing one never copies or frees sample data.
+struct Voice {
+    int soundId;
+    const SoundData* sound;
+    double cursor;          // next frame to read; fractional when rate != 1
+    float rate;             // frames read per frame mixed; 2 = an octave up
+    int64_t startFrame;     // output frame it begins on; earlier = at once
+    bool loop;
+    float volume;
+    float pan;
+    float position[3];
+};
+
 class SoundManager {
 public:
+    // Sounds playing at once; starting another past this is dropped
+    static const size_t MAX_VOICES = 64;
+    
     SoundManager();
     ~SoundManager();
     
@@ -32,13 +52,29 @@ public:
     void unloadSound(int soundId);
     void unloadAllSounds();
     
-    // Playback control
-    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f);
+    // Playback control. Rates are clamped to MIN_PLAYBACK_RATE through
+    // MAX_PLAYBACK_RATE; a sound asked to play at a NaN or infinite rate
+    // does not start.
+    void playSound(int soundId, float volume = 1.0f, float pan = 0.0f, float rate = 1.0f);
     void playSound3D(int soundId, float x, float y, float z, float volume = 1.0f);
     void stopSound(int soundId);
     void stopAllSounds();
     
-    // Audio processing
+    // Starts a sound on an exact output frame, counted as by
+    // getFramePosition(), for sample-accurate scheduling. A frame already
+    // mixed starts it with the next block.
+    void playSoundAt(int soundId, float volume, float pan, int64_t startFrame, float rate = 1.0f);
+    // Changes the gain of a sound already playing; false when it is not
+    bool setSoundVolume(int soundId, float volume);
+    // Frames mixed so far; the first frame of the next block. Any thread.
+    int64_t getFramePosition() const { return mFramePosition.load(std::memory_order_acquire); }
+    
+    // How voices playing at a rate other than 1 read between frames
+    void setInterpolation(Interpolation mode);
+    // Channels per frame of the buffer mixAudio fills; stereo by default
+    void setOutputChannels(int channels);
+    
+    // Audio processing; never allocates, so safe on the audio thread
     void mixAudio(float* output, int numFrames);
     
     // Sound state
@@ -47,8 +83,14 @@ public:
     
 private:
     std::mutex mMutex;
-    std::unordered_map<int, SoundData> mLoadedSounds;
-    std::unordered_map<int, SoundData> mActiveSounds;
+    // Nodes never move, so voices keep pointing at their sound
+    AudioMap<int, SoundData, AudioMemoryTag::SoundManager> mLoadedSounds;
+    FixedPool<Voice, AudioMemoryTag::SoundManager> mVoices;
+    std::atomic<int64_t> mFramePosition{0};
+    Interpolation mInterpolation = Interpolation::Linear;
+    int mOutputChannels = 2;
+    
+    Voice* startVoice(int soundId, const SoundData& sound);
     
     void generateTone(SoundData& sound, float frequency, float duration);
     void generateNoise(SoundData& sound, float duration);
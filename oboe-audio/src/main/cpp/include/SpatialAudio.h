@@ -3,6 +3,7 @@
 #include <vector>
 #include <map>
 #include <cmath>
+#include "AudioMemory.h"
 
 namespace trashapp {
 namespace audio {
@@ -12,7 +13,7 @@ struct Vector3 {
     
     Vector3(float x = 0, float y = 0, float z = 0) : x(x), y(y), z(z) {}
     
-    float distanceTo(const Vector3&amp; other) const {
+    float distanceTo(const Vector3& other) const {
         float dx = x - other.x;
         float dy = y - other.y;
         float dz = z - other.z;
@@ -30,19 +31,26 @@ struct Sound3D {
 
 class SpatialAudio {
 public:
+    // Sources playing at once; starting another past this is dropped
+    static const size_t MAX_SOURCES = 64;
+    
     SpatialAudio();
     ~SpatialAudio();
     
     void setListenerPosition(float x, float y, float z);
     void playSound3D(int soundId, float x, float y, float z, float volume, float maxDistance = 100.0f);
+    // Never allocates, so safe on the audio thread
     void process(float* audioData, int32_t numFrames);
+    // Channels per frame of the buffers process() takes; stereo by default
+    void setOutputChannels(int channels) { mOutputChannels = channels > 0 ? channels : 1; }
     void stopSound3D(int soundId);
     
 private:
     Vector3 mListenerPosition;
-    std::vector<Sound3D> mActiveSounds;
+    FixedPool<Sound3D, AudioMemoryTag::Spatial> mActiveSounds;
+    int mOutputChannels = 2;
     
-    float calculateAttenuation(const Vector3&amp; soundPos, float volume, float maxDistance);
+    float calculateAttenuation(const Vector3& soundPos, float volume, float maxDistance);
     void applyHRTF(float* audioData, int32_t numFrames, float azimuth);
 };
 
@@ -1,12 +1,12 @@
-#include &lt;jni.h&gt;
-#include &lt;android/log.h&gt;
-#include &quot;AudioEngine.h&quot;
+#include <jni.h>
+#include <android/log.h>
+#include "AudioEngine.h"
 
-#define TAG &quot;AudioJNI&quot;
+#define TAG "AudioJNI"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
-extern &quot;C&quot; {
+extern "C" {
 
 JNIEXPORT void JNICALL
 Java_com_trashapp_oboe_AudioEngine_nativeInitialize(
@@ -15,8 +15,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeInitialize(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().initialize();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeInitialize: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeInitialize: %s", e.what());
     }
 }
 
@@ -27,8 +27,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeStart(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().start();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeStart: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeStart: %s", e.what());
     }
 }
 
@@ -39,8 +39,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeStop(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().stop();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeStop: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeStop: %s", e.what());
     }
 }
 
@@ -50,12 +50,53 @@ Java_com_trashapp_oboe_AudioEngine_nativePlaySound(
     jobject thiz,
     jint soundId,
     jfloat volume,
-    jfloat pan
+    jfloat pan,
+    jfloat rate
 ) {
     try {
-        trashapp::audio::AudioEngine::getInstance().playSound(soundId, volume, pan);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativePlaySound: %s&quot;, e.what());
+        trashapp::audio::AudioEngine::getInstance().playSound(soundId, volume, pan, rate);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativePlaySound: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeSetOutputChannelCount(
+    JNIEnv* env,
+    jobject thiz,
+    jint channels
+) {
+    try {
+        trashapp::audio::AudioEngine::getInstance().setOutputChannelCount(channels);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetOutputChannelCount: %s", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeGetOutputChannelCount(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        return trashapp::audio::AudioEngine::getInstance().getOutputChannelCount();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetOutputChannelCount: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeSetInterpolation(
+    JNIEnv* env,
+    jobject thiz,
+    jint mode
+) {
+    try {
+        trashapp::audio::AudioEngine::getInstance().setInterpolation(
+            mode == 1 ? trashapp::audio::Interpolation::Cubic : trashapp::audio::Interpolation::Linear);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetInterpolation: %s", e.what());
     }
 }
 
@@ -71,8 +112,8 @@ Java_com_trashapp_oboe_AudioEngine_nativePlaySound3D(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().playSound3D(soundId, x, y, z, volume);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativePlaySound3D: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativePlaySound3D: %s", e.what());
     }
 }
 
@@ -86,8 +127,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeSetListenerPosition(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().setListenerPosition(x, y, z);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeSetListenerPosition: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetListenerPosition: %s", e.what());
     }
 }
 
@@ -99,8 +140,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeSetMasterVolume(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().setMasterVolume(volume);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeSetMasterVolume: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetMasterVolume: %s", e.what());
     }
 }
 
@@ -112,11 +153,11 @@ Java_com_trashapp_oboe_AudioEngine_nativePlayMusic(
     jboolean loop
 ) {
     try {
-        const char* filenameChars = env-&gt;GetStringUTFChars(filename, nullptr);
+        const char* filenameChars = env->GetStringUTFChars(filename, nullptr);
         trashapp::audio::AudioEngine::getInstance().playMusic(filenameChars, loop);
-        env-&gt;ReleaseStringUTFChars(filename, filenameChars);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativePlayMusic: %s&quot;, e.what());
+        env->ReleaseStringUTFChars(filename, filenameChars);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativePlayMusic: %s", e.what());
     }
 }
 
@@ -127,8 +168,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeStopMusic(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().stopMusic();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeStopMusic: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeStopMusic: %s", e.what());
     }
 }
 
@@ -140,8 +181,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeSetMusicVolume(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().setMusicVolume(volume);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeSetMusicVolume: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetMusicVolume: %s", e.what());
     }
 }
 
@@ -153,8 +194,8 @@ Java_com_trashapp_oboe_AudioEngine_nativeEnableReverb(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().enableReverb(enable);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeEnableReverb: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeEnableReverb: %s", e.what());
     }
 }
 
@@ -166,9 +207,161 @@ Java_com_trashapp_oboe_AudioEngine_nativeSetReverbLevel(
 ) {
     try {
         trashapp::audio::AudioEngine::getInstance().setReverbLevel(level);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeSetReverbLevel: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetReverbLevel: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeRegisterEvent(
+    JNIEnv* env,
+    jobject thiz,
+    jint eventId,
+    jint soundId,
+    jfloat volume,
+    jfloat windowMilliseconds,
+    jfloat maxPerSecond,
+    jfloat maxGain,
+    jfloat timeJitterMilliseconds,
+    jfloat pitchVarianceSemitones,
+    jint hapticMilliseconds
+) {
+    try {
+        trashapp::audio::AudioEventConfig config = {};
+        config.soundId = soundId;
+        config.volume = volume;
+        config.windowMilliseconds = windowMilliseconds;
+        config.maxPerSecond = maxPerSecond;
+        config.maxGain = maxGain;
+        config.timeJitterMilliseconds = timeJitterMilliseconds;
+        config.pitchVarianceSemitones = pitchVarianceSemitones;
+        config.hapticMilliseconds = hapticMilliseconds;
+        trashapp::audio::AudioEngine::getInstance().registerEvent(eventId, config);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRegisterEvent: %s", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeTriggerEvent(
+    JNIEnv* env,
+    jobject thiz,
+    jint eventId,
+    jfloat volume,
+    jfloat pan
+) {
+    try {
+        return trashapp::audio::AudioEngine::getInstance().triggerEvent(eventId, volume, pan);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeTriggerEvent: %s", e.what());
+    }
+    return -1;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeGetEventStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::audio::AudioEngine::getInstance().getEventStats();
+        jdouble values[4] = {
+            static_cast<jdouble>(stats.triggers),
+            static_cast<jdouble>(stats.voicesStarted),
+            static_cast<jdouble>(stats.coalesced),
+            static_cast<jdouble>(stats.rateLimited)
+        };
+        jdoubleArray result = env->NewDoubleArray(4);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 4, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetEventStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeGetNextPresentTimeNanos(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        return static_cast<jlong>(trashapp::audio::AudioEngine::getInstance().getNextPresentTimeNanos());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetNextPresentTimeNanos: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativePlaySoundAt(
+    JNIEnv* env,
+    jobject thiz,
+    jint soundId,
+    jfloat volume,
+    jfloat pan,
+    jlong presentTimeNanos
+) {
+    try {
+        trashapp::audio::AudioEngine::getInstance().playSoundAt(soundId, volume, pan, presentTimeNanos);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativePlaySoundAt: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeGetSyncStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::audio::AudioEngine::getInstance().getSyncStats();
+        jdouble values[5] = {
+            stats.outputLatencyMilliseconds,
+            stats.timestampSupported ? 1.0 : 0.0,
+            static_cast<jdouble>(stats.scheduledSounds),
+            static_cast<jdouble>(stats.lateSounds),
+            stats.lastLateMilliseconds
+        };
+        jdoubleArray result = env->NewDoubleArray(5);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 5, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetSyncStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_oboe_AudioEngine_nativeGetMemoryStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto report = trashapp::audio::AudioEngine::getInstance().getMemoryStats();
+        // Bytes, peak bytes and allocations per tag, then the violation count
+        const int tagCount = static_cast<int>(trashapp::audio::AudioMemoryTag::Count);
+        const int count = tagCount * 3 + 1;
+        jdouble values[count];
+        for (int tag = 0; tag < tagCount; tag++) {
+            values[tag * 3] = static_cast<jdouble>(report.tags[tag].bytes);
+            values[tag * 3 + 1] = static_cast<jdouble>(report.tags[tag].peakBytes);
+            values[tag * 3 + 2] = static_cast<jdouble>(report.tags[tag].allocations);
+        }
+        values[tagCount * 3] = static_cast<jdouble>(report.realtimeViolations);
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetMemoryStats: %s", e.what());
     }
+    return nullptr;
 }
 
-} // extern &quot;C&quot;
\ No newline at end of file
+} // extern "C"
\ No newline at end of file
@@ -1,15 +1,50 @@
 package com.trashapp.oboe;
 
+import android.os.VibrationEffect;
+import android.os.Vibrator;
+
 /**
  * Java wrapper for Oboe Audio Engine
  * Provides JNI bridge to native C++ audio engine
  */
 public class AudioEngine {
     static {
-        System.loadLibrary(&quot;trashaudio&quot;);
+        System.loadLibrary("trashaudio");
     }
     
+    // getMemoryStats(): MEMORY_STATS_PER_TAG values per tag, at
+    // tag * MEMORY_STATS_PER_TAG + MEMORY_STAT_*, then the violation count
+    public static final int MEMORY_TAG_SOUND_MANAGER = 0;
+    public static final int MEMORY_TAG_MIXER = 1;
+    public static final int MEMORY_TAG_SPATIAL = 2;
+    public static final int MEMORY_TAG_EVENTS = 3;
+    public static final int MEMORY_TAG_COUNT = 4;
+    public static final int MEMORY_STAT_BYTES = 0;
+    public static final int MEMORY_STAT_PEAK_BYTES = 1;
+    public static final int MEMORY_STAT_ALLOCATIONS = 2;
+    public static final int MEMORY_STATS_PER_TAG = 3;
+    // Heap calls caught on the audio thread; debug builds abort on the first
+    public static final int MEMORY_REALTIME_VIOLATIONS = MEMORY_TAG_COUNT * MEMORY_STATS_PER_TAG;
+    
+    // Modes for setInterpolation()
+    public static final int INTERPOLATION_LINEAR = 0;
+    public static final int INTERPOLATION_CUBIC = 1;
+    
+    // Indices into getEventStats()
+    public static final int EVENT_STAT_TRIGGERS = 0;
+    public static final int EVENT_STAT_VOICES_STARTED = 1;
+    public static final int EVENT_STAT_COALESCED = 2;
+    public static final int EVENT_STAT_RATE_LIMITED = 3;
+    
+    // Indices into getSyncStats()
+    public static final int SYNC_OUTPUT_LATENCY_MS = 0;
+    public static final int SYNC_TIMESTAMP_SUPPORTED = 1;
+    public static final int SYNC_SCHEDULED_SOUNDS = 2;
+    public static final int SYNC_LATE_SOUNDS = 3;
+    public static final int SYNC_LAST_LATE_MS = 4;
+    
     private static AudioEngine instance;
+    private Vibrator vibrator;
     
     private AudioEngine() {}
     
@@ -26,10 +61,25 @@ public class AudioEngine {
     public native void nativeStop();
     
     // Sound playback
-    public native void nativePlaySound(int soundId, float volume, float pan);
+    public native void nativePlaySound(int soundId, float volume, float pan, float rate);
+    public native void nativeSetInterpolation(int mode);
+    public native void nativeSetOutputChannelCount(int channels);
+    public native int nativeGetOutputChannelCount();
     public native void nativePlaySound3D(int soundId, float x, float y, float z, float volume);
     public native void nativeSetListenerPosition(float x, float y, float z);
     
+    // Game events
+    public native void nativeRegisterEvent(int eventId, int soundId, float volume, float windowMilliseconds,
+                                           float maxPerSecond, float maxGain, float timeJitterMilliseconds,
+                                           float pitchVarianceSemitones, int hapticMilliseconds);
+    public native int nativeTriggerEvent(int eventId, float volume, float pan);
+    public native double[] nativeGetEventStats();
+    
+    // A/V sync
+    public native long nativeGetNextPresentTimeNanos();
+    public native void nativePlaySoundAt(int soundId, float volume, float pan, long presentTimeNanos);
+    public native double[] nativeGetSyncStats();
+    
     // Volume control
     public native void nativeSetMasterVolume(float volume);
     public native void nativePlayMusic(String filename, boolean loop);
@@ -40,6 +90,9 @@ public class AudioEngine {
     public native void nativeEnableReverb(boolean enable);
     public native void nativeSetReverbLevel(float level);
     
+    // Diagnostics
+    public native double[] nativeGetMemoryStats();
+    
     // Java wrapper methods for convenience
     public void initialize() {
         nativeInitialize();
@@ -62,7 +115,37 @@ public class AudioEngine {
     }
     
     public void playSound(int soundId, float volume, float pan) {
-        nativePlaySound(soundId, volume, pan);
+        nativePlaySound(soundId, volume, pan, 1.0f);
+    }
+    
+    /**
+     * Plays a sound resampled by rate: 2 is an octave up and half as long,
+     * 0.5 an octave down. Rates are clamped to 1/16..16, and a NaN or
+     * infinite rate plays nothing
+     */
+    public void playSound(int soundId, float volume, float pan, float rate) {
+        nativePlaySound(soundId, volume, pan, rate);
+    }
+    
+    /**
+     * INTERPOLATION_LINEAR (the default) or INTERPOLATION_CUBIC, which keeps
+     * more of the highs on sounds played off their recorded rate
+     */
+    public void setInterpolation(int mode) {
+        nativeSetInterpolation(mode);
+    }
+    
+    /**
+     * Output channels to ask the device for; stereo unless set. Takes effect
+     * at the next initialize(), and the device may grant another count
+     */
+    public void setOutputChannelCount(int channels) {
+        nativeSetOutputChannelCount(channels);
+    }
+    
+    /** Channels the open output stream was granted */
+    public int getOutputChannelCount() {
+        return nativeGetOutputChannelCount();
     }
     
     public void playSound3D(int soundId, float x, float y, float z) {
@@ -77,6 +160,77 @@ public class AudioEngine {
         nativeSetListenerPosition(x, y, z);
     }
     
+    /**
+     * Configures a game event. Triggers within windowMilliseconds of the
+     * first share its voice, which gets louder by the square root of their
+     * count up to maxGain; maxPerSecond caps new voices (0 = no cap). Each
+     * voice starts up to timeJitterMilliseconds late and up to
+     * pitchVarianceSemitones off pitch so repeats never sound identical, and
+     * pulses the vibrator for hapticMilliseconds (0 = none).
+     * Unregistered event ids play the sound of the same id with a 35 ms
+     * window and no haptics.
+     */
+    public void registerEvent(int eventId, int soundId, float volume, float windowMilliseconds,
+                              float maxPerSecond, float maxGain, float timeJitterMilliseconds,
+                              float pitchVarianceSemitones, int hapticMilliseconds) {
+        nativeRegisterEvent(eventId, soundId, volume, windowMilliseconds, maxPerSecond, maxGain,
+                            timeJitterMilliseconds, pitchVarianceSemitones, hapticMilliseconds);
+    }
+    
+    /** Vibrator for event haptics; null turns them off */
+    public void setVibrator(Vibrator vibrator) {
+        this.vibrator = vibrator;
+    }
+    
+    public boolean triggerEvent(int eventId) {
+        return triggerEvent(eventId, 1.0f, 0.0f);
+    }
+    
+    /**
+     * Plays a game event; returns false when it merged into a voice already
+     * playing for the same event, or came faster than its maxPerSecond, in
+     * which case no haptic pulse fires either
+     */
+    public boolean triggerEvent(int eventId, float volume, float pan) {
+        int hapticMilliseconds = nativeTriggerEvent(eventId, volume, pan);
+        if (hapticMilliseconds < 0) {
+            return false;
+        }
+        if (hapticMilliseconds > 0 && vibrator != null) {
+            vibrator.vibrate(VibrationEffect.createOneShot(hapticMilliseconds,
+                                                           VibrationEffect.DEFAULT_AMPLITUDE));
+        }
+        return true;
+    }
+    
+    /** Indexed by the EVENT_STAT_* constants */
+    public double[] getEventStats() {
+        return nativeGetEventStats();
+    }
+    
+    /**
+     * When a sound started now would be heard, on the System.nanoTime()
+     * clock. GraphicsEngine.getNextPresentTimeNanos() is on the same clock.
+     */
+    public long getNextPresentTimeNanos() {
+        return nativeGetNextPresentTimeNanos();
+    }
+    
+    /**
+     * Starts a sound so that its first sample is heard at presentTimeNanos
+     * (System.nanoTime() clock); a time already past plays it at once
+     */
+    public void playSoundAt(int soundId, float volume, float pan, long presentTimeNanos) {
+        nativePlaySoundAt(soundId, volume, pan, presentTimeNanos);
+    }
+    
+    /**
+     * Output latency and scheduling counts, indexed by SYNC_*
+     */
+    public double[] getSyncStats() {
+        return nativeGetSyncStats();
+    }
+    
     public void setMasterVolume(float volume) {
         nativeSetMasterVolume(volume);
     }
@@ -104,4 +258,12 @@ public class AudioEngine {
     public void setReverbLevel(float level) {
         nativeSetReverbLevel(level);
     }
+    
+    /**
+     * Native memory held by the sound manager, mixer and spatial audio,
+     * laid out as described at MEMORY_TAG_SOUND_MANAGER
+     */
+    public double[] getMemoryStats() {
+        return nativeGetMemoryStats();
+    }
 }
\ No newline at end of file
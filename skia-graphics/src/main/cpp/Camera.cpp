@@ -0,0 +1,125 @@
+#include "Camera.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define TAG "Camera"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// std140 image of the Camera block
+struct CameraBlock {
+    float projection[16];
+    float viewport[4];
+};
+static_assert(sizeof(CameraBlock) == 80, "Camera block must match std140 layout");
+
+Camera::Camera() {
+    setViewport(static_cast<int>(VIRTUAL_WIDTH), static_cast<int>(VIRTUAL_HEIGHT), 1.0f);
+}
+
+Camera::~Camera() {
+}
+
+void Camera::initialize() {
+    if (mBuffer == 0) {
+        glGenBuffers(1, &mBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    mDirty = true;
+}
+
+void Camera::release() {
+    if (mBuffer != 0) {
+        glDeleteBuffers(1, &mBuffer);
+        mBuffer = 0;
+    }
+}
+
+void Camera::abandon() {
+    mBuffer = 0;
+}
+
+void Camera::setViewport(int outputWidth, int outputHeight, float renderScale) {
+    outputWidth = std::max(outputWidth, 1);
+    outputHeight = std::max(outputHeight, 1);
+    renderScale = std::max(0.1f, std::min(renderScale, 1.0f));
+
+    int renderWidth = std::max(1, static_cast<int>(std::lround(outputWidth * renderScale)));
+    int renderHeight = std::max(1, static_cast<int>(std::lround(outputHeight * renderScale)));
+    if (outputWidth == mState.outputWidth && outputHeight == mState.outputHeight &&
+        renderWidth == mState.renderWidth && renderHeight == mState.renderHeight) {
+        return;
+    }
+
+    mState.outputWidth = outputWidth;
+    mState.outputHeight = outputHeight;
+    mState.renderWidth = renderWidth;
+    mState.renderHeight = renderHeight;
+    mState.renderScale = renderScale;
+
+    // Extend the longer axis, centred, so the layout space is never cropped
+    float aspect = static_cast<float>(outputWidth) / outputHeight;
+    if (aspect >= VIRTUAL_WIDTH / VIRTUAL_HEIGHT) {
+        mState.visibleHeight = VIRTUAL_HEIGHT;
+        mState.visibleWidth = VIRTUAL_HEIGHT * aspect;
+    } else {
+        mState.visibleWidth = VIRTUAL_WIDTH;
+        mState.visibleHeight = VIRTUAL_WIDTH / aspect;
+    }
+    mState.visibleLeft = (VIRTUAL_WIDTH - mState.visibleWidth) * 0.5f;
+    mState.visibleBottom = (VIRTUAL_HEIGHT - mState.visibleHeight) * 0.5f;
+    mState.pixelsPerUnit = renderHeight / mState.visibleHeight;
+
+    updateProjection();
+    mDirty = true;
+}
+
+void Camera::updateProjection() {
+    // Orthographic, column major: visible rectangle to clip space
+    float left = mState.visibleLeft;
+    float bottom = mState.visibleBottom;
+    float width = mState.visibleWidth;
+    float height = mState.visibleHeight;
+
+    memset(mProjection, 0, sizeof(mProjection));
+    mProjection[0] = 2.0f / width;
+    mProjection[5] = 2.0f / height;
+    mProjection[10] = -1.0f;
+    mProjection[12] = -1.0f - 2.0f * left / width;
+    mProjection[13] = -1.0f - 2.0f * bottom / height;
+    mProjection[15] = 1.0f;
+}
+
+void Camera::bind() {
+    if (mBuffer == 0) return;
+
+    if (mDirty) {
+        CameraBlock block;
+        memcpy(block.projection, mProjection, sizeof(block.projection));
+        block.viewport[0] = static_cast<float>(mState.renderWidth);
+        block.viewport[1] = static_cast<float>(mState.renderHeight);
+        block.viewport[2] = mState.pixelsPerUnit;
+        block.viewport[3] = mState.renderScale;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, mBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        mDirty = false;
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, BLOCK_BINDING, mBuffer);
+}
+
+void Camera::screenToWorld(float screenX, float screenY, float& worldX, float& worldY) const {
+    worldX = mState.visibleLeft + screenX / mState.outputWidth * mState.visibleWidth;
+    worldY = mState.visibleBottom + (1.0f - screenY / mState.outputHeight) * mState.visibleHeight;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,480 @@
+#include "CardAtlas.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+#define TAG "CardAtlas"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// Suit order matches com.trashapp.gcms.models.Suit
+enum SuitIndex { SPADES = 0, HEARTS = 1, CLUBS = 2, DIAMONDS = 3 };
+
+static const uint8_t PARCHMENT[4] = { 245, 222, 179, 255 };
+static const uint8_t PARCHMENT_BORDER[4] = { 92, 60, 30, 255 };
+static const uint8_t SUIT_RED[4] = { 170, 20, 20, 255 };
+static const uint8_t SUIT_BLACK[4] = { 30, 25, 20, 255 };
+static const uint8_t BACK_FILL[4] = { 139, 0, 0, 255 };
+static const uint8_t BACK_PATTERN[4] = { 178, 34, 34, 255 };
+static const uint8_t BACK_BORDER[4] = { 200, 170, 90, 255 };
+static const uint8_t JOKER_GOLD[4] = { 190, 140, 20, 255 };
+
+static const char* CACHE_FILE = "card_atlas.rgba";
+static const char CACHE_MAGIC[4] = { 'T', 'C', 'A', 'T' };
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+// 5x7 bitmap glyphs, one byte per row, bit 4 is the leftmost column
+struct Glyph {
+    char character;
+    uint8_t rows[7];
+};
+
+static const Glyph FONT[] = {
+    { 'A', { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 } },
+    { '0', { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+    { '1', { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+    { '2', { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+    { '3', { 0x1E, 0x01, 0x01, 0x0E, 0x01, 0x01, 0x1E } },
+    { '4', { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+    { '5', { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+    { '6', { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+    { '7', { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+    { '8', { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+    { '9', { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+    { 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C } },
+    { 'Q', { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D } },
+    { 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+    { 'O', { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E } },
+    { 'E', { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+    { 'R', { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 } },
+};
+
+static const char* RANK_LABELS[CardAtlas::RANK_COUNT] = {
+    "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K"
+};
+
+static const Glyph* findGlyph(char c) {
+    for (const auto& glyph : FONT) {
+        if (glyph.character == c) return &glyph;
+    }
+    return nullptr;
+}
+
+static int textWidth(const char* text, int scale) {
+    int length = static_cast<int>(strlen(text));
+    return length > 0 ? (length * 6 - 1) * scale : 0;
+}
+
+static bool insideHeart(float x, float y) {
+    float a = x * x + y * y - 1.0f;
+    return a * a * a - x * x * y * y * y <= 0.0f;
+}
+
+static bool insideStem(float u, float v) {
+    if (v > -0.35f || v < -1.0f) return false;
+    return std::fabs(u) <= 0.08f + 0.3f * ((-0.35f - v) / 0.65f);
+}
+
+static bool insideCircle(float u, float v, float cx, float cy, float r) {
+    float dx = u - cx;
+    float dy = v - cy;
+    return dx * dx + dy * dy <= r * r;
+}
+
+static bool insideStar(float u, float v) {
+    // Five pointed sheriff star, tested against its ten polygon edges
+    const float pi = 3.14159265f;
+    float px[10], py[10];
+    for (int i = 0; i < 10; i++) {
+        float angle = pi / 2.0f + i * pi / 5.0f;
+        float radius = (i % 2 == 0) ? 0.95f : 0.42f;
+        px[i] = radius * std::cos(angle);
+        py[i] = radius * std::sin(angle);
+    }
+
+    bool inside = false;
+    for (int i = 0, j = 9; i < 10; j = i++) {
+        if (((py[i] > v) != (py[j] > v)) &&
+            (u < (px[j] - px[i]) * (v - py[i]) / (py[j] - py[i]) + px[i])) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool CardAtlas::insideSuit(int suit, float u, float v) {
+    switch (suit) {
+        case HEARTS:
+            return insideHeart(u * 1.15f, v * 1.15f + 0.12f);
+        case DIAMONDS:
+            return std::fabs(u) / 0.7f + std::fabs(v) <= 0.95f;
+        case SPADES:
+            return insideHeart(u * 1.3f, -(v - 0.15f) * 1.3f) || insideStem(u, v);
+        case CLUBS:
+            return insideCircle(u, v, 0.0f, 0.42f, 0.36f) ||
+                   insideCircle(u, v, -0.4f, -0.12f, 0.36f) ||
+                   insideCircle(u, v, 0.4f, -0.12f, 0.36f) ||
+                   insideCircle(u, v, 0.0f, 0.05f, 0.2f) ||
+                   insideStem(u, v);
+        default:
+            return insideStar(u, v);
+    }
+}
+
+int CardAtlas::cardIdFor(const char* suit, const char* rank) {
+    if (suit == nullptr || rank == nullptr) return -1;
+
+    int rankIndex = -1;
+    static const char* RANK_NAMES[RANK_COUNT] = {
+        "ACE", "TWO", "THREE", "FOUR", "FIVE", "SIX", "SEVEN",
+        "EIGHT", "NINE", "TEN", "JACK", "QUEEN", "KING"
+    };
+    for (int i = 0; i < RANK_COUNT; i++) {
+        if (strcasecmp(rank, RANK_LABELS[i]) == 0 || strcasecmp(rank, RANK_NAMES[i]) == 0) {
+            rankIndex = i;
+            break;
+        }
+    }
+    if (strcasecmp(rank, "Joker") == 0) {
+        return JOKER_ID;
+    }
+    if (rankIndex < 0) return -1;
+
+    struct SuitName { const char* name; int index; };
+    static const SuitName SUIT_NAMES[] = {
+        { "SPADES", SPADES }, { "Sheriff Stars", SPADES }, { "\xE2\x99\xA0", SPADES }, { "S", SPADES },
+        { "HEARTS", HEARTS }, { "Horseshoes", HEARTS }, { "\xE2\x99\xA5", HEARTS }, { "H", HEARTS },
+        { "CLUBS", CLUBS }, { "Cactus", CLUBS }, { "\xE2\x99\xA3", CLUBS }, { "C", CLUBS },
+        { "DIAMONDS", DIAMONDS }, { "Gold Nuggets", DIAMONDS }, { "\xE2\x99\xA6", DIAMONDS }, { "D", DIAMONDS },
+    };
+    for (const auto& entry : SUIT_NAMES) {
+        if (strcasecmp(suit, entry.name) == 0) {
+            return entry.index * RANK_COUNT + rankIndex;
+        }
+    }
+    return -1;
+}
+
+CardAtlas::CardAtlas() {
+    memset(mUVRects, 0, sizeof(mUVRects));
+}
+
+CardAtlas::~CardAtlas() {
+    releaseTexture();
+}
+
+bool CardAtlas::build(const std::string& cacheDirectory) {
+    computeUVRects();
+
+    std::string cachePath;
+    if (!cacheDirectory.empty()) {
+        cachePath = cacheDirectory + "/" + CACHE_FILE;
+        if (loadFromCache(cachePath)) {
+            LOGI("Card atlas loaded from cache");
+            return true;
+        }
+    }
+
+    composite();
+    LOGI("Card atlas composited: %dx%d, %d cards", ATLAS_SIZE, ATLAS_SIZE, CARD_COUNT);
+
+    if (!cachePath.empty()) {
+        saveToCache(cachePath);
+    }
+    return true;
+}
+
+bool CardAtlas::loadFromCache(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    CacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header.version == CACHE_VERSION &&
+                 header.width == ATLAS_SIZE &&
+                 header.height == ATLAS_SIZE;
+
+    if (valid) {
+        mPixels.resize(static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE * 4);
+        valid = fread(mPixels.data(), 1, mPixels.size(), file) == mPixels.size();
+    }
+    fclose(file);
+
+    if (!valid) {
+        LOGI("Discarding stale card atlas cache");
+        mPixels.clear();
+    }
+    return valid;
+}
+
+void CardAtlas::saveToCache(const std::string& path) const {
+    // Write to a temporary file first so an interrupted write is never loaded
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        LOGE("Cannot write card atlas cache: %s", tempPath.c_str());
+        return;
+    }
+
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.width = ATLAS_SIZE;
+    header.height = ATLAS_SIZE;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(mPixels.data(), 1, mPixels.size(), file) == mPixels.size();
+    fclose(file);
+
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to store card atlas cache");
+        remove(tempPath.c_str());
+    }
+}
+
+void CardAtlas::computeUVRects() {
+    // Texture rows are uploaded top-down, so the card's bottom edge has the larger v.
+    // Half a texel is trimmed so filtering never samples the gutter.
+    const float texel = 1.0f / ATLAS_SIZE;
+    for (int id = 0; id < CARD_COUNT; id++) {
+        int x = (id % COLUMNS) * (CELL_WIDTH + CELL_GUTTER) + CELL_GUTTER / 2;
+        int y = (id / COLUMNS) * (CELL_HEIGHT + CELL_GUTTER) + CELL_GUTTER / 2;
+
+        UVRect& rect = mUVRects[id];
+        rect.u0 = (x + 0.5f) * texel;
+        rect.u1 = (x + CELL_WIDTH - 0.5f) * texel;
+        rect.v0 = (y + CELL_HEIGHT - 0.5f) * texel;
+        rect.v1 = (y + 0.5f) * texel;
+    }
+}
+
+const UVRect& CardAtlas::getUVRect(int cardId) const {
+    if (cardId < 0 || cardId >= CARD_COUNT) {
+        return mUVRects[BACK_ID];
+    }
+    return mUVRects[cardId];
+}
+
+void CardAtlas::composite() {
+    mPixels.assign(static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE * 4, 0);
+
+    for (int id = 0; id < CARD_COUNT; id++) {
+        int cellX = (id % COLUMNS) * (CELL_WIDTH + CELL_GUTTER) + CELL_GUTTER / 2;
+        int cellY = (id / COLUMNS) * (CELL_HEIGHT + CELL_GUTTER) + CELL_GUTTER / 2;
+
+        if (id == BACK_ID) {
+            drawBack(cellX, cellY);
+        } else if (id == JOKER_ID) {
+            drawJoker(cellX, cellY);
+        } else {
+            drawFace(cellX, cellY, id / RANK_COUNT, id % RANK_COUNT);
+        }
+    }
+}
+
+void CardAtlas::drawFace(int cellX, int cellY, int suit, int rank) {
+    drawTemplate(cellX, cellY, PARCHMENT, PARCHMENT_BORDER);
+
+    const uint8_t* ink = (suit == HEARTS || suit == DIAMONDS) ? SUIT_RED : SUIT_BLACK;
+    const char* label = RANK_LABELS[rank];
+    const int margin = 7;
+    const int textScale = 3;
+    const int textHeight = 7 * textScale;
+    const int pipSize = 16;
+    int labelWidth = textWidth(label, textScale);
+
+    // Corner indices, repeated upside down in the opposite corner
+    drawText(label, cellX + margin, cellY + margin, textScale, false, ink);
+    drawSuit(suit, cellX + margin, cellY + margin + textHeight + 4, pipSize, false, ink);
+    drawText(label, cellX + CELL_WIDTH - margin - labelWidth,
+             cellY + CELL_HEIGHT - margin - textHeight, textScale, true, ink);
+    drawSuit(suit, cellX + CELL_WIDTH - margin - pipSize,
+             cellY + CELL_HEIGHT - margin - textHeight - 4 - pipSize, pipSize, true, ink);
+
+    // Centre: large letter for court cards, a large pip otherwise
+    if (rank >= 10) {
+        const int courtScale = 8;
+        drawText(label, cellX + (CELL_WIDTH - textWidth(label, courtScale)) / 2,
+                 cellY + (CELL_HEIGHT - 7 * courtScale) / 2, courtScale, false, ink);
+    } else {
+        int centreSize = rank == 0 ? 70 : 54;
+        drawSuit(suit, cellX + (CELL_WIDTH - centreSize) / 2,
+                 cellY + (CELL_HEIGHT - centreSize) / 2, centreSize, false, ink);
+    }
+}
+
+void CardAtlas::drawJoker(int cellX, int cellY) {
+    drawTemplate(cellX, cellY, PARCHMENT, PARCHMENT_BORDER);
+
+    const int textScale = 2;
+    int width = textWidth("JOKER", textScale);
+    drawText("JOKER", cellX + (CELL_WIDTH - width) / 2, cellY + 14, textScale, false, SUIT_RED);
+    drawText("JOKER", cellX + (CELL_WIDTH - width) / 2,
+             cellY + CELL_HEIGHT - 14 - 7 * textScale, textScale, true, SUIT_RED);
+
+    const int starSize = 72;
+    drawSuit(-1, cellX + (CELL_WIDTH - starSize) / 2, cellY + (CELL_HEIGHT - starSize) / 2,
+             starSize, false, JOKER_GOLD);
+}
+
+void CardAtlas::drawBack(int cellX, int cellY) {
+    drawTemplate(cellX, cellY, BACK_FILL, BACK_BORDER);
+
+    // Diagonal lattice inside an inset frame
+    const int inset = 9;
+    for (int y = inset; y < CELL_HEIGHT - inset; y++) {
+        for (int x = inset; x < CELL_WIDTH - inset; x++) {
+            bool frame = x < inset + 2 || x >= CELL_WIDTH - inset - 2 ||
+                         y < inset + 2 || y >= CELL_HEIGHT - inset - 2;
+            bool lattice = ((x + y) % 12 == 0) || ((x - y + 1200) % 12 == 0);
+            if (frame) {
+                blendPixel(cellX + x, cellY + y, BACK_BORDER, 1.0f);
+            } else if (lattice) {
+                blendPixel(cellX + x, cellY + y, BACK_PATTERN, 1.0f);
+            }
+        }
+    }
+
+    const int starSize = 40;
+    drawSuit(-1, cellX + (CELL_WIDTH - starSize) / 2, cellY + (CELL_HEIGHT - starSize) / 2,
+             starSize, false, BACK_BORDER);
+}
+
+void CardAtlas::drawTemplate(int cellX, int cellY, const uint8_t* fill, const uint8_t* border) {
+    // Rounded rectangle with an anti-aliased outer edge
+    const float radius = 8.0f;
+    const float borderWidth = 3.0f;
+
+    for (int y = 0; y < CELL_HEIGHT; y++) {
+        for (int x = 0; x < CELL_WIDTH; x++) {
+            float px = x + 0.5f;
+            float py = y + 0.5f;
+            float cx = std::min(std::max(px, radius), CELL_WIDTH - radius);
+            float cy = std::min(std::max(py, radius), CELL_HEIGHT - radius);
+            float dx = px - cx;
+            float dy = py - cy;
+            float outside = std::sqrt(dx * dx + dy * dy) - radius; // < 0 inside the corner arc
+
+            // Distance to the nearest straight edge for the border band
+            float edge = std::min(std::min(px, CELL_WIDTH - px), std::min(py, CELL_HEIGHT - py));
+            float inner = (dx != 0.0f || dy != 0.0f) ? -outside : edge;
+
+            float coverage = std::min(1.0f, std::max(0.0f, 0.5f - outside));
+            if (coverage <= 0.0f) continue;
+
+            blendPixel(cellX + x, cellY + y, inner < borderWidth ? border : fill, coverage);
+        }
+    }
+}
+
+void CardAtlas::drawSuit(int suit, int x, int y, int size, bool flipped, const uint8_t* color) {
+    // 4x4 supersampling for smooth edges
+    const int samples = 4;
+    for (int py = 0; py < size; py++) {
+        for (int px = 0; px < size; px++) {
+            int hits = 0;
+            for (int sy = 0; sy < samples; sy++) {
+                for (int sx = 0; sx < samples; sx++) {
+                    float u = ((px + (sx + 0.5f) / samples) / size) * 2.0f - 1.0f;
+                    float v = 1.0f - ((py + (sy + 0.5f) / samples) / size) * 2.0f;
+                    if (flipped) {
+                        u = -u;
+                        v = -v;
+                    }
+                    if (insideSuit(suit, u, v)) hits++;
+                }
+            }
+            if (hits > 0) {
+                blendPixel(x + px, y + py, color, static_cast<float>(hits) / (samples * samples));
+            }
+        }
+    }
+}
+
+void CardAtlas::drawText(const char* text, int x, int y, int scale, bool flipped, const uint8_t* color) {
+    int width = textWidth(text, scale);
+    int height = 7 * scale;
+    int length = static_cast<int>(strlen(text));
+
+    for (int i = 0; i < length; i++) {
+        const Glyph* glyph = findGlyph(text[i]);
+        if (glyph == nullptr) continue;
+
+        for (int row = 0; row < 7; row++) {
+            for (int col = 0; col < 5; col++) {
+                if ((glyph->rows[row] & (0x10 >> col)) == 0) continue;
+
+                for (int sy = 0; sy < scale; sy++) {
+                    for (int sx = 0; sx < scale; sx++) {
+                        int gx = (i * 6 + col) * scale + sx;
+                        int gy = row * scale + sy;
+                        if (flipped) {
+                            gx = width - 1 - gx;
+                            gy = height - 1 - gy;
+                        }
+                        blendPixel(x + gx, y + gy, color, 1.0f);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CardAtlas::blendPixel(int x, int y, const uint8_t* color, float coverage) {
+    if (x < 0 || y < 0 || x >= ATLAS_SIZE || y >= ATLAS_SIZE) return;
+
+    uint8_t* dst = &mPixels[(static_cast<size_t>(y) * ATLAS_SIZE + x) * 4];
+    float alpha = coverage * (color[3] / 255.0f);
+    float dstAlpha = dst[3] / 255.0f;
+    float outAlpha = alpha + dstAlpha * (1.0f - alpha);
+
+    for (int c = 0; c < 3; c++) {
+        float blended = color[c] * alpha + dst[c] * dstAlpha * (1.0f - alpha);
+        dst[c] = static_cast<uint8_t>(outAlpha > 0.0f ? blended / outAlpha + 0.5f : 0.0f);
+    }
+    dst[3] = static_cast<uint8_t>(outAlpha * 255.0f + 0.5f);
+}
+
+GLuint CardAtlas::upload() {
+    if (mPixels.empty()) return 0;
+    if (mTexture != 0) return mTexture;
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Deeper mips would blend neighbouring cards across the 2 pixel gutter
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 2);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_SIZE, ATLAS_SIZE, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, mPixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    return mTexture;
+}
+
+void CardAtlas::releaseTexture() {
+    if (mTexture != 0) {
+        glDeleteTextures(1, &mTexture);
+        mTexture = 0;
+    }
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,112 @@
+#include "DynamicResolution.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+
+#define TAG "DynamicResolution"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static const float MIN_SCALE_LIMIT = 0.25f;
+// Over this share of the budget counts as a miss; under the lower one is headroom
+static const double OVER_BUDGET = 0.95;
+static const double UNDER_BUDGET = 0.70;
+// Consecutive frames needed before acting: react fast, recover cautiously
+static const int FRAMES_TO_DROP = 8;
+static const int FRAMES_TO_RAISE = 90;
+// Frames ignored after a change while GPU timings from the old size drain
+static const int COOLDOWN_FRAMES = 30;
+static const float DROP_STEP = 0.1f;
+static const float RAISE_STEP = 0.05f;
+static const double AVERAGE_WEIGHT = 0.2;
+
+// Scales are kept on a 5% grid so repeated steps land on the same sizes
+static float snapScale(float scale) {
+    return std::round(scale * 20.0f) / 20.0f;
+}
+
+DynamicResolution::DynamicResolution() {
+}
+
+void DynamicResolution::setDynamic(bool enabled, float minScale) {
+    mDynamic = enabled;
+    mMinScale = std::max(MIN_SCALE_LIMIT, std::min(snapScale(minScale), 1.0f));
+    mOverBudgetFrames = 0;
+    mUnderBudgetFrames = 0;
+    mCooldownFrames = 0;
+    if (mScale < mMinScale) {
+        mScale = mMinScale;
+    }
+    LOGI("Dynamic resolution %s, minimum scale %.2f", enabled ? "on" : "off", mMinScale);
+}
+
+void DynamicResolution::setScale(float scale) {
+    mScale = std::max(MIN_SCALE_LIMIT, std::min(snapScale(scale), 1.0f));
+    mCooldownFrames = COOLDOWN_FRAMES;
+}
+
+bool DynamicResolution::update(double cpuMilliseconds, double gpuMilliseconds, double budgetMilliseconds) {
+    // CPU and GPU work overlap, so the slower of the two bounds the frame
+    double cost = std::max(cpuMilliseconds, gpuMilliseconds);
+    mFrameMilliseconds = mFrameMilliseconds <= 0.0
+        ? cost : mFrameMilliseconds + (cost - mFrameMilliseconds) * AVERAGE_WEIGHT;
+    mBudgetMilliseconds = budgetMilliseconds;
+
+    if (!mDynamic || budgetMilliseconds <= 0.0) return false;
+    if (mCooldownFrames > 0) {
+        mCooldownFrames--;
+        return false;
+    }
+
+    if (mFrameMilliseconds > budgetMilliseconds * OVER_BUDGET) {
+        mOverBudgetFrames++;
+        mUnderBudgetFrames = 0;
+    } else if (mFrameMilliseconds < budgetMilliseconds * UNDER_BUDGET) {
+        mUnderBudgetFrames++;
+        mOverBudgetFrames = 0;
+    } else {
+        mOverBudgetFrames = 0;
+        mUnderBudgetFrames = 0;
+    }
+
+    float scale = mScale;
+    if (mOverBudgetFrames >= FRAMES_TO_DROP) {
+        scale = std::max(mMinScale, snapScale(mScale - DROP_STEP));
+    } else if (mUnderBudgetFrames >= FRAMES_TO_RAISE) {
+        scale = std::min(1.0f, snapScale(mScale + RAISE_STEP));
+    }
+    if (scale == mScale) {
+        // Pinned at a limit; keep counting from zero
+        if (mOverBudgetFrames >= FRAMES_TO_DROP) mOverBudgetFrames = 0;
+        if (mUnderBudgetFrames >= FRAMES_TO_RAISE) mUnderBudgetFrames = 0;
+        return false;
+    }
+
+    LOGI("Render scale %.2f -> %.2f (frame %.2f ms, budget %.2f ms)",
+         mScale, scale, mFrameMilliseconds, budgetMilliseconds);
+    mScale = scale;
+    mScaleChanges++;
+    mOverBudgetFrames = 0;
+    mUnderBudgetFrames = 0;
+    mCooldownFrames = COOLDOWN_FRAMES;
+    // The average still reflects the old size
+    mFrameMilliseconds = 0.0;
+    return true;
+}
+
+RenderScaleStats DynamicResolution::getStats() const {
+    RenderScaleStats stats;
+    stats.scale = mScale;
+    stats.minScale = mMinScale;
+    stats.dynamic = mDynamic;
+    stats.budgetMilliseconds = mBudgetMilliseconds;
+    stats.frameMilliseconds = mFrameMilliseconds;
+    stats.scaleChanges = mScaleChanges;
+    return stats;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,197 @@
+#include "EmitterLibrary.h"
+#include "JsonReader.h"
+#include <android/log.h>
+#include <cstring>
+
+#define TAG "EmitterLibrary"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// Fallback definitions so the original effect names keep working before the
+// asset has been loaded. Mirrors assets/particles/emitters.json.
+static const char* DEFAULT_EMITTERS = R"({
+    "emitters": [
+        {
+            "name": "gold_coin",
+            "burst": 1,
+            "velocityX": [-50, 50],
+            "velocityY": [-200, -50],
+            "life": 2.0,
+            "size": 20.0,
+            "color": [1.0, 0.84, 0.0, 1.0]
+        },
+        {
+            "name": "dust",
+            "burst": 5,
+            "offsetX": [-50, 50],
+            "offsetY": [-30, 30],
+            "velocityX": [-25, 25],
+            "velocityY": [-25, 25],
+            "life": 1.5,
+            "size": [5, 15],
+            "color": [0.62, 0.45, 0.33, 0.6]
+        },
+        {
+            "name": "fire_spark",
+            "burst": 1,
+            "velocityX": [-30, 30],
+            "velocityY": [-150, -100],
+            "life": 1.0,
+            "size": [8, 16],
+            "color": [1.0, [0.5, 1.0], 0.0, 1.0]
+        }
+    ]
+})";
+
+static uint32_t hashName(const std::string& name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Accepts either a single number or a [min, max] pair
+static bool readRange(const JsonValue* value, FloatRange& out) {
+    if (value == nullptr) return true; // keep default
+
+    if (value->isNumber()) {
+        out.min = out.max = static_cast<float>(value->asNumber());
+        return true;
+    }
+    if (value->isArray() && value->size() == 2 && (*value)[0].isNumber() && (*value)[1].isNumber()) {
+        out.min = static_cast<float>((*value)[0].asNumber());
+        out.max = static_cast<float>((*value)[1].asNumber());
+        return true;
+    }
+    return false;
+}
+
+EmitterLibrary::EmitterLibrary() {
+}
+
+EmitterLibrary::~EmitterLibrary() {
+}
+
+void EmitterLibrary::loadDefaults() {
+    loadFromJson(DEFAULT_EMITTERS, strlen(DEFAULT_EMITTERS));
+}
+
+bool EmitterLibrary::loadFromJson(const char* json, size_t length) {
+    JsonValue document;
+    std::string error;
+    if (!JsonReader::parse(json, length, document, error)) {
+        LOGE("Failed to parse emitter definitions: %s", error.c_str());
+        return false;
+    }
+
+    const JsonValue* emitters = document.find("emitters");
+    if (emitters == nullptr || !emitters->isArray()) {
+        LOGE("Emitter definitions have no \"emitters\" array");
+        return false;
+    }
+
+    int compiled = 0;
+    for (size_t i = 0; i < emitters->size(); i++) {
+        EmitterDescriptor descriptor;
+        std::string name;
+        if (!compileEmitter((*emitters)[i], descriptor, name)) {
+            LOGE("Skipping invalid emitter definition #%zu", i);
+            continue;
+        }
+
+        auto it = mHandles.find(name);
+        if (it != mHandles.end()) {
+            mDescriptors[it->second] = descriptor;
+        } else {
+            EmitterHandle handle = static_cast<EmitterHandle>(mDescriptors.size());
+            mDescriptors.push_back(descriptor);
+            mHandles.emplace(name, handle);
+        }
+        compiled++;
+    }
+
+    LOGI("Compiled %d emitter definitions (%zu total)", compiled, mDescriptors.size());
+    return compiled > 0;
+}
+
+bool EmitterLibrary::compileEmitter(const JsonValue& definition, EmitterDescriptor& out, std::string& name) {
+    const JsonValue* nameValue = definition.find("name");
+    if (nameValue == nullptr || !nameValue->isString() || nameValue->asString().empty()) {
+        return false;
+    }
+    name = nameValue->asString();
+
+    out.burstCount = 0;
+    out.emissionRate = 0.0f;
+    out.duration = 0.0f;
+    out.offsetX = { 0.0f, 0.0f };
+    out.offsetY = { 0.0f, 0.0f };
+    out.velocityX = { 0.0f, 0.0f };
+    out.velocityY = { 0.0f, 0.0f };
+    out.life = { 1.0f, 1.0f };
+    out.size = { 10.0f, 10.0f };
+    for (auto& channel : out.color) {
+        channel = { 1.0f, 1.0f };
+    }
+    out.seed = hashName(name);
+
+    if (const JsonValue* burst = definition.find("burst")) {
+        out.burstCount = static_cast<uint32_t>(burst->asNumber(0.0) > 0.0 ? burst->asNumber() : 0.0);
+    }
+    if (const JsonValue* rate = definition.find("rate")) {
+        out.emissionRate = static_cast<float>(rate->asNumber(0.0));
+    }
+    if (const JsonValue* duration = definition.find("duration")) {
+        out.duration = static_cast<float>(duration->asNumber(0.0));
+    }
+
+    bool valid = readRange(definition.find("offsetX"), out.offsetX) &&
+                 readRange(definition.find("offsetY"), out.offsetY) &&
+                 readRange(definition.find("velocityX"), out.velocityX) &&
+                 readRange(definition.find("velocityY"), out.velocityY) &&
+                 readRange(definition.find("life"), out.life) &&
+                 readRange(definition.find("size"), out.size);
+
+    const JsonValue* color = definition.find("color");
+    if (color != nullptr) {
+        if (!color->isArray() || color->size() < 3 || color->size() > 4) {
+            return false;
+        }
+        for (size_t c = 0; c < color->size(); c++) {
+            valid = valid && readRange(&(*color)[c], out.color[c]);
+        }
+    }
+
+    // Particles with no lifetime would be culled before they are drawn
+    if (out.life.min <= 0.0f || out.life.max <= 0.0f) {
+        return false;
+    }
+
+    return valid;
+}
+
+EmitterHandle EmitterLibrary::find(const char* name) const {
+    if (name == nullptr) return INVALID_EMITTER;
+
+    auto it = mHandles.find(name);
+    if (it != mHandles.end()) {
+        return it->second;
+    }
+    return INVALID_EMITTER;
+}
+
+const EmitterDescriptor* EmitterLibrary::get(EmitterHandle handle) const {
+    if (handle < 0 || handle >= static_cast<EmitterHandle>(mDescriptors.size())) {
+        return nullptr;
+    }
+    return &mDescriptors[handle];
+}
+
+} // namespace graphics
+} // namespace trashapp
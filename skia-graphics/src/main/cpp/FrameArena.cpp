@@ -0,0 +1,77 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+namespace trashapp {
+namespace graphics {
+
+FrameArena::FrameArena(size_t capacity) {
+    addChunk(capacity);
+}
+
+FrameArena::~FrameArena() {
+    freeChunks();
+}
+
+void FrameArena::addChunk(size_t minimum) {
+    Chunk chunk;
+    chunk.size = std::max(minimum, DEFAULT_CAPACITY);
+    chunk.data = static_cast<uint8_t*>(::operator new(chunk.size));
+    MemoryTracker::onAllocate(MemoryTag::FrameArena, chunk.size);
+    mChunks.push_back(chunk);
+}
+
+void FrameArena::freeChunks() {
+    for (const Chunk& chunk : mChunks) {
+        MemoryTracker::onFree(MemoryTag::FrameArena, chunk.size);
+        ::operator delete(chunk.data);
+    }
+    mChunks.clear();
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    while (true) {
+        Chunk& chunk = mChunks[mChunk];
+        size_t start = (mOffset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= chunk.size) {
+            mUsed += start + bytes - mOffset;
+            mOffset = start + bytes;
+            return chunk.data + start;
+        }
+        // What is left of this chunk goes unused this frame
+        mUsed += chunk.size - mOffset;
+        if (mChunk + 1 == mChunks.size()) {
+            addChunk(bytes + alignment);
+        }
+        mChunk++;
+        mOffset = 0;
+    }
+}
+
+void FrameArena::reset() {
+    mPeak = std::max(mPeak, mUsed);
+    if (mChunks.size() > 1) {
+        // One chunk for the busiest frame so far, with room to spare
+        mOverflows++;
+        freeChunks();
+        addChunk(mPeak + mPeak / 2);
+    }
+    mChunk = 0;
+    mOffset = 0;
+    mUsed = 0;
+}
+
+FrameArenaStats FrameArena::getStats() const {
+    FrameArenaStats stats = {};
+    for (const Chunk& chunk : mChunks) {
+        stats.capacityBytes += chunk.size;
+    }
+    stats.usedBytes = mUsed;
+    stats.peakBytes = std::max(mPeak, mUsed);
+    stats.chunks = static_cast<uint32_t>(mChunks.size());
+    stats.overflows = mOverflows;
+    return stats;
+}
+
+} // namespace graphics
+} // namespace trashapp
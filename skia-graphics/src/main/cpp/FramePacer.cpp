@@ -0,0 +1,427 @@
+#include "FramePacer.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <time.h>
+
+#define TAG "FramePacer"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static const int64_t NANOS_PER_SECOND = 1000000000LL;
+static const int MAX_FRAME_RATE = 240;
+// Weight of the newest sample in the running averages
+static const double AVERAGE_WEIGHT = 0.1;
+// Longer GPU times are driver glitches, not frames
+static const uint64_t MAX_GPU_FRAME_NANOS = NANOS_PER_SECOND;
+// Likewise present latencies; a frame shown this late was held back
+static const int64_t MAX_PRESENT_LATENCY_NANOS = NANOS_PER_SECOND / 4;
+// Assumed refresh before Choreographer or the display reports one
+static const int64_t DEFAULT_VSYNC_PERIOD_NANOS = NANOS_PER_SECOND / 60;
+
+static bool hasExtension(const char* list, const char* name) {
+    if (list == nullptr) return false;
+    size_t length = strlen(name);
+    for (const char* p = strstr(list, name); p != nullptr; p = strstr(p + length, name)) {
+        bool startOk = p == list || p[-1] == ' ';
+        bool endOk = p[length] == ' ' || p[length] == '\0';
+        if (startOk && endOk) return true;
+    }
+    return false;
+}
+
+static bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static double toMilliseconds(int64_t nanos) {
+    return static_cast<double>(nanos) / 1.0e6;
+}
+
+static double average(double current, double sample) {
+    return current <= 0.0 ? sample : current + (sample - current) * AVERAGE_WEIGHT;
+}
+
+FramePacer::FramePacer() {
+}
+
+FramePacer::~FramePacer() {
+}
+
+int64_t FramePacer::nowNanos() {
+    // Same clock as Choreographer frame times and presentation timestamps
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * NANOS_PER_SECOND + now.tv_nsec;
+}
+
+void FramePacer::initialize(EGLDisplay display) {
+    mDisplay = display;
+    mPresentationTime = nullptr;
+    if (hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_ANDROID_presentation_time")) {
+        mPresentationTime = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+            eglGetProcAddress("eglPresentationTimeANDROID"));
+    }
+    mGetNextFrameId = nullptr;
+    mGetFrameTimestamps = nullptr;
+    if (hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_ANDROID_get_frame_timestamps")) {
+        mGetNextFrameId = reinterpret_cast<PFNEGLGETNEXTFRAMEIDANDROIDPROC>(
+            eglGetProcAddress("eglGetNextFrameIdANDROID"));
+        mGetFrameTimestamps = reinterpret_cast<PFNEGLGETFRAMETIMESTAMPSANDROIDPROC>(
+            eglGetProcAddress("eglGetFrameTimestampsANDROID"));
+        if (mGetNextFrameId == nullptr || mGetFrameTimestamps == nullptr) {
+            mGetNextFrameId = nullptr;
+            mGetFrameTimestamps = nullptr;
+        }
+    }
+
+    // ES 3.0 has the query entry points; the extension adds the timer target
+    mGpuTimer = hasGLExtension("GL_EXT_disjoint_timer_query");
+    if (mGpuTimer) {
+        // The 32-bit getter saturates; prefer the extension's 64-bit one
+        mGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+            eglGetProcAddress("glGetQueryObjectui64vEXT"));
+        glGenQueries(QUERY_COUNT, mQueries);
+        // Reading the flag clears any disjoint event from before the first frame
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    }
+
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        mQueryPending[i] = false;
+    }
+    mQueryIndex = 0;
+    mQueryActive = false;
+    mFrameStartNanos = 0;
+    mFrameEndNanos = 0;
+    mLastSwapNanos = 0;
+    mLastPresentNanos = 0;
+    mFramePresentNanos = 0;
+    mTimestampSurface = EGL_NO_SURFACE;
+    for (int i = 0; i < PRESENT_HISTORY; i++) {
+        mPresents[i].pending = false;
+    }
+    mSwapIntervalDirty = true;
+
+    mStats = {};
+    mStats.gpuMilliseconds = -1.0;
+    mStats.presentationTimeSupported = mPresentationTime != nullptr;
+    mStats.gpuTimerSupported = mGpuTimer;
+    mStats.presentTimestampsSupported = mGetFrameTimestamps != nullptr;
+    mInitialized = true;
+
+    LOGI("Frame pacer: presentation time %s, GPU timer %s, present timestamps %s",
+         mPresentationTime != nullptr ? "yes" : "no", mGpuTimer ? "yes" : "no",
+         mGetFrameTimestamps != nullptr ? "yes" : "no");
+}
+
+void FramePacer::release() {
+    if (!mInitialized) return;
+
+    if (mGpuTimer) {
+        if (mQueryActive) {
+            glEndQuery(GL_TIME_ELAPSED_EXT);
+            mQueryActive = false;
+        }
+        glDeleteQueries(QUERY_COUNT, mQueries);
+        memset(mQueries, 0, sizeof(mQueries));
+    }
+    mGpuTimer = false;
+    mGetQueryObjectui64v = nullptr;
+    mPresentationTime = nullptr;
+    mGetNextFrameId = nullptr;
+    mGetFrameTimestamps = nullptr;
+    mTimestampSurface = EGL_NO_SURFACE;
+    mDisplay = EGL_NO_DISPLAY;
+    mInitialized = false;
+}
+
+void FramePacer::abandon() {
+    memset(mQueries, 0, sizeof(mQueries));
+    mQueryActive = false;
+    mGpuTimer = false;
+    mGetQueryObjectui64v = nullptr;
+    mPresentationTime = nullptr;
+    mGetNextFrameId = nullptr;
+    mGetFrameTimestamps = nullptr;
+    mTimestampSurface = EGL_NO_SURFACE;
+    mDisplay = EGL_NO_DISPLAY;
+    mInitialized = false;
+}
+
+void FramePacer::onSurfaceChanged() {
+    mSwapIntervalDirty = true;
+    mLastPresentNanos = 0;
+    mLastSwapNanos = 0;
+    // Timestamps are per surface; the latency learned so far still holds
+    mTimestampSurface = EGL_NO_SURFACE;
+    for (int i = 0; i < PRESENT_HISTORY; i++) {
+        mPresents[i].pending = false;
+    }
+}
+
+void FramePacer::setVSync(bool enabled) {
+    if (mVSync == enabled) return;
+    mVSync = enabled;
+    mSwapIntervalDirty = true;
+}
+
+void FramePacer::setTargetFrameRate(int framesPerSecond) {
+    mTargetFrameRate = std::max(0, std::min(framesPerSecond, MAX_FRAME_RATE));
+    // Restart the cadence from the next frame
+    mLastPresentNanos = 0;
+    mSwapIntervalDirty = true;
+    LOGI("Target frame rate %d", mTargetFrameRate);
+}
+
+void FramePacer::setDisplayRefreshRate(float hz) {
+    mDisplayRefreshRate = hz > 0.0f ? hz : 0.0f;
+    mSwapIntervalDirty = true;
+}
+
+void FramePacer::onVsync(int64_t frameTimeNanos) {
+    int64_t previous = mLastVsyncNanos.exchange(frameTimeNanos, std::memory_order_relaxed);
+    if (previous <= 0 || frameTimeNanos <= previous) return;
+
+    int64_t delta = frameTimeNanos - previous;
+    int64_t period = mVsyncPeriodNanos.load(std::memory_order_relaxed);
+    // A late callback spans several vsyncs and says nothing new about the period
+    if (period > 0 && delta > period + period / 2) return;
+    if (period <= 0 && delta > NANOS_PER_SECOND / 10) return;
+
+    period = period <= 0 ? delta : period + (delta - period) / 8;
+    mVsyncPeriodNanos.store(period, std::memory_order_relaxed);
+}
+
+int64_t FramePacer::vsyncPeriodNanos() const {
+    int64_t period = mVsyncPeriodNanos.load(std::memory_order_relaxed);
+    if (period > 0) return period;
+    if (mDisplayRefreshRate > 0.0f) {
+        return static_cast<int64_t>(NANOS_PER_SECOND / mDisplayRefreshRate);
+    }
+    return 0;
+}
+
+int64_t FramePacer::presentLatencyNanos() const {
+    if (mPresentLatencyNanos > 0) return mPresentLatencyNanos;
+    // Unmeasured: latched at the vsync after the frame's interval, shown at
+    // the one after that
+    int64_t period = vsyncPeriodNanos();
+    if (period <= 0) period = DEFAULT_VSYNC_PERIOD_NANOS;
+    return period * (std::max(1, mSwapInterval) + 1);
+}
+
+int64_t FramePacer::predictNextPresentNanos() const {
+    int64_t now = nowNanos();
+    int64_t start = now;
+    int64_t period = vsyncPeriodNanos();
+    int64_t lastVsync = mLastVsyncNanos.load(std::memory_order_relaxed);
+    if (mVSync && period > 0 && lastVsync > 0 && lastVsync <= now) {
+        // Frames start on vsync; the next one after now
+        start = lastVsync + ((now - lastVsync) / period + 1) * period;
+    }
+    return start + presentLatencyNanos();
+}
+
+int64_t FramePacer::getFramePeriodNanos() const {
+    int64_t period = vsyncPeriodNanos();
+    if (period <= 0) period = DEFAULT_VSYNC_PERIOD_NANOS;
+    return period * std::max(1, mSwapInterval);
+}
+
+bool FramePacer::presentsBy(int64_t presentNanos) const {
+    return mFramePresentNanos + getFramePeriodNanos() / 2 >= presentNanos;
+}
+
+void FramePacer::updateSwapInterval() {
+    int interval = 1;
+    int64_t period = vsyncPeriodNanos();
+    if (!mVSync) {
+        interval = 0;
+    } else if (mTargetFrameRate > 0 && period > 0) {
+        // Whole vsyncs per frame, rounding down so 60 on 90 Hz stays at one
+        // interval and presentation time spaces the frames out
+        double refresh = static_cast<double>(NANOS_PER_SECOND) / period;
+        interval = std::max(1, static_cast<int>(std::floor(refresh / mTargetFrameRate + 0.1)));
+    }
+
+    if (interval != mSwapInterval) {
+        mSwapInterval = interval;
+        mSwapIntervalDirty = true;
+    }
+}
+
+void FramePacer::beginFrame() {
+    if (!mInitialized) return;
+
+    mFrameStartNanos = nowNanos();
+    updateSwapInterval();
+    mFramePresentNanos = mFrameStartNanos + presentLatencyNanos();
+
+    if (mGpuTimer) {
+        collectGpuTimings();
+        // Skip timing this frame rather than reuse a query the GPU still owns
+        if (!mQueryPending[mQueryIndex]) {
+            glBeginQuery(GL_TIME_ELAPSED_EXT, mQueries[mQueryIndex]);
+            mQueryActive = true;
+        }
+    }
+}
+
+void FramePacer::endFrame() {
+    if (!mInitialized) return;
+
+    if (mQueryActive) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        mQueryPending[mQueryIndex] = true;
+        mQueryIndex = (mQueryIndex + 1) % QUERY_COUNT;
+        mQueryActive = false;
+    }
+    mFrameEndNanos = nowNanos();
+}
+
+void FramePacer::collectGpuTimings() {
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    // Oldest first; results arrive in submission order
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        int slot = (mQueryIndex + i) % QUERY_COUNT;
+        if (!mQueryPending[slot]) continue;
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(mQueries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) break;
+
+        GLuint64 elapsed = 0;
+        if (mGetQueryObjectui64v != nullptr) {
+            mGetQueryObjectui64v(mQueries[slot], GL_QUERY_RESULT, &elapsed);
+        } else {
+            GLuint elapsed32 = 0;
+            glGetQueryObjectuiv(mQueries[slot], GL_QUERY_RESULT, &elapsed32);
+            elapsed = elapsed32;
+        }
+        mQueryPending[slot] = false;
+
+        // A disjoint event (frequency change, context switch) voids the result
+        if (disjoint == 0 && elapsed < MAX_GPU_FRAME_NANOS) {
+            mStats.gpuMilliseconds = toMilliseconds(elapsed);
+            mStats.averageGpuMilliseconds = average(mStats.averageGpuMilliseconds, mStats.gpuMilliseconds);
+        }
+    }
+}
+
+void FramePacer::enablePresentTimestamps(EGLSurface surface) {
+    if (mGetFrameTimestamps == nullptr || surface == mTimestampSurface) return;
+    if (!eglSurfaceAttrib(mDisplay, surface, EGL_TIMESTAMPS_ANDROID, EGL_TRUE)) {
+        LOGE("Enabling frame timestamps failed: 0x%x", eglGetError());
+        mGetNextFrameId = nullptr;
+        mGetFrameTimestamps = nullptr;
+        mStats.presentTimestampsSupported = false;
+        return;
+    }
+    mTimestampSurface = surface;
+}
+
+void FramePacer::collectPresentTimes(EGLSurface surface) {
+    if (mGetFrameTimestamps == nullptr || surface != mTimestampSurface) return;
+
+    const EGLint name = EGL_DISPLAY_PRESENT_TIME_ANDROID;
+    for (int i = 0; i < PRESENT_HISTORY; i++) {
+        PendingPresent& frame = mPresents[i];
+        if (!frame.pending) continue;
+
+        EGLnsecsANDROID presented = EGL_TIMESTAMP_PENDING_ANDROID;
+        if (!mGetFrameTimestamps(mDisplay, surface, frame.frameId, 1, &name, &presented)) {
+            // Aged out of the compositor's history
+            frame.pending = false;
+            continue;
+        }
+        if (presented == EGL_TIMESTAMP_PENDING_ANDROID) continue;
+        frame.pending = false;
+
+        int64_t latency = presented - frame.startNanos;
+        if (presented <= 0 || latency <= 0 || latency > MAX_PRESENT_LATENCY_NANOS) continue;
+        mPresentLatencyNanos = mPresentLatencyNanos <= 0
+            ? latency : mPresentLatencyNanos + (latency - mPresentLatencyNanos) / 8;
+    }
+}
+
+void FramePacer::beforeSwap(EGLSurface surface) {
+    if (!mInitialized || surface == EGL_NO_SURFACE) return;
+
+    enablePresentTimestamps(surface);
+    collectPresentTimes(surface);
+    if (mGetNextFrameId != nullptr && surface == mTimestampSurface) {
+        PendingPresent& frame = mPresents[mPresentIndex];
+        if (mGetNextFrameId(mDisplay, surface, &frame.frameId)) {
+            frame.startNanos = mFrameStartNanos;
+            frame.pending = true;
+            mPresentIndex = (mPresentIndex + 1) % PRESENT_HISTORY;
+        }
+    }
+
+    if (mSwapIntervalDirty) {
+        if (eglSwapInterval(mDisplay, mSwapInterval)) {
+            mSwapIntervalDirty = false;
+        } else {
+            LOGE("eglSwapInterval(%d) failed: 0x%x", mSwapInterval, eglGetError());
+        }
+    }
+
+    int64_t period = vsyncPeriodNanos();
+    if (mPresentationTime == nullptr || !mVSync || mTargetFrameRate <= 0 || period <= 0) return;
+
+    int64_t now = nowNanos();
+    int64_t framePeriod = NANOS_PER_SECOND / mTargetFrameRate;
+    int64_t target = mLastPresentNanos + framePeriod;
+    // Fell behind (or first frame): restart the cadence at the next vsync
+    if (mLastPresentNanos == 0 || target < now) {
+        target = now + period;
+    }
+
+    // Land on the vsync grid so rounding never drifts into a skipped frame
+    int64_t lastVsync = mLastVsyncNanos.load(std::memory_order_relaxed);
+    if (lastVsync > 0) {
+        int64_t steps = (target - lastVsync + period / 2) / period;
+        target = lastVsync + steps * period;
+    }
+
+    if (mPresentationTime(mDisplay, surface, target)) {
+        mLastPresentNanos = target;
+    }
+}
+
+void FramePacer::afterSwap() {
+    if (!mInitialized) return;
+
+    int64_t now = nowNanos();
+    if (mFrameStartNanos > 0 && mFrameEndNanos >= mFrameStartNanos) {
+        mStats.cpuMilliseconds = toMilliseconds(mFrameEndNanos - mFrameStartNanos);
+        mStats.averageCpuMilliseconds = average(mStats.averageCpuMilliseconds, mStats.cpuMilliseconds);
+    }
+    if (mLastSwapNanos > 0) {
+        mStats.frameIntervalMilliseconds = toMilliseconds(now - mLastSwapNanos);
+        mStats.averageIntervalMilliseconds = average(mStats.averageIntervalMilliseconds,
+                                                     mStats.frameIntervalMilliseconds);
+    }
+    mLastSwapNanos = now;
+
+    mStats.vsyncPeriodMilliseconds = toMilliseconds(vsyncPeriodNanos());
+    mStats.targetFrameRate = mTargetFrameRate;
+    mStats.swapInterval = mSwapInterval;
+    mStats.presentLatencyMilliseconds = toMilliseconds(presentLatencyNanos());
+}
+
+} // namespace graphics
+} // namespace trashapp
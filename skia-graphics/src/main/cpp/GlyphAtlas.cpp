@@ -0,0 +1,410 @@
+#include "GlyphAtlas.h"
+#include "CardAtlas.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define TAG "GlyphAtlas"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static const char* CACHE_FILE = "glyph_atlas.sdf";
+static const char CACHE_MAGIC[4] = { 'T', 'G', 'L', 'Y' };
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Stroke font on a 4 x 6 grid, y up, baseline at 0. Polylines are separated
+// by '|'; a zero-length segment draws a dot.
+struct StrokeGlyph {
+    uint32_t codepoint;
+    const char* strokes;
+};
+
+static const StrokeGlyph STROKES[] = {
+    { '0', "1,0 3,0 4,1 4,5 3,6 1,6 0,5 0,1 1,0" },
+    { '1', "1,5 2,6 2,0|1,0 3,0" },
+    { '2', "0,5 1,6 3,6 4,5 4,4 0,0 4,0" },
+    { '3', "0,6 4,6 2,3.5 3,3.5 4,2.5 4,1 3,0 1,0 0,1" },
+    { '4', "3,0 3,6 0,2 4,2" },
+    { '5', "4,6 0,6 0,3.5 3,3.5 4,2.5 4,1 3,0 1,0 0,1" },
+    { '6', "3.5,6 2,6 0,4 0,1 1,0 3,0 4,1 4,2.5 3,3.5 1,3.5 0,2.5" },
+    { '7', "0,6 4,6 1.5,0" },
+    { '8', "1,3.5 0,4.5 0,5 1,6 3,6 4,5 4,4.5 3,3.5 1,3.5 0,2.5 0,1 1,0 3,0 4,1 4,2.5 3,3.5" },
+    { '9', "0.5,0 2,0 4,2 4,5 3,6 1,6 0,5 0,3.5 1,2.5 3,2.5 4,3.5" },
+    { 'A', "0,0 0,4 2,6 4,4 4,0|0,2.5 4,2.5" },
+    { 'J', "1.5,6 4,6|3,6 3,1 2,0 1,0 0,1" },
+    { 'Q', "1,0 3,0 4,1 4,5 3,6 1,6 0,5 0,1 1,0|2.5,1.5 4,0" },
+    { 'K', "0,0 0,6|4,6 0,2|1.3,3.3 4,0" },
+    { 'O', "1,0 3,0 4,1 4,5 3,6 1,6 0,5 0,1 1,0" },
+    { 'E', "4,6 0,6 0,0 4,0|0,3 3,3" },
+    { 'R', "0,0 0,6 3,6 4,5 4,4 3,3 0,3|2,3 4,0" },
+    { '+', "2,1 2,5|0,3 4,3" },
+    { '-', "0.5,3 3.5,3" },
+    { '.', "2,0.3 2,0.3" },
+    { ':', "2,1 2,1|2,4.5 2,4.5" },
+    { '/', "0,0 4,6" },
+    { 'x', "0.5,0.5 3.5,4|0.5,4 3.5,0.5" },
+};
+
+static const float STROKE_HALF_WIDTH = 0.45f;
+static const float STROKE_ADVANCE = 5.5f;     // grid units, including the gap
+
+// Pips use CardAtlas suit ids; -1 is the star
+struct SuitGlyph {
+    uint32_t codepoint;
+    int suit;
+};
+
+static const SuitGlyph SUITS[] = {
+    { GlyphAtlas::SPADE, 0 },
+    { GlyphAtlas::HEART, 1 },
+    { GlyphAtlas::CLUB, 2 },
+    { GlyphAtlas::DIAMOND, 3 },
+    { GlyphAtlas::STAR, -1 },
+};
+
+static const size_t STROKE_COUNT = sizeof(STROKES) / sizeof(STROKES[0]);
+static const size_t GLYPH_COUNT = STROKE_COUNT + sizeof(SUITS) / sizeof(SUITS[0]);
+
+// Cap heights: strokes are 6 grid units tall, pips 2 outline units (-1..1)
+static const float GRID_UNITS_PER_CAP = 6.0f;
+static const float SUIT_UNITS_PER_CAP = 2.0f;
+static const float SUIT_ADVANCE = 1.25f;      // cap heights
+
+struct Segment {
+    float x0, y0, x1, y1;
+};
+
+static std::vector<Segment> parseStrokes(const char* strokes) {
+    std::vector<Segment> segments;
+    const char* p = strokes;
+    bool havePoint = false;
+    float lastX = 0.0f;
+    float lastY = 0.0f;
+    while (*p != '\0') {
+        if (*p == '|') {
+            havePoint = false;
+            p++;
+            continue;
+        }
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+        char* end = nullptr;
+        float x = strtof(p, &end);
+        if (end == p || *end != ',') break;
+        p = end + 1;
+        float y = strtof(p, &end);
+        if (end == p) break;
+        p = end;
+        if (havePoint) {
+            segments.push_back({ lastX, lastY, x, y });
+        } else if (*p == '\0' || *p == '|') {
+            segments.push_back({ x, y, x, y });
+        }
+        lastX = x;
+        lastY = y;
+        havePoint = true;
+    }
+    return segments;
+}
+
+static float segmentDistance(const Segment& s, float x, float y) {
+    float dx = s.x1 - s.x0;
+    float dy = s.y1 - s.y0;
+    float lengthSquared = dx * dx + dy * dy;
+    float t = lengthSquared > 0.0f ? ((x - s.x0) * dx + (y - s.y0) * dy) / lengthSquared : 0.0f;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    float px = s.x0 + t * dx - x;
+    float py = s.y0 + t * dy - y;
+    return std::sqrt(px * px + py * py);
+}
+
+// Squared distance transform of one row or column (Felzenszwalb and
+// Huttenlocher): f holds 0 on features and a large value elsewhere
+static void distanceTransform1d(const float* f, int n, float* d, int* v, float* z) {
+    const float infinity = 1e20f;
+    int k = 0;
+    v[0] = 0;
+    z[0] = -infinity;
+    z[1] = infinity;
+    for (int q = 1; q < n; q++) {
+        // z[0] is below any intersection, so k never drops under 0
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        while (s <= z[k]) {
+            k--;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * (q - v[k]));
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = infinity;
+    }
+    k = 0;
+    for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) k++;
+        float delta = static_cast<float>(q - v[k]);
+        d[q] = delta * delta + f[v[k]];
+    }
+}
+
+// In place: grid holds 0 on features and a large value elsewhere on entry,
+// squared distances to the nearest feature on return
+static void distanceTransform2d(std::vector<float>& grid, int size) {
+    std::vector<float> f(size);
+    std::vector<float> d(size);
+    std::vector<int> v(size);
+    std::vector<float> z(size + 1);
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) f[y] = grid[y * size + x];
+        distanceTransform1d(f.data(), size, d.data(), v.data(), z.data());
+        for (int y = 0; y < size; y++) grid[y * size + x] = d[y];
+    }
+    for (int y = 0; y < size; y++) {
+        float* row = &grid[y * size];
+        std::copy(row, row + size, f.begin());
+        distanceTransform1d(f.data(), size, d.data(), v.data(), z.data());
+        std::copy(d.begin(), d.end(), row);
+    }
+}
+
+GlyphAtlas::GlyphAtlas() {
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    releaseTexture();
+}
+
+bool GlyphAtlas::build(const std::string& cacheDirectory) {
+    computeMetrics();
+
+    std::string cachePath;
+    if (!cacheDirectory.empty()) {
+        cachePath = cacheDirectory + "/" + CACHE_FILE;
+        if (loadFromCache(cachePath)) {
+            LOGI("Glyph atlas loaded from cache");
+            return true;
+        }
+    }
+
+    generate();
+    LOGI("Glyph atlas generated: %dx%d, %zu glyphs", ATLAS_WIDTH, ATLAS_HEIGHT, mMetrics.size());
+
+    if (!cachePath.empty()) {
+        saveToCache(cachePath);
+    }
+    return true;
+}
+
+bool GlyphAtlas::loadFromCache(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) return false;
+
+    CacheHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header.version == CACHE_VERSION &&
+                 header.width == ATLAS_WIDTH &&
+                 header.height == ATLAS_HEIGHT;
+
+    if (valid) {
+        mPixels.resize(static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT);
+        valid = fread(mPixels.data(), 1, mPixels.size(), file) == mPixels.size();
+    }
+    fclose(file);
+
+    if (!valid) {
+        LOGI("Discarding stale glyph atlas cache");
+        mPixels.clear();
+    }
+    return valid;
+}
+
+void GlyphAtlas::saveToCache(const std::string& path) const {
+    // Write to a temporary file first so an interrupted write is never loaded
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        LOGE("Cannot write glyph atlas cache: %s", tempPath.c_str());
+        return;
+    }
+
+    CacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.width = ATLAS_WIDTH;
+    header.height = ATLAS_HEIGHT;
+
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(mPixels.data(), 1, mPixels.size(), file) == mPixels.size();
+    fclose(file);
+
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to store glyph atlas cache");
+        remove(tempPath.c_str());
+    }
+}
+
+void GlyphAtlas::computeMetrics() {
+    // Outlines fill the cell inside the spread margin: 8 grid units (the
+    // 6 unit cap plus a unit each side) or the 2 unit suit square
+    const float inner = static_cast<float>(CELL_SIZE - 2 * SPREAD);
+    const float strokeCellCaps = (CELL_SIZE / (inner / 8.0f)) / GRID_UNITS_PER_CAP;
+    const float suitCellCaps = (CELL_SIZE / (inner / 2.0f)) / SUIT_UNITS_PER_CAP;
+
+    mMetrics.resize(GLYPH_COUNT);
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        GlyphMetrics& metrics = mMetrics[i];
+        int x = static_cast<int>(i % COLUMNS) * CELL_SIZE;
+        int y = static_cast<int>(i / COLUMNS) * CELL_SIZE;
+
+        // Texture rows are uploaded top-down, so the cell's bottom edge has the larger v
+        metrics.u0 = static_cast<float>(x) / ATLAS_WIDTH;
+        metrics.u1 = static_cast<float>(x + CELL_SIZE) / ATLAS_WIDTH;
+        metrics.v0 = static_cast<float>(y + CELL_SIZE) / ATLAS_HEIGHT;
+        metrics.v1 = static_cast<float>(y) / ATLAS_HEIGHT;
+
+        // The outline's centre sits at the cell's centre
+        if (i < STROKE_COUNT) {
+            metrics.codepoint = STROKES[i].codepoint;
+            metrics.size = strokeCellCaps;
+            metrics.left = 2.0f / GRID_UNITS_PER_CAP - strokeCellCaps * 0.5f;
+            metrics.bottom = 0.5f - strokeCellCaps * 0.5f;
+            metrics.advance = STROKE_ADVANCE / GRID_UNITS_PER_CAP;
+        } else {
+            metrics.codepoint = SUITS[i - STROKE_COUNT].codepoint;
+            metrics.size = suitCellCaps;
+            metrics.left = 0.5f - suitCellCaps * 0.5f;
+            metrics.bottom = 0.5f - suitCellCaps * 0.5f;
+            metrics.advance = SUIT_ADVANCE;
+        }
+    }
+}
+
+const GlyphMetrics* GlyphAtlas::find(uint32_t codepoint) const {
+    for (const GlyphMetrics& metrics : mMetrics) {
+        if (metrics.codepoint == codepoint) return &metrics;
+    }
+    return nullptr;
+}
+
+void GlyphAtlas::generate() {
+    mPixels.assign(static_cast<size_t>(ATLAS_WIDTH) * ATLAS_HEIGHT, 0);
+
+    const size_t samples = static_cast<size_t>(CELL_SIZE * SUPERSAMPLE) * CELL_SIZE * SUPERSAMPLE;
+    std::vector<uint8_t> mask(samples);
+    std::vector<float> inside(samples);
+    std::vector<float> outside(samples);
+    for (size_t i = 0; i < GLYPH_COUNT; i++) {
+        generateGlyph(i, mask, inside, outside);
+    }
+}
+
+void GlyphAtlas::generateGlyph(size_t index, std::vector<uint8_t>& mask, std::vector<float>& inside,
+                               std::vector<float>& outside) {
+    const int size = CELL_SIZE * SUPERSAMPLE;
+    const float inner = static_cast<float>(CELL_SIZE - 2 * SPREAD);
+    const float infinity = 1e20f;
+
+    // Binary outline at the supersampled resolution
+    std::vector<Segment> segments;
+    float unitsPerSample;
+    if (index < STROKE_COUNT) {
+        segments = parseStrokes(STROKES[index].strokes);
+        unitsPerSample = 8.0f / (inner * SUPERSAMPLE);
+    } else {
+        unitsPerSample = 2.0f / (inner * SUPERSAMPLE);
+    }
+    for (int sy = 0; sy < size; sy++) {
+        for (int sx = 0; sx < size; sx++) {
+            // Relative to the centre, y up
+            float cx = (sx + 0.5f - size * 0.5f) * unitsPerSample;
+            float cy = (size * 0.5f - sy - 0.5f) * unitsPerSample;
+            bool covered = false;
+            if (index < STROKE_COUNT) {
+                for (const Segment& segment : segments) {
+                    if (segmentDistance(segment, cx + 2.0f, cy + 3.0f) <= STROKE_HALF_WIDTH) {
+                        covered = true;
+                        break;
+                    }
+                }
+            } else {
+                covered = CardAtlas::insideSuit(SUITS[index - STROKE_COUNT].suit, cx, cy);
+            }
+            size_t i = static_cast<size_t>(sy) * size + sx;
+            mask[i] = covered ? 1 : 0;
+            inside[i] = covered ? infinity : 0.0f;    // distance to the outside
+            outside[i] = covered ? 0.0f : infinity;   // distance to the outline
+        }
+    }
+    distanceTransform2d(inside, size);
+    distanceTransform2d(outside, size);
+
+    // Signed distance in cell pixels, averaged over each texel's samples;
+    // half a sample puts the edge between covered and uncovered centres
+    int cellX = static_cast<int>(index % COLUMNS) * CELL_SIZE;
+    int cellY = static_cast<int>(index / COLUMNS) * CELL_SIZE;
+    const float scale = 1.0f / SUPERSAMPLE;
+    for (int y = 0; y < CELL_SIZE; y++) {
+        for (int x = 0; x < CELL_SIZE; x++) {
+            float sum = 0.0f;
+            for (int sy = 0; sy < SUPERSAMPLE; sy++) {
+                for (int sx = 0; sx < SUPERSAMPLE; sx++) {
+                    size_t i = static_cast<size_t>(y * SUPERSAMPLE + sy) * size + x * SUPERSAMPLE + sx;
+                    float distance = mask[i] ? -(std::sqrt(inside[i]) - 0.5f)
+                                             : std::sqrt(outside[i]) - 0.5f;
+                    sum += distance;
+                }
+            }
+            float distance = sum * scale / (SUPERSAMPLE * SUPERSAMPLE);
+            float value = 0.5f - distance / (2.0f * SPREAD);
+            value = std::min(std::max(value, 0.0f), 1.0f);
+            mPixels[static_cast<size_t>(cellY + y) * ATLAS_WIDTH + cellX + x] =
+                static_cast<uint8_t>(value * 255.0f + 0.5f);
+        }
+    }
+}
+
+GLuint GlyphAtlas::upload() {
+    if (mPixels.empty()) return 0;
+    if (mTexture != 0) return mTexture;
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+
+    // Distances interpolate linearly; minified text thresholds a coarser
+    // field, so no mipmaps
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
+                 GL_RED, GL_UNSIGNED_BYTE, mPixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return mTexture;
+}
+
+void GlyphAtlas::releaseTexture() {
+    if (mTexture != 0) {
+        glDeleteTextures(1, &mTexture);
+        mTexture = 0;
+    }
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,360 @@
+#include "GpuParticleSystem.h"
+#include "ParticleEffect.h"
+#include "ShaderManager.h"
+#include "Camera.h"
+#include <android/log.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "GpuParticleSystem"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// Must stay in sync with ParticleEffect::updateParticle
+static const char* UPDATE_VERTEX_SHADER = R"(#version 300 es
+    layout(location = 0) in vec4 aPosVel;
+    layout(location = 1) in vec4 aLifeSize;
+    layout(location = 2) in vec4 aColor;
+
+    uniform float uDeltaTime;
+
+    out vec4 vPosVel;
+    out vec4 vLifeSize;
+    out vec4 vColor;
+
+    void main() {
+        vec4 posVel = aPosVel;
+        vec4 lifeSize = aLifeSize;
+        vec4 color = aColor;
+
+        if (lifeSize.x > 0.0) {
+            // Physics
+            posVel.xy += posVel.zw * uDeltaTime;
+
+            // Gravity
+            posVel.w -= 200.0 * uDeltaTime;
+
+            // Life
+            lifeSize.x -= uDeltaTime;
+
+            // Fade out
+            color.a = lifeSize.x / lifeSize.y;
+
+            // Shrink
+            lifeSize.z *= 0.99;
+        }
+
+        vPosVel = posVel;
+        vLifeSize = lifeSize;
+        vColor = color;
+    }
+)";
+
+static const char* UPDATE_FRAGMENT_SHADER = R"(#version 300 es
+    precision mediump float;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(0.0);
+    }
+)";
+
+static const char* RENDER_VERTEX_SHADER = "#version 300 es\n" CAMERA_UNIFORM_BLOCK R"(
+    layout(location = 0) in vec4 aPosVel;
+    layout(location = 1) in vec4 aLifeSize;
+    layout(location = 2) in vec4 aColor;
+
+    out vec4 vColor;
+
+    void main() {
+        if (aLifeSize.x <= 0.0) {
+            // Dead or unused ring slot: place outside the clip volume
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+            gl_PointSize = 0.0;
+        } else {
+            gl_Position = uProjection * vec4(aPosVel.xy, 0.0, 1.0);
+            // Size is in layout units, like the CPU quads
+            gl_PointSize = aLifeSize.z * uViewport.z;
+        }
+        vColor = aColor;
+    }
+)";
+
+static const char* RENDER_FRAGMENT_SHADER = R"(#version 300 es
+    precision mediump float;
+
+    in vec4 vColor;
+    out vec4 FragColor;
+
+    void main() {
+        // Circular particle
+        vec2 coord = gl_PointCoord - vec2(0.5);
+        float dist = length(coord);
+
+        if (dist > 0.5) {
+            discard;
+        }
+
+        // Soft edge
+        float alpha = 1.0 - smoothstep(0.3, 0.5, dist);
+
+        // The fade applies to both the color and the opacity, as on the CPU
+        FragColor = vec4(vColor.rgb, vColor.a * vColor.a * alpha);
+    }
+)";
+
+GpuParticleSystem::GpuParticleSystem() {
+}
+
+GpuParticleSystem::~GpuParticleSystem() {
+    release();
+}
+
+bool GpuParticleSystem::initialize(uint32_t capacity, ShaderManager& shaders) {
+    if (mInitialized) {
+        return true;
+    }
+
+    mCapacity = capacity;
+    if (!createPrograms(shaders)) {
+        LOGE("Transform feedback programs unavailable, GPU particles disabled");
+        release();
+        return false;
+    }
+    createBuffers();
+
+    mInitialized = true;
+    LOGI("GpuParticleSystem initialized: %u particles", capacity);
+    return true;
+}
+
+void GpuParticleSystem::release() {
+    if (mBuffers[0] != 0) {
+        glDeleteBuffers(2, mBuffers);
+        mBuffers[0] = mBuffers[1] = 0;
+    }
+    if (mVertexArrays[0] != 0) {
+        glDeleteVertexArrays(2, mVertexArrays);
+        mVertexArrays[0] = mVertexArrays[1] = 0;
+    }
+    if (mTransformFeedbacks[0] != 0) {
+        glDeleteTransformFeedbacks(2, mTransformFeedbacks);
+        mTransformFeedbacks[0] = mTransformFeedbacks[1] = 0;
+    }
+    // Programs belong to the shader manager
+    mUpdateProgram = 0;
+    mRenderProgram = 0;
+
+    mPendingSpawns.clear();
+    mRingHead = 0;
+    mOccupied = 0;
+    mCurrent = 0;
+    mLifeRemaining = 0.0f;
+    mInitialized = false;
+}
+
+void GpuParticleSystem::abandon() {
+    mBuffers[0] = mBuffers[1] = 0;
+    mVertexArrays[0] = mVertexArrays[1] = 0;
+    mTransformFeedbacks[0] = mTransformFeedbacks[1] = 0;
+    release();
+}
+
+bool GpuParticleSystem::createPrograms(ShaderManager& shaders) {
+    const char* varyings[] = { "vPosVel", "vLifeSize", "vColor" };
+    if (!shaders.loadShader("particle_update", UPDATE_VERTEX_SHADER, UPDATE_FRAGMENT_SHADER, varyings, 3) ||
+        !shaders.loadShader("particle_render", RENDER_VERTEX_SHADER, RENDER_FRAGMENT_SHADER)) {
+        return false;
+    }
+    mUpdateProgram = shaders.getProgram("particle_update");
+    mRenderProgram = shaders.getProgram("particle_render");
+
+    mDeltaTimeLoc = glGetUniformLocation(mUpdateProgram, "uDeltaTime");
+    return true;
+}
+
+void GpuParticleSystem::createBuffers() {
+    // Unused slots start dead (life = 0) so they are skipped by both passes
+    std::vector<GpuParticle> initial(mCapacity);
+    memset(initial.data(), 0, initial.size() * sizeof(GpuParticle));
+    for (auto& p : initial) {
+        p.maxLife = 1.0f;
+    }
+
+    glGenBuffers(2, mBuffers);
+    glGenVertexArrays(2, mVertexArrays);
+    glGenTransformFeedbacks(2, mTransformFeedbacks);
+
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, mBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, mCapacity * sizeof(GpuParticle), initial.data(), GL_DYNAMIC_COPY);
+
+        glBindVertexArray(mVertexArrays[i]);
+        setupAttributes(mBuffers[i]);
+
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, mTransformFeedbacks[i]);
+        glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, mBuffers[i]);
+    }
+
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GpuParticleSystem::setupAttributes(GLuint buffer) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    GLsizei stride = sizeof(GpuParticle);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+}
+
+void GpuParticleSystem::spawn(const Particle* particles, uint32_t count) {
+    if (!mInitialized) return;
+
+    // Never queue more than one full ring; older entries would be overwritten anyway
+    if (count > mCapacity) {
+        particles += count - mCapacity;
+        count = mCapacity;
+    }
+
+    size_t first = mPendingSpawns.size();
+    mPendingSpawns.resize(first + count);
+    GpuParticle* out = mPendingSpawns.data() + first;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Particle& p = particles[i];
+        out[i] = { p.x, p.y, p.vx, p.vy,
+                   p.life, p.maxLife, p.size, 0.0f,
+                   p.r, p.g, p.b, p.a };
+        mLifeRemaining = std::max(mLifeRemaining, p.life);
+    }
+}
+
+void GpuParticleSystem::flushSpawns() {
+    if (mPendingSpawns.empty()) return;
+
+    // Keep only the newest ring's worth if several frames of spawns piled up
+    const GpuParticle* data = mPendingSpawns.data();
+    uint32_t count = static_cast<uint32_t>(mPendingSpawns.size());
+    if (count > mCapacity) {
+        data += count - mCapacity;
+        count = mCapacity;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffers[mCurrent]);
+
+    // Write into the ring, wrapping at most once
+    uint32_t firstChunk = std::min(count, mCapacity - mRingHead);
+    glBufferSubData(GL_ARRAY_BUFFER, mRingHead * sizeof(GpuParticle),
+                    firstChunk * sizeof(GpuParticle), data);
+    if (count > firstChunk) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (count - firstChunk) * sizeof(GpuParticle),
+                        data + firstChunk);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    mRingHead = (mRingHead + count) % mCapacity;
+    mOccupied = std::min(mCapacity, mOccupied + count);
+    mPendingSpawns.clear();
+}
+
+void GpuParticleSystem::update(float deltaTime) {
+    if (!mInitialized) return;
+
+    flushSpawns();
+    if (mOccupied == 0) return;
+
+    // Everything has died: no more passes until the next spawn, which
+    // starts the ring over
+    if (mLifeRemaining <= 0.0f) {
+        mOccupied = 0;
+        mRingHead = 0;
+        return;
+    }
+
+    int destination = 1 - mCurrent;
+
+    glUseProgram(mUpdateProgram);
+    glUniform1f(mDeltaTimeLoc, deltaTime);
+
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(mVertexArrays[mCurrent]);
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, mTransformFeedbacks[destination]);
+
+    // The whole ring is simulated so slot indices stay stable between buffers
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, mCapacity);
+    glEndTransformFeedback();
+
+    glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    mCurrent = destination;
+    mLifeRemaining -= deltaTime;
+}
+
+void GpuParticleSystem::render() {
+    if (!mInitialized || mOccupied == 0 || mLifeRemaining <= 0.0f) return;
+
+    glUseProgram(mRenderProgram);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glBindVertexArray(mVertexArrays[mCurrent]);
+    glDrawArrays(GL_POINTS, 0, mCapacity);
+    glBindVertexArray(0);
+}
+
+void GpuParticleSystem::readBack(std::vector<Particle>& out) {
+    out.clear();
+    if (!mInitialized) return;
+
+    flushSpawns();
+
+    glBindBuffer(GL_ARRAY_BUFFER, mBuffers[mCurrent]);
+    const auto* data = static_cast<const GpuParticle*>(
+        glMapBufferRange(GL_ARRAY_BUFFER, 0, mCapacity * sizeof(GpuParticle), GL_MAP_READ_BIT));
+    if (data == nullptr) {
+        LOGE("Failed to map particle buffer for readback");
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return;
+    }
+
+    // Slots are returned in spawn order, oldest first
+    out.reserve(mOccupied);
+    uint32_t start = (mRingHead + mCapacity - mOccupied) % mCapacity;
+    for (uint32_t i = 0; i < mOccupied; i++) {
+        const GpuParticle& g = data[(start + i) % mCapacity];
+        Particle p;
+        p.x = g.x;
+        p.y = g.y;
+        p.z = 0.0f;
+        p.vx = g.vx;
+        p.vy = g.vy;
+        p.vz = 0.0f;
+        p.life = g.life;
+        p.maxLife = g.maxLife;
+        p.size = g.size;
+        p.r = g.r;
+        p.g = g.g;
+        p.b = g.b;
+        p.a = g.a;
+        out.push_back(p);
+    }
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -1,57 +1,100 @@
-#include &quot;GraphicsEngine.h&quot;
-#include &lt;android/log.h&gt;
+#include "GraphicsEngine.h"
+#include <algorithm>
+#include <android/log.h>
+#include <chrono>
 
-#define TAG &quot;GraphicsEngine&quot;
+#define TAG "GraphicsEngine"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
 namespace trashapp {
 namespace graphics {
 
+// Android's ARGB to the sprite batcher's RGBA bytes
+static uint32_t spriteColor(uint32_t argb) {
+    return ((argb >> 16) & 0xffu) | (argb & 0xff00u) | ((argb & 0xffu) << 16) | (argb & 0xff000000u);
+}
+
+static double millisecondsBetween(std::chrono::steady_clock::time_point start,
+                                  std::chrono::steady_clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
 GraphicsEngine::GraphicsEngine() {
-    mRenderer = std::make_unique&lt;Renderer&gt;();
-    mShaderManager = std::make_unique&lt;ShaderManager&gt;();
-    mCardRenderer = std::make_unique&lt;CardRenderer&gt;();
-    mParticleEffect = std::make_unique&lt;ParticleEffect&gt;();
+    mRenderer = std::make_unique<Renderer>();
+    mShaderManager = std::make_unique<ShaderManager>();
+    mSprites = std::make_unique<SpriteBatcher>();
+    mSprites->setFrameArena(&mFrameArena);
+    mCardRenderer = std::make_unique<CardRenderer>();
+    mTextRenderer = std::make_unique<TextRenderer>();
+    mParticleEffect = std::make_unique<ParticleEffect>();
+    mTextureLoader = std::make_unique<TextureLoader>();
+    mScene = std::make_unique<SceneGraph>();
+    mTweens = std::make_unique<TweenEngine>();
 }
 
 GraphicsEngine::~GraphicsEngine() {
     release();
 }
 
-GraphicsEngine&amp; GraphicsEngine::getInstance() {
+GraphicsEngine& GraphicsEngine::getInstance() {
     static GraphicsEngine instance;
     return instance;
 }
 
-void GraphicsEngine::initialize(const GraphicsConfig&amp; config) {
+void GraphicsEngine::initialize(const GraphicsConfig& config) {
     if (mInitialized) {
-        LOGI(&quot;GraphicsEngine already initialized&quot;);
+        LOGI("GraphicsEngine already initialized");
         return;
     }
     
     mConfig = config;
+    mStartupTiming = {};
+    mInitializeStart = std::chrono::steady_clock::now();
+    auto stepStart = mInitializeStart;
+    auto step = [&stepStart]() {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = millisecondsBetween(stepStart, now);
+        stepStart = now;
+        return elapsed;
+    };
     
     // Initialize renderer
-    if (!mRenderer->initialize(config.width, config.height, config.msaaSamples)) {
-        LOGE(&quot;Failed to initialize renderer&quot;);
+    if (!mRenderer->initialize(config.width, config.height, config.msaaSamples, config.enableVSync,
+                               config.offscreen)) {
+        LOGE("Failed to initialize renderer");
         return;
     }
+    mStartupTiming.rendererMilliseconds = step();
+    Profiler::getInstance().setThreadName("Render");
+    Profiler::getInstance().initializeGpu();
     
-    // Initialize shader manager
-    mShaderManager->initialize();
+    // Initialize shader manager, with program binaries cached beside the atlas
+    mShaderManager->initialize(mCacheDirectory.empty() ? std::string() : mCacheDirectory + "/shaders");
     
-    // Initialize card renderer
-    mCardRenderer->initialize();
+    // Submit every program up front; the driver compiles them while the
+    // card atlas is built and results are collected as frames are rendered
+    setWildWestTheme();
+    mSprites->initialize(*mShaderManager);
+    mParticleEffect->initialize(*mShaderManager, *mSprites);
+    mScene->initialize(*mShaderManager);
+    mStartupTiming.shaderSubmitMilliseconds = step();
     
-    // Initialize particle effects
-    mParticleEffect->initialize();
+    // Initialize card and text renderers (build or load their atlases)
+    mCardRenderer->initialize(*mSprites, mCacheDirectory);
+    mTextRenderer->initialize(*mShaderManager, *mSprites, mCacheDirectory);
+    mStartupTiming.cardRendererMilliseconds = step();
     
-    // Load Wild West shaders
-    setWildWestTheme();
+    // Start the texture streaming worker
+    mTextureLoader->initialize();
+    mStartupTiming.textureLoaderMilliseconds = step();
+    
+    mStartupTiming.initializeMilliseconds = millisecondsBetween(mInitializeStart, stepStart);
+    mShadersPending = true;
+    pollShaderWarmup();
     
     mInitialized = true;
-    LOGI(&quot;GraphicsEngine initialized: %dx%d&quot;, config.width, config.height);
+    LOGI("GraphicsEngine initialized: %dx%d", config.width, config.height);
 }
 
 void GraphicsEngine::resize(int width, int height) {
@@ -60,47 +103,262 @@ void GraphicsEngine::resize(int width, int height) {
     }
     mConfig.width = width;
     mConfig.height = height;
+    mScene->invalidate();
 }
 
 void GraphicsEngine::render() {
-    if (!mInitialized) return;
+    // An unchanged retained scene is already on screen
+    if (mScene->hasContent() && !needsRender()) {
+        mScene->noteSkippedFrame();
+        return;
+    }
+    if (!beginFrame()) return;
+    endFrame();
+}
+
+bool GraphicsEngine::needsRender() {
+    if (!mInitialized) return false;
+    return mImmediateDrawn || mShadersPending || mRenderer->isContextLost() ||
+           mScene->isDirty() || mParticleEffect->isAnimating() || mTweens->isAnimating() ||
+           !mScheduledEffects.empty();
+}
+
+bool GraphicsEngine::beginFrame() {
+    if (!mInitialized) return false;
     
-    // Render current frame
-    mRenderer->beginFrame();
+    if (mRenderer->isContextLost() && !restoreContext()) return false;
+    // Nothing to present to while paused
+    if (!mRenderer->hasTarget()) return false;
     
-    // Update and render particles
-    mParticleEffect->render();
+    Profiler& profiler = Profiler::getInstance();
+    profiler.beginFrame();
+    mFrameStartNanos = Profiler::nowNanos();
+    mFrameGpuScope = profiler.beginGpuScope("frame");
+    PROFILE_SCOPE("engine.beginFrame");
+    mFrameArena.reset();
     
-    mRenderer->endFrame();
+    // Collect programs that finished compiling; until then their draws are skipped
+    if (mShadersPending) {
+        pollShaderWarmup();
+    }
+    
+    // Stream pending texture mip levels before drawing
+    {
+        PROFILE_SCOPE("textures.upload");
+        mTextureLoader->processUploads(mTextureUploadBudget);
+    }
+    
+    // Animated nodes move before the layer catches up with them
+    advanceAnimations();
+    
+    // Render current frame. The scene layer is patched in its own pass
+    // first; when it can be shown it covers the whole frame, so the frame
+    // target's old contents are not even cleared.
+    mRenderer->prepareFrame();
+    releaseScheduledEffects();
+    mSprites->beginFrame();
+    bool layered = false;
+    if (mScene->hasContent()) {
+        PROFILE_SCOPE("scene.layer");
+        PROFILE_GPU_SCOPE("scene.layer");
+        layered = mScene->updateLayer(*mRenderer, *mCardRenderer, *mSprites,
+                                      mVintageEffectEnabled, mWoodGrainEnabled);
+        for (const SceneEffectMove& move : mScene->getEffectMoves()) {
+            mParticleEffect->moveEmitter(move.emitterId, move.x, move.y);
+        }
+        mScene->getEffectMoves().clear();
+    }
+    
+    RenderPassDescriptor framePass = mRenderer->getFramePass();
+    if (layered) {
+        framePass.colorLoad = LoadAction::DontCare;
+    }
+    mRenderer->beginFramePass(framePass);
+    if (layered) {
+        mScene->composite();
+    } else if (mScene->hasContent()) {
+        mScene->drawDirect(*mCardRenderer, mVintageEffectEnabled, mWoodGrainEnabled);
+    }
+    return true;
+}
+
+void GraphicsEngine::endFrame() {
+    {
+        PROFILE_SCOPE("engine.endFrame");
+        // Particles go last so GPU-simulated ones cover every queued card
+        mParticleEffect->render();
+        mSprites->endFrame();
+        mRenderer->endFrame();
+    }
+    Profiler& profiler = Profiler::getInstance();
+    profiler.endGpuScope(mFrameGpuScope);
+    mFrameGpuScope = -1;
+    profiler.endFrame();
     presentFrame();
+    // The whole frame, swap included, spans two calls
+    if (profiler.isEnabled()) {
+        profiler.record("frame", mFrameStartNanos, Profiler::nowNanos());
+    }
+    mImmediateDrawn = false;
+}
+
+bool GraphicsEngine::readPixels(std::vector<uint8_t>& rgba) {
+    return mInitialized && mRenderer->readPixels(rgba);
+}
+
+bool GraphicsEngine::attachWindow(ANativeWindow* window) {
+    if (!mInitialized) {
+        LOGE("attachWindow before initialize");
+        return false;
+    }
+    if (!mRenderer->attachWindow(window)) return false;
+    
+    mConfig.width = mRenderer->getWidth();
+    mConfig.height = mRenderer->getHeight();
+    // A new window starts out blank
+    mScene->invalidate();
+    return true;
+}
+
+void GraphicsEngine::detachWindow() {
+    mRenderer->detachWindow();
+}
+
+SurfaceStats GraphicsEngine::getSurfaceStats() {
+    SurfaceStats stats = mRenderer->getSurfaceStats();
+    stats.contextRestoreMilliseconds = mContextRestoreMilliseconds;
+    return stats;
+}
+
+bool GraphicsEngine::restoreContext() {
+    auto start = std::chrono::steady_clock::now();
+    
+    // Every handle is dead; forget them before the new context hands out the same ids
+    mShaderManager->onContextLost();
+    mSprites->onContextLost();
+    mCardRenderer->onContextLost();
+    mTextRenderer->onContextLost();
+    mParticleEffect->onContextLost();
+    mScene->onContextLost();
+    mTextureLoader->onContextLost();
+    Profiler::getInstance().abandonGpu();
+    
+    if (!mRenderer->recoverContext()) {
+        LOGE("Context recovery failed");
+        return false;
+    }
+    
+    // Rebuilt from memory: shader sources, atlas pixels and texture mappings.
+    // Cards and textures come back lazily as frames are drawn.
+    mShaderManager->restorePrograms();
+    mParticleEffect->restoreAfterContextLoss();
+    Profiler::getInstance().initializeGpu();
+    
+    mContextRestoreMilliseconds = millisecondsBetween(start, std::chrono::steady_clock::now());
+    LOGI("GPU state restored in %.1f ms", mContextRestoreMilliseconds);
+    return true;
 }
 
 void GraphicsEngine::release() {
     if (!mInitialized) return;
     
+    mTextureLoader->release();
+    mScene->release();
     mParticleEffect->release();
+    mTextRenderer->release();
     mCardRenderer->release();
+    mSprites->release();
     mShaderManager->release();
+    Profiler::getInstance().releaseGpu();
     mRenderer->release();
+    mScheduledEffects.clear();
     
     mInitialized = false;
-    LOGI(&quot;GraphicsEngine released&quot;);
+    LOGI("GraphicsEngine released");
 }
 
 void GraphicsEngine::clearScreen(float r, float g, float b, float a) {
     if (mRenderer) {
+        // The scene layer notices a new background itself
+        const float* current = mRenderer->getFramePass().clearColor;
+        if (current[0] != r || current[1] != g || current[2] != b || current[3] != a) {
+            mImmediateDrawn = true;
+        }
         mRenderer->clear(r, g, b, a);
     }
 }
 
 void GraphicsEngine::presentFrame() {
+    PROFILE_SCOPE("present");
     if (mRenderer) {
         mRenderer->present();
     }
 }
 
+void GraphicsEngine::setVSync(bool enabled) {
+    mConfig.enableVSync = enabled;
+    mRenderer->setVSync(enabled);
+}
+
+void GraphicsEngine::setTargetFrameRate(int framesPerSecond) {
+    mRenderer->setTargetFrameRate(framesPerSecond);
+}
+
+void GraphicsEngine::setDisplayRefreshRate(float hz) {
+    mRenderer->setDisplayRefreshRate(hz);
+}
+
+void GraphicsEngine::onVsync(int64_t frameTimeNanos) {
+    mRenderer->onVsync(frameTimeNanos);
+}
+
+FrameTimingStats GraphicsEngine::getFrameTiming() {
+    return mRenderer->getFrameTiming();
+}
+
+void GraphicsEngine::setRenderScale(float scale) {
+    mRenderer->setRenderScale(scale);
+    mScene->invalidate();
+}
+
+void GraphicsEngine::setDynamicResolution(bool enabled, float minScale) {
+    mRenderer->setDynamicResolution(enabled, minScale);
+    mScene->invalidate();
+}
+
+RenderScaleStats GraphicsEngine::getRenderScaleStats() {
+    return mRenderer->getRenderScaleStats();
+}
+
+CameraState GraphicsEngine::getCameraState() {
+    return mRenderer->getCamera().getState();
+}
+
+void GraphicsEngine::screenToWorld(float screenX, float screenY, float& worldX, float& worldY) {
+    mRenderer->getCamera().screenToWorld(screenX, screenY, worldX, worldY);
+}
+
+void GraphicsEngine::setMsaaSamples(int samples) {
+    mConfig.msaaSamples = samples;
+    mRenderer->setMsaaSamples(samples);
+    mScene->invalidate();
+}
+
+MsaaStats GraphicsEngine::getMsaaStats() {
+    return mRenderer->getMsaaStats();
+}
+
+RenderPassStats GraphicsEngine::getRenderPassStats() {
+    return mRenderer->getRenderPassStats();
+}
+
+void GraphicsEngine::setCacheDirectory(const char* path) {
+    mCacheDirectory = path ? path : "";
+}
+
 void GraphicsEngine::renderCard(float x, float y, float width, float height,
                                 const char* suit, const char* rank, bool faceUp) {
+    mImmediateDrawn = true;
     if (faceUp) {
         mCardRenderer->renderFace(x, y, width, height, suit, rank, mVintageEffectEnabled);
     } else {
@@ -108,29 +366,403 @@ void GraphicsEngine::renderCard(float x, float y, float width, float height,
     }
 }
 
+int GraphicsEngine::getCardId(const char* suit, const char* rank) {
+    return mCardRenderer->getCardId(suit, rank);
+}
+
+void GraphicsEngine::renderCardById(float x, float y, float width, float height,
+                                    int cardId, bool faceUp) {
+    mImmediateDrawn = true;
+    if (faceUp) {
+        mCardRenderer->renderFace(x, y, width, height, cardId, mVintageEffectEnabled);
+    } else {
+        mCardRenderer->renderBack(x, y, width, height, mWoodGrainEnabled);
+    }
+}
+
+void GraphicsEngine::renderCards(const CardRecord* records, size_t count) {
+    if (count == 0) return;
+    mImmediateDrawn = true;
+    mCardRenderer->renderRecords(records, count, mVintageEffectEnabled, mWoodGrainEnabled);
+}
+
 void GraphicsEngine::renderCardBack(float x, float y, float width, float height) {
+    mImmediateDrawn = true;
     mCardRenderer->renderBack(x, y, width, height, mWoodGrainEnabled);
 }
 
+void GraphicsEngine::drawSprite(const Sprite& sprite) {
+    mImmediateDrawn = true;
+    mSprites->draw(sprite);
+}
+
+void GraphicsEngine::drawTexture(TextureHandle handle, float x, float y, float width, float height,
+                                 uint32_t argb, BlendMode blend, int layer) {
+    GLuint texture = mTextureLoader->getTexture(handle);
+    if (texture == 0) return;
+    
+    Sprite sprite;
+    sprite.x = x;
+    sprite.y = y;
+    sprite.width = width;
+    sprite.height = height;
+    sprite.color = spriteColor(argb);
+    sprite.texture = texture;
+    sprite.blend = blend;
+    sprite.layer = layer;
+    drawSprite(sprite);
+}
+
+BatchStats GraphicsEngine::getSpriteBatchStats() {
+    return mSprites->getStats();
+}
+
+float GraphicsEngine::drawText(const char* text, float x, float y, float capHeight,
+                               uint32_t argb, int layer) {
+    mImmediateDrawn = true;
+    return mTextRenderer->drawText(text, x, y, capHeight, spriteColor(argb), layer);
+}
+
+float GraphicsEngine::measureText(const char* text, float capHeight) {
+    return mTextRenderer->measureText(text, capHeight);
+}
+
+void GraphicsEngine::drawSuitPip(int suit, float x, float y, float size, uint32_t argb, int layer) {
+    static const uint32_t PIPS[CardAtlas::SUIT_COUNT] = {
+        GlyphAtlas::SPADE, GlyphAtlas::HEART, GlyphAtlas::CLUB, GlyphAtlas::DIAMOND
+    };
+    uint32_t codepoint = suit >= 0 && suit < CardAtlas::SUIT_COUNT ? PIPS[suit] : GlyphAtlas::STAR;
+    mImmediateDrawn = true;
+    mTextRenderer->drawGlyph(codepoint, x, y, size, spriteColor(argb), layer);
+}
+
+int GraphicsEngine::createSceneGroup(int parent, float x, float y) {
+    int id = mScene->createNode(SceneNodeType::Group, parent);
+    mScene->setPosition(id, x, y);
+    return id;
+}
+
+int GraphicsEngine::createSceneCard(int parent, float x, float y, float width, float height,
+                                    int cardId, bool faceUp) {
+    int id = mScene->createNode(SceneNodeType::Card, parent);
+    mScene->setPosition(id, x, y);
+    mScene->setSize(id, width, height);
+    mScene->setCard(id, cardId, faceUp);
+    return id;
+}
+
+int GraphicsEngine::createSceneEffect(int parent, float x, float y, int emitterHandle) {
+    int id = mScene->createNode(SceneNodeType::Effect, parent);
+    if (id == 0) return 0;
+    mScene->setPosition(id, x, y);
+    
+    float worldX, worldY;
+    mScene->getWorldPosition(id, worldX, worldY);
+    mScene->setEmitter(id, mParticleEffect->startEmitter(static_cast<EmitterHandle>(emitterHandle),
+                                                         worldX, worldY));
+    return id;
+}
+
+void GraphicsEngine::setSceneNodePosition(int id, float x, float y) {
+    mScene->setPosition(id, x, y);
+}
+
+void GraphicsEngine::setSceneNodeSize(int id, float width, float height) {
+    mScene->setSize(id, width, height);
+}
+
+void GraphicsEngine::setSceneCard(int id, int cardId, bool faceUp) {
+    mScene->setCard(id, cardId, faceUp);
+}
+
+void GraphicsEngine::setSceneNodeVisible(int id, bool visible) {
+    mScene->setVisible(id, visible);
+}
+
+void GraphicsEngine::setSceneNodeOrder(int id, int order) {
+    mScene->setOrder(id, order);
+}
+
+void GraphicsEngine::destroySceneNode(int id) {
+    mStoppedEmitters.clear();
+    mScene->destroyNode(id, mStoppedEmitters);
+    for (int emitterId : mStoppedEmitters) {
+        mParticleEffect->stopEmitter(emitterId);
+    }
+}
+
+void GraphicsEngine::clearScene() {
+    mTweens->clear();
+    mStoppedEmitters.clear();
+    mScene->clear(mStoppedEmitters);
+    for (int emitterId : mStoppedEmitters) {
+        mParticleEffect->stopEmitter(emitterId);
+    }
+}
+
+void GraphicsEngine::invalidateScene() {
+    mScene->invalidate();
+}
+
+SceneStats GraphicsEngine::getSceneStats() {
+    return mScene->getStats();
+}
+
+void GraphicsEngine::prepareAnimation() {
+    // Time spent idle does not count towards the first step
+    if (!mTweens->isAnimating()) {
+        mLastAnimationTime = std::chrono::steady_clock::now();
+    }
+}
+
+void GraphicsEngine::advanceAnimations() {
+    PROFILE_SCOPE("animations");
+    auto now = std::chrono::steady_clock::now();
+    if (mTweens->isAnimating()) {
+        float step = mAnimationTimeStep;
+        if (step <= 0.0f) {
+            step = std::min(std::chrono::duration<float>(now - mLastAnimationTime).count(),
+                            MAX_ANIMATION_STEP);
+        }
+        mTweens->update(step, *mScene);
+    }
+    mLastAnimationTime = now;
+}
+
+int GraphicsEngine::animateSceneNode(int id, TweenChannel channel, const TweenKey* keys,
+                                     size_t keyCount, float delay) {
+    prepareAnimation();
+    return mTweens->addTrack(0, id, channel, keys, keyCount, delay);
+}
+
+int GraphicsEngine::moveSceneNode(int id, float x, float y, float duration, float delay,
+                                  Easing easing) {
+    prepareAnimation();
+    TweenKey keys[2] = {{0.0f, TweenEngine::CURRENT, Easing::Linear}, {duration, x, easing}};
+    int animation = mTweens->addTrack(0, id, TweenChannel::X, keys, 2, delay);
+    keys[1].value = y;
+    return mTweens->addTrack(animation, id, TweenChannel::Y, keys, 2, delay);
+}
+
+int GraphicsEngine::flipSceneCard(int id, int cardId, bool faceUp, float duration, float delay) {
+    prepareAnimation();
+    float half = duration * 0.5f;
+    const TweenKey keys[3] = {
+        {0.0f, TweenEngine::CURRENT, Easing::Linear},
+        {half, 0.0f, Easing::QuadIn},
+        {duration, 1.0f, Easing::QuadOut}
+    };
+    int animation = mTweens->addTrack(0, id, TweenChannel::ScaleX, keys, 3, delay);
+    return mTweens->addCardChange(animation, id, delay + half, cardId, faceUp);
+}
+
+void GraphicsEngine::cancelAnimation(int animation, bool finish) {
+    mTweens->cancel(animation, finish, *mScene);
+}
+
+bool GraphicsEngine::isAnimationActive(int animation) {
+    return mTweens->isActive(animation);
+}
+
+TweenStats GraphicsEngine::getAnimationStats() {
+    return mTweens->getStats();
+}
+
+void GraphicsEngine::setAnimationTimeStep(float seconds) {
+    mAnimationTimeStep = std::max(seconds, 0.0f);
+}
+
+void GraphicsEngine::setProfilingEnabled(bool enabled) {
+    Profiler::getInstance().setEnabled(enabled);
+}
+
+void GraphicsEngine::clearProfile() {
+    Profiler::getInstance().clear();
+}
+
+bool GraphicsEngine::exportProfile(const char* path) {
+    return path != nullptr && Profiler::getInstance().exportChromeTrace(path);
+}
+
+ProfilerStats GraphicsEngine::getProfilerStats() {
+    return Profiler::getInstance().getStats();
+}
+
+GraphicsMemoryStats GraphicsEngine::getMemoryStats() {
+    GraphicsMemoryStats stats = {};
+    for (int tag = 0; tag < static_cast<int>(MemoryTag::Count); tag++) {
+        stats.tags[tag] = MemoryTracker::getStats(static_cast<MemoryTag>(tag));
+    }
+    stats.frameArena = mFrameArena.getStats();
+    return stats;
+}
+
 void GraphicsEngine::addParticleEffect(const char* effectType, float x, float y) {
     mParticleEffect->spawn(effectType, x, y);
 }
 
+int64_t GraphicsEngine::getNextPresentTimeNanos() {
+    if (!mInitialized) return Profiler::nowNanos();
+    return mRenderer->predictNextPresentNanos();
+}
+
+void GraphicsEngine::addParticleEffectAt(const char* effectType, float x, float y,
+                                         int64_t presentTimeNanos) {
+    mScheduledEffects.push_back({effectType, x, y, presentTimeNanos});
+}
+
+void GraphicsEngine::releaseScheduledEffects() {
+    if (mScheduledEffects.empty()) return;
+    
+    int64_t framePresent = mRenderer->getFramePresentNanos();
+    int64_t halfFrame = mRenderer->getFramePeriodNanos() / 2;
+    size_t kept = 0;
+    for (size_t i = 0; i < mScheduledEffects.size(); i++) {
+        ScheduledEffect& effect = mScheduledEffects[i];
+        if (!mRenderer->framePresentsBy(effect.presentNanos)) {
+            mScheduledEffects[kept++] = std::move(effect);
+            continue;
+        }
+        mParticleEffect->spawn(effect.effectType.c_str(), effect.x, effect.y);
+        
+        // Past the closest frame means the request came in too late for it
+        int64_t error = framePresent - effect.presentNanos;
+        mScheduledEffectCount++;
+        if (error > halfFrame) {
+            mLateEffectCount++;
+        }
+        mAverageSyncErrorMilliseconds += (error / 1.0e6 - mAverageSyncErrorMilliseconds) /
+            static_cast<double>(std::min<uint64_t>(mScheduledEffectCount, 32));
+    }
+    mScheduledEffects.resize(kept);
+}
+
+SyncStats GraphicsEngine::getSyncStats() {
+    SyncStats stats = {};
+    if (mRenderer) {
+        stats.presentLatencyMilliseconds = mRenderer->getFrameTiming().presentLatencyMilliseconds;
+    }
+    stats.pendingEffects = static_cast<int>(mScheduledEffects.size());
+    stats.scheduledEffects = mScheduledEffectCount;
+    stats.lateEffects = mLateEffectCount;
+    stats.averageErrorMilliseconds = mAverageSyncErrorMilliseconds;
+    return stats;
+}
+
 void GraphicsEngine::updateParticles(float deltaTime) {
     mParticleEffect->update(deltaTime);
 }
 
+bool GraphicsEngine::loadParticleEmitters(const char* json, size_t length) {
+    return mParticleEffect->loadEmitters(json, length);
+}
+
+int GraphicsEngine::findParticleEmitter(const char* name) {
+    return mParticleEffect->findEmitter(name);
+}
+
+void GraphicsEngine::spawnParticleEmitter(int emitterHandle, float x, float y) {
+    mParticleEffect->spawn(static_cast<EmitterHandle>(emitterHandle), x, y);
+}
+
+int GraphicsEngine::startParticleEmitter(int emitterHandle, float x, float y) {
+    return mParticleEffect->startEmitter(static_cast<EmitterHandle>(emitterHandle), x, y);
+}
+
+void GraphicsEngine::moveParticleEmitter(int emitterId, float x, float y) {
+    mParticleEffect->moveEmitter(emitterId, x, y);
+}
+
+void GraphicsEngine::stopParticleEmitter(int emitterId) {
+    mParticleEffect->stopEmitter(emitterId);
+}
+
+bool GraphicsEngine::setParticleBackend(ParticleBackend backend) {
+    return mParticleEffect->setBackend(backend);
+}
+
+ParticleValidationResult GraphicsEngine::validateParticleBackend(int sampleCount, int steps) {
+    // Dust has randomized offsets, velocities and sizes, so it exercises every attribute
+    EmitterHandle handle = mParticleEffect->findEmitter("dust");
+    return mParticleEffect->validateGpuBackend(handle, static_cast<uint32_t>(sampleCount),
+                                               steps, 1.0f / 60.0f);
+}
+
+TextureHandle GraphicsEngine::loadTexture(const char* path) {
+    return mTextureLoader->load(path);
+}
+
+TextureHandle GraphicsEngine::loadTextureFromFd(int fd, int64_t offset, int64_t length) {
+    return mTextureLoader->loadFromFd(fd, offset, length);
+}
+
+void GraphicsEngine::releaseTexture(TextureHandle handle) {
+    mTextureLoader->releaseTexture(handle);
+}
+
+GLuint GraphicsEngine::getTexture(TextureHandle handle) {
+    return mTextureLoader->getTexture(handle);
+}
+
+TextureState GraphicsEngine::getTextureState(TextureHandle handle) {
+    return mTextureLoader->getState(handle);
+}
+
+TextureMemoryStats GraphicsEngine::getTextureMemoryStats() {
+    return mTextureLoader->getMemoryStats();
+}
+
+void GraphicsEngine::setTextureUploadBudget(size_t bytesPerFrame) {
+    mTextureUploadBudget = bytesPerFrame;
+}
+
 void GraphicsEngine::loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc) {
     mShaderManager->loadShader(name, vertexSrc, fragmentSrc);
 }
 
 void GraphicsEngine::useShader(const char* name) {
+    // Sprites queued so far draw before anything using this program
+    mSprites->flush();
     mShaderManager->useShader(name);
 }
 
+void GraphicsEngine::pollShaderWarmup() {
+    mStartupTiming.pendingShaders = static_cast<int>(mShaderManager->pollShaders(false));
+    if (mStartupTiming.pendingShaders > 0) return;
+    
+    mShadersPending = false;
+    // Cards drawn before their program was ready are missing from the layer
+    mScene->invalidate();
+    mStartupTiming.shadersReadyMilliseconds =
+        millisecondsBetween(mInitializeStart, std::chrono::steady_clock::now());
+    
+    LOGI("Startup: renderer %.1f ms, shader submit %.1f ms, card renderer %.1f ms, "
+         "texture loader %.1f ms, initialize %.1f ms, all shaders ready at %.1f ms",
+         mStartupTiming.rendererMilliseconds, mStartupTiming.shaderSubmitMilliseconds,
+         mStartupTiming.cardRendererMilliseconds, mStartupTiming.textureLoaderMilliseconds,
+         mStartupTiming.initializeMilliseconds, mStartupTiming.shadersReadyMilliseconds);
+    
+    const ShaderCacheStats& shaderStats = mShaderManager->getCacheStats();
+    LOGI("Shader cache: %u hits, %u misses (%u rejected), compiled %.1f ms, loaded %.1f ms, saved %.1f ms",
+         shaderStats.hits, shaderStats.misses, shaderStats.rejected,
+         shaderStats.compileMilliseconds, shaderStats.loadMilliseconds, shaderStats.savedMilliseconds);
+}
+
+bool GraphicsEngine::isShaderReady(const char* name) {
+    return mShaderManager->isShaderReady(name);
+}
+
+StartupTiming GraphicsEngine::getStartupTiming() {
+    return mStartupTiming;
+}
+
+ShaderCacheStats GraphicsEngine::getShaderCacheStats() {
+    return mShaderManager->getCacheStats();
+}
+
 void GraphicsEngine::setWildWestTheme() {
     // Load Wild West themed shaders
-    const char* woodVertexShader = R&quot;(
+    const char* woodVertexShader = R"(
         attribute vec4 position;
         attribute vec2 texCoord;
         varying vec2 vTexCoord;
@@ -140,9 +772,9 @@ void GraphicsEngine::setWildWestTheme() {
             gl_Position = projection * position;
             vTexCoord = texCoord;
         }
-    )&quot;;
+    )";
     
-    const char* woodFragmentShader = R&quot;(
+    const char* woodFragmentShader = R"(
         precision mediump float;
         varying vec2 vTexCoord;
         uniform float time;
@@ -158,9 +790,9 @@ void GraphicsEngine::setWildWestTheme() {
             vec4 finalColor = texColor + vec4(grain, grain * 0.8, grain * 0.6, 0.0);
             gl_FragColor = finalColor;
         }
-    )&quot;;
+    )";
     
-    const char* vintageFragmentShader = R&quot;(
+    const char* vintageFragmentShader = R"(
         precision mediump float;
         varying vec2 vTexCoord;
         uniform sampler2D texture;
@@ -180,10 +812,10 @@ void GraphicsEngine::setWildWestTheme() {
             vec4 finalColor = vec4(sepia * vignette, texColor.a);
             gl_FragColor = finalColor;
         }
-    )&quot;;
+    )";
     
-    mShaderManager->loadShader(&quot;wood_grain&quot;, woodVertexShader, woodFragmentShader);
-    mShaderManager->loadShader(&quot;vintage&quot;, woodVertexShader, vintageFragmentShader);
+    mShaderManager->submitShader("wood_grain", woodVertexShader, woodFragmentShader);
+    mShaderManager->submitShader("vintage", woodVertexShader, vintageFragmentShader);
 }
 
 void GraphicsEngine::enableWoodGrainEffect(bool enable) {
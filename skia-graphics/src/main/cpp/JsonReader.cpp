@@ -0,0 +1,257 @@
+#include "JsonReader.h"
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
+namespace trashapp {
+namespace graphics {
+
+double JsonValue::asNumber(double fallback) const {
+    return mType == Type::Number ? mNumber : fallback;
+}
+
+bool JsonValue::asBool(bool fallback) const {
+    return mType == Type::Bool ? mBool : fallback;
+}
+
+const JsonValue* JsonValue::find(const char* key) const {
+    if (mType != Type::Object) return nullptr;
+
+    for (const auto& member : mMembers) {
+        if (member.first == key) {
+            return &member.second;
+        }
+    }
+    return nullptr;
+}
+
+bool JsonReader::parse(const char* text, size_t length, JsonValue& out, std::string& error) {
+    JsonReader reader(text, length);
+
+    if (!reader.parseValue(out, 0)) {
+        error = reader.mError;
+        return false;
+    }
+
+    reader.skipWhitespace();
+    if (reader.mPos != reader.mLength) {
+        reader.fail("Trailing characters after document");
+        error = reader.mError;
+        return false;
+    }
+
+    return true;
+}
+
+void JsonReader::skipWhitespace() {
+    while (mPos < mLength) {
+        char c = mText[mPos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        mPos++;
+    }
+}
+
+bool JsonReader::fail(const char* message) {
+    char buffer[128];
+    snprintf(buffer, sizeof(buffer), "%s at offset %zu", message, mPos);
+    mError = buffer;
+    return false;
+}
+
+bool JsonReader::parseValue(JsonValue& out, int depth) {
+    if (depth > MAX_DEPTH) {
+        return fail("Document nested too deeply");
+    }
+
+    skipWhitespace();
+    if (mPos >= mLength) {
+        return fail("Unexpected end of document");
+    }
+
+    switch (mText[mPos]) {
+        case '{':
+            return parseObject(out, depth);
+        case '[':
+            return parseArray(out, depth);
+        case '"':
+            out.mType = JsonValue::Type::String;
+            return parseString(out.mString);
+        case 't':
+            return parseLiteral("true", out, JsonValue::Type::Bool, true);
+        case 'f':
+            return parseLiteral("false", out, JsonValue::Type::Bool, false);
+        case 'n':
+            return parseLiteral("null", out, JsonValue::Type::Null, false);
+        default:
+            return parseNumber(out);
+    }
+}
+
+bool JsonReader::parseObject(JsonValue& out, int depth) {
+    out.mType = JsonValue::Type::Object;
+    mPos++; // '{'
+
+    skipWhitespace();
+    if (mPos < mLength && mText[mPos] == '}') {
+        mPos++;
+        return true;
+    }
+
+    while (true) {
+        skipWhitespace();
+        if (mPos >= mLength || mText[mPos] != '"') {
+            return fail("Expected object key");
+        }
+
+        std::string key;
+        if (!parseString(key)) return false;
+
+        skipWhitespace();
+        if (mPos >= mLength || mText[mPos] != ':') {
+            return fail("Expected ':'");
+        }
+        mPos++;
+
+        out.mMembers.emplace_back(std::move(key), JsonValue());
+        if (!parseValue(out.mMembers.back().second, depth + 1)) return false;
+
+        skipWhitespace();
+        if (mPos >= mLength) {
+            return fail("Unterminated object");
+        }
+        if (mText[mPos] == ',') {
+            mPos++;
+            continue;
+        }
+        if (mText[mPos] == '}') {
+            mPos++;
+            return true;
+        }
+        return fail("Expected ',' or '}'");
+    }
+}
+
+bool JsonReader::parseArray(JsonValue& out, int depth) {
+    out.mType = JsonValue::Type::Array;
+    mPos++; // '['
+
+    skipWhitespace();
+    if (mPos < mLength && mText[mPos] == ']') {
+        mPos++;
+        return true;
+    }
+
+    while (true) {
+        out.mElements.emplace_back();
+        if (!parseValue(out.mElements.back(), depth + 1)) return false;
+
+        skipWhitespace();
+        if (mPos >= mLength) {
+            return fail("Unterminated array");
+        }
+        if (mText[mPos] == ',') {
+            mPos++;
+            continue;
+        }
+        if (mText[mPos] == ']') {
+            mPos++;
+            return true;
+        }
+        return fail("Expected ',' or ']'");
+    }
+}
+
+bool JsonReader::parseString(std::string& out) {
+    mPos++; // opening quote
+
+    while (mPos < mLength) {
+        char c = mText[mPos++];
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            out.push_back(c);
+            continue;
+        }
+
+        if (mPos >= mLength) break;
+        char escape = mText[mPos++];
+        switch (escape) {
+            case '"':  out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/':  out.push_back('/'); break;
+            case 'b':  out.push_back('\b'); break;
+            case 'f':  out.push_back('\f'); break;
+            case 'n':  out.push_back('\n'); break;
+            case 'r':  out.push_back('\r'); break;
+            case 't':  out.push_back('\t'); break;
+            case 'u': {
+                if (mPos + 4 > mLength) return fail("Truncated unicode escape");
+                char hex[5] = { mText[mPos], mText[mPos + 1], mText[mPos + 2], mText[mPos + 3], 0 };
+                unsigned long code = strtoul(hex, nullptr, 16);
+                mPos += 4;
+                // Asset names are ASCII; encode the BMP code point as UTF-8
+                if (code < 0x80) {
+                    out.push_back(static_cast<char>(code));
+                } else if (code < 0x800) {
+                    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                } else {
+                    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default:
+                return fail("Invalid escape sequence");
+        }
+    }
+
+    return fail("Unterminated string");
+}
+
+bool JsonReader::parseNumber(JsonValue& out) {
+    // strtod needs a terminated buffer; numbers in assets are short
+    char buffer[64];
+    size_t length = 0;
+    while (mPos + length < mLength && length < sizeof(buffer) - 1) {
+        char c = mText[mPos + length];
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            buffer[length++] = c;
+        } else {
+            break;
+        }
+    }
+    buffer[length] = 0;
+
+    if (length == 0) {
+        return fail("Unexpected character");
+    }
+
+    char* end = nullptr;
+    double value = strtod(buffer, &end);
+    if (end != buffer + length) {
+        return fail("Malformed number");
+    }
+
+    out.mType = JsonValue::Type::Number;
+    out.mNumber = value;
+    mPos += length;
+    return true;
+}
+
+bool JsonReader::parseLiteral(const char* literal, JsonValue& out, JsonValue::Type type, bool value) {
+    size_t length = strlen(literal);
+    if (mPos + length > mLength || strncmp(mText + mPos, literal, length) != 0) {
+        return fail("Invalid literal");
+    }
+
+    out.mType = type;
+    out.mBool = value;
+    mPos += length;
+    return true;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,18 @@
+#include "MemoryTracker.h"
+
+namespace trashapp {
+namespace graphics {
+
+const char* MemoryTracker::tagName(MemoryTag tag) {
+    switch (tag) {
+        case MemoryTag::Particles:  return "particles";
+        case MemoryTag::Sprites:    return "sprites";
+        case MemoryTag::Scene:      return "scene";
+        case MemoryTag::Animation:  return "animation";
+        case MemoryTag::FrameArena: return "frame_arena";
+        default:                    return "unknown";
+    }
+}
+
+} // namespace graphics
+} // namespace trashapp
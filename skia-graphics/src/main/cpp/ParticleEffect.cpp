@@ -1,117 +1,91 @@
-#include &quot;ParticleEffect.h&quot;
-#include &lt;android/log.h&gt;
-#include &lt;cmath&gt;
-#include &lt;random&gt;
+#include "ParticleEffect.h"
+#include "GpuParticleSystem.h"
+#include "Profiler.h"
+#include "ShaderManager.h"
+#include "SpriteBatcher.h"
+#include <android/log.h>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
 
-#define TAG &quot;ParticleEffect&quot;
+#define TAG "ParticleEffect"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
 namespace trashapp {
 namespace graphics {
 
-static std::random_device rd;
-static std::mt19937 gen(rd());
+// Each particle consumes one counter slot per randomized attribute
+static const uint32_t ATTRIBUTE_STREAMS = 10;
 
 ParticleEffect::ParticleEffect() {
+    mParticles.reserve(MAX_PARTICLES);
+    mLibrary.loadDefaults();
 }
 
 ParticleEffect::~ParticleEffect() {
     release();
 }
 
-void ParticleEffect::initialize() {
+void ParticleEffect::initialize(ShaderManager& shaders, SpriteBatcher& sprites) {
     if (mInitialized) {
-        LOGI(&quot;ParticleEffect already initialized&quot;);
+        LOGI("ParticleEffect already initialized");
         return;
     }
     
-    createParticleGeometry();
+    mShaders = &shaders;
+    mSprites = &sprites;
+    submitParticleShader();
     
     mInitialized = true;
-    LOGI(&quot;ParticleEffect initialized&quot;);
+    LOGI("ParticleEffect initialized");
 }
 
 void ParticleEffect::release() {
     if (!mInitialized) return;
     
-    if (mVertexArray != 0) {
-        glDeleteVertexArrays(1, &amp;mVertexArray);
-        mVertexArray = 0;
-    }
-    if (mVertexBuffer != 0) {
-        glDeleteBuffers(1, &amp;mVertexBuffer);
-        mVertexBuffer = 0;
-    }
-    if (mShaderProgram != 0) {
-        glDeleteProgram(mShaderProgram);
-        mShaderProgram = 0;
-    }
+    mSprites = nullptr;
+    mSpriteShader = -1;
+    
+    mGpuParticles.reset();
+    mBackend = ParticleBackend::Cpu;
     
     mParticles.clear();
+    mEmitters.clear();
     mInitialized = false;
 }
 
-void ParticleEffect::createParticleGeometry() {
-    // Simple quad for particle rendering
-    float vertices[] = {
-        -0.5f, -0.5f,
-         0.5f, -0.5f,
-        -0.5f,  0.5f,
-         0.5f,  0.5f
-    };
-    
-    glGenVertexArrays(1, &amp;mVertexArray);
-    glBindVertexArray(mVertexArray);
-    
-    glGenBuffers(1, &amp;mVertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    glBindVertexArray(0);
-    
-    // Load particle shader
-    const char* vertexShaderSrc = R&quot;(
-        #version 300 es
-        layout(location = 0) in vec2 aPosition;
-        
-        uniform mat4 uProjection;
-        uniform vec2 uPosition;
-        uniform float uSize;
-        uniform float uRotation;
-        
-        out vec2 vTexCoord;
-        
-        void main() {
-            float cosR = cos(uRotation);
-            float sinR = sin(uRotation);
-            vec2 rotatedPos = vec2(
-                aPosition.x * cosR - aPosition.y * sinR,
-                aPosition.x * sinR + aPosition.y * cosR
-            );
-            
-            vec2 pos = rotatedPos * uSize + uPosition;
-            gl_Position = uProjection * vec4(pos, 0.0, 1.0);
-            gl_PointSize = uSize * 10.0;
-        }
-    )&quot;;
+void ParticleEffect::onContextLost() {
+    if (mGpuParticles) {
+        mGpuParticles->abandon();
+        mGpuParticles.reset();
+    }
+    mRestoreGpuBackend = mBackend == ParticleBackend::GpuTransformFeedback;
+    mBackend = ParticleBackend::Cpu;
+}
+
+void ParticleEffect::restoreAfterContextLoss() {
+    if (!mInitialized) return;
     
-    const char* fragmentShaderSrc = R&quot;(
-        #version 300 es
+    if (mRestoreGpuBackend) {
+        mRestoreGpuBackend = false;
+        setBackend(ParticleBackend::GpuTransformFeedback);
+    }
+}
+
+void ParticleEffect::submitParticleShader() {
+    // The batcher's vertex stage passes the quad's -0.5..0.5 corners as
+    // texture coordinates and the particle color with its fade applied
+    const char* fragmentShaderSrc = R"(#version 300 es
         precision mediump float;
         
-        uniform vec4 uColor;
-        uniform float uAlpha;
-        
+        in vec2 vTexCoord;
+        in vec4 vColor;
         out vec4 FragColor;
         
         void main() {
             // Circular particle
-            vec2 coord = gl_PointCoord - vec2(0.5);
-            float dist = length(coord);
+            float dist = length(vTexCoord);
             
             if (dist > 0.5) {
                 discard;
@@ -120,122 +94,163 @@ void ParticleEffect::createParticleGeometry() {
             // Soft edge
             float alpha = 1.0 - smoothstep(0.3, 0.5, dist);
             
-            FragColor = vec4(uColor.rgb, uColor.a * alpha * uAlpha);
+            FragColor = vec4(vColor.rgb, vColor.a * alpha);
         }
-    )&quot;;
-    
-    // Compile shaders
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &amp;vertexShaderSrc, nullptr);
-    glCompileShader(vertexShader);
-    
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &amp;fragmentShaderSrc, nullptr);
-    glCompileShader(fragmentShader);
-    
-    // Create program
-    mShaderProgram = glCreateProgram();
-    glAttachShader(mShaderProgram, vertexShader);
-    glAttachShader(mShaderProgram, fragmentShader);
-    glLinkProgram(mShaderProgram);
-    
-    // Cleanup
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    )";
+    
+    // Resolved by the batcher once the driver has finished it
+    mShaders->submitShader("particle", SpriteBatcher::VERTEX_SHADER, fragmentShaderSrc);
+    mSpriteShader = mSprites->registerShader("particle");
+}
+
+bool ParticleEffect::loadEmitters(const char* json, size_t length) {
+    return mLibrary.loadFromJson(json, length);
+}
+
+EmitterHandle ParticleEffect::findEmitter(const char* name) const {
+    return mLibrary.find(name);
 }
 
 void ParticleEffect::spawn(const char* effectType, float x, float y) {
-    if (strcmp(effectType, &quot;gold_coin&quot;) == 0) {
-        spawnGoldCoin(x, y);
-    } else if (strcmp(effectType, &quot;dust&quot;) == 0) {
-        spawnDust(x, y);
-    } else if (strcmp(effectType, &quot;fire_spark&quot;) == 0) {
-        spawnFireSpark(x, y);
+    spawn(mLibrary.find(effectType), x, y);
+}
+
+void ParticleEffect::spawn(EmitterHandle handle, float x, float y) {
+    const EmitterDescriptor* emitter = mLibrary.get(handle);
+    if (emitter == nullptr) return;
+    
+    emit(*emitter, x, y, emitter->burstCount);
+}
+
+int ParticleEffect::startEmitter(EmitterHandle handle, float x, float y) {
+    const EmitterDescriptor* emitter = mLibrary.get(handle);
+    if (emitter == nullptr) return 0;
+    
+    EmitterInstance instance;
+    instance.id = mNextEmitterId++;
+    instance.handle = handle;
+    instance.x = x;
+    instance.y = y;
+    instance.elapsed = 0.0f;
+    instance.pending = 0.0f;
+    instance.active = true;
+    mEmitters.push_back(instance);
+    
+    emit(*emitter, x, y, emitter->burstCount);
+    return instance.id;
+}
+
+void ParticleEffect::moveEmitter(int emitterId, float x, float y) {
+    for (auto& instance : mEmitters) {
+        if (instance.id == emitterId) {
+            instance.x = x;
+            instance.y = y;
+            return;
+        }
     }
 }
 
-void ParticleEffect::spawnGoldCoin(float x, float y) {
-    std::uniform_real_distribution<float> distX(-100, 100);
-    std::uniform_real_distribution<float> distY(-200, -50);
-    std::uniform_real_distribution<float> distVel(-50, 50);
-    
-    Particle p;
-    p.x = x;
-    p.y = y;
-    p.z = 0;
-    p.vx = distVel(gen);
-    p.vy = distY(gen);
-    p.vz = 0;
-    p.life = 2.0f;
-    p.maxLife = 2.0f;
-    p.size = 20.0f;
-    p.r = 1.0f;  // Gold
-    p.g = 0.84f;
-    p.b = 0.0f;
-    p.a = 1.0f;
-    
-    mParticles.push_back(p);
+void ParticleEffect::stopEmitter(int emitterId) {
+    mEmitters.erase(
+        std::remove_if(mEmitters.begin(), mEmitters.end(),
+            [emitterId](const EmitterInstance& instance) { return instance.id == emitterId; }),
+        mEmitters.end()
+    );
+}
+
+void ParticleEffect::emit(const EmitterDescriptor& emitter, float x, float y, uint32_t count) {
+    emitInto(mParticles, emitter, x, y, count);
 }
 
-void ParticleEffect::spawnDust(float x, float y) {
-    std::uniform_real_distribution<float> distX(-50, 50);
-    std::uniform_real_distribution<float> distY(-30, 30);
-    
-    for (int i = 0; i < 5; i++) {
-        Particle p;
-        p.x = x + distX(gen);
-        p.y = y + distY(gen);
+void ParticleEffect::emitInto(ParticleVector& particles, const EmitterDescriptor& emitter,
+                              float x, float y, uint32_t count) {
+    size_t available = MAX_PARTICLES - std::min(particles.size(), MAX_PARTICLES);
+    if (count > available) {
+        count = static_cast<uint32_t>(available);
+    }
+    if (count == 0) return;
+    
+    size_t first = particles.size();
+    particles.resize(first + count);
+    Particle* out = particles.data() + first;
+    
+    const uint32_t seed = emitter.seed;
+    uint32_t counter = mSpawnCounter * ATTRIBUTE_STREAMS;
+    mSpawnCounter += count;
+    
+    for (uint32_t i = 0; i < count; i++, counter += ATTRIBUTE_STREAMS) {
+        Particle& p = out[i];
+        p.x = x + particleRandom(emitter.offsetX, seed, counter);
+        p.y = y + particleRandom(emitter.offsetY, seed, counter + 1);
         p.z = 0;
-        p.vx = (gen() % 100 - 50) * 0.5f;
-        p.vy = (gen() % 100 - 50) * 0.5f;
+        p.vx = particleRandom(emitter.velocityX, seed, counter + 2);
+        p.vy = particleRandom(emitter.velocityY, seed, counter + 3);
         p.vz = 0;
-        p.life = 1.5f;
-        p.maxLife = 1.5f;
-        p.size = 5.0f + (gen() % 10);
-        p.r = 0.62f;  // Dust brown
-        p.g = 0.45f;
-        p.b = 0.33f;
-        p.a = 0.6f;
-        
-        mParticles.push_back(p);
+        p.life = particleRandom(emitter.life, seed, counter + 4);
+        p.maxLife = p.life;
+        p.size = particleRandom(emitter.size, seed, counter + 5);
+        p.r = particleRandom(emitter.color[0], seed, counter + 6);
+        p.g = particleRandom(emitter.color[1], seed, counter + 7);
+        p.b = particleRandom(emitter.color[2], seed, counter + 8);
+        p.a = particleRandom(emitter.color[3], seed, counter + 9);
     }
 }
 
-void ParticleEffect::spawnFireSpark(float x, float y) {
-    std::uniform_real_distribution<float> distVel(-100, 100);
-    
-    Particle p;
-    p.x = x;
-    p.y = y;
-    p.z = 0;
-    p.vx = distVel(gen) * 0.3f;
-    p.vy = -100 - (gen() % 50);
-    p.vz = 0;
-    p.life = 1.0f;
-    p.maxLife = 1.0f;
-    p.size = 8.0f + (gen() % 8);
-    p.r = 1.0f;  // Orange fire
-    p.g = 0.5f + (gen() % 50) * 0.01f;
-    p.b = 0.0f;
-    p.a = 1.0f;
-    
-    mParticles.push_back(p);
+void ParticleEffect::updateEmitters(float deltaTime) {
+    for (auto& instance : mEmitters) {
+        const EmitterDescriptor* emitter = mLibrary.get(instance.handle);
+        if (emitter == nullptr) {
+            instance.active = false;
+            continue;
+        }
+        
+        // Only emit for the part of the step that falls inside the duration
+        float activeTime = deltaTime;
+        if (emitter->duration > 0.0f) {
+            activeTime = std::min(deltaTime, emitter->duration - instance.elapsed);
+            if (activeTime <= 0.0f) {
+                instance.active = false;
+                continue;
+            }
+        }
+        instance.elapsed += deltaTime;
+        
+        instance.pending += emitter->emissionRate * activeTime;
+        uint32_t count = static_cast<uint32_t>(instance.pending);
+        instance.pending -= static_cast<float>(count);
+        emit(*emitter, instance.x, instance.y, count);
+    }
+    
+    mEmitters.erase(
+        std::remove_if(mEmitters.begin(), mEmitters.end(),
+            [](const EmitterInstance& instance) { return !instance.active; }),
+        mEmitters.end()
+    );
 }
 
 void ParticleEffect::update(float deltaTime) {
-    for (auto&amp; p : mParticles) {
+    PROFILE_SCOPE("particles.update");
+    updateEmitters(deltaTime);
+    
+    if (mBackend == ParticleBackend::GpuTransformFeedback) {
+        handOffToGpu();
+        mGpuParticles->update(deltaTime);
+        return;
+    }
+    
+    for (auto& p : mParticles) {
         updateParticle(p, deltaTime);
     }
     
     // Remove dead particles
     mParticles.erase(
         std::remove_if(mParticles.begin(), mParticles.end(),
-            [](const Particle&amp; p) { return p.life <= 0; }),
+            [](const Particle& p) { return p.life <= 0; }),
         mParticles.end()
     );
 }
 
-void ParticleEffect::updateParticle(Particle&amp; p, float deltaTime) {
+void ParticleEffect::updateParticle(Particle& p, float deltaTime) {
     // Physics
     p.x += p.vx * deltaTime;
     p.y += p.vy * deltaTime;
@@ -255,42 +270,188 @@ void ParticleEffect::updateParticle(Particle&amp; p, float deltaTime) {
 }
 
 void ParticleEffect::render() {
-    if (mParticles.empty()) return;
-    
-    glUseProgram(mShaderProgram);
-    glBindVertexArray(mVertexArray);
-    
-    // Enable blending for particles
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    
-    // Projection matrix
-    float projMatrix[16] = {
-        2.0f / 1920.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, 2.0f / 1080.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, -1.0f, 0.0f,
-        -1.0f, -1.0f, 0.0f, 1.0f
-    };
-    
-    GLint projLoc = glGetUniformLocation(mShaderProgram, &quot;uProjection&quot;);
-    GLint posLoc = glGetUniformLocation(mShaderProgram, &quot;uPosition&quot;);
-    GLint sizeLoc = glGetUniformLocation(mShaderProgram, &quot;uSize&quot;);
-    GLint colorLoc = glGetUniformLocation(mShaderProgram, &quot;uColor&quot;);
-    GLint alphaLoc = glGetUniformLocation(mShaderProgram, &quot;uAlpha&quot;);
-    
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projMatrix);
-    
-    // Render each particle
-    for (const auto&amp; p : mParticles) {
-        glUniform2f(posLoc, p.x, p.y);
-        glUniform1f(sizeLoc, p.size);
-        glUniform4f(colorLoc, p.r, p.g, p.b, p.a);
-        glUniform1f(alphaLoc, p.a);
+    PROFILE_SCOPE("particles.render");
+    PROFILE_GPU_SCOPE("particles.render");
+    if (mBackend == ParticleBackend::GpuTransformFeedback) {
+        // Queued sprites below the particles go first
+        mSprites->flush();
+        mGpuParticles->render();
+        return;
+    }
+    
+    if (mParticles.empty() || mSpriteShader < 0) return;
+    
+    // One quad per particle, all in a single batch
+    Sprite sprite;
+    sprite.u0 = -0.5f;
+    sprite.v0 = -0.5f;
+    sprite.u1 = 0.5f;
+    sprite.v1 = 0.5f;
+    sprite.shader = mSpriteShader;
+    sprite.layer = SpriteBatcher::LAYER_EFFECTS;
+    for (const auto& p : mParticles) {
+        sprite.x = p.x - p.size * 0.5f;
+        sprite.y = p.y - p.size * 0.5f;
+        sprite.width = p.size;
+        sprite.height = p.size;
+        // The fade applies to both the color and the opacity
+        sprite.color = SpriteBatcher::packColor(p.r, p.g, p.b, p.a * p.a);
+        mSprites->draw(sprite);
+    }
+}
+
+void ParticleEffect::handOffToGpu() {
+    mGpuParticles->spawn(mParticles.data(), static_cast<uint32_t>(mParticles.size()));
+    mParticles.clear();
+}
+
+bool ParticleEffect::isAnimating() const {
+    // On the GPU backend mParticles holds spawns not yet handed over
+    if (!mParticles.empty() || !mEmitters.empty()) return true;
+    return mBackend == ParticleBackend::GpuTransformFeedback && mGpuParticles->hasLiveParticles();
+}
+
+size_t ParticleEffect::getParticleCount() const {
+    if (mBackend == ParticleBackend::GpuTransformFeedback) {
+        return mParticles.size() + mGpuParticles->getOccupiedCount();
+    }
+    return mParticles.size();
+}
+
+bool ParticleEffect::setBackend(ParticleBackend backend) {
+    if (backend == mBackend) return true;
+    
+    if (backend == ParticleBackend::GpuTransformFeedback) {
+        if (!mInitialized) {
+            LOGE("Cannot enable GPU particles before initialize()");
+            return false;
+        }
+        
+        mGpuParticles = std::make_unique<GpuParticleSystem>();
+        if (!mGpuParticles->initialize(MAX_PARTICLES, *mShaders)) {
+            mGpuParticles.reset();
+            return false;
+        }
         
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        // Live CPU particles continue on the GPU
+        handOffToGpu();
+        mBackend = backend;
+        LOGI("Particle backend: GPU transform feedback");
+        return true;
     }
     
-    glBindVertexArray(0);
+    // Back to the CPU: keep whatever is still alive
+    std::vector<Particle> live;
+    mGpuParticles->readBack(live);
+    for (const auto& p : live) {
+        if (p.life > 0 && mParticles.size() < MAX_PARTICLES) {
+            mParticles.push_back(p);
+        }
+    }
+    mGpuParticles.reset();
+    mBackend = backend;
+    LOGI("Particle backend: CPU");
+    return true;
+}
+
+ParticleValidationResult ParticleEffect::validateGpuBackend(EmitterHandle handle, uint32_t count,
+                                                            int steps, float deltaTime) {
+    ParticleValidationResult result = {};
+    
+    const EmitterDescriptor* emitter = mLibrary.get(handle);
+    if (emitter == nullptr || !mInitialized) {
+        return result;
+    }
+    
+    ParticleVector cpuParticles;
+    cpuParticles.reserve(count);
+    emitInto(cpuParticles, *emitter, 960.0f, 540.0f, count);
+    result.particleCount = static_cast<uint32_t>(cpuParticles.size());
+    
+    GpuParticleSystem gpu;
+    if (result.particleCount == 0 || !gpu.initialize(result.particleCount, *mShaders)) {
+        return result;
+    }
+    gpu.spawn(cpuParticles.data(), result.particleCount);
+    
+    // CPU reference, without culling so slots line up with the GPU ring
+    auto cpuStart = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (auto& p : cpuParticles) {
+            if (p.life > 0) {
+                updateParticle(p, deltaTime);
+            }
+        }
+    }
+    auto cpuEnd = std::chrono::steady_clock::now();
+    
+    glFinish();
+    auto gpuStart = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        gpu.update(deltaTime);
+    }
+    glFinish();
+    auto gpuEnd = std::chrono::steady_clock::now();
+    
+    std::vector<Particle> gpuParticles;
+    gpu.readBack(gpuParticles);
+    
+    result.cpuMilliseconds = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+    result.gpuMilliseconds = std::chrono::duration<double, std::milli>(gpuEnd - gpuStart).count();
+    
+    if (gpuParticles.size() != cpuParticles.size()) {
+        LOGE("GPU validation: expected %zu particles, read back %zu",
+             cpuParticles.size(), gpuParticles.size());
+        return result;
+    }
+    
+    // Relative tolerance: positions reach thousands of units after long runs
+    const float tolerance = 1e-3f;
+    bool aliveMismatch = false;
+    for (size_t i = 0; i < cpuParticles.size(); i++) {
+        const Particle& c = cpuParticles[i];
+        const Particle& g = gpuParticles[i];
+        
+        // A particle dying on exactly this step may land either side of zero
+        if ((c.life > 0) != (g.life > 0) && std::fabs(c.life - g.life) > 1e-4f) {
+            aliveMismatch = true;
+        }
+        if (c.life <= 0 || g.life <= 0) continue;
+        
+        float dx = std::fabs(c.x - g.x) / std::max(1.0f, std::fabs(c.x));
+        float dy = std::fabs(c.y - g.y) / std::max(1.0f, std::fabs(c.y));
+        result.maxPositionError = std::max(result.maxPositionError, std::max(dx, dy));
+        
+        float dc = std::max(std::max(std::fabs(c.r - g.r), std::fabs(c.g - g.g)),
+                            std::max(std::fabs(c.b - g.b), std::fabs(c.a - g.a)));
+        result.maxColorError = std::max(result.maxColorError, dc);
+    }
+    
+    // Run the ring on until everything has died: it must then stop its
+    // passes and start over empty
+    float longestLife = 0.0f;
+    for (const auto& p : cpuParticles) {
+        longestLife = std::max(longestLife, p.life);
+    }
+    int drainSteps = static_cast<int>(std::ceil(longestLife / deltaTime)) + 2;
+    for (int step = 0; step < drainSteps; step++) {
+        gpu.update(deltaTime);
+    }
+    bool drained = !gpu.hasLiveParticles() && gpu.getOccupiedCount() == 0;
+    if (!drained) {
+        LOGE("GPU validation: ring still holds %u slots after every particle died",
+             gpu.getOccupiedCount());
+    }
+    
+    result.passed = !aliveMismatch && drained &&
+                    result.maxPositionError <= tolerance &&
+                    result.maxColorError <= tolerance;
+    
+    LOGI("GPU particle validation: %u particles, %d steps, pos err %.2e, color err %.2e, "
+         "cpu %.3f ms, gpu %.3f ms -> %s",
+         result.particleCount, steps, result.maxPositionError, result.maxColorError,
+         result.cpuMilliseconds, result.gpuMilliseconds, result.passed ? "PASS" : "FAIL");
+    return result;
 }
 
 } // namespace graphics
@@ -0,0 +1,371 @@
+#include "Profiler.h"
+#include <EGL/egl.h>
+#include <android/log.h>
+#include <android/trace.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+#include <vector>
+
+#define TAG "Profiler"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+static void appendEscaped(std::string& json, const char* text) {
+    for (const char* c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') json += '\\';
+        if (static_cast<unsigned char>(*c) >= 0x20) json += *c;
+    }
+}
+
+// Set before the thread's ring exists, copied in when it is created
+static thread_local const char* tThreadName = nullptr;
+
+std::atomic<uint32_t> Profiler::sFlags{0};
+
+Profiler& Profiler::getInstance() {
+    static Profiler instance;
+    return instance;
+}
+
+// Rings live as long as the process: threads may still be recording while
+// static destructors run
+Profiler::Profiler() {
+    mEpochNanos = nowNanos();
+    mGpuRing.threadId = MAX_THREADS + 1;
+    snprintf(mGpuRing.name, sizeof(mGpuRing.name), "GPU");
+}
+
+Profiler::~Profiler() {
+}
+
+int64_t Profiler::nowNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+void Profiler::ThreadRing::push(const Event& event) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    events[index % CAPACITY] = event;
+    head.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setEnabled(bool enabled) {
+    if (enabled) {
+        sFlags.fetch_or(RECORD, std::memory_order_relaxed);
+    } else {
+        sFlags.fetch_and(~RECORD, std::memory_order_relaxed);
+    }
+    LOGI("Profiling %s", enabled ? "on" : "off");
+}
+
+Profiler::ThreadRing* Profiler::threadRing() {
+    static thread_local ThreadRing* ring = nullptr;
+    static thread_local bool unavailable = false;
+    if (ring != nullptr || unavailable) return ring;
+
+    int index = mRingCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MAX_THREADS) {
+        unavailable = true;
+        LOGE("More than %d profiled threads; the rest are not recorded", MAX_THREADS);
+        return nullptr;
+    }
+    ring = new ThreadRing();
+    ring->threadId = index + 1;
+    if (tThreadName != nullptr) {
+        snprintf(ring->name, sizeof(ring->name), "%s", tThreadName);
+    } else {
+        snprintf(ring->name, sizeof(ring->name), "Thread %d", index + 1);
+    }
+    mRings[index].store(ring, std::memory_order_release);
+    return ring;
+}
+
+void Profiler::record(const char* name, int64_t startNanos, int64_t endNanos) {
+    ThreadRing* ring = threadRing();
+    if (ring != nullptr) {
+        ring->push({name, startNanos, endNanos});
+    }
+}
+
+void Profiler::setThreadName(const char* name) {
+    tThreadName = name;
+}
+
+void ProfileScope::begin(uint32_t flags) {
+    mFlags = flags;
+    if ((flags & Profiler::ATRACE) != 0) {
+        ATrace_beginSection(mName);
+    }
+    if ((flags & Profiler::RECORD) != 0) {
+        mStartNanos = Profiler::nowNanos();
+    }
+}
+
+void ProfileScope::end() {
+    if ((mFlags & Profiler::RECORD) != 0) {
+        Profiler::getInstance().record(mName, mStartNanos, Profiler::nowNanos());
+    }
+    if ((mFlags & Profiler::ATRACE) != 0) {
+        ATrace_endSection();
+    }
+}
+
+void Profiler::initializeGpu() {
+    mGpuSupported = false;
+    mGpuFrameActive = false;
+    if (!hasGLExtension("GL_EXT_disjoint_timer_query")) return;
+
+    mQueryCounter = reinterpret_cast<PFNGLQUERYCOUNTEREXTPROC>(eglGetProcAddress("glQueryCounterEXT"));
+    mGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+        eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    auto getQueryiv = reinterpret_cast<PFNGLGETQUERYIVEXTPROC>(eglGetProcAddress("glGetQueryivEXT"));
+    if (mQueryCounter == nullptr || mGetQueryObjectui64v == nullptr) return;
+    // Drivers may list the extension with timestamps left out
+    GLint bits = 0;
+    if (getQueryiv != nullptr) {
+        getQueryiv(GL_TIMESTAMP_EXT, GL_QUERY_COUNTER_BITS_EXT, &bits);
+    }
+    if (bits == 0) {
+        LOGI("GPU timestamps unsupported");
+        return;
+    }
+
+    for (GpuFrame& frame : mGpuFrames) {
+        glGenQueries(GpuFrame::MAX_SCOPES * 2, frame.queries);
+        frame.scopeCount = 0;
+        frame.pending = false;
+    }
+    mGpuFrame = 0;
+    mGpuSupported = true;
+}
+
+void Profiler::releaseGpu() {
+    if (mGpuSupported) {
+        for (GpuFrame& frame : mGpuFrames) {
+            glDeleteQueries(GpuFrame::MAX_SCOPES * 2, frame.queries);
+        }
+    }
+    abandonGpu();
+}
+
+void Profiler::abandonGpu() {
+    for (GpuFrame& frame : mGpuFrames) {
+        memset(frame.queries, 0, sizeof(frame.queries));
+        frame.scopeCount = 0;
+        frame.pending = false;
+    }
+    mGpuSupported = false;
+    mGpuFrameActive = false;
+}
+
+void Profiler::beginFrame() {
+    // Polled once a frame: capture can start and stop at any time
+    if (ATrace_isEnabled()) {
+        sFlags.fetch_or(ATRACE, std::memory_order_relaxed);
+    } else {
+        sFlags.fetch_and(~ATRACE, std::memory_order_relaxed);
+    }
+
+    if (!mGpuSupported) return;
+    collectGpuFrames();
+    mGpuFrameActive = false;
+    if (!isEnabled()) return;
+
+    // The GPU is more than GPU_FRAMES behind; leave this frame untimed
+    GpuFrame& frame = mGpuFrames[mGpuFrame];
+    if (frame.pending) return;
+
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP_EXT, &gpuNow);
+    frame.cpuBase = nowNanos();
+    frame.gpuBase = gpuNow;
+    frame.scopeCount = 0;
+    frame.lastQuery = 0;
+    mGpuFrameActive = true;
+}
+
+void Profiler::endFrame() {
+    if (!mGpuFrameActive) return;
+
+    GpuFrame& frame = mGpuFrames[mGpuFrame];
+    frame.pending = frame.lastQuery != 0;
+    mGpuFrame = (mGpuFrame + 1) % GPU_FRAMES;
+    mGpuFrameActive = false;
+}
+
+int Profiler::beginGpuScope(const char* name) {
+    if (!mGpuFrameActive) return -1;
+    GpuFrame& frame = mGpuFrames[mGpuFrame];
+    if (frame.scopeCount == GpuFrame::MAX_SCOPES) return -1;
+
+    int index = frame.scopeCount++;
+    GpuScope& scope = frame.scopes[index];
+    scope.name = name;
+    scope.begin = frame.queries[index * 2];
+    scope.end = frame.queries[index * 2 + 1];
+    scope.ended = false;
+    mQueryCounter(scope.begin, GL_TIMESTAMP_EXT);
+    frame.lastQuery = scope.begin;
+    return index;
+}
+
+void Profiler::endGpuScope(int scope) {
+    if (!mGpuFrameActive) return;
+    GpuFrame& frame = mGpuFrames[mGpuFrame];
+    if (scope < 0 || scope >= frame.scopeCount) return;
+
+    mQueryCounter(frame.scopes[scope].end, GL_TIMESTAMP_EXT);
+    frame.scopes[scope].ended = true;
+    frame.lastQuery = frame.scopes[scope].end;
+}
+
+void Profiler::collectGpuFrames() {
+    // Reading the flag clears it, so FramePacer and the profiler each see
+    // only some disjoint events; both just lose a few samples
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    // Oldest first; a frame's queries complete in the order they were issued
+    for (int i = 0; i < GPU_FRAMES; i++) {
+        GpuFrame& frame = mGpuFrames[(mGpuFrame + i) % GPU_FRAMES];
+        if (!frame.pending) continue;
+
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) break;
+        frame.pending = false;
+
+        if (disjoint != 0) {
+            mGpuDiscarded.fetch_add(static_cast<uint32_t>(frame.scopeCount), std::memory_order_relaxed);
+            continue;
+        }
+        for (int s = 0; s < frame.scopeCount; s++) {
+            const GpuScope& scope = frame.scopes[s];
+            if (!scope.ended) continue;
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            mGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+            mGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+            int64_t start = frame.cpuBase + (static_cast<int64_t>(begin) - frame.gpuBase);
+            mGpuRing.push({scope.name, start, start + static_cast<int64_t>(end - begin)});
+            mGpuScopes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Profiler::clear() {
+    int count = std::min(mRingCount.load(std::memory_order_acquire), MAX_THREADS);
+    for (int i = 0; i < count; i++) {
+        ThreadRing* ring = mRings[i].load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            ring->cleared.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+        }
+    }
+    mGpuRing.cleared.store(mGpuRing.head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    mGpuScopes.store(0, std::memory_order_relaxed);
+    mGpuDiscarded.store(0, std::memory_order_relaxed);
+}
+
+void Profiler::appendEvents(const ThreadRing& ring, std::string& json, bool& first) const {
+    // Snapshot without stopping the writer, then drop what it overwrote meanwhile
+    uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t begin = std::max(ring.cleared.load(std::memory_order_relaxed),
+                              head > ThreadRing::CAPACITY ? head - ThreadRing::CAPACITY : 0);
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(head - begin));
+    for (uint64_t i = begin; i < head; i++) {
+        events.push_back(ring.events[i % ThreadRing::CAPACITY]);
+    }
+    uint64_t after = ring.head.load(std::memory_order_acquire);
+    uint64_t valid = after > ThreadRing::CAPACITY ? after - ThreadRing::CAPACITY : 0;
+    size_t skip = valid > begin ? static_cast<size_t>(std::min<uint64_t>(valid - begin, events.size())) : 0;
+    if (events.size() == skip) return;
+
+    char buffer[160];
+    snprintf(buffer, sizeof(buffer), "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+             "\"args\": {\"name\": \"", first ? "" : ",\n", ring.threadId);
+    json += buffer;
+    appendEscaped(json, ring.name);
+    json += "\"}}";
+    first = false;
+
+    for (size_t i = skip; i < events.size(); i++) {
+        const Event& event = events[i];
+        json += ",\n{\"name\": \"";
+        appendEscaped(json, event.name);
+        snprintf(buffer, sizeof(buffer), "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                 ring.threadId, (event.startNanos - mEpochNanos) / 1000.0,
+                 (event.endNanos - event.startNanos) / 1000.0);
+        json += buffer;
+    }
+}
+
+std::string Profiler::chromeTraceJson() const {
+    std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    int count = std::min(mRingCount.load(std::memory_order_acquire), MAX_THREADS);
+    for (int i = 0; i < count; i++) {
+        const ThreadRing* ring = mRings[i].load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            appendEvents(*ring, json, first);
+        }
+    }
+    appendEvents(mGpuRing, json, first);
+    json += "\n]}\n";
+    return json;
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const {
+    std::string json = chromeTraceJson();
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        LOGE("Cannot write trace: %s", path.c_str());
+        return false;
+    }
+    bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+    written = fclose(file) == 0 && written;
+    if (!written) {
+        LOGE("Failed to write trace: %s", path.c_str());
+        return false;
+    }
+    LOGI("Trace written to %s (%zu bytes)", path.c_str(), json.size());
+    return true;
+}
+
+ProfilerStats Profiler::getStats() const {
+    ProfilerStats stats = {};
+    int count = std::min(mRingCount.load(std::memory_order_acquire), MAX_THREADS);
+    for (int i = 0; i < count; i++) {
+        const ThreadRing* ring = mRings[i].load(std::memory_order_acquire);
+        if (ring == nullptr) continue;
+        uint64_t recorded = ring->head.load(std::memory_order_acquire) -
+                            ring->cleared.load(std::memory_order_relaxed);
+        stats.threads++;
+        stats.cpuScopes += recorded;
+        stats.overwritten += recorded > ThreadRing::CAPACITY ? recorded - ThreadRing::CAPACITY : 0;
+    }
+    stats.gpuScopes = mGpuScopes.load(std::memory_order_relaxed);
+    stats.gpuDiscarded = mGpuDiscarded.load(std::memory_order_relaxed);
+    stats.gpuTimerSupported = mGpuSupported;
+    stats.atraceEnabled = (flags() & ATRACE) != 0;
+    return stats;
+}
+
+} // namespace graphics
+} // namespace trashapp
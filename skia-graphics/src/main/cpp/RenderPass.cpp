@@ -0,0 +1,33 @@
+#include "RenderPass.h"
+
+namespace trashapp {
+namespace graphics {
+
+static const uint64_t COLOR_BYTES_PER_SAMPLE = 4;
+static const uint64_t DEPTH_BYTES_PER_SAMPLE = 4;
+
+PassTraffic estimatePassTraffic(const RenderPassDescriptor& pass, int width, int height, int samples) {
+    uint64_t samplesPerPixel = samples > 1 ? static_cast<uint64_t>(samples) : 1;
+    uint64_t pixels = static_cast<uint64_t>(width > 0 ? width : 0) * (height > 0 ? height : 0);
+    uint64_t color = pixels * samplesPerPixel * COLOR_BYTES_PER_SAMPLE;
+    uint64_t depth = pixels * samplesPerPixel * DEPTH_BYTES_PER_SAMPLE;
+
+    // A driver told nothing has to load and store every attachment
+    uint64_t worstCase = 2 * (color + depth);
+
+    uint64_t bytes = 0;
+    if (pass.colorLoad == LoadAction::Load) bytes += color;
+    if (pass.colorStore == StoreAction::Store) bytes += color;
+    if (pass.useDepth) {
+        if (pass.depthLoad == LoadAction::Load) bytes += depth;
+        if (pass.depthStore == StoreAction::Store) bytes += depth;
+    }
+
+    PassTraffic traffic;
+    traffic.bytes = bytes;
+    traffic.bytesSaved = worstCase - bytes;
+    return traffic;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -1,79 +1,141 @@
-#include &quot;Renderer.h&quot;
-#include &lt;android/log.h&gt;
+#include "Renderer.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
 
-#define TAG &quot;Renderer&quot;
+#define TAG "Renderer"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
+// EGL_MESA_platform_surfaceless, for offscreen rendering on host builds
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
 namespace trashapp {
 namespace graphics {
 
+// Sample counts behind each MsaaSettingCost slot, in fallback order reversed
+static const int SETTING_SAMPLES[MsaaStats::SETTING_COUNT] = { 0, 2, 4 };
+static const double COST_AVERAGE_WEIGHT = 0.1;
+
 Renderer::Renderer() : mWidth(0), mHeight(0), mMSAASamples(4) {
+    // Wild West background
+    mFramePass.clearColor[0] = 0.24f;
+    mFramePass.clearColor[1] = 0.15f;
+    mFramePass.clearColor[2] = 0.14f;
+    mFramePass.clearColor[3] = 1.0f;
 }
 
 Renderer::~Renderer() {
     release();
 }
 
-bool Renderer::initialize(int width, int height, int msaaSamples) {
+bool Renderer::initialize(int width, int height, int msaaSamples, bool vsync, bool offscreen) {
     if (mInitialized) {
-        LOGI(&quot;Renderer already initialized&quot;);
+        LOGI("Renderer already initialized");
         return true;
     }
     
     mWidth = width;
     mHeight = height;
     mMSAASamples = msaaSamples;
+    mOffscreen = offscreen;
+    for (auto& cost : mMsaaCosts) {
+        cost = {};
+        cost.averageGpuMilliseconds = -1.0;
+    }
     
     if (!initializeEGL()) {
-        LOGE(&quot;Failed to initialize EGL&quot;);
+        LOGE("Failed to initialize EGL");
         return false;
     }
     
     if (!initializeGL()) {
-        LOGE(&quot;Failed to initialize OpenGL&quot;);
+        LOGE("Failed to initialize OpenGL");
         return false;
     }
     
+    mPacer.setVSync(vsync);
+    mPacer.initialize(mDisplay);
+    
     mInitialized = true;
-    LOGI(&quot;Renderer initialized: %dx%d with %dx MSAA&quot;, width, height, msaaSamples);
+    LOGI("Renderer initialized: %dx%d with %dx MSAA%s", width, height, mActiveSamples,
+         offscreen ? " (offscreen)" : "");
     return true;
 }
 
+EGLDisplay Renderer::getOffscreenDisplay() {
+    // Mesa can render with no window system at all; elsewhere fall back to
+    // the default display and a pbuffer
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions != nullptr && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay != nullptr) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
 bool Renderer::initializeEGL() {
-    mDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    mDisplay = mOffscreen ? getOffscreenDisplay() : eglGetDisplay(EGL_DEFAULT_DISPLAY);
     if (mDisplay == EGL_NO_DISPLAY) {
-        LOGE(&quot;Failed to get EGL display&quot;);
+        LOGE("Failed to get EGL display");
         return false;
     }
     
     if (!eglInitialize(mDisplay, nullptr, nullptr)) {
-        LOGE(&quot;Failed to initialize EGL&quot;);
+        LOGE("Failed to initialize EGL");
         return false;
     }
+    eglBindAPI(EGL_OPENGL_ES_API);
     
-    // Choose EGL config
+    // The offscreen target is a framebuffer object, so its config needs no
+    // window support. Multisampling is done in a framebuffer object too.
+    EGLint surfaceType = mOffscreen ? EGL_PBUFFER_BIT : EGL_WINDOW_BIT | EGL_PBUFFER_BIT;
+    
+    // Choose EGL config; pbuffer support keeps the context current without a window
     EGLint configAttribs[] = {
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
-        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_SURFACE_TYPE, surfaceType,
         EGL_RED_SIZE, 8,
         EGL_GREEN_SIZE, 8,
         EGL_BLUE_SIZE, 8,
         EGL_ALPHA_SIZE, 8,
         EGL_DEPTH_SIZE, 24,
         EGL_STENCIL_SIZE, 8,
-        EGL_SAMPLE_BUFFERS, mMSAASamples > 1 ? 1 : 0,
-        EGL_SAMPLES, mMSAASamples,
         EGL_NONE
     };
     
     EGLint numConfigs = 0;
-    if (!eglChooseConfig(mDisplay, configAttribs, &amp;mConfig, 1, &amp;numConfigs) || numConfigs == 0) {
-        LOGE(&quot;Failed to choose EGL config&quot;);
+    if (!eglChooseConfig(mDisplay, configAttribs, &mConfig, 1, &numConfigs) || numConfigs == 0) {
+        LOGE("Failed to choose EGL config");
+        return false;
+    }
+    
+    EGLint pbufferAttribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    mPbuffer = eglCreatePbufferSurface(mDisplay, mConfig, pbufferAttribs);
+    if (mPbuffer == EGL_NO_SURFACE) {
+        LOGE("Failed to create placeholder pbuffer: 0x%x", eglGetError());
         return false;
     }
     
-    // Create EGL context
+    if (!createContext()) {
+        return false;
+    }
+    
+    LOGI("EGL initialized successfully");
+    return true;
+}
+
+bool Renderer::createContext() {
     EGLint contextAttribs[] = {
         EGL_CONTEXT_CLIENT_VERSION, 3,
         EGL_NONE
@@ -81,15 +143,33 @@ bool Renderer::initializeEGL() {
     
     mContext = eglCreateContext(mDisplay, mConfig, EGL_NO_CONTEXT, contextAttribs);
     if (mContext == EGL_NO_CONTEXT) {
-        LOGE(&quot;Failed to create EGL context&quot;);
+        LOGE("Failed to create EGL context");
+        return false;
+    }
+    return makeCurrent();
+}
+
+bool Renderer::makeCurrent() {
+    EGLSurface surface = mSurface != EGL_NO_SURFACE ? mSurface : mPbuffer;
+    if (!eglMakeCurrent(mDisplay, surface, surface, mContext)) {
+        LOGE("eglMakeCurrent failed");
+        checkContextLost("eglMakeCurrent");
         return false;
     }
-    
-    LOGI(&quot;EGL initialized successfully&quot;);
     return true;
 }
 
 bool Renderer::initializeGL() {
+    if (mOffscreen && !createOffscreenTarget()) {
+        return false;
+    }
+    
+    // Shared projection block; the scene target follows on the first frame
+    querySampleSupport();
+    mActiveSamples = chooseSamples(mMSAASamples);
+    mCamera.initialize();
+    mCamera.setViewport(mWidth, mHeight, mResolution.getScale());
+    
     // Set viewport
     glViewport(0, 0, mWidth, mHeight);
     
@@ -97,48 +177,472 @@ bool Renderer::initializeGL() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
+    // Everything is 2D in painter's order; passes that want depth enable it
+    glDisable(GL_DEPTH_TEST);
     glDepthFunc(GL_LEQUAL);
     
-    // Set clear color
-    glClearColor(0.24f, 0.15f, 0.14f, 1.0f); // Wild West background
-    
     // Check for errors
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
-        LOGE(&quot;OpenGL error after initialization: 0x%x&quot;, error);
+        LOGE("OpenGL error after initialization: 0x%x", error);
         return false;
     }
     
-    LOGI(&quot;OpenGL initialized successfully&quot;);
+    LOGI("OpenGL initialized successfully");
     return true;
 }
 
+bool Renderer::allocateTarget(GLuint& framebuffer, GLuint& color, GLuint& depth,
+                              int width, int height, int samples) {
+    if (framebuffer == 0) {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &color);
+        glGenRenderbuffers(1, &depth);
+    }
+    // Clear stale errors so a failed allocation below is attributed correctly
+    while (glGetError() != GL_NO_ERROR) {}
+    
+    // Storage is reallocated when the size changes
+    glBindRenderbuffer(GL_RENDERBUFFER, color);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        LOGE("Framebuffer %dx%d with %d samples: storage failed 0x%x", width, height, samples, error);
+        return false;
+    }
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOGE("Framebuffer %dx%d with %d samples incomplete: 0x%x", width, height, samples, status);
+        return false;
+    }
+    return true;
+}
+
+void Renderer::deleteTarget(GLuint& framebuffer, GLuint& color, GLuint& depth) {
+    if (framebuffer != 0) {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+    if (color != 0) {
+        glDeleteRenderbuffers(1, &color);
+        color = 0;
+    }
+    if (depth != 0) {
+        glDeleteRenderbuffers(1, &depth);
+        depth = 0;
+    }
+}
+
+bool Renderer::createOffscreenTarget() {
+    return allocateTarget(mFramebuffer, mRenderbuffer, mDepthRenderbuffer, mWidth, mHeight);
+}
+
+void Renderer::destroyOffscreenTarget() {
+    deleteTarget(mFramebuffer, mRenderbuffer, mDepthRenderbuffer);
+}
+
+void Renderer::querySampleSupport() {
+    glGetIntegerv(GL_MAX_SAMPLES, &mMaxSamples);
+    
+    // Counts the driver offers for both attachment formats
+    auto supportedCounts = [](GLenum format) {
+        std::vector<GLint> counts;
+        GLint count = 0;
+        glGetInternalformativ(GL_RENDERBUFFER, format, GL_NUM_SAMPLE_COUNTS, 1, &count);
+        if (count > 0) {
+            counts.resize(count);
+            glGetInternalformativ(GL_RENDERBUFFER, format, GL_SAMPLES, count, counts.data());
+        }
+        return counts;
+    };
+    std::vector<GLint> color = supportedCounts(GL_RGBA8);
+    std::vector<GLint> depth = supportedCounts(GL_DEPTH24_STENCIL8);
+    
+    for (int i = 0; i < MsaaStats::SETTING_COUNT; i++) {
+        int samples = SETTING_SAMPLES[i];
+        mSampleSupport[i] = samples == 0 ||
+            (samples <= mMaxSamples &&
+             std::find(color.begin(), color.end(), samples) != color.end() &&
+             std::find(depth.begin(), depth.end(), samples) != depth.end());
+    }
+}
+
+int Renderer::settingIndex(int samples) {
+    for (int i = MsaaStats::SETTING_COUNT - 1; i > 0; i--) {
+        if (samples >= SETTING_SAMPLES[i]) return i;
+    }
+    return 0;
+}
+
+int Renderer::chooseSamples(int requested) const {
+    // Highest supported setting at or below the request: 4, then 2, then none
+    for (int i = settingIndex(requested); i > 0; i--) {
+        if (mSampleSupport[i]) return SETTING_SAMPLES[i];
+    }
+    return 0;
+}
+
+void Renderer::setMsaaSamples(int samples) {
+    mMSAASamples = std::max(0, samples);
+    if (!mInitialized) return;
+    
+    // The scene target is rebuilt at the next beginFrame
+    mActiveSamples = chooseSamples(mMSAASamples);
+    LOGI("MSAA %dx requested, %dx active", mMSAASamples, mActiveSamples);
+}
+
+bool Renderer::allocateSceneTarget(int width, int height, int samples) {
+    if (!allocateTarget(mSceneFramebuffer, mSceneColor, mSceneDepth, width, height, samples)) {
+        return false;
+    }
+    
+    bool scaled = width != mWidth || height != mHeight;
+    if (samples > 1 && scaled) {
+        if (!allocateTarget(mResolveFramebuffer, mResolveColor, mResolveDepth, width, height)) {
+            return false;
+        }
+        // Only the color attachment is blitted through; no depth needed
+        glBindFramebuffer(GL_FRAMEBUFFER, mResolveFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+        glDeleteRenderbuffers(1, &mResolveDepth);
+        mResolveDepth = 0;
+    } else {
+        deleteTarget(mResolveFramebuffer, mResolveColor, mResolveDepth);
+    }
+    return true;
+}
+
+void Renderer::destroySceneTarget() {
+    deleteTarget(mSceneFramebuffer, mSceneColor, mSceneDepth);
+    deleteTarget(mResolveFramebuffer, mResolveColor, mResolveDepth);
+    mSceneWidth = 0;
+    mSceneHeight = 0;
+    mSceneSamples = 0;
+}
+
+void Renderer::updateSceneTarget() {
+    mCamera.setViewport(mWidth, mHeight, mResolution.getScale());
+    const CameraState& view = mCamera.getState();
+    bool scaled = view.renderWidth != mWidth || view.renderHeight != mHeight;
+    
+    // Single-sampled at full scale draws straight to the output
+    if (!scaled && mActiveSamples <= 1) {
+        if (mSceneFramebuffer != 0) {
+            destroySceneTarget();
+        }
+        return;
+    }
+    
+    if (mSceneFramebuffer != 0 && mSceneWidth == view.renderWidth &&
+        mSceneHeight == view.renderHeight && mSceneSamples == mActiveSamples) {
+        return;
+    }
+    
+    // Step down 4x -> 2x -> none until the driver accepts the target
+    while (!allocateSceneTarget(view.renderWidth, view.renderHeight, mActiveSamples)) {
+        destroySceneTarget();
+        if (mActiveSamples > 1) {
+            int index = settingIndex(mActiveSamples);
+            mSampleSupport[index] = false;
+            int fallback = chooseSamples(SETTING_SAMPLES[index - 1]);
+            LOGE("MSAA %dx unavailable, falling back to %dx", mActiveSamples, fallback);
+            mActiveSamples = fallback;
+            if (scaled || mActiveSamples > 1) continue;
+        } else if (scaled) {
+            LOGE("Reduced-scale target unavailable, rendering at full scale");
+            mResolution.setScale(1.0f);
+            mCamera.setViewport(mWidth, mHeight, 1.0f);
+        }
+        return;
+    }
+    
+    mSceneWidth = view.renderWidth;
+    mSceneHeight = view.renderHeight;
+    mSceneSamples = mActiveSamples;
+    LOGI("Scene target %dx%d, %dx MSAA, for %dx%d output", mSceneWidth, mSceneHeight,
+         mSceneSamples, mWidth, mHeight);
+}
+
+void Renderer::resolveScene() {
+    // Depth and stencil were already dropped when the frame pass ended
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mSceneFramebuffer);
+    
+    bool scaled = mSceneWidth != mWidth || mSceneHeight != mHeight;
+    if (mSceneSamples > 1 && scaled) {
+        // Resolve at render size, then upscale
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mResolveFramebuffer);
+        glBlitFramebuffer(0, 0, mSceneWidth, mSceneHeight, 0, 0, mSceneWidth, mSceneHeight,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mResolveFramebuffer);
+    }
+    
+    // Multisample resolves must not scale; upscales filter bilinearly
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer());
+    glBlitFramebuffer(0, 0, mSceneWidth, mSceneHeight, 0, 0, mWidth, mHeight,
+                      GL_COLOR_BUFFER_BIT, scaled ? GL_LINEAR : GL_NEAREST);
+    
+    // The scene has been consumed; nothing needs to be preserved for next frame
+    invalidateAttachments(GL_READ_FRAMEBUFFER, mSceneFramebuffer, true, false);
+    if (mResolveFramebuffer != 0 && mSceneSamples > 1 && scaled) {
+        invalidateAttachments(GL_READ_FRAMEBUFFER, mResolveFramebuffer, true, false);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer());
+    glViewport(0, 0, mWidth, mHeight);
+}
+
+void Renderer::recordMsaaCost(const FrameTimingStats& timing) {
+    MsaaSettingCost& cost = mMsaaCosts[settingIndex(mActiveSamples)];
+    cost.averageCpuMilliseconds = cost.frames == 0 ? timing.cpuMilliseconds
+        : cost.averageCpuMilliseconds + (timing.cpuMilliseconds - cost.averageCpuMilliseconds) * COST_AVERAGE_WEIGHT;
+    if (timing.gpuMilliseconds >= 0.0) {
+        cost.averageGpuMilliseconds = cost.averageGpuMilliseconds < 0.0 ? timing.gpuMilliseconds
+            : cost.averageGpuMilliseconds + (timing.gpuMilliseconds - cost.averageGpuMilliseconds) * COST_AVERAGE_WEIGHT;
+    }
+    cost.frames++;
+}
+
+MsaaStats Renderer::getMsaaStats() const {
+    MsaaStats stats = {};
+    stats.requestedSamples = mMSAASamples;
+    stats.activeSamples = mActiveSamples;
+    stats.maxSamples = mMaxSamples;
+    
+    const CameraState& view = mCamera.getState();
+    uint64_t renderPixels = static_cast<uint64_t>(view.renderWidth) * view.renderHeight;
+    uint64_t outputPixels = static_cast<uint64_t>(mWidth) * mHeight;
+    bool scaled = renderPixels != outputPixels;
+    
+    for (int i = 0; i < MsaaStats::SETTING_COUNT; i++) {
+        MsaaSettingCost cost = mMsaaCosts[i];
+        int samples = SETTING_SAMPLES[i];
+        uint64_t sampleCount = samples > 1 ? samples : 1;
+        cost.samples = samples;
+        cost.supported = mSampleSupport[i];
+        
+        // RGBA8 + D24S8 per sample; the single-sample full-scale case draws
+        // into the window and needs no target
+        bool hasTarget = samples > 1 || scaled;
+        cost.targetBytes = hasTarget ? renderPixels * sampleCount * 8 : 0;
+        if (samples > 1 && scaled) {
+            cost.targetBytes += renderPixels * 4;
+        }
+        
+        // Resolve traffic with depth invalidated: every color sample written
+        // out and read back, plus the resolved or upscaled image written.
+        // Tilers that resolve on chip pay less; this is the upper bound.
+        uint64_t traffic = 0;
+        if (samples > 1) {
+            traffic += renderPixels * sampleCount * 4 * 2 + renderPixels * 4;
+        }
+        if (scaled) {
+            traffic += renderPixels * 4 + outputPixels * 4;
+        }
+        cost.resolveBytesPerFrame = traffic;
+        stats.settings[i] = cost;
+    }
+    return stats;
+}
+
+double Renderer::frameBudgetMilliseconds() const {
+    FrameTimingStats stats = mPacer.getStats();
+    if (stats.targetFrameRate > 0) {
+        return 1000.0 / stats.targetFrameRate;
+    }
+    if (stats.vsyncPeriodMilliseconds > 0.0) {
+        return stats.vsyncPeriodMilliseconds;
+    }
+    return 1000.0 / 60.0;
+}
+
+bool Renderer::readPixels(std::vector<uint8_t>& rgba) {
+    if (!mInitialized || mWidth <= 0 || mHeight <= 0) return false;
+    
+    size_t rowBytes = static_cast<size_t>(mWidth) * 4;
+    rgba.resize(rowBytes * mHeight);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mOffscreen ? mFramebuffer : 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    
+    // GL rows start at the bottom
+    std::vector<uint8_t> row(rowBytes);
+    for (int y = 0; y < mHeight / 2; y++) {
+        uint8_t* top = rgba.data() + y * rowBytes;
+        uint8_t* bottom = rgba.data() + (mHeight - 1 - y) * rowBytes;
+        memcpy(row.data(), top, rowBytes);
+        memcpy(top, bottom, rowBytes);
+        memcpy(bottom, row.data(), rowBytes);
+    }
+    return glGetError() == GL_NO_ERROR;
+}
+
+bool Renderer::attachWindow(ANativeWindow* window) {
+    if (!mInitialized || window == nullptr) return false;
+    if (mOffscreen) {
+        LOGE("Offscreen renderer cannot attach a window");
+        return false;
+    }
+    if (window == mWindow && mSurface != EGL_NO_SURFACE) return true;
+    
+    detachWindow();
+    
+    mSurface = eglCreateWindowSurface(mDisplay, mConfig, window, nullptr);
+    if (mSurface == EGL_NO_SURFACE) {
+        LOGE("Failed to create window surface: 0x%x", eglGetError());
+        return false;
+    }
+    ANativeWindow_acquire(window);
+    mWindow = window;
+    
+    if (!makeCurrent()) {
+        destroyWindowSurface();
+        return false;
+    }
+    
+    EGLint width = 0;
+    EGLint height = 0;
+    eglQuerySurface(mDisplay, mSurface, EGL_WIDTH, &width);
+    eglQuerySurface(mDisplay, mSurface, EGL_HEIGHT, &height);
+    if (width > 0 && height > 0) {
+        resize(width, height);
+    }
+    
+    // Swap interval is per surface
+    mPacer.onSurfaceChanged();
+    mSurfaceStats.windowAttachCount++;
+    mAttachTime = std::chrono::steady_clock::now();
+    mAwaitingFirstFrame = true;
+    LOGI("Window attached: %dx%d", width, height);
+    return true;
+}
+
+void Renderer::detachWindow() {
+    if (mSurface == EGL_NO_SURFACE && mWindow == nullptr) return;
+    
+    // Keep the context (and every GL object) alive on the pbuffer
+    destroyWindowSurface();
+    if (mContext != EGL_NO_CONTEXT) {
+        makeCurrent();
+    }
+    mAwaitingFirstFrame = false;
+    LOGI("Window detached");
+}
+
+void Renderer::destroyWindowSurface() {
+    if (mSurface != EGL_NO_SURFACE) {
+        if (eglGetCurrentSurface(EGL_DRAW) == mSurface) {
+            eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+        eglDestroySurface(mDisplay, mSurface);
+        mSurface = EGL_NO_SURFACE;
+    }
+    if (mWindow != nullptr) {
+        ANativeWindow_release(mWindow);
+        mWindow = nullptr;
+    }
+}
+
+void Renderer::checkContextLost(const char* operation) {
+    EGLint error = eglGetError();
+    if (error == EGL_CONTEXT_LOST && !mContextLost) {
+        LOGE("EGL context lost during %s", operation);
+        mContextLost = true;
+        mSurfaceStats.contextLossCount++;
+    } else if (error == EGL_BAD_NATIVE_WINDOW || error == EGL_BAD_SURFACE) {
+        // The window went away without a detach; fall back to the pbuffer
+        LOGE("Window surface invalid during %s", operation);
+        detachWindow();
+    }
+}
+
+bool Renderer::recoverContext() {
+    if (!mInitialized) return false;
+    
+    // Old handles are meaningless now; nothing may delete them in the new context
+    mPacer.abandon();
+    mCamera.abandon();
+    mFramebuffer = 0;
+    mRenderbuffer = 0;
+    mDepthRenderbuffer = 0;
+    mSceneFramebuffer = 0;
+    mSceneColor = 0;
+    mSceneDepth = 0;
+    mResolveFramebuffer = 0;
+    mResolveColor = 0;
+    mResolveDepth = 0;
+    mSceneWidth = 0;
+    mSceneHeight = 0;
+    mSceneSamples = 0;
+    eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (mContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(mDisplay, mContext);
+        mContext = EGL_NO_CONTEXT;
+    }
+    
+    mContextLost = false;
+    if (!createContext() || !initializeGL()) {
+        LOGE("Failed to recreate EGL context");
+        return false;
+    }
+    mPacer.initialize(mDisplay);
+    mPacer.onSurfaceChanged();
+    
+    LOGI("EGL context recreated");
+    return true;
+}
+
+SurfaceStats Renderer::getSurfaceStats() const {
+    SurfaceStats stats = mSurfaceStats;
+    stats.hasWindow = hasWindow();
+    return stats;
+}
+
 void Renderer::resize(int width, int height) {
     mWidth = width;
     mHeight = height;
+    if (mOffscreen && mInitialized) {
+        createOffscreenTarget();
+    }
+    // The scene target follows at the next beginFrame
+    mCamera.setViewport(width, height, mResolution.getScale());
     glViewport(0, 0, width, height);
-    LOGI(&quot;Renderer resized to %dx%d&quot;, width, height);
+    LOGI("Renderer resized to %dx%d", width, height);
 }
 
 void Renderer::release() {
     if (!mInitialized) return;
     
+    mPacer.release();
+    mCamera.release();
+    destroySceneTarget();
+    destroyOffscreenTarget();
     cleanupEGL();
     mInitialized = false;
-    LOGI(&quot;Renderer released&quot;);
+    LOGI("Renderer released");
 }
 
 void Renderer::cleanupEGL() {
+    if (mDisplay != EGL_NO_DISPLAY) {
+        eglMakeCurrent(mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+    
     if (mContext != EGL_NO_CONTEXT) {
         eglDestroyContext(mDisplay, mContext);
         mContext = EGL_NO_CONTEXT;
     }
     
-    if (mSurface != EGL_NO_SURFACE) {
-        eglDestroySurface(mDisplay, mSurface);
-        mSurface = EGL_NO_SURFACE;
+    destroyWindowSurface();
+    if (mPbuffer != EGL_NO_SURFACE) {
+        eglDestroySurface(mDisplay, mPbuffer);
+        mPbuffer = EGL_NO_SURFACE;
     }
     
     if (mDisplay != EGL_NO_DISPLAY) {
@@ -149,28 +653,165 @@ void Renderer::cleanupEGL() {
 
 void Renderer::beginFrame() {
     if (!mInitialized) return;
+    prepareFrame();
+    beginFramePass(mFramePass);
+}
+
+void Renderer::prepareFrame() {
+    mPacer.beginFrame();
+    updateSceneTarget();
+    mFrameStats = {};
+    mCamera.bind();
+}
+
+void Renderer::beginFramePass(const RenderPassDescriptor& pass) {
+    if (!mInitialized) return;
     
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    const CameraState& view = mCamera.getState();
+    if (mSceneFramebuffer != 0) {
+        beginPass(pass, mSceneFramebuffer, mSceneWidth, mSceneHeight, mSceneSamples);
+    } else {
+        beginPass(pass, outputFramebuffer(), view.renderWidth, view.renderHeight);
+    }
 }
 
 void Renderer::endFrame() {
     if (!mInitialized) return;
-    // Flush OpenGL commands
-    glFlush();
+    if (mInPass) {
+        endPass();
+    }
+    if (mSceneFramebuffer != 0) {
+        resolveScene();
+    }
+    
+    mFrameStats.bytesSavedTotal = mPassStats.bytesSavedTotal + mFrameStats.bytesSavedPerFrame;
+    mPassStats = mFrameStats;
+    // No glFlush: eglSwapBuffers flushes, and an explicit flush only adds a
+    // driver round trip
+    mPacer.endFrame();
 }
 
 void Renderer::present() {
-    if (!mInitialized || mDisplay == EGL_NO_DISPLAY || mSurface == EGL_NO_SURFACE) {
+    if (!mInitialized || mDisplay == EGL_NO_DISPLAY) {
         return;
     }
     
-    // Swap buffers
-    eglSwapBuffers(mDisplay, mSurface);
+    if (mSurface != EGL_NO_SURFACE) {
+        mPacer.beforeSwap(mSurface);
+        if (!eglSwapBuffers(mDisplay, mSurface)) {
+            checkContextLost("eglSwapBuffers");
+            return;
+        }
+        if (mAwaitingFirstFrame) {
+            mAwaitingFirstFrame = false;
+            mSurfaceStats.firstFrameMilliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - mAttachTime).count();
+            LOGI("First frame %.1f ms after window attach", mSurfaceStats.firstFrameMilliseconds);
+        }
+    }
+    mPacer.afterSwap();
+    
+    if (hasTarget()) {
+        FrameTimingStats timing = mPacer.getStats();
+        recordMsaaCost(timing);
+        mResolution.update(timing.cpuMilliseconds, timing.gpuMilliseconds, frameBudgetMilliseconds());
+    }
+}
+
+void Renderer::beginPass(const RenderPassDescriptor& pass, GLuint framebuffer,
+                         int width, int height, int samples) {
+    if (mInPass) {
+        endPass();
+    }
+    mPass = pass;
+    mPassFramebuffer = framebuffer;
+    mPassWidth = width;
+    mPassHeight = height;
+    mPassSamples = samples;
+    mInPass = true;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    
+    // Contents nobody will read: tell the driver so tilers skip the load
+    bool dropColor = pass.colorLoad == LoadAction::DontCare;
+    bool dropDepth = !pass.useDepth || pass.depthLoad == LoadAction::DontCare;
+    if (dropColor || dropDepth) {
+        invalidateAttachments(GL_FRAMEBUFFER, framebuffer, dropColor, dropDepth);
+    }
+    
+    GLbitfield clearMask = 0;
+    if (pass.colorLoad == LoadAction::Clear) {
+        glClearColor(pass.clearColor[0], pass.clearColor[1], pass.clearColor[2], pass.clearColor[3]);
+        clearMask |= GL_COLOR_BUFFER_BIT;
+    }
+    if (pass.useDepth) {
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        if (pass.depthLoad == LoadAction::Clear) {
+            glClearDepthf(pass.clearDepth);
+            glClearStencil(0);
+            clearMask |= GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+        }
+    } else {
+        glDisable(GL_DEPTH_TEST);
+    }
+    if (clearMask != 0) {
+        glClear(clearMask);
+    }
+}
+
+void Renderer::endPass() {
+    if (!mInPass) return;
+    
+    bool dropColor = mPass.colorStore == StoreAction::DontCare;
+    bool dropDepth = !mPass.useDepth || mPass.depthStore == StoreAction::DontCare;
+    if (dropColor || dropDepth) {
+        invalidateAttachments(GL_FRAMEBUFFER, mPassFramebuffer, dropColor, dropDepth);
+    }
+    if (mPass.useDepth) {
+        glDisable(GL_DEPTH_TEST);
+    }
+    
+    PassTraffic traffic = estimatePassTraffic(mPass, mPassWidth, mPassHeight, mPassSamples);
+    mFrameStats.passesPerFrame++;
+    mFrameStats.bytesPerFrame += traffic.bytes;
+    mFrameStats.bytesSavedPerFrame += traffic.bytesSaved;
+    mInPass = false;
+}
+
+void Renderer::invalidateAttachments(GLenum target, GLuint framebuffer, bool color, bool depth) {
+    // The window names its buffers differently from framebuffer objects
+    GLenum attachments[3];
+    GLsizei count = 0;
+    if (framebuffer == 0) {
+        if (color) attachments[count++] = GL_COLOR;
+        if (depth) {
+            attachments[count++] = GL_DEPTH;
+            attachments[count++] = GL_STENCIL;
+        }
+    } else {
+        if (color) attachments[count++] = GL_COLOR_ATTACHMENT0;
+        if (depth) attachments[count++] = GL_DEPTH_STENCIL_ATTACHMENT;
+    }
+    if (count == 0) return;
+    
+    glInvalidateFramebuffer(target, count, attachments);
+    mFrameStats.invalidatesPerFrame++;
 }
 
 void Renderer::clear(float r, float g, float b, float a) {
-    glClearColor(r, g, b, a);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    mFramePass.clearColor[0] = r;
+    mFramePass.clearColor[1] = g;
+    mFramePass.clearColor[2] = b;
+    mFramePass.clearColor[3] = a;
+    
+    // Between frames this only sets the next frame pass's clear; clearing
+    // there as well would cost a second full-screen write
+    if (mInPass) {
+        glClearColor(r, g, b, a);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 }
 
 } // namespace graphics
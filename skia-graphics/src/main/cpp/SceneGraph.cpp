@@ -0,0 +1,608 @@
+#include "SceneGraph.h"
+#include "CardRenderer.h"
+#include "Renderer.h"
+#include "ShaderManager.h"
+#include "SpriteBatcher.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#define TAG "SceneGraph"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static bool intersects(const PixelRect& a, const PixelRect& b) {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+static PixelRect unite(const PixelRect& a, const PixelRect& b) {
+    return { std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+}
+
+SceneGraph::SceneGraph() {
+}
+
+SceneGraph::~SceneGraph() {
+    destroyLayer();
+}
+
+void SceneGraph::initialize(ShaderManager& shaders) {
+    mShaders = &shaders;
+
+    // One triangle over the viewport; the layer is the same size as the
+    // frame target, so texels map to pixels one to one
+    const char* vertexShaderSrc = R"(#version 300 es
+        void main() {
+            vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+            gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    const char* fragmentShaderSrc = R"(#version 300 es
+        precision mediump float;
+
+        uniform sampler2D uLayer;
+
+        out vec4 FragColor;
+
+        void main() {
+            FragColor = texelFetch(uLayer, ivec2(gl_FragCoord.xy), 0);
+        }
+    )";
+
+    if (!mShaders->submitShader("scene_layer", vertexShaderSrc, fragmentShaderSrc)) {
+        LOGE("Scene layer shader unavailable");
+    }
+    mFullRedraw = true;
+}
+
+void SceneGraph::release() {
+    destroyLayer();
+    mCompositeProgram = 0;
+    mShaders = nullptr;
+
+    mNodes.clear();
+    mRootChildren.clear();
+    mStale.clear();
+    mEffectMoves.clear();
+    mDirty.clear();
+    mFullRedraw = true;
+}
+
+void SceneGraph::onContextLost() {
+    mLayerFramebuffer = 0;
+    mLayerTexture = 0;
+    mMsaaFramebuffer = 0;
+    mMsaaColor = 0;
+    mLayerWidth = 0;
+    mLayerHeight = 0;
+    mCompositeProgram = 0;
+    mDirty.clear();
+    mFullRedraw = true;
+}
+
+SceneGraph::Node* SceneGraph::find(int id) {
+    auto it = mNodes.find(id);
+    return it != mNodes.end() ? &it->second : nullptr;
+}
+
+const SceneGraph::Node* SceneGraph::find(int id) const {
+    auto it = mNodes.find(id);
+    return it != mNodes.end() ? &it->second : nullptr;
+}
+
+SceneGraph::NodeList& SceneGraph::childrenOf(int parent) {
+    Node* node = find(parent);
+    return node != nullptr ? node->children : mRootChildren;
+}
+
+void SceneGraph::insertChild(int parent, int id) {
+    NodeList& siblings = childrenOf(parent);
+    siblings.push_back(id);
+    // Ids grow with creation, so ties keep creation order
+    std::sort(siblings.begin(), siblings.end(), [this](int a, int b) {
+        int orderA = find(a)->order;
+        int orderB = find(b)->order;
+        return orderA != orderB ? orderA < orderB : a < b;
+    });
+}
+
+int SceneGraph::createNode(SceneNodeType type, int parent) {
+    if (parent != ROOT && find(parent) == nullptr) return 0;
+
+    int id = mNextId++;
+    Node& node = mNodes[id];
+    node.type = type;
+    node.parent = parent;
+    node.x = 0.0f;
+    node.y = 0.0f;
+    node.width = 0.0f;
+    node.height = 0.0f;
+    node.scaleX = 1.0f;
+    node.cardId = 0;
+    node.order = 0;
+    node.emitterId = 0;
+    node.faceUp = true;
+    node.visible = true;
+    node.stale = false;
+    node.drawn = false;
+    node.left = node.bottom = node.right = node.top = 0.0f;
+
+    insertChild(parent, id);
+    markStale(id);
+    return id;
+}
+
+void SceneGraph::removeSubtree(int id, std::vector<int>& stoppedEmitters) {
+    Node* node = find(id);
+    if (node == nullptr) return;
+
+    for (int child : node->children) {
+        removeSubtree(child, stoppedEmitters);
+    }
+    if (node->drawn) {
+        addDirty(node->left, node->bottom, node->right, node->top);
+    }
+    if (node->emitterId != 0) {
+        stoppedEmitters.push_back(node->emitterId);
+    }
+    mNodes.erase(id);
+}
+
+void SceneGraph::destroyNode(int id, std::vector<int>& stoppedEmitters) {
+    Node* node = find(id);
+    if (node == nullptr) return;
+
+    NodeList& siblings = childrenOf(node->parent);
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), id), siblings.end());
+    removeSubtree(id, stoppedEmitters);
+}
+
+void SceneGraph::clear(std::vector<int>& stoppedEmitters) {
+    for (const auto& entry : mNodes) {
+        if (entry.second.emitterId != 0) {
+            stoppedEmitters.push_back(entry.second.emitterId);
+        }
+    }
+    mNodes.clear();
+    mRootChildren.clear();
+    mStale.clear();
+    mEffectMoves.clear();
+    mDirty.clear();
+    mFullRedraw = true;
+}
+
+void SceneGraph::markStale(int id) {
+    Node* node = find(id);
+    // Descendants were marked along with it
+    if (node == nullptr || node->stale) return;
+
+    node->stale = true;
+    mStale.push_back(id);
+    for (int child : node->children) {
+        markStale(child);
+    }
+}
+
+void SceneGraph::setPosition(int id, float x, float y) {
+    Node* node = find(id);
+    if (node == nullptr || (node->x == x && node->y == y)) return;
+    node->x = x;
+    node->y = y;
+    markStale(id);
+}
+
+void SceneGraph::setSize(int id, float width, float height) {
+    Node* node = find(id);
+    if (node == nullptr || (node->width == width && node->height == height)) return;
+    node->width = width;
+    node->height = height;
+    markStale(id);
+}
+
+bool SceneGraph::getTransform(int id, SceneTransform& transform) const {
+    const Node* node = find(id);
+    if (node == nullptr) return false;
+    transform.x = node->x;
+    transform.y = node->y;
+    transform.width = node->width;
+    transform.height = node->height;
+    transform.scaleX = node->scaleX;
+    return true;
+}
+
+void SceneGraph::setTransform(int id, const SceneTransform& transform) {
+    Node* node = find(id);
+    if (node == nullptr) return;
+    if (node->x == transform.x && node->y == transform.y && node->width == transform.width &&
+        node->height == transform.height && node->scaleX == transform.scaleX) {
+        return;
+    }
+    node->x = transform.x;
+    node->y = transform.y;
+    node->width = transform.width;
+    node->height = transform.height;
+    node->scaleX = transform.scaleX;
+    markStale(id);
+}
+
+void SceneGraph::setCard(int id, int cardId, bool faceUp) {
+    Node* node = find(id);
+    if (node == nullptr || (node->cardId == cardId && node->faceUp == faceUp)) return;
+    node->cardId = cardId;
+    node->faceUp = faceUp;
+    markStale(id);
+}
+
+void SceneGraph::setVisible(int id, bool visible) {
+    Node* node = find(id);
+    if (node == nullptr || node->visible == visible) return;
+    node->visible = visible;
+    markStale(id);
+}
+
+void SceneGraph::setOrder(int id, int order) {
+    Node* node = find(id);
+    if (node == nullptr || node->order == order) return;
+    node->order = order;
+
+    // Re-sorts the siblings; the node's bounds are redrawn in the new order
+    NodeList& siblings = childrenOf(node->parent);
+    siblings.erase(std::remove(siblings.begin(), siblings.end(), id), siblings.end());
+    insertChild(node->parent, id);
+    markStale(id);
+}
+
+void SceneGraph::setEmitter(int id, int emitterId) {
+    Node* node = find(id);
+    if (node != nullptr) {
+        node->emitterId = emitterId;
+    }
+}
+
+void SceneGraph::computeWorld(const Node& node, float& x, float& y, bool& visible) const {
+    x = node.x;
+    y = node.y;
+    visible = node.visible;
+    for (int parent = node.parent; parent != ROOT;) {
+        const Node* ancestor = find(parent);
+        if (ancestor == nullptr) break;
+        x += ancestor->x;
+        y += ancestor->y;
+        visible = visible && ancestor->visible;
+        parent = ancestor->parent;
+    }
+}
+
+bool SceneGraph::getWorldPosition(int id, float& x, float& y) const {
+    const Node* node = find(id);
+    if (node == nullptr) return false;
+    bool visible;
+    computeWorld(*node, x, y, visible);
+    return true;
+}
+
+void SceneGraph::resolveStale() {
+    for (int id : mStale) {
+        Node* node = find(id);
+        if (node == nullptr) continue;
+        node->stale = false;
+
+        // Where it was, then where it is now
+        if (node->drawn) {
+            addDirty(node->left, node->bottom, node->right, node->top);
+            node->drawn = false;
+        }
+
+        float x, y;
+        bool visible;
+        computeWorld(*node, x, y, visible);
+        if (node->type == SceneNodeType::Card) {
+            float width = node->width * node->scaleX;
+            if (visible && width > 0.0f && node->height > 0.0f) {
+                node->left = x + (node->width - width) * 0.5f;
+                node->bottom = y;
+                node->right = node->left + width;
+                node->top = y + node->height;
+                node->drawn = true;
+                addDirty(node->left, node->bottom, node->right, node->top);
+            }
+        } else if (node->type == SceneNodeType::Effect && node->emitterId != 0) {
+            mEffectMoves.push_back({ node->emitterId, x, y });
+        }
+    }
+    mStale.clear();
+}
+
+PixelRect SceneGraph::toPixels(float left, float bottom, float right, float top) const {
+    // Widened by a pixel so filtering and rounding never leave a stale edge
+    PixelRect rect;
+    rect.x0 = static_cast<int>(std::floor((left - mVisibleLeft) * mPixelsPerUnit)) - 1;
+    rect.y0 = static_cast<int>(std::floor((bottom - mVisibleBottom) * mPixelsPerUnit)) - 1;
+    rect.x1 = static_cast<int>(std::ceil((right - mVisibleLeft) * mPixelsPerUnit)) + 1;
+    rect.y1 = static_cast<int>(std::ceil((top - mVisibleBottom) * mPixelsPerUnit)) + 1;
+    rect.x0 = std::max(rect.x0, 0);
+    rect.y0 = std::max(rect.y0, 0);
+    rect.x1 = std::min(rect.x1, mLayerWidth);
+    rect.y1 = std::min(rect.y1, mLayerHeight);
+    return rect;
+}
+
+void SceneGraph::addDirty(float left, float bottom, float right, float top) {
+    // A full redraw covers it, and without a layer there is nothing to patch
+    if (mFullRedraw || mLayerFramebuffer == 0) return;
+
+    PixelRect rect = toPixels(left, bottom, right, top);
+    if (!rect.empty()) {
+        mDirty.push_back(rect);
+    }
+}
+
+void SceneGraph::mergeDirtyRects() {
+    // Overlapping rectangles are joined so no pixel is drawn twice, then the
+    // cheapest pairs are joined until few enough scissored redraws remain
+    for (;;) {
+        bool merged = false;
+        for (size_t i = 0; i < mDirty.size() && !merged; i++) {
+            for (size_t j = i + 1; j < mDirty.size(); j++) {
+                if (intersects(mDirty[i], mDirty[j])) {
+                    mDirty[i] = unite(mDirty[i], mDirty[j]);
+                    mDirty.erase(mDirty.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+        if (merged) continue;
+        if (mDirty.size() <= MAX_DIRTY_RECTS) return;
+
+        size_t bestI = 0;
+        size_t bestJ = 1;
+        int64_t bestGrowth = INT64_MAX;
+        for (size_t i = 0; i < mDirty.size(); i++) {
+            for (size_t j = i + 1; j < mDirty.size(); j++) {
+                int64_t growth = unite(mDirty[i], mDirty[j]).area() - mDirty[i].area() - mDirty[j].area();
+                if (growth < bestGrowth) {
+                    bestGrowth = growth;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+        mDirty[bestI] = unite(mDirty[bestI], mDirty[bestJ]);
+        mDirty.erase(mDirty.begin() + bestJ);
+    }
+}
+
+void SceneGraph::drawNodes(const NodeList& ids, CardRenderer& cards, bool vintage, bool woodGrain,
+                           const PixelRect* clip) {
+    for (int id : ids) {
+        const Node* node = find(id);
+        if (node == nullptr || !node->visible) continue;
+
+        if (node->drawn) {
+            bool inside = clip == nullptr ||
+                intersects(toPixels(node->left, node->bottom, node->right, node->top), *clip);
+            if (inside) {
+                float width = node->right - node->left;
+                if (node->faceUp) {
+                    cards.renderFace(node->left, node->bottom, width, node->height,
+                                     node->cardId, vintage);
+                } else {
+                    cards.renderBack(node->left, node->bottom, width, node->height, woodGrain);
+                }
+                mCardsDrawn++;
+            }
+        }
+        drawNodes(node->children, cards, vintage, woodGrain, clip);
+    }
+}
+
+bool SceneGraph::allocateLayer(int width, int height, int samples) {
+    destroyLayer();
+    // Clear stale errors so a failed allocation below is attributed correctly
+    while (glGetError() != GL_NO_ERROR) {}
+
+    glGenTextures(1, &mLayerTexture);
+    glBindTexture(GL_TEXTURE_2D, mLayerTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &mLayerFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mLayerFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mLayerTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && samples > 1) {
+        glGenRenderbuffers(1, &mMsaaColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, mMsaaColor);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &mMsaaFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, mMsaaFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mMsaaColor);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    GLenum error = glGetError();
+    if (!complete || error != GL_NO_ERROR) {
+        LOGE("Scene layer %dx%d with %d samples unavailable (0x%x)", width, height, samples, error);
+        destroyLayer();
+        return false;
+    }
+
+    mLayerWidth = width;
+    mLayerHeight = height;
+    mLayerSamples = samples;
+    LOGI("Scene layer %dx%d, %d samples", width, height, samples);
+    return true;
+}
+
+void SceneGraph::destroyLayer() {
+    if (mLayerFramebuffer != 0) {
+        glDeleteFramebuffers(1, &mLayerFramebuffer);
+        mLayerFramebuffer = 0;
+    }
+    if (mLayerTexture != 0) {
+        glDeleteTextures(1, &mLayerTexture);
+        mLayerTexture = 0;
+    }
+    if (mMsaaFramebuffer != 0) {
+        glDeleteFramebuffers(1, &mMsaaFramebuffer);
+        mMsaaFramebuffer = 0;
+    }
+    if (mMsaaColor != 0) {
+        glDeleteRenderbuffers(1, &mMsaaColor);
+        mMsaaColor = 0;
+    }
+    mLayerWidth = 0;
+    mLayerHeight = 0;
+    mLayerSamples = 0;
+}
+
+bool SceneGraph::updateLayer(Renderer& renderer, CardRenderer& cards, SpriteBatcher& sprites,
+                             bool vintage, bool woodGrain) {
+    const CameraState& view = renderer.getCamera().getState();
+    int samples = renderer.getSceneSamples();
+    const float* background = renderer.getFramePass().clearColor;
+
+    // Anything that moves pixels around or changes the background starts over
+    bool resized = view.renderWidth != mLayerWidth || view.renderHeight != mLayerHeight ||
+                   samples != mLayerSamples;
+    if (resized || mLayerFramebuffer == 0 ||
+        view.visibleLeft != mVisibleLeft || view.visibleBottom != mVisibleBottom ||
+        view.pixelsPerUnit != mPixelsPerUnit ||
+        std::memcmp(background, mBackground, sizeof(mBackground)) != 0) {
+        mFullRedraw = true;
+        mDirty.clear();
+    }
+    mVisibleLeft = view.visibleLeft;
+    mVisibleBottom = view.visibleBottom;
+    mPixelsPerUnit = view.pixelsPerUnit;
+    std::memcpy(mBackground, background, sizeof(mBackground));
+
+    resolveStale();
+
+    // Until the composite program is ready cards are drawn into the frame
+    if (mCompositeProgram == 0 && mShaders != nullptr) {
+        mCompositeProgram = mShaders->getProgram("scene_layer");
+        if (mCompositeProgram != 0) {
+            mLayerLoc = glGetUniformLocation(mCompositeProgram, "uLayer");
+        }
+    }
+    if (mCompositeProgram == 0) {
+        mFullRedraw = true;
+        return false;
+    }
+
+    if ((resized || mLayerFramebuffer == 0) &&
+        !allocateLayer(view.renderWidth, view.renderHeight, samples)) {
+        return false;
+    }
+    if (!mFullRedraw && mDirty.empty()) return true;
+
+    int64_t layerArea = static_cast<int64_t>(mLayerWidth) * mLayerHeight;
+    int64_t dirtyArea = 0;
+    if (!mFullRedraw) {
+        mergeDirtyRects();
+        for (const PixelRect& rect : mDirty) {
+            dirtyArea += rect.area();
+        }
+        if (dirtyArea > FULL_REDRAW_FRACTION * layerArea) {
+            mFullRedraw = true;
+        }
+    }
+
+    // Cleared when redrawn whole, otherwise patched in place
+    RenderPassDescriptor pass;
+    pass.colorLoad = mFullRedraw ? LoadAction::Clear : LoadAction::Load;
+    std::memcpy(pass.clearColor, mBackground, sizeof(pass.clearColor));
+    GLuint target = mLayerSamples > 1 ? mMsaaFramebuffer : mLayerFramebuffer;
+    renderer.beginPass(pass, target, mLayerWidth, mLayerHeight, mLayerSamples);
+
+    mCardsDrawn = 0;
+    if (mFullRedraw) {
+        drawNodes(mRootChildren, cards, vintage, woodGrain, nullptr);
+        sprites.flush();
+    } else {
+        glEnable(GL_SCISSOR_TEST);
+        glClearColor(mBackground[0], mBackground[1], mBackground[2], mBackground[3]);
+        for (const PixelRect& rect : mDirty) {
+            glScissor(rect.x0, rect.y0, rect.x1 - rect.x0, rect.y1 - rect.y0);
+            glClear(GL_COLOR_BUFFER_BIT);
+            drawNodes(mRootChildren, cards, vintage, woodGrain, &rect);
+            // Each rect's cards must be drawn under its own scissor
+            sprites.flush();
+        }
+        // Blits are scissored too
+        glDisable(GL_SCISSOR_TEST);
+    }
+    renderer.endPass();
+
+    if (mLayerSamples > 1) {
+        // Resolve only what changed; ES 3 resolves need matching rectangles
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mMsaaFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mLayerFramebuffer);
+        if (mFullRedraw) {
+            glBlitFramebuffer(0, 0, mLayerWidth, mLayerHeight, 0, 0, mLayerWidth, mLayerHeight,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        } else {
+            for (const PixelRect& rect : mDirty) {
+                glBlitFramebuffer(rect.x0, rect.y0, rect.x1, rect.y1, rect.x0, rect.y0, rect.x1, rect.y1,
+                                  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            }
+        }
+    }
+
+    mStats.layerUpdates++;
+    if (mFullRedraw) {
+        mStats.fullRedraws++;
+        mStats.lastDirtyRects = 1;
+        mStats.lastDirtyFraction = 1.0f;
+    } else {
+        mStats.lastDirtyRects = static_cast<uint32_t>(mDirty.size());
+        mStats.lastDirtyFraction = layerArea > 0 ? static_cast<float>(dirtyArea) / layerArea : 0.0f;
+    }
+    mStats.lastCardsDrawn = mCardsDrawn;
+
+    mDirty.clear();
+    mFullRedraw = false;
+    return true;
+}
+
+void SceneGraph::composite() {
+    // The layer is opaque where it matters and replaces whatever is there;
+    // blending against a DontCare target would read garbage
+    glUseProgram(mCompositeProgram);
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mLayerTexture);
+    glUniform1i(mLayerLoc, 0);
+
+    glDisable(GL_BLEND);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_BLEND);
+}
+
+void SceneGraph::drawDirect(CardRenderer& cards, bool vintage, bool woodGrain) {
+    mCardsDrawn = 0;
+    drawNodes(mRootChildren, cards, vintage, woodGrain, nullptr);
+}
+
+SceneStats SceneGraph::getStats() const {
+    SceneStats stats = mStats;
+    stats.nodeCount = static_cast<uint32_t>(mNodes.size());
+    return stats;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,194 @@
+#include "ShaderCache.h"
+#include <android/log.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <vector>
+
+#define TAG "ShaderCache"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static const char CACHE_MAGIC[4] = { 'T', 'S', 'P', 'B' };
+static const uint32_t CACHE_VERSION = 1;
+
+struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+    float compileMilliseconds;
+    uint32_t reserved;
+};
+
+static const uint64_t FNV_OFFSET = 1469598103934665603ull;
+static const uint64_t FNV_PRIME = 1099511628211ull;
+
+static uint64_t hashString(uint64_t hash, const char* text) {
+    if (text != nullptr) {
+        for (const char* c = text; *c != '\0'; c++) {
+            hash = (hash ^ static_cast<uint8_t>(*c)) * FNV_PRIME;
+        }
+    }
+    // Separator so ("ab", "c") and ("a", "bc") hash differently
+    return (hash ^ 0xFFu) * FNV_PRIME;
+}
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ShaderCache::ShaderCache() {
+}
+
+ShaderCache::~ShaderCache() {
+}
+
+void ShaderCache::initialize(const std::string& directory) {
+    mStats = {};
+    mEnabled = false;
+    mDirectory = directory;
+    if (mDirectory.empty()) return;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0) {
+        LOGI("Driver exposes no program binary formats, shader cache disabled");
+        return;
+    }
+
+    if (mkdir(mDirectory.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOGE("Cannot create shader cache directory %s", mDirectory.c_str());
+        return;
+    }
+
+    // Binaries are only valid for the exact driver that produced them
+    mDriverHash = FNV_OFFSET;
+    mDriverHash = hashString(mDriverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    mDriverHash = hashString(mDriverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    mDriverHash = hashString(mDriverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    mEnabled = true;
+}
+
+uint64_t ShaderCache::computeKey(const char* vertexSrc, const char* fragmentSrc,
+                                 const char* const* feedbackVaryings, int varyingCount) const {
+    uint64_t hash = hashString(mDriverHash, vertexSrc);
+    hash = hashString(hash, fragmentSrc);
+    for (int i = 0; i < varyingCount; i++) {
+        hash = hashString(hash, feedbackVaryings[i]);
+    }
+    return hash;
+}
+
+std::string ShaderCache::pathFor(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return mDirectory + "/" + name;
+}
+
+GLuint ShaderCache::load(uint64_t key) {
+    if (!mEnabled) return 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string path = pathFor(key);
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        mStats.misses++;
+        return 0;
+    }
+
+    BinaryHeader header;
+    std::vector<uint8_t> binary;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                 memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+                 header.version == CACHE_VERSION &&
+                 header.key == key &&
+                 header.binaryLength > 0;
+    if (valid) {
+        binary.resize(header.binaryLength);
+        valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_FALSE) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (program == 0) {
+        // Stale or corrupt; the caller recompiles and store() replaces it
+        LOGI("Rejected cached program %s", path.c_str());
+        remove(path.c_str());
+        mStats.rejected++;
+        mStats.misses++;
+        return 0;
+    }
+
+    double elapsed = millisecondsSince(start);
+    mStats.hits++;
+    mStats.loadMilliseconds += elapsed;
+    mStats.savedMilliseconds += header.compileMilliseconds - elapsed;
+    return program;
+}
+
+void ShaderCache::store(uint64_t key, GLuint program, double compileMilliseconds) {
+    if (!mEnabled || program == 0) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<uint8_t> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    BinaryHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.key = key;
+    header.binaryFormat = format;
+    header.binaryLength = static_cast<uint32_t>(written);
+    header.compileMilliseconds = static_cast<float>(compileMilliseconds);
+    header.reserved = 0;
+
+    // Write beside the final name so a crash never leaves a truncated binary
+    std::string path = pathFor(key);
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (file == nullptr) {
+        LOGE("Cannot write shader cache entry %s", tempPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(binary.data(), 1, written, file) == static_cast<size_t>(written);
+    fclose(file);
+
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to store shader cache entry");
+        remove(tempPath.c_str());
+    }
+}
+
+void ShaderCache::recordCompile(double milliseconds) {
+    mStats.compileMilliseconds += milliseconds;
+}
+
+} // namespace graphics
+} // namespace trashapp
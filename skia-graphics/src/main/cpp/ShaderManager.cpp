@@ -1,13 +1,45 @@
-#include &quot;ShaderManager.h&quot;
-#include &lt;android/log.h&gt;
+#include "ShaderManager.h"
+#include "Camera.h"
+#include <android/log.h>
+#include <EGL/egl.h>
+#include <chrono>
+#include <cstring>
+#include <vector>
 
-#define TAG &quot;ShaderManager&quot;
+#define TAG "ShaderManager"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
+// KHR_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+typedef void (*MaxShaderCompilerThreadsProc)(GLuint count);
+
 namespace trashapp {
 namespace graphics {
 
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Uniform blocks shared between programs and the binding point each uses
+static const struct {
+    const char* name;
+    GLuint binding;
+} SHARED_BLOCKS[] = {
+    { "Camera", Camera::BLOCK_BINDING },
+};
+
+static void bindSharedBlocks(GLuint program) {
+    for (const auto& block : SHARED_BLOCKS) {
+        GLuint index = glGetUniformBlockIndex(program, block.name);
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, index, block.binding);
+        }
+    }
+}
+
 void ShaderProgram::use() const {
     if (program != 0) {
         glUseProgram(program);
@@ -36,55 +68,198 @@ ShaderManager::~ShaderManager() {
     release();
 }
 
-void ShaderManager::initialize() {
+void ShaderManager::initialize(const std::string& cacheDirectory) {
+    mCache.initialize(cacheDirectory);
+    
+    configureParallelCompile();
+    
     mInitialized = true;
-    LOGI(&quot;ShaderManager initialized&quot;);
+    LOGI("ShaderManager initialized (parallel compile %s)", mParallelCompile ? "on" : "off");
+}
+
+void ShaderManager::configureParallelCompile() {
+    // With KHR_parallel_shader_compile the driver compiles on its own threads
+    // and GL_COMPLETION_STATUS_KHR can be polled without blocking
+    mParallelCompile = false;
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name != nullptr && strcmp(name, "GL_KHR_parallel_shader_compile") == 0) {
+            mParallelCompile = true;
+            break;
+        }
+    }
+    if (mParallelCompile) {
+        auto maxThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(
+            eglGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (maxThreads != nullptr) {
+            maxThreads(0xFFFFFFFFu);   // let the driver pick
+        }
+    }
 }
 
 void ShaderManager::release() {
-    for (auto&amp; pair : mShaders) {
+    for (auto& pair : mShaders) {
         pair.second->cleanup();
     }
     mShaders.clear();
     mInitialized = false;
-    LOGI(&quot;ShaderManager released&quot;);
+    LOGI("ShaderManager released");
+}
+
+void ShaderManager::onContextLost() {
+    for (auto& pair : mShaders) {
+        ShaderProgram& shader = *pair.second;
+        shader.vertexShader = 0;
+        shader.fragmentShader = 0;
+        shader.program = 0;
+        shader.ready = false;
+    }
+}
+
+void ShaderManager::restorePrograms() {
+    if (!mInitialized) return;
+    
+    // Extension state belongs to the context
+    configureParallelCompile();
+    
+    std::vector<std::string> names;
+    for (const auto& pair : mShaders) {
+        names.push_back(pair.first);
+    }
+    
+    for (const auto& name : names) {
+        // submitShader replaces the entry, so copy the sources out first
+        ShaderProgram& shader = *mShaders[name];
+        std::string vertexSrc = shader.vertexSource;
+        std::string fragmentSrc = shader.fragmentSource;
+        std::vector<std::string> varyings = shader.feedbackVaryings;
+        std::vector<const char*> varyingNames;
+        for (const auto& varying : varyings) {
+            varyingNames.push_back(varying.c_str());
+        }
+        submitShader(name.c_str(), vertexSrc.c_str(), fragmentSrc.c_str(),
+                     varyingNames.data(), static_cast<int>(varyingNames.size()));
+    }
+    LOGI("Resubmitted %zu shader programs after context loss", names.size());
 }
 
 bool ShaderManager::loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc) {
+    return loadShader(name, vertexSrc, fragmentSrc, nullptr, 0);
+}
+
+bool ShaderManager::loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc,
+                               const char* const* feedbackVaryings, int varyingCount) {
+    if (!submitShader(name, vertexSrc, fragmentSrc, feedbackVaryings, varyingCount)) {
+        return false;
+    }
+    return finishShader(name, true);
+}
+
+bool ShaderManager::submitShader(const char* name, const char* vertexSrc, const char* fragmentSrc,
+                                 const char* const* feedbackVaryings, int varyingCount) {
+    uint64_t key = mCache.computeKey(vertexSrc, fragmentSrc, feedbackVaryings, varyingCount);
+    
+    // Several owners may request the same program; keep the one already submitted
+    auto existing = mShaders.find(name);
+    if (existing != mShaders.end() && existing->second->program != 0 &&
+        existing->second->cacheKey == key) {
+        return true;
+    }
+    
     auto shader = std::make_unique<ShaderProgram>();
+    shader->cacheKey = key;
+    shader->vertexSource = vertexSrc;
+    shader->fragmentSource = fragmentSrc;
+    for (int i = 0; i < varyingCount; i++) {
+        shader->feedbackVaryings.push_back(feedbackVaryings[i]);
+    }
     
-    // Compile vertex shader
-    shader->vertexShader = compileShader(GL_VERTEX_SHADER, vertexSrc);
-    if (shader->vertexShader == 0) {
-        LOGE(&quot;Failed to compile vertex shader: %s&quot;, name);
-        return false;
+    // Try the program binary cache first
+    shader->program = mCache.load(key);
+    shader->ready = shader->program != 0;
+    if (shader->ready) {
+        bindSharedBlocks(shader->program);
     }
     
-    // Compile fragment shader
-    shader->fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
-    if (shader->fragmentShader == 0) {
-        LOGE(&quot;Failed to compile fragment shader: %s&quot;, name);
-        shader->cleanup();
-        return false;
+    if (!shader->ready) {
+        // Queue compile and link without asking for status, so the driver
+        // can work on every program while the caller does something else
+        auto start = std::chrono::steady_clock::now();
+        shader->vertexShader = compileShader(GL_VERTEX_SHADER, vertexSrc);
+        shader->fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
+        linkProgram(*shader, feedbackVaryings, varyingCount);
+        shader->buildMilliseconds = millisecondsSince(start);
     }
     
-    // Link program
-    if (!linkProgram(*shader)) {
-        LOGE(&quot;Failed to link shader program: %s&quot;, name);
-        shader->cleanup();
-        return false;
+    if (existing != mShaders.end()) {
+        existing->second->cleanup();
     }
     
     mShaders[name] = std::move(shader);
-    LOGI(&quot;Shader loaded successfully: %s&quot;, name);
     return true;
 }
 
-void ShaderManager::useShader(const char* name) {
+bool ShaderManager::finishShader(const char* name, bool block) {
     auto it = mShaders.find(name);
-    if (it != mShaders.end()) {
-        it->second->use();
+    if (it == mShaders.end()) return false;
+    
+    ShaderProgram& shader = *it->second;
+    if (shader.ready) return true;
+    
+    if (!block && mParallelCompile) {
+        GLint complete = GL_FALSE;
+        glGetProgramiv(shader.program, GL_COMPLETION_STATUS_KHR, &complete);
+        if (complete == GL_FALSE) return false;
+    }
+    
+    // These queries wait for the driver if it has not finished yet
+    auto start = std::chrono::steady_clock::now();
+    bool compiled = checkCompileStatus(shader.vertexShader, name) &&
+                    checkCompileStatus(shader.fragmentShader, name);
+    if (!compiled || !checkLinkStatus(shader.program, name)) {
+        LOGE("Failed to build shader program: %s", name);
+        shader.cleanup();
+        mShaders.erase(it);
+        return false;
+    }
+    
+    shader.buildMilliseconds += millisecondsSince(start);
+    mCache.recordCompile(shader.buildMilliseconds);
+    mCache.store(shader.cacheKey, shader.program, shader.buildMilliseconds);
+    bindSharedBlocks(shader.program);
+    shader.ready = true;
+    
+    LOGI("Shader loaded successfully: %s (%.1f ms)", name, shader.buildMilliseconds);
+    return true;
+}
+
+size_t ShaderManager::pollShaders(bool block) {
+    std::vector<std::string> pending;
+    for (const auto& pair : mShaders) {
+        if (!pair.second->ready) {
+            pending.push_back(pair.first);
+        }
     }
+    
+    size_t remaining = 0;
+    for (const auto& name : pending) {
+        if (!finishShader(name.c_str(), block) && mShaders.count(name) != 0) {
+            remaining++;
+        }
+    }
+    return remaining;
+}
+
+bool ShaderManager::isShaderReady(const char* name) {
+    return finishShader(name, false);
+}
+
+void ShaderManager::useShader(const char* name) {
+    // An explicit use needs the program now, so wait for it if necessary
+    if (!finishShader(name, true)) return;
+    mShaders[name]->use();
 }
 
 ShaderProgram* ShaderManager::getShader(const char* name) {
@@ -95,52 +270,66 @@ ShaderProgram* ShaderManager::getShader(const char* name) {
     return nullptr;
 }
 
+GLuint ShaderManager::getProgram(const char* name) {
+    if (!isShaderReady(name)) return 0;
+    return mShaders[name]->program;
+}
+
 GLuint ShaderManager::compileShader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &amp;source, nullptr);
+    glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
-    
+    return shader;
+}
+
+void ShaderManager::linkProgram(ShaderProgram& shader, const char* const* feedbackVaryings,
+                                int varyingCount) {
+    shader.program = glCreateProgram();
+    glAttachShader(shader.program, shader.vertexShader);
+    glAttachShader(shader.program, shader.fragmentShader);
+    if (varyingCount > 0) {
+        glTransformFeedbackVaryings(shader.program, varyingCount, feedbackVaryings, GL_INTERLEAVED_ATTRIBS);
+    }
+    if (mCache.isEnabled()) {
+        glProgramParameteri(shader.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(shader.program);
+}
+
+bool ShaderManager::checkCompileStatus(GLuint shader, const char* name) {
     GLint success = 0;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &amp;success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     
     if (success == GL_FALSE) {
         GLint logLength = 0;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &amp;logLength);
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &logLength);
         
         if (logLength > 0) {
             char* log = new char[logLength];
             glGetShaderInfoLog(shader, logLength, nullptr, log);
-            LOGE(&quot;Shader compilation error: %s&quot;, log);
+            LOGE("Shader compilation error in %s: %s", name, log);
             delete[] log;
         }
-        
-        glDeleteShader(shader);
-        return 0;
+        return false;
     }
     
-    return shader;
+    return true;
 }
 
-bool ShaderManager::linkProgram(ShaderProgram&amp; shader) {
-    shader.program = glCreateProgram();
-    glAttachShader(shader.program, shader.vertexShader);
-    glAttachShader(shader.program, shader.fragmentShader);
-    glLinkProgram(shader.program);
-    
+bool ShaderManager::checkLinkStatus(GLuint program, const char* name) {
     GLint success = 0;
-    glGetProgramiv(shader.program, GL_LINK_STATUS, &amp;success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     
     if (success == GL_FALSE) {
         GLint logLength = 0;
-        glGetProgramiv(shader.program, GL_INFO_LOG_LENGTH, &amp;logLength);
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &logLength);
         
         if (logLength > 0) {
             char* log = new char[logLength];
-            glGetProgramInfoLog(shader.program, logLength, nullptr, log);
-            LOGE(&quot;Program link error: %s&quot;, log);
+            glGetProgramInfoLog(program, logLength, nullptr, log);
+            LOGE("Program link error in %s: %s", name, log);
             delete[] log;
         }
-        
         return false;
     }
     
@@ -0,0 +1,341 @@
+#include "SpriteBatcher.h"
+#include "ShaderManager.h"
+#include "Camera.h"
+#include "Profiler.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstddef>
+
+#define TAG "SpriteBatcher"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// Sort key, most significant first: layer 16 bits, blend 4, shader 12,
+// texture slot 16, submission order 16
+static const int LAYER_SHIFT = 48;
+static const int BLEND_SHIFT = 44;
+static const int SHADER_SHIFT = 32;
+static const int TEXTURE_SHIFT = 16;
+static const uint32_t SHADER_LIMIT = 1u << 12;
+static const uint32_t TEXTURE_SLOT_LIMIT = 0xffffu;
+
+const char* const SpriteBatcher::VERTEX_SHADER = "#version 300 es\n" CAMERA_UNIFORM_BLOCK R"(
+    layout(location = 0) in vec2 aPosition;
+    layout(location = 1) in vec2 aTexCoord;
+    layout(location = 2) in vec4 aColor;
+
+    out vec2 vTexCoord;
+    out vec4 vColor;
+
+    void main() {
+        gl_Position = uProjection * vec4(aPosition, 0.0, 1.0);
+        vTexCoord = aTexCoord;
+        vColor = aColor;
+    }
+)";
+
+static const char* const DEFAULT_FRAGMENT_SHADER = R"(#version 300 es
+    precision mediump float;
+
+    in vec2 vTexCoord;
+    in vec4 vColor;
+    uniform sampler2D uTexture;
+
+    out vec4 FragColor;
+
+    void main() {
+        FragColor = texture(uTexture, vTexCoord) * vColor;
+    }
+)";
+
+SpriteBatcher::SpriteBatcher() {
+    mQueue.reserve(1024);
+    mKeys.reserve(1024);
+}
+
+SpriteBatcher::~SpriteBatcher() {
+    release();
+}
+
+void SpriteBatcher::initialize(ShaderManager& shaders) {
+    if (mInitialized) {
+        LOGI("SpriteBatcher already initialized");
+        return;
+    }
+
+    mShaders = &shaders;
+    if (!mShaders->submitShader("sprite", VERTEX_SHADER, DEFAULT_FRAGMENT_SHADER)) {
+        LOGE("Sprite shader unavailable");
+    }
+    mShaderEntries.clear();
+    registerShader("sprite");
+
+    createBuffers();
+    mInitialized = true;
+    LOGI("SpriteBatcher initialized");
+}
+
+void SpriteBatcher::release() {
+    if (!mInitialized) return;
+
+    if (mVertexArray != 0) {
+        glDeleteVertexArrays(1, &mVertexArray);
+        mVertexArray = 0;
+    }
+    if (mVertexBuffer != 0) {
+        glDeleteBuffers(1, &mVertexBuffer);
+        mVertexBuffer = 0;
+    }
+    if (mIndexBuffer != 0) {
+        glDeleteBuffers(1, &mIndexBuffer);
+        mIndexBuffer = 0;
+    }
+    // Programs belong to the shader manager
+    mShaderEntries.clear();
+    mShaders = nullptr;
+    mQueue.clear();
+    mKeys.clear();
+
+    mInitialized = false;
+}
+
+void SpriteBatcher::onContextLost() {
+    mVertexArray = 0;
+    mVertexBuffer = 0;
+    mIndexBuffer = 0;
+    for (auto& entry : mShaderEntries) {
+        entry.program = 0;
+    }
+    mQueue.clear();
+    mKeys.clear();
+}
+
+void SpriteBatcher::createBuffers() {
+    // Every quad is two triangles over its four vertices, so one static
+    // index buffer serves any run
+    std::vector<uint16_t> indices(MAX_SPRITES * 6);
+    for (uint32_t i = 0; i < MAX_SPRITES; i++) {
+        uint16_t base = static_cast<uint16_t>(i * 4);
+        uint16_t* quad = indices.data() + i * 6;
+        quad[0] = base;
+        quad[1] = base + 1;
+        quad[2] = base + 2;
+        quad[3] = base + 1;
+        quad[4] = base + 3;
+        quad[5] = base + 2;
+    }
+
+    glGenVertexArrays(1, &mVertexArray);
+    glBindVertexArray(mVertexArray);
+
+    glGenBuffers(1, &mVertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, MAX_SPRITES * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+
+    glGenBuffers(1, &mIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                          (void*)offsetof(SpriteVertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex),
+                          (void*)offsetof(SpriteVertex, u));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex),
+                          (void*)offsetof(SpriteVertex, color));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+}
+
+int SpriteBatcher::registerShader(const char* name) {
+    for (size_t i = 0; i < mShaderEntries.size(); i++) {
+        if (mShaderEntries[i].name == name) return static_cast<int>(i);
+    }
+    if (mShaderEntries.size() >= SHADER_LIMIT) {
+        LOGE("No room for sprite shader %s", name);
+        return -1;
+    }
+
+    ShaderEntry entry;
+    entry.name = name;
+    entry.program = 0;
+    entry.textureLoc = -1;
+    mShaderEntries.push_back(entry);
+    return static_cast<int>(mShaderEntries.size() - 1);
+}
+
+bool SpriteBatcher::resolveShader(ShaderEntry& entry) {
+    if (entry.program != 0) return true;
+
+    // Sprites are skipped until the driver has finished the program
+    entry.program = mShaders != nullptr ? mShaders->getProgram(entry.name.c_str()) : 0;
+    if (entry.program == 0) return false;
+    entry.textureLoc = glGetUniformLocation(entry.program, "uTexture");
+    return true;
+}
+
+uint32_t SpriteBatcher::packColor(float r, float g, float b, float a) {
+    auto channel = [](float value) {
+        return static_cast<uint32_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+    };
+    return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24);
+}
+
+uint64_t SpriteBatcher::sortKey(const Sprite& sprite, uint32_t textureSlot, uint32_t sequence) {
+    // Offset so negative layers sort below zero
+    uint64_t layer = static_cast<uint16_t>(std::min(std::max(sprite.layer, -32768), 32767) + 32768);
+    return (layer << LAYER_SHIFT) |
+           (static_cast<uint64_t>(sprite.blend) << BLEND_SHIFT) |
+           (static_cast<uint64_t>(sprite.shader) << SHADER_SHIFT) |
+           (static_cast<uint64_t>(textureSlot) << TEXTURE_SHIFT) |
+           sequence;
+}
+
+uint32_t SpriteBatcher::textureSlot(GLuint texture) {
+    for (size_t i = 0; i < mTextureSlots.size(); i++) {
+        if (mTextureSlots[i] == texture) return static_cast<uint32_t>(i);
+    }
+    // Past the limit textures share a slot; runs still split on the real name
+    if (mTextureSlots.size() >= TEXTURE_SLOT_LIMIT) return TEXTURE_SLOT_LIMIT;
+    mTextureSlots.push_back(texture);
+    return static_cast<uint32_t>(mTextureSlots.size() - 1);
+}
+
+void SpriteBatcher::draw(const Sprite& sprite) {
+    if (!mInitialized) return;
+    if (sprite.shader < 0 || sprite.shader >= static_cast<int>(mShaderEntries.size())) return;
+
+    if (mQueue.size() >= MAX_SPRITES) {
+        flush();
+    }
+    if (mQueue.empty()) {
+        mTextureSlots.clear();
+    }
+    uint32_t sequence = static_cast<uint32_t>(mQueue.size());
+    mKeys.push_back(sortKey(sprite, textureSlot(sprite.texture), sequence));
+    mQueue.push_back(sprite);
+}
+
+void SpriteBatcher::applyBlend(BlendMode blend) {
+    switch (blend) {
+        case BlendMode::Alpha:
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BlendMode::Premultiplied:
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case BlendMode::Additive:
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            break;
+        case BlendMode::Opaque:
+            glDisable(GL_BLEND);
+            break;
+    }
+}
+
+void SpriteBatcher::flush() {
+    if (mQueue.empty()) return;
+    PROFILE_SCOPE("sprites.flush");
+    PROFILE_GPU_SCOPE("sprites.flush");
+
+    // Rebuilt lazily after context loss
+    if (mVertexArray == 0) {
+        createBuffers();
+    }
+
+    std::sort(mKeys.begin(), mKeys.end());
+
+    // Vertices in draw order; sprites without a ready program are dropped
+    mVertices.clear();
+    FrameVector<const Sprite*> ordered{ArenaAllocator<const Sprite*>(mFrameArena)};
+    ordered.reserve(mKeys.size());
+    for (uint64_t key : mKeys) {
+        const Sprite& sprite = mQueue[key & 0xffffu];
+        if (!resolveShader(mShaderEntries[sprite.shader])) {
+            mFrame.skippedSprites++;
+            continue;
+        }
+        float x1 = sprite.x + sprite.width;
+        float y1 = sprite.y + sprite.height;
+        mVertices.push_back({ sprite.x, y1, sprite.u0, sprite.v1, sprite.color });   // top-left
+        mVertices.push_back({ x1, y1, sprite.u1, sprite.v1, sprite.color });         // top-right
+        mVertices.push_back({ sprite.x, sprite.y, sprite.u0, sprite.v0, sprite.color }); // bottom-left
+        mVertices.push_back({ x1, sprite.y, sprite.u1, sprite.v0, sprite.color });   // bottom-right
+        ordered.push_back(&sprite);
+    }
+
+    if (!ordered.empty()) {
+        glBindVertexArray(mVertexArray);
+        glBindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+        // Orphan last flush's storage so the driver never waits on it
+        glBufferData(GL_ARRAY_BUFFER, MAX_SPRITES * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mVertices.size() * sizeof(SpriteVertex), mVertices.data());
+        glActiveTexture(GL_TEXTURE0);
+
+        size_t runStart = 0;
+        const Sprite* bound = nullptr;
+        for (size_t i = 0; i <= ordered.size(); i++) {
+            const Sprite* sprite = i < ordered.size() ? ordered[i] : nullptr;
+            bool sameState = sprite != nullptr && bound != nullptr &&
+                             sprite->shader == bound->shader && sprite->texture == bound->texture &&
+                             sprite->blend == bound->blend;
+            if (sameState) continue;
+
+            // Draw the run that just ended, then switch to the new state
+            if (i > runStart) {
+                GLsizei count = static_cast<GLsizei>(i - runStart);
+                glDrawElements(GL_TRIANGLES, count * 6, GL_UNSIGNED_SHORT,
+                               (void*)(runStart * 6 * sizeof(uint16_t)));
+                mFrame.batches++;
+                mFrame.largestBatch = std::max(mFrame.largestBatch, static_cast<uint32_t>(count));
+            }
+            if (sprite == nullptr) break;
+
+            const ShaderEntry& entry = mShaderEntries[sprite->shader];
+            if (bound == nullptr || sprite->shader != bound->shader) {
+                glUseProgram(entry.program);
+                glUniform1i(entry.textureLoc, 0);
+                mFrame.stateChanges++;
+            }
+            if (bound == nullptr || sprite->texture != bound->texture) {
+                glBindTexture(GL_TEXTURE_2D, sprite->texture);
+                mFrame.stateChanges++;
+            }
+            if (bound == nullptr || sprite->blend != bound->blend) {
+                applyBlend(sprite->blend);
+                mFrame.stateChanges++;
+            }
+            bound = sprite;
+            runStart = i;
+        }
+
+        // Leave the renderer's defaults behind
+        applyBlend(BlendMode::Alpha);
+        glBindVertexArray(0);
+        mFrame.sprites += static_cast<uint32_t>(ordered.size());
+    }
+
+    mFrame.flushes++;
+    mQueue.clear();
+    mKeys.clear();
+}
+
+void SpriteBatcher::beginFrame() {
+    mFrame = {};
+}
+
+void SpriteBatcher::endFrame() {
+    flush();
+    mStats = mFrame;
+}
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,184 @@
+#include "TextRenderer.h"
+#include "ShaderManager.h"
+#include "SpriteBatcher.h"
+#include <android/log.h>
+
+#define TAG "TextRenderer"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+// Next code point of a UTF-8 string; malformed bytes come back as themselves
+static uint32_t decodeUtf8(const char*& p) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(p);
+    uint32_t c = s[0];
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra > 0) {
+        uint32_t codepoint = c & (0x3F >> extra);
+        for (int i = 1; i <= extra; i++) {
+            if ((s[i] & 0xC0) != 0x80) {
+                p++;
+                return c;
+            }
+            codepoint = (codepoint << 6) | (s[i] & 0x3F);
+        }
+        p += extra + 1;
+        return codepoint;
+    }
+    p++;
+    return c;
+}
+
+TextRenderer::TextRenderer() {
+}
+
+TextRenderer::~TextRenderer() {
+    release();
+}
+
+void TextRenderer::initialize(ShaderManager& shaders, SpriteBatcher& sprites,
+                              const std::string& cacheDirectory) {
+    if (mInitialized) {
+        LOGI("TextRenderer already initialized");
+        return;
+    }
+
+    // The atlas stores distance, not coverage: edges are thresholded at 0.5
+    // and smoothed over about one screen pixel at any magnification
+    const char* fragmentShaderSrc = R"(#version 300 es
+        precision mediump float;
+
+        in vec2 vTexCoord;
+        in vec4 vColor;
+        uniform sampler2D uTexture;
+
+        out vec4 FragColor;
+
+        void main() {
+            float distance = texture(uTexture, vTexCoord).r;
+            float width = max(fwidth(distance) * 0.7, 0.001);
+            float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+            FragColor = vec4(vColor.rgb, vColor.a * alpha);
+        }
+    )";
+
+    // Submitted before the atlas is generated so the driver compiles meanwhile
+    if (!shaders.submitShader("sdf_glyph", SpriteBatcher::VERTEX_SHADER, fragmentShaderSrc)) {
+        LOGE("Glyph shader unavailable");
+    }
+    mSprites = &sprites;
+    mShader = mSprites->registerShader("sdf_glyph");
+
+    if (!mAtlas.isBuilt()) {
+        mAtlas.build(cacheDirectory);
+    }
+    bindAtlas();
+
+    mInitialized = true;
+    LOGI("TextRenderer initialized");
+}
+
+void TextRenderer::release() {
+    if (!mInitialized) return;
+
+    mAtlas.releaseTexture();
+    mSprites = nullptr;
+    mShader = -1;
+
+    mInitialized = false;
+}
+
+void TextRenderer::onContextLost() {
+    mAtlas.abandonTexture();
+}
+
+bool TextRenderer::bindAtlas() {
+    // Rebuilt lazily after context loss
+    if (mAtlas.getTexture() == 0 && mAtlas.upload() == 0) {
+        LOGE("Glyph atlas has no distances to upload");
+        return false;
+    }
+    return true;
+}
+
+const GlyphMetrics* TextRenderer::resolve(uint32_t codepoint) const {
+    const GlyphMetrics* metrics = mAtlas.find(codepoint);
+    if (metrics == nullptr && codepoint < 0x80) {
+        // Ranks and labels are upper case; only 'x' has its own glyph
+        if (codepoint >= 'a' && codepoint <= 'z') {
+            metrics = mAtlas.find(codepoint - 'a' + 'A');
+        } else if (codepoint >= 'A' && codepoint <= 'Z') {
+            metrics = mAtlas.find(codepoint - 'A' + 'a');
+        }
+    }
+    return metrics;
+}
+
+float TextRenderer::spaceAdvance() const {
+    // A space is as wide as a digit
+    const GlyphMetrics* digit = mAtlas.find('0');
+    return digit != nullptr ? digit->advance : 1.0f;
+}
+
+void TextRenderer::queueGlyph(const GlyphMetrics& metrics, float x, float y, float capHeight,
+                              uint32_t color, int layer) {
+    Sprite sprite;
+    sprite.x = x + metrics.left * capHeight;
+    sprite.y = y + metrics.bottom * capHeight;
+    sprite.width = metrics.size * capHeight;
+    sprite.height = sprite.width;
+    sprite.u0 = metrics.u0;
+    sprite.v0 = metrics.v0;
+    sprite.u1 = metrics.u1;
+    sprite.v1 = metrics.v1;
+    sprite.color = color;
+    sprite.texture = mAtlas.getTexture();
+    sprite.shader = mShader;
+    sprite.layer = layer;
+    mSprites->draw(sprite);
+}
+
+float TextRenderer::drawText(const char* text, float x, float y, float capHeight,
+                             uint32_t color, int layer) {
+    if (!mInitialized || text == nullptr || mShader < 0 || !bindAtlas()) return 0.0f;
+
+    float pen = x;
+    const char* p = text;
+    while (*p != '\0') {
+        const GlyphMetrics* metrics = resolve(decodeUtf8(p));
+        if (metrics == nullptr) {
+            pen += spaceAdvance() * capHeight;
+            continue;
+        }
+        queueGlyph(*metrics, pen, y, capHeight, color, layer);
+        pen += metrics->advance * capHeight;
+    }
+    return pen - x;
+}
+
+void TextRenderer::drawGlyph(uint32_t codepoint, float x, float y, float capHeight,
+                             uint32_t color, int layer) {
+    if (!mInitialized || mShader < 0 || !bindAtlas()) return;
+
+    const GlyphMetrics* metrics = resolve(codepoint);
+    if (metrics != nullptr) {
+        queueGlyph(*metrics, x, y, capHeight, color, layer);
+    }
+}
+
+float TextRenderer::measureText(const char* text, float capHeight) const {
+    if (text == nullptr) return 0.0f;
+
+    float width = 0.0f;
+    const char* p = text;
+    while (*p != '\0') {
+        const GlyphMetrics* metrics = resolve(decodeUtf8(p));
+        width += (metrics != nullptr ? metrics->advance : spaceAdvance()) * capHeight;
+    }
+    return width;
+}
+
+} // namespace graphics
+} // namespace trashapp
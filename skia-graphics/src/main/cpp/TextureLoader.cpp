@@ -0,0 +1,552 @@
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAG "TextureLoader"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+
+namespace trashapp {
+namespace graphics {
+
+static const uint8_t KTX_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+static const uint32_t KTX_ENDIAN_NATIVE = 0x04030201;
+static const uint32_t KTX_ENDIAN_SWAPPED = 0x01020304;
+
+struct KtxHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+struct BlockFormat {
+    uint32_t blockWidth;
+    uint32_t blockHeight;
+    uint32_t blockBytes;
+};
+
+static uint32_t swap32(uint32_t value) {
+    return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8) |
+           ((value >> 8) & 0xFF00) | (value >> 24);
+}
+
+static bool isAstcFormat(GLenum format) {
+    return (format >= 0x93B0 && format <= 0x93BD) || (format >= 0x93D0 && format <= 0x93DD);
+}
+
+// Block footprint of the compressed formats we accept
+static bool blockFormatFor(GLenum format, BlockFormat& out) {
+    switch (format) {
+        case GL_COMPRESSED_R11_EAC:
+        case GL_COMPRESSED_SIGNED_R11_EAC:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+            out = { 4, 4, 8 };
+            return true;
+        case GL_COMPRESSED_RG11_EAC:
+        case GL_COMPRESSED_SIGNED_RG11_EAC:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            out = { 4, 4, 16 };
+            return true;
+        default:
+            break;
+    }
+
+    if (isAstcFormat(format)) {
+        // Both the linear and sRGB ranges list footprints in the same order
+        static const uint8_t ASTC_FOOTPRINTS[14][2] = {
+            { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+            { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 }
+        };
+        uint32_t index = format >= 0x93D0 ? format - 0x93D0 : format - 0x93B0;
+        out = { ASTC_FOOTPRINTS[index][0], ASTC_FOOTPRINTS[index][1], 16 };
+        return true;
+    }
+    return false;
+}
+
+TextureLoader::TextureLoader() {
+}
+
+TextureLoader::~TextureLoader() {
+    release();
+}
+
+void TextureLoader::initialize() {
+    if (mInitialized) return;
+
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++) {
+        const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (name != nullptr && (strcmp(name, "GL_KHR_texture_compression_astc_ldr") == 0 ||
+                                strcmp(name, "GL_OES_texture_compression_astc") == 0)) {
+            mAstcSupported = true;
+            break;
+        }
+    }
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (maxTextureSize > 0) {
+        mMaxTextureSize = static_cast<uint32_t>(maxTextureSize);
+    }
+
+    mRunning = true;
+    mWorker = std::thread(&TextureLoader::workerLoop, this);
+
+    mInitialized = true;
+    LOGI("TextureLoader initialized (ASTC %s)", mAstcSupported ? "supported" : "unsupported");
+}
+
+void TextureLoader::release() {
+    if (!mInitialized) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRunning = false;
+    }
+    mCondition.notify_all();
+    if (mWorker.joinable()) {
+        mWorker.join();
+    }
+
+    for (auto& pair : mEntries) {
+        destroyEntry(*pair.second);
+    }
+    mEntries.clear();
+    mParseQueue.clear();
+    mUploadQueue.clear();
+    mResidentBytes = 0;
+
+    mInitialized = false;
+}
+
+TextureHandle TextureLoader::load(const std::string& path) {
+    auto entry = std::make_unique<Entry>();
+    entry->path = path;
+    return enqueue(std::move(entry));
+}
+
+TextureHandle TextureLoader::loadFromFd(int fd, int64_t offset, int64_t length) {
+    int ownedFd = dup(fd);
+    if (ownedFd < 0) {
+        LOGE("Failed to duplicate texture descriptor");
+        return INVALID_TEXTURE;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->fd = ownedFd;
+    entry->fileOffset = offset;
+    entry->fileLength = length;
+    entry->path = "fd:" + std::to_string(fd);
+    return enqueue(std::move(entry));
+}
+
+TextureHandle TextureLoader::enqueue(std::unique_ptr<Entry> entry) {
+    TextureHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mInitialized) {
+            LOGE("TextureLoader not initialized");
+            if (entry->fd >= 0) close(entry->fd);
+            return INVALID_TEXTURE;
+        }
+        handle = mNextHandle++;
+        entry->handle = handle;
+        mParseQueue.push_back(entry.get());
+        mEntries[handle] = std::move(entry);
+    }
+    mCondition.notify_one();
+    return handle;
+}
+
+void TextureLoader::releaseTexture(TextureHandle handle) {
+    // GL objects are freed by the next processUploads() on the GL thread
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(handle);
+    if (it != mEntries.end()) {
+        it->second->releaseRequested = true;
+    }
+}
+
+void TextureLoader::onContextLost() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& pair : mEntries) {
+        Entry& entry = *pair.second;
+        if (entry.state == TextureState::Pending || entry.state == TextureState::Failed) continue;
+        
+        entry.texture = 0;
+        if (entry.releaseRequested) continue;
+        
+        bool queued = entry.state == TextureState::Ready || entry.state == TextureState::Uploading;
+        entry.nextLevel = static_cast<int>(entry.levels.size()) - 1;
+        entry.uploadedBytes = 0;
+        entry.state = TextureState::Ready;
+        madvise(entry.mapping, entry.mappingSize, MADV_WILLNEED);
+        if (!queued) {
+            mUploadQueue.push_back(entry.handle);
+        }
+    }
+    mResidentBytes = 0;
+    LOGI("Texture uploads restarted after context loss");
+}
+
+void TextureLoader::workerLoop() {
+    Profiler::getInstance().setThreadName("TextureLoader");
+    while (true) {
+        Entry* entry = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return !mRunning || !mParseQueue.empty(); });
+            if (!mRunning) return;
+            entry = mParseQueue.front();
+            mParseQueue.pop_front();
+            if (entry->releaseRequested) {
+                entry->state = TextureState::Failed;
+                continue;
+            }
+        }
+
+        // Only this thread touches a Pending entry, so parse without the lock
+        bool parsed;
+        {
+            PROFILE_SCOPE("textures.parse");
+            parsed = mapEntry(*entry) && parseKtx(*entry);
+        }
+        if (!parsed) {
+            unmapEntry(*entry);
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (parsed) {
+            entry->state = TextureState::Ready;
+            mUploadQueue.push_back(entry->handle);
+        } else {
+            entry->state = TextureState::Failed;
+            LOGE("Failed to load texture %s", entry->path.c_str());
+        }
+    }
+}
+
+bool TextureLoader::mapEntry(Entry& entry) {
+    int fd = entry.fd;
+    int64_t offset = entry.fileOffset;
+    int64_t length = entry.fileLength;
+
+    if (fd < 0) {
+        fd = open(entry.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            LOGE("Cannot open %s", entry.path.c_str());
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return false;
+        }
+        offset = 0;
+        length = info.st_size;
+    }
+
+    // mmap offsets must be page aligned; asset descriptors usually are not
+    int64_t pageSize = sysconf(_SC_PAGESIZE);
+    int64_t alignedOffset = offset & ~(pageSize - 1);
+    size_t delta = static_cast<size_t>(offset - alignedOffset);
+
+    void* mapping = MAP_FAILED;
+    if (length > 0) {
+        mapping = mmap(nullptr, static_cast<size_t>(length) + delta, PROT_READ, MAP_PRIVATE,
+                       fd, alignedOffset);
+    }
+    close(fd);
+    entry.fd = -1;
+
+    if (mapping == MAP_FAILED) {
+        LOGE("Cannot map %s", entry.path.c_str());
+        return false;
+    }
+
+    entry.mapping = mapping;
+    entry.mappingSize = static_cast<size_t>(length) + delta;
+    entry.data = static_cast<const uint8_t*>(mapping) + delta;
+    entry.fileLength = length;
+
+    // Start paging the file in now so uploads on the GL thread don't fault
+    madvise(mapping, entry.mappingSize, MADV_WILLNEED);
+    return true;
+}
+
+bool TextureLoader::parseKtx(Entry& entry) {
+    size_t fileSize = static_cast<size_t>(entry.fileLength);
+    if (fileSize < sizeof(KtxHeader)) {
+        LOGE("%s: too small for a KTX header", entry.path.c_str());
+        return false;
+    }
+
+    KtxHeader header;
+    memcpy(&header, entry.data, sizeof(header));
+    if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) {
+        LOGE("%s: not a KTX 1.1 file", entry.path.c_str());
+        return false;
+    }
+
+    bool swap = header.endianness == KTX_ENDIAN_SWAPPED;
+    if (!swap && header.endianness != KTX_ENDIAN_NATIVE) {
+        LOGE("%s: bad endianness marker", entry.path.c_str());
+        return false;
+    }
+    if (swap) {
+        uint32_t* fields = &header.endianness;
+        for (size_t i = 0; i < (sizeof(header) - sizeof(header.identifier)) / sizeof(uint32_t); i++) {
+            fields[i] = swap32(fields[i]);
+        }
+    }
+
+    if (header.glType != 0 || header.glFormat != 0) {
+        LOGE("%s: uncompressed KTX is not supported", entry.path.c_str());
+        return false;
+    }
+    if (header.pixelDepth > 1 || header.numberOfArrayElements > 1 || header.numberOfFaces != 1) {
+        LOGE("%s: only 2D textures are supported", entry.path.c_str());
+        return false;
+    }
+
+    BlockFormat block;
+    if (!blockFormatFor(header.glInternalFormat, block) || !isFormatSupported(header.glInternalFormat)) {
+        LOGE("%s: unsupported format 0x%x", entry.path.c_str(), header.glInternalFormat);
+        return false;
+    }
+
+    // Bounding the size up front also keeps the block counts below from
+    // wrapping
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 ||
+        header.pixelWidth > mMaxTextureSize || header.pixelHeight > mMaxTextureSize) {
+        LOGE("%s: bad size %ux%u", entry.path.c_str(), header.pixelWidth, header.pixelHeight);
+        return false;
+    }
+
+    entry.internalFormat = header.glInternalFormat;
+    entry.width = header.pixelWidth;
+    entry.height = header.pixelHeight;
+
+    // Sizes below are compared as what is left of the file, never as sums,
+    // since size_t is 32 bits on armeabi-v7a
+    if (header.bytesOfKeyValueData > fileSize - sizeof(KtxHeader)) {
+        LOGE("%s: key/value data runs past the end", entry.path.c_str());
+        return false;
+    }
+
+    uint32_t levelCount = std::max(header.numberOfMipmapLevels, 1u);
+    size_t offset = sizeof(KtxHeader) + header.bytesOfKeyValueData;
+    entry.levels.clear();
+    entry.storageBytes = 0;
+
+    for (uint32_t level = 0; level < levelCount; level++) {
+        if (sizeof(uint32_t) > fileSize - offset) {
+            LOGE("%s: truncated at mip level %u", entry.path.c_str(), level);
+            return false;
+        }
+        uint32_t imageSize;
+        memcpy(&imageSize, entry.data + offset, sizeof(imageSize));
+        if (swap) imageSize = swap32(imageSize);
+        offset += sizeof(uint32_t);
+
+        MipLevel mip;
+        mip.width = std::max(entry.width >> level, 1u);
+        mip.height = std::max(entry.height >> level, 1u);
+        mip.offset = offset;
+        mip.size = imageSize;
+
+        size_t blocksWide = mip.width / block.blockWidth + (mip.width % block.blockWidth != 0);
+        size_t blocksHigh = mip.height / block.blockHeight + (mip.height % block.blockHeight != 0);
+        size_t expected = blocksWide * blocksHigh * block.blockBytes;
+        if (imageSize != expected || imageSize > fileSize - offset) {
+            LOGE("%s: mip level %u has %u bytes, expected %zu", entry.path.c_str(),
+                 level, imageSize, expected);
+            return false;
+        }
+
+        entry.levels.push_back(mip);
+        entry.storageBytes += imageSize;
+        // Mip padding; a last level may leave the offset past the end,
+        // which only matters if another level follows
+        size_t padded = (static_cast<size_t>(imageSize) + 3) & ~static_cast<size_t>(3);
+        if (level + 1 < levelCount && padded > fileSize - offset) {
+            LOGE("%s: truncated at mip level %u", entry.path.c_str(), level + 1);
+            return false;
+        }
+        offset += padded;
+    }
+
+    entry.nextLevel = static_cast<int>(entry.levels.size()) - 1;
+    return true;
+}
+
+bool TextureLoader::isFormatSupported(GLenum internalFormat) const {
+    // ETC2/EAC are core in GLES 3.0; ASTC needs the extension
+    return !isAstcFormat(internalFormat) || mAstcSupported;
+}
+
+size_t TextureLoader::processUploads(size_t byteBudget) {
+    if (!mInitialized) return 0;
+
+    std::vector<Entry*> uploads;
+    std::vector<TextureHandle> finished;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Drop released textures the worker is no longer looking at
+        for (auto it = mEntries.begin(); it != mEntries.end();) {
+            Entry& entry = *it->second;
+            if (entry.releaseRequested && entry.state != TextureState::Pending) {
+                mResidentBytes -= entry.texture != 0 ? entry.storageBytes : 0;
+                destroyEntry(entry);
+                mUploadQueue.erase(std::remove(mUploadQueue.begin(), mUploadQueue.end(), it->first),
+                                   mUploadQueue.end());
+                it = mEntries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (TextureHandle handle : mUploadQueue) {
+            uploads.push_back(mEntries[handle].get());
+        }
+    }
+
+    // Entries are only erased on this thread, so the pointers stay valid
+    size_t uploaded = 0;
+    size_t allocated = 0;
+    for (size_t i = 0; i < uploads.size() && (uploaded < byteBudget || uploaded == 0); i++) {
+        Entry& entry = *uploads[i];
+
+        if (entry.texture == 0) {
+            glGenTextures(1, &entry.texture);
+            glBindTexture(GL_TEXTURE_2D, entry.texture);
+            glTexStorage2D(GL_TEXTURE_2D, static_cast<GLsizei>(entry.levels.size()),
+                           entry.internalFormat, entry.width, entry.height);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                            entry.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            allocated += entry.storageBytes;
+        } else {
+            glBindTexture(GL_TEXTURE_2D, entry.texture);
+        }
+
+        // Smallest levels first; the base level follows the upload so the
+        // texture samples at reduced detail until the full chain arrives
+        while (entry.nextLevel >= 0) {
+            const MipLevel& mip = entry.levels[entry.nextLevel];
+            if (uploaded > 0 && uploaded + mip.size > byteBudget) break;
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, entry.nextLevel, 0, 0, mip.width, mip.height,
+                                      entry.internalFormat, static_cast<GLsizei>(mip.size),
+                                      entry.data + mip.offset);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, entry.nextLevel);
+            entry.uploadedBytes += mip.size;
+            uploaded += mip.size;
+            entry.nextLevel--;
+        }
+
+        if (entry.nextLevel < 0) {
+            // Keep the mapping for context loss, but let the kernel drop its pages
+            madvise(entry.mapping, entry.mappingSize, MADV_DONTNEED);
+            finished.push_back(entry.handle);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (Entry* entry : uploads) {
+        if (entry->uploadedBytes == 0) continue;
+        entry->state = entry->nextLevel < 0 ? TextureState::Resident : TextureState::Uploading;
+    }
+    for (TextureHandle handle : finished) {
+        mUploadQueue.erase(std::remove(mUploadQueue.begin(), mUploadQueue.end(), handle),
+                           mUploadQueue.end());
+    }
+    mResidentBytes += allocated;
+    mPeakResidentBytes = std::max(mPeakResidentBytes, mResidentBytes);
+    return uploaded;
+}
+
+GLuint TextureLoader::getTexture(TextureHandle handle) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(handle);
+    if (it == mEntries.end()) return 0;
+    const Entry& entry = *it->second;
+    return entry.uploadedBytes > 0 ? entry.texture : 0;
+}
+
+TextureState TextureLoader::getState(TextureHandle handle) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(handle);
+    return it != mEntries.end() ? it->second->state : TextureState::Failed;
+}
+
+TextureMemoryStats TextureLoader::getMemoryStats() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    TextureMemoryStats stats = {};
+    stats.residentBytes = mResidentBytes;
+    stats.peakResidentBytes = mPeakResidentBytes;
+    for (const auto& pair : mEntries) {
+        const Entry& entry = *pair.second;
+        if (entry.releaseRequested) continue;
+        stats.textureCount++;
+        if (entry.state == TextureState::Pending) continue;   // the worker owns it
+        stats.mappedBytes += entry.mappingSize;
+        if (entry.state == TextureState::Resident) {
+            stats.residentCount++;
+        } else if (entry.state == TextureState::Ready || entry.state == TextureState::Uploading) {
+            stats.pendingUploadBytes += entry.storageBytes - entry.uploadedBytes;
+        }
+    }
+    return stats;
+}
+
+void TextureLoader::destroyEntry(Entry& entry) {
+    if (entry.texture != 0) {
+        glDeleteTextures(1, &entry.texture);
+        entry.texture = 0;
+    }
+    if (entry.fd >= 0) {
+        close(entry.fd);
+        entry.fd = -1;
+    }
+    unmapEntry(entry);
+}
+
+void TextureLoader::unmapEntry(Entry& entry) {
+    if (entry.mapping != nullptr) {
+        munmap(entry.mapping, entry.mappingSize);
+        entry.mapping = nullptr;
+        entry.mappingSize = 0;
+        entry.data = nullptr;
+    }
+}
+
+} // namespace graphics
+} // namespace trashapp
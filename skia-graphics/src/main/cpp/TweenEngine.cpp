@@ -0,0 +1,304 @@
+#include "TweenEngine.h"
+#include "SceneGraph.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace trashapp {
+namespace graphics {
+
+namespace {
+
+// eased(t) = ((a * t + b) * t + c) * t
+struct Curve {
+    float a, b, c;
+};
+
+Curve curveFor(Easing easing) {
+    // BackOut is 1 + (s + 1)(t - 1)^3 + s(t - 1)^2 expanded, the usual overshoot
+    static const float BACK = 1.70158f;
+    switch (easing) {
+        case Easing::QuadIn:     return {0.0f, 1.0f, 0.0f};
+        case Easing::QuadOut:    return {0.0f, -1.0f, 2.0f};
+        case Easing::SmoothStep: return {-2.0f, 3.0f, 0.0f};
+        case Easing::CubicIn:    return {1.0f, 0.0f, 0.0f};
+        case Easing::CubicOut:   return {1.0f, -3.0f, 3.0f};
+        case Easing::BackOut:    return {BACK + 1.0f, -2.0f * BACK - 3.0f, BACK + 3.0f};
+        case Easing::Linear:
+        default:                 return {0.0f, 0.0f, 1.0f};
+    }
+}
+
+float& channelOf(SceneTransform& transform, TweenChannel channel) {
+    switch (channel) {
+        case TweenChannel::Y:      return transform.y;
+        case TweenChannel::Width:  return transform.width;
+        case TweenChannel::Height: return transform.height;
+        case TweenChannel::ScaleX: return transform.scaleX;
+        case TweenChannel::X:
+        default:                   return transform.x;
+    }
+}
+
+// Keeps a zero-length segment from dividing by zero; it completes on start
+const float MIN_DURATION = 1e-6f;
+
+} // namespace
+
+TweenEngine::TweenEngine() = default;
+TweenEngine::~TweenEngine() = default;
+
+int TweenEngine::resolveAnimation(int animation) {
+    if (animation == 0) return mNextId++;
+    // A running animation can gain tracks; a finished one stays finished
+    return isActive(animation) ? animation : 0;
+}
+
+int TweenEngine::addTrack(int animation, int node, TweenChannel channel, const TweenKey* keys,
+                          size_t keyCount, float delay) {
+    if (keys == nullptr || keyCount < 2) return 0;
+    animation = resolveAnimation(animation);
+    if (animation == 0) return 0;
+
+    float trackStart = mClock + std::max(delay, 0.0f);
+    for (size_t k = 1; k < keyCount; k++) {
+        const TweenKey& from = keys[k - 1];
+        const TweenKey& to = keys[k];
+        bool captureFrom = k == 1 && std::isnan(from.value);
+        addSegment(animation, node, channel, trackStart + from.time,
+                   std::max(to.time - from.time, 0.0f), captureFrom ? 0.0f : from.value,
+                   to.value, to.easing, captureFrom, k == keyCount - 1);
+    }
+    return animation;
+}
+
+int TweenEngine::addCardChange(int animation, int node, float time, int cardId, bool faceUp) {
+    animation = resolveAnimation(animation);
+    if (animation == 0) return 0;
+
+    mCardChanges.push_back({animation, node, mClock + std::max(time, 0.0f), cardId, faceUp});
+    mLive[animation]++;
+    return animation;
+}
+
+void TweenEngine::addSegment(int animation, int node, TweenChannel channel, float start,
+                             float duration, float from, float to, Easing easing,
+                             bool captureFrom, bool finishing) {
+    Curve curve = curveFor(easing);
+    mStart.push_back(start);
+    mInvDuration.push_back(1.0f / std::max(duration, MIN_DURATION));
+    mFrom.push_back(from);
+    mDelta.push_back(to - from);
+    mCurveA.push_back(curve.a);
+    mCurveB.push_back(curve.b);
+    mCurveC.push_back(curve.c);
+    mProgress.push_back(0.0f);
+    mValue.push_back(from);
+    mInfo.push_back({animation, node, channel, captureFrom, false, finishing, false});
+    mLive[animation]++;
+}
+
+void TweenEngine::startSegment(size_t index, SceneGraph& scene) {
+    SegmentInfo& info = mInfo[index];
+    info.started = true;
+
+    // The newest animation on a node channel wins: older ones give it up,
+    // and this one gives way if a newer one is already running there
+    for (size_t i = 0; i < mInfo.size(); i++) {
+        SegmentInfo& other = mInfo[i];
+        if (i == index || other.removed || other.animation == info.animation ||
+            other.node != info.node || other.channel != info.channel) {
+            continue;
+        }
+        if (other.animation < info.animation) {
+            other.removed = true;
+        } else if (other.started) {
+            info.removed = true;
+            return;
+        }
+    }
+
+    if (info.captureFrom) {
+        float to = mFrom[index] + mDelta[index];
+        float from = readChannel(scene, info.node, info.channel, to);
+        mFrom[index] = from;
+        mDelta[index] = to - from;
+        info.captureFrom = false;
+    }
+}
+
+float TweenEngine::readChannel(SceneGraph& scene, int node, TweenChannel channel, float fallback) {
+    SceneTransform transform;
+    if (!scene.getTransform(node, transform)) return fallback;
+    return channelOf(transform, channel);
+}
+
+void TweenEngine::apply(size_t index, float value, SceneGraph& scene) {
+    const SegmentInfo& info = mInfo[index];
+    SceneTransform transform;
+    // The node may have been destroyed under the animation; it ends quietly
+    if (!scene.getTransform(info.node, transform)) return;
+    channelOf(transform, info.channel) = value;
+    scene.setTransform(info.node, transform);
+}
+
+void TweenEngine::update(float deltaTime, SceneGraph& scene) {
+    auto start = std::chrono::steady_clock::now();
+    mClock += std::max(deltaTime, 0.0f);
+    size_t count = mInfo.size();
+
+    for (size_t i = 0; i < count; i++) {
+        if (!mInfo[i].started && !mInfo[i].removed && mClock >= mStart[i]) {
+            startSegment(i, scene);
+        }
+    }
+
+    // Progress and value for the whole pool in two flat loops. Segments that
+    // have not started clamp to 0 and are simply not applied.
+    const float clock = mClock;
+    const float* __restrict startTimes = mStart.data();
+    const float* __restrict invDurations = mInvDuration.data();
+    float* __restrict progress = mProgress.data();
+    for (size_t i = 0; i < count; i++) {
+        float t = (clock - startTimes[i]) * invDurations[i];
+        progress[i] = std::min(std::max(t, 0.0f), 1.0f);
+    }
+
+    const float* __restrict from = mFrom.data();
+    const float* __restrict delta = mDelta.data();
+    const float* __restrict curveA = mCurveA.data();
+    const float* __restrict curveB = mCurveB.data();
+    const float* __restrict curveC = mCurveC.data();
+    float* __restrict value = mValue.data();
+    for (size_t i = 0; i < count; i++) {
+        float t = progress[i];
+        value[i] = from[i] + delta[i] * (((curveA[i] * t + curveB[i]) * t + curveC[i]) * t);
+    }
+    mEvaluated = static_cast<uint32_t>(count);
+
+    // Finished segments first, so when one hands a channel to the next key
+    // in the same frame the running one has the last word
+    for (size_t i = 0; i < count; i++) {
+        const SegmentInfo& info = mInfo[i];
+        if (info.started && !info.removed && progress[i] >= 1.0f) {
+            apply(i, from[i] + delta[i], scene);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        const SegmentInfo& info = mInfo[i];
+        if (info.started && !info.removed && progress[i] < 1.0f) {
+            apply(i, value[i], scene);
+        }
+    }
+
+    for (size_t i = mCardChanges.size(); i-- > 0;) {
+        const CardChange& change = mCardChanges[i];
+        if (mClock < change.time) continue;
+        scene.setCard(change.node, change.cardId, change.faceUp);
+        int animation = change.animation;
+        mCardChanges[i] = mCardChanges.back();
+        mCardChanges.pop_back();
+        release(animation);
+    }
+
+    for (size_t i = count; i-- > 0;) {
+        if (mInfo[i].removed || (mInfo[i].started && progress[i] >= 1.0f)) {
+            removeSegment(i);
+        }
+    }
+
+    if (mInfo.empty() && mCardChanges.empty()) {
+        mClock = 0.0f;
+    }
+    mUpdateMicroseconds = std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void TweenEngine::removeSegment(size_t index) {
+    int animation = mInfo[index].animation;
+    size_t last = mInfo.size() - 1;
+    if (index != last) {
+        mStart[index] = mStart[last];
+        mInvDuration[index] = mInvDuration[last];
+        mFrom[index] = mFrom[last];
+        mDelta[index] = mDelta[last];
+        mCurveA[index] = mCurveA[last];
+        mCurveB[index] = mCurveB[last];
+        mCurveC[index] = mCurveC[last];
+        mProgress[index] = mProgress[last];
+        mValue[index] = mValue[last];
+        mInfo[index] = mInfo[last];
+    }
+    mStart.pop_back();
+    mInvDuration.pop_back();
+    mFrom.pop_back();
+    mDelta.pop_back();
+    mCurveA.pop_back();
+    mCurveB.pop_back();
+    mCurveC.pop_back();
+    mProgress.pop_back();
+    mValue.pop_back();
+    mInfo.pop_back();
+    release(animation);
+}
+
+void TweenEngine::release(int animation) {
+    auto it = mLive.find(animation);
+    if (it == mLive.end()) return;
+    if (--it->second == 0) {
+        mLive.erase(it);
+        mCompleted++;
+    }
+}
+
+void TweenEngine::cancel(int animation, bool finish, SceneGraph& scene) {
+    if (!isActive(animation)) return;
+
+    for (size_t i = mInfo.size(); i-- > 0;) {
+        if (mInfo[i].animation != animation) continue;
+        // Removed ones lost their channel to a newer animation
+        if (finish && mInfo[i].finishing && !mInfo[i].removed) {
+            apply(i, mFrom[i] + mDelta[i], scene);
+        }
+        removeSegment(i);
+    }
+    for (size_t i = mCardChanges.size(); i-- > 0;) {
+        const CardChange& change = mCardChanges[i];
+        if (change.animation != animation) continue;
+        if (finish) {
+            scene.setCard(change.node, change.cardId, change.faceUp);
+        }
+        mCardChanges[i] = mCardChanges.back();
+        mCardChanges.pop_back();
+        release(animation);
+    }
+}
+
+void TweenEngine::clear() {
+    mStart.clear();
+    mInvDuration.clear();
+    mFrom.clear();
+    mDelta.clear();
+    mCurveA.clear();
+    mCurveB.clear();
+    mCurveC.clear();
+    mProgress.clear();
+    mValue.clear();
+    mInfo.clear();
+    mCardChanges.clear();
+    mLive.clear();
+    mClock = 0.0f;
+}
+
+TweenStats TweenEngine::getStats() const {
+    TweenStats stats = {};
+    stats.animations = static_cast<uint32_t>(mLive.size());
+    stats.segments = static_cast<uint32_t>(mInfo.size());
+    stats.evaluated = mEvaluated;
+    stats.completed = mCompleted;
+    stats.updateMicroseconds = mUpdateMicroseconds;
+    return stats;
+}
+
+} // namespace graphics
+} // namespace trashapp
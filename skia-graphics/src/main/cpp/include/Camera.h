@@ -0,0 +1,68 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+namespace trashapp {
+namespace graphics {
+
+// GLSL for the camera block, pasted into 2D vertex shaders after #version.
+// uViewport is (render width, render height, pixels per unit, render scale).
+#define CAMERA_UNIFORM_BLOCK \
+    "layout(std140) uniform Camera {\n" \
+    "    mat4 uProjection;\n" \
+    "    vec4 uViewport;\n" \
+    "};\n"
+
+struct CameraState {
+    int outputWidth;        // window or offscreen target, pixels
+    int outputHeight;
+    int renderWidth;        // what the scene is drawn at, after render scale
+    int renderHeight;
+    float renderScale;
+    float visibleLeft;      // virtual units; the 1920x1080 layout is always inside
+    float visibleBottom;
+    float visibleWidth;
+    float visibleHeight;
+    float pixelsPerUnit;    // render pixels per virtual unit
+};
+
+// Layouts are authored in a 1920x1080 virtual space with y up. The camera
+// fits that space into the target without stretching: the shorter axis
+// covers it exactly and the longer one extends past it on both sides. One
+// uniform buffer carries the projection to every program that declares
+// CAMERA_UNIFORM_BLOCK.
+class Camera {
+public:
+    static constexpr float VIRTUAL_WIDTH = 1920.0f;
+    static constexpr float VIRTUAL_HEIGHT = 1080.0f;
+    static const GLuint BLOCK_BINDING = 0;
+
+    Camera();
+    ~Camera();
+
+    // Needs a current context
+    void initialize();
+    void release();
+    // After context loss: forgets the buffer without deleting it
+    void abandon();
+
+    void setViewport(int outputWidth, int outputHeight, float renderScale);
+    // Uploads pending changes and binds the block; once per frame
+    void bind();
+
+    const CameraState& getState() const { return mState; }
+
+    // Window pixels (top-left origin, as in touch events) to virtual units
+    void screenToWorld(float screenX, float screenY, float& worldX, float& worldY) const;
+
+private:
+    void updateProjection();
+
+    GLuint mBuffer = 0;
+    CameraState mState = {};
+    float mProjection[16] = {};
+    bool mDirty = true;
+};
+
+} // namespace graphics
+} // namespace trashapp
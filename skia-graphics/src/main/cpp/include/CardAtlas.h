@@ -0,0 +1,82 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+struct UVRect {
+    float u0, v0;   // bottom-left of the card
+    float u1, v1;   // top-right of the card
+};
+
+// One texture holding every card face plus the joker and the card back.
+// Faces are composited from a parchment template and procedural suit/rank
+// glyphs on first launch, then cached to disk as raw RGBA.
+class CardAtlas {
+public:
+    // Card ids: suit * 13 + (rank - 1) for the standard deck
+    static const int SUIT_COUNT = 4;
+    static const int RANK_COUNT = 13;
+    static const int JOKER_ID = 52;
+    static const int BACK_ID = 53;
+    static const int CARD_COUNT = 54;
+
+    // Accepts enum names ("HEARTS"), display names ("Horseshoes"), symbols
+    // and single letters for suits; "A", "2".."10", "J", "Q", "K", "Joker"
+    // or enum names for ranks. Returns -1 if either is unknown.
+    static int cardIdFor(const char* suit, const char* rank);
+
+    // Suit outlines shared with the glyph atlas: suit is card id / RANK_COUNT,
+    // or -1 for the sheriff star. u, v in [-1, 1] with v pointing up.
+    static bool insideSuit(int suit, float u, float v);
+
+    CardAtlas();
+    ~CardAtlas();
+
+    // Loads the cached atlas or composites and caches it. An empty cache
+    // directory disables the disk cache.
+    bool build(const std::string& cacheDirectory);
+
+    // Creates the GL texture from the composited pixels
+    GLuint upload();
+    void releaseTexture();
+    // After context loss; the pixels stay, so upload() rebuilds the texture
+    void abandonTexture() { mTexture = 0; }
+
+    GLuint getTexture() const { return mTexture; }
+    const UVRect& getUVRect(int cardId) const;
+    bool isBuilt() const { return !mPixels.empty(); }
+
+private:
+    bool loadFromCache(const std::string& path);
+    void saveToCache(const std::string& path) const;
+    void composite();
+    void computeUVRects();
+
+    void drawFace(int cellX, int cellY, int suit, int rank);
+    void drawJoker(int cellX, int cellY);
+    void drawBack(int cellX, int cellY);
+    void drawTemplate(int cellX, int cellY, const uint8_t* fill, const uint8_t* border);
+    void drawSuit(int suit, int x, int y, int size, bool flipped, const uint8_t* color);
+    void drawText(const char* text, int x, int y, int scale, bool flipped, const uint8_t* color);
+    void blendPixel(int x, int y, const uint8_t* color, float coverage);
+
+    std::vector<uint8_t> mPixels;
+    UVRect mUVRects[CARD_COUNT];
+    GLuint mTexture = 0;
+
+    // Layout: 9 x 6 grid of 110x154 cells with a 2 pixel gutter
+    static const int ATLAS_SIZE = 1024;
+    static const int CELL_WIDTH = 110;
+    static const int CELL_HEIGHT = 154;
+    static const int CELL_GUTTER = 2;
+    static const int COLUMNS = 9;
+    static const uint32_t CACHE_VERSION = 1;
+};
+
+} // namespace graphics
+} // namespace trashapp
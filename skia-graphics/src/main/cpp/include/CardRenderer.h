@@ -1,38 +1,60 @@
 #pragma once
 
 #include <GLES3/gl3.h>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
+#include "CardAtlas.h"
 
 namespace trashapp {
 namespace graphics {
 
+class SpriteBatcher;
+
+// One card of a packed batch, read in place from a Java direct buffer in
+// native byte order; the layout is shared with GraphicsEngine.CardBatch
+struct CardRecord {
+    static const uint32_t FACE_UP = 1u;
+
+    float x, y;
+    float width, height;
+    int32_t cardId;
+    uint32_t flags;
+};
+static_assert(sizeof(CardRecord) == 24, "CardRecord layout is shared with Java");
+
 class CardRenderer {
 public:
     CardRenderer();
     ~CardRenderer();
     
-    void initialize();
+    // The atlas is cached under cacheDirectory; pass an empty string to
+    // composite it on every launch. Cards are queued on sprites as atlas
+    // quads, so they batch with everything else on the table layer.
+    void initialize(SpriteBatcher& sprites, const std::string& cacheDirectory = std::string());
     void release();
     
+    // Atlas id overload for callers that resolve cards once up front
+    void renderFace(float x, float y, float width, float height,
+                   int cardId, bool vintageEffect);
     void renderFace(float x, float y, float width, float height, 
                    const char* suit, const char* rank, bool vintageEffect);
     void renderBack(float x, float y, float width, float height, bool woodGrain);
+    void renderRecords(const CardRecord* records, size_t count, bool vintageEffect, bool woodGrain);
+    
+    // After context loss: forgets GL handles. The atlas texture is rebuilt
+    // from memory on the next draw.
+    void onContextLost();
+    
+    int getCardId(const char* suit, const char* rank) const { return CardAtlas::cardIdFor(suit, rank); }
     
 private:
-    void createCardGeometry();
     void setupCardMaterials();
+    void drawCard(float x, float y, float width, float height, int cardId);
     
-    // OpenGL objects
-    GLuint mVertexArray = 0;
-    GLuint mVertexBuffer = 0;
-    GLuint mIndexBuffer = 0;
-    GLuint mTexture = 0;
-    GLuint mShaderProgram = 0;
-    
-    // Card geometry
-    static const int CARD_VERTICES = 4;
-    static const int CARD_INDICES = 6;
+    CardAtlas mAtlas;
+    SpriteBatcher* mSprites = nullptr;
     
     bool mInitialized = false;
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+namespace trashapp {
+namespace graphics {
+
+struct RenderScaleStats {
+    float scale;            // current fraction of the output resolution
+    float minScale;
+    bool dynamic;
+    double budgetMilliseconds;
+    double frameMilliseconds;   // smoothed frame cost the controller acts on
+    uint32_t scaleChanges;
+};
+
+// Chooses the render scale from frame cost. Drops quickly when frames run
+// over budget and climbs back slowly once there is clear headroom; the gap
+// between the two thresholds and a cooldown after each change keep it from
+// oscillating. With dynamic mode off the scale stays where it was set.
+class DynamicResolution {
+public:
+    DynamicResolution();
+
+    void setDynamic(bool enabled, float minScale);
+    void setScale(float scale);
+
+    // Feeds one presented frame: CPU and GPU cost (gpu < 0 when unknown)
+    // against the frame budget. Returns true when the scale changed.
+    bool update(double cpuMilliseconds, double gpuMilliseconds, double budgetMilliseconds);
+
+    float getScale() const { return mScale; }
+    RenderScaleStats getStats() const;
+
+private:
+    float mScale = 1.0f;
+    float mMinScale = 0.5f;
+    bool mDynamic = false;
+
+    double mFrameMilliseconds = 0.0;
+    double mBudgetMilliseconds = 0.0;
+    int mOverBudgetFrames = 0;
+    int mUnderBudgetFrames = 0;
+    int mCooldownFrames = 0;
+    uint32_t mScaleChanges = 0;
+};
+
+} // namespace graphics
+} // namespace trashapp
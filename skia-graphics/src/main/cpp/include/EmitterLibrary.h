@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace trashapp {
+namespace graphics {
+
+class JsonValue;
+
+// Integer handle to a compiled emitter. Handles stay valid across reloads
+// of the definition asset as long as the emitter keeps its name.
+using EmitterHandle = int32_t;
+static const EmitterHandle INVALID_EMITTER = -1;
+
+struct FloatRange {
+    float min;
+    float max;
+};
+
+// Emitter definition compiled from the asset. Every per-particle attribute
+// is a [min, max] range sampled with the counter-based RNG below.
+struct EmitterDescriptor {
+    uint32_t burstCount;     // particles emitted immediately on spawn
+    float emissionRate;      // particles per second while a continuous emitter runs
+    float duration;          // seconds a continuous emitter runs, <= 0 runs until stopped
+    FloatRange offsetX;
+    FloatRange offsetY;
+    FloatRange velocityX;
+    FloatRange velocityY;
+    FloatRange life;
+    FloatRange size;
+    FloatRange color[4];     // r, g, b, a
+    uint32_t seed;           // derived from the emitter name
+};
+
+// Stateless counter-based RNG: the same (seed, counter) pair always yields
+// the same value, so spawning needs no shared generator state.
+inline uint32_t particleHash(uint32_t seed, uint32_t counter) {
+    uint32_t x = counter * 0x9E3779B9u ^ seed;
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline float particleRandom(const FloatRange& range, uint32_t seed, uint32_t counter) {
+    float unit = static_cast<float>(particleHash(seed, counter) >> 8) * (1.0f / 16777216.0f);
+    return range.min + (range.max - range.min) * unit;
+}
+
+class EmitterLibrary {
+public:
+    EmitterLibrary();
+    ~EmitterLibrary();
+
+    // Compiles the built-in Wild West effects (gold_coin, dust, fire_spark)
+    void loadDefaults();
+
+    // Compiles emitter definitions from a JSON asset. Emitters with a name
+    // that is already known keep their handle and are updated in place.
+    bool loadFromJson(const char* json, size_t length);
+
+    EmitterHandle find(const char* name) const;
+    const EmitterDescriptor* get(EmitterHandle handle) const;
+    size_t size() const { return mDescriptors.size(); }
+
+private:
+    bool compileEmitter(const JsonValue& definition, EmitterDescriptor& out, std::string& name);
+
+    std::vector<EmitterDescriptor> mDescriptors;
+    std::unordered_map<std::string, EmitterHandle> mHandles;
+};
+
+} // namespace graphics
+} // namespace trashapp
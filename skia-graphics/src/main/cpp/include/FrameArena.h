@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+struct FrameArenaStats {
+    uint64_t capacityBytes;     // held in chunks
+    uint64_t usedBytes;         // this frame so far
+    uint64_t peakBytes;         // the busiest frame
+    uint32_t chunks;
+    uint32_t overflows;         // frames that needed another chunk
+};
+
+// Linear allocator for data that lives one frame: allocation bumps a
+// pointer, reset() at the start of the next frame frees everything at once.
+// A frame that outgrows the arena takes another chunk; the next reset
+// replaces the chunks with one big enough for that frame, so a steady
+// workload settles at a single chunk and no heap calls. Render thread only.
+class FrameArena {
+public:
+    static const size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit FrameArena(size_t capacity = DEFAULT_CAPACITY);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    FrameArenaStats getStats() const;
+
+private:
+    struct Chunk {
+        uint8_t* data;
+        size_t size;
+    };
+
+    void addChunk(size_t minimum);
+    void freeChunks();
+
+    std::vector<Chunk> mChunks;
+    size_t mChunk = 0;          // chunk being filled
+    size_t mOffset = 0;         // into that chunk
+    size_t mUsed = 0;           // across chunks, this frame
+    size_t mPeak = 0;
+    uint32_t mOverflows = 0;
+};
+
+// Standard allocator over a frame arena, for containers that are built and
+// dropped within a frame. Freeing is a no-op. Without an arena it falls back
+// to the heap, for code that also runs outside the engine's frames.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(FrameArena* arena) : mArena(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.arena()) {}
+
+    T* allocate(size_t count) {
+        if (mArena == nullptr) return static_cast<T*>(::operator new(count * sizeof(T)));
+        return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* items, size_t) {
+        if (mArena == nullptr) ::operator delete(items);
+    }
+
+    FrameArena* arena() const { return mArena; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return mArena == other.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return mArena != other.arena(); }
+
+private:
+    FrameArena* mArena;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <atomic>
+#include <cstdint>
+
+namespace trashapp {
+namespace graphics {
+
+struct FrameTimingStats {
+    double cpuMilliseconds;           // beginFrame to endFrame, last frame
+    double gpuMilliseconds;           // GPU time of the newest resolved frame, -1 if unknown
+    double frameIntervalMilliseconds; // swap to swap, last frame
+    double averageCpuMilliseconds;
+    double averageGpuMilliseconds;
+    double averageIntervalMilliseconds;
+    double vsyncPeriodMilliseconds;   // 0 until the refresh rate is known
+    int targetFrameRate;              // 0 = every vsync
+    int swapInterval;
+    bool presentationTimeSupported;
+    bool gpuTimerSupported;
+    double presentLatencyMilliseconds; // frame start to display, measured or estimated
+    bool presentTimestampsSupported;   // latency read back from the compositor
+};
+
+// Paces presentation to a target rate (30/60/90/120 Hz). The swap interval
+// covers whole multiples of the display refresh; EGL_ANDROID_presentation_time,
+// fed by Choreographer vsync timestamps when available, keeps frames on an
+// even cadence. Also measures CPU and GPU frame time, and predicts when each
+// frame reaches the display: EGL_ANDROID_get_frame_timestamps reports when
+// earlier frames actually did, and the pacer learns the latency from that.
+class FramePacer {
+public:
+    FramePacer();
+    ~FramePacer();
+
+    // Needs the display and a current context
+    void initialize(EGLDisplay display);
+    void release();
+    // After context loss: forgets the timer queries without deleting them
+    void abandon();
+    // A new window surface needs its swap interval set again
+    void onSurfaceChanged();
+
+    void setVSync(bool enabled);
+    void setTargetFrameRate(int framesPerSecond);
+    void setDisplayRefreshRate(float hz);
+
+    // Choreographer frame time (CLOCK_MONOTONIC nanoseconds); any thread
+    void onVsync(int64_t frameTimeNanos);
+
+    void beginFrame();
+    void endFrame();
+    void beforeSwap(EGLSurface surface);
+    void afterSwap();
+
+    FrameTimingStats getStats() const { return mStats; }
+    
+    // Predicted display time of the frame in progress, and of a frame begun
+    // at the next vsync from now (CLOCK_MONOTONIC nanoseconds)
+    int64_t getFramePresentNanos() const { return mFramePresentNanos; }
+    int64_t predictNextPresentNanos() const;
+    // True when the frame in progress is the one predicted to reach the
+    // display closest to the given time, or later
+    bool presentsBy(int64_t presentNanos) const;
+    // Display time between paced frames
+    int64_t getFramePeriodNanos() const;
+
+private:
+    void updateSwapInterval();
+    void collectGpuTimings();
+    int64_t vsyncPeriodNanos() const;
+    int64_t presentLatencyNanos() const;
+    void enablePresentTimestamps(EGLSurface surface);
+    void collectPresentTimes(EGLSurface surface);
+    static int64_t nowNanos();
+
+    EGLDisplay mDisplay = EGL_NO_DISPLAY;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC mPresentationTime = nullptr;
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC mGetNextFrameId = nullptr;
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC mGetFrameTimestamps = nullptr;
+
+    bool mVSync = true;
+    int mTargetFrameRate = 0;
+    float mDisplayRefreshRate = 0.0f;
+    int mSwapInterval = 1;
+    bool mSwapIntervalDirty = true;
+
+    // Written by the Choreographer thread
+    std::atomic<int64_t> mLastVsyncNanos{0};
+    std::atomic<int64_t> mVsyncPeriodNanos{0};
+
+    int64_t mFrameStartNanos = 0;
+    int64_t mFrameEndNanos = 0;
+    int64_t mLastSwapNanos = 0;
+    int64_t mLastPresentNanos = 0;
+    int64_t mFramePresentNanos = 0;
+
+    // Frames swapped but not yet seen on the display, by EGL frame id. The
+    // compositor reports them a few frames late.
+    struct PendingPresent {
+        EGLuint64KHR frameId;
+        int64_t startNanos;
+        bool pending;
+    };
+    static const int PRESENT_HISTORY = 8;
+    PendingPresent mPresents[PRESENT_HISTORY] = {};
+    int mPresentIndex = 0;
+    EGLSurface mTimestampSurface = EGL_NO_SURFACE;   // timestamps enabled on it
+    int64_t mPresentLatencyNanos = 0;               // measured; 0 until known
+
+    // GPU timer queries in a small ring so results are read frames later
+    // without stalling the pipeline
+    static const int QUERY_COUNT = 4;
+    GLuint mQueries[QUERY_COUNT] = {};
+    bool mQueryPending[QUERY_COUNT] = {};
+    int mQueryIndex = 0;
+    bool mQueryActive = false;
+    bool mGpuTimer = false;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC mGetQueryObjectui64v = nullptr;
+
+    FrameTimingStats mStats = {};
+    bool mInitialized = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
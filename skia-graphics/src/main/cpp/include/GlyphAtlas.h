@@ -0,0 +1,82 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+// Where a glyph sits in the atlas and how it lays out. Quad and advance are
+// in cap heights, relative to the pen at the baseline.
+struct GlyphMetrics {
+    uint32_t codepoint;
+    float u0, v0;           // bottom-left of the cell
+    float u1, v1;           // top-right of the cell
+    float left, bottom;     // quad corner relative to the pen
+    float size;             // the quad is square
+    float advance;
+};
+
+// Single-channel signed distance field for card ranks, suit pips and UI
+// numbers. Every glyph is generated once from vector outlines (strokes for
+// characters, the card atlas's suit shapes for pips) at a fixed cell size;
+// the shader thresholds the interpolated distance, so one small texture stays
+// sharp at any scale. The atlas is cached to disk after the first launch.
+class GlyphAtlas {
+public:
+    // Suit pips and the sheriff star by code point
+    static const uint32_t SPADE = 0x2660;
+    static const uint32_t HEART = 0x2665;
+    static const uint32_t CLUB = 0x2663;
+    static const uint32_t DIAMOND = 0x2666;
+    static const uint32_t STAR = 0x2605;
+
+    GlyphAtlas();
+    ~GlyphAtlas();
+
+    // Loads the cached atlas or generates and caches it. An empty cache
+    // directory disables the disk cache.
+    bool build(const std::string& cacheDirectory);
+
+    // Creates the GL texture from the generated distances
+    GLuint upload();
+    void releaseTexture();
+    // After context loss; the distances stay, so upload() rebuilds the texture
+    void abandonTexture() { mTexture = 0; }
+
+    GLuint getTexture() const { return mTexture; }
+    // nullptr when the atlas has no such glyph
+    const GlyphMetrics* find(uint32_t codepoint) const;
+    bool isBuilt() const { return !mPixels.empty(); }
+
+    // Distance, in cell pixels, that maps to the full 0..1 range around the
+    // 0.5 edge; the shader needs it to turn distances into coverage
+    static const int SPREAD = 8;
+
+private:
+    bool loadFromCache(const std::string& path);
+    void saveToCache(const std::string& path) const;
+    void computeMetrics();
+    void generate();
+    void generateGlyph(size_t index, std::vector<uint8_t>& mask, std::vector<float>& inside,
+                       std::vector<float>& outside);
+
+    std::vector<uint8_t> mPixels;
+    std::vector<GlyphMetrics> mMetrics;
+    GLuint mTexture = 0;
+
+    // Layout: 8 x 4 grid of 64x64 cells. Outlines fill the inner 48 pixels
+    // and the distance ramps out over the SPREAD margin.
+    static const int ATLAS_WIDTH = 512;
+    static const int ATLAS_HEIGHT = 256;
+    static const int CELL_SIZE = 64;
+    static const int COLUMNS = 8;
+    // Outlines are sampled at this many times the cell resolution
+    static const int SUPERSAMPLE = 4;
+    static const uint32_t CACHE_VERSION = 1;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+struct Particle;
+class ShaderManager;
+
+// Particle simulation on the GPU using transform feedback. State lives in two
+// buffers that are swapped every update; new particles are written into a
+// ring region of the source buffer just before the simulation step.
+class GpuParticleSystem {
+public:
+    GpuParticleSystem();
+    ~GpuParticleSystem();
+
+    // Returns false if transform feedback programs could not be built, in
+    // which case the caller should stay on the CPU path.
+    bool initialize(uint32_t capacity, ShaderManager& shaders);
+    void release();
+    // After context loss: forgets GL handles and the particles they held
+    void abandon();
+
+    // Queue particles for upload into the ring at the next update()
+    void spawn(const Particle* particles, uint32_t count);
+    // Once every particle in the ring has died, update() and render() skip
+    // their passes and the ring starts over empty
+    void update(float deltaTime);
+    // Projection comes from the camera block
+    void render();
+
+    // Copies the current simulation state back (slow, for validation only).
+    // Slots that have never been written are skipped.
+    void readBack(std::vector<Particle>& out);
+
+    // Ring slots written since the ring was last empty, capped at the capacity
+    uint32_t getOccupiedCount() const { return mOccupied; }
+    // False once the longest-lived particle spawned has run out
+    bool hasLiveParticles() const { return mLifeRemaining > 0.0f; }
+    uint32_t getCapacity() const { return mCapacity; }
+    bool isInitialized() const { return mInitialized; }
+
+private:
+    // Interleaved GPU layout: posVel (x, y, vx, vy), lifeSize (life, maxLife, size, unused), color
+    struct GpuParticle {
+        float x, y, vx, vy;
+        float life, maxLife, size, unused;
+        float r, g, b, a;
+    };
+
+    bool createPrograms(ShaderManager& shaders);
+    void createBuffers();
+    void flushSpawns();
+    void setupAttributes(GLuint buffer);
+
+    GLuint mBuffers[2] = { 0, 0 };
+    GLuint mVertexArrays[2] = { 0, 0 };
+    GLuint mTransformFeedbacks[2] = { 0, 0 };
+    GLuint mUpdateProgram = 0;
+    GLuint mRenderProgram = 0;
+    GLint mDeltaTimeLoc = -1;
+
+    std::vector<GpuParticle> mPendingSpawns;
+    uint32_t mCapacity = 0;
+    uint32_t mRingHead = 0;
+    uint32_t mOccupied = 0;
+    int mCurrent = 0;
+    // Longest life left of anything spawned; every slot is dead at zero
+    float mLifeRemaining = 0.0f;
+
+    bool mInitialized = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -1,10 +1,21 @@
 #pragma once
 
-#include &lt;memory&gt;
-#include &quot;Renderer.h&quot;
-#include &quot;ShaderManager.h&quot;
-#include &quot;CardRenderer.h&quot;
-#include &quot;ParticleEffect.h&quot;
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Renderer.h"
+#include "ShaderManager.h"
+#include "CardRenderer.h"
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include "ParticleEffect.h"
+#include "Profiler.h"
+#include "SceneGraph.h"
+#include "SpriteBatcher.h"
+#include "TextRenderer.h"
+#include "TextureLoader.h"
+#include "TweenEngine.h"
 
 namespace trashapp {
 namespace graphics {
@@ -14,34 +25,201 @@ struct GraphicsConfig {
     int height;
     bool enableVSync;
     int msaaSamples;
+    bool offscreen;   // render into a framebuffer object, no window needed
+};
+
+// Where initialize() spends its time. Shaders finish compiling after
+// initialize returns, so shadersReadyMilliseconds is measured from the start
+// of initialize and stays 0 until the last program is ready.
+struct StartupTiming {
+    double rendererMilliseconds;
+    double shaderSubmitMilliseconds;
+    double cardRendererMilliseconds;
+    double textureLoaderMilliseconds;
+    double initializeMilliseconds;
+    double shadersReadyMilliseconds;
+    int pendingShaders;
+};
+
+struct GraphicsMemoryStats {
+    MemoryTagStats tags[static_cast<int>(MemoryTag::Count)];
+    FrameArenaStats frameArena;
+};
+
+struct SyncStats {
+    double presentLatencyMilliseconds;  // frame start to display
+    int pendingEffects;                 // scheduled, waiting for their frame
+    uint64_t scheduledEffects;          // released into a frame so far
+    uint64_t lateEffects;               // their time had passed by the first frame that could show them
+    double averageErrorMilliseconds;    // predicted display time minus requested
 };
 
 class GraphicsEngine {
 public:
-    static GraphicsEngine&amp; getInstance();
+    static GraphicsEngine& getInstance();
     
     // Lifecycle
-    void initialize(const GraphicsConfig&amp; config);
+    void initialize(const GraphicsConfig& config);
     void resize(int width, int height);
     void render();
     void release();
     
+    // render() split in two so callers can draw cards into the frame.
+    // render() skips the frame when the retained scene is unchanged and
+    // nothing animates; beginFrame always draws.
+    bool beginFrame();
+    void endFrame();
+    // False while the last frame is still current, for render-on-demand loops
+    bool needsRender();
+    // The last rendered frame as RGBA, top row first
+    bool readPixels(std::vector<uint8_t>& rgba);
+    
+    // Window surface from SurfaceHolder callbacks, on the render thread. The
+    // context and every GPU resource survive detach (pause); frames are only
+    // rendered while a window is attached.
+    bool attachWindow(ANativeWindow* window);
+    void detachWindow();
+    SurfaceStats getSurfaceStats();
+    
+    // Directory for generated assets such as the card atlas; set before initialize()
+    void setCacheDirectory(const char* path);
+    
     // Rendering
     void clearScreen(float r, float g, float b, float a);
     void presentFrame();
     
+    // Frame pacing: target 30/60/90/120 Hz (0 = every vsync). onVsync takes
+    // Choreographer frame times and may be called from any thread.
+    void setVSync(bool enabled);
+    void setTargetFrameRate(int framesPerSecond);
+    void setDisplayRefreshRate(float hz);
+    void onVsync(int64_t frameTimeNanos);
+    FrameTimingStats getFrameTiming();
+    
+    // Resolution: layouts use 1920x1080 virtual units fitted to any aspect.
+    // The render scale trades sharpness for GPU time; dynamic mode picks it
+    // from the frame budget.
+    void setRenderScale(float scale);
+    void setDynamicResolution(bool enabled, float minScale);
+    RenderScaleStats getRenderScaleStats();
+    CameraState getCameraState();
+    void screenToWorld(float screenX, float screenY, float& worldX, float& worldY);
+    
+    // Multisampling in an offscreen target; falls back 4x -> 2x -> none
+    void setMsaaSamples(int samples);
+    MsaaStats getMsaaStats();
+    
+    // Attachment traffic of the last frame's render passes
+    RenderPassStats getRenderPassStats();
+    
     // Card rendering
     void renderCard(float x, float y, float width, float height, 
                     const char* suit, const char* rank, bool faceUp);
     void renderCardBack(float x, float y, float width, float height);
     
+    // Resolve a card to its atlas id once, then draw it by id
+    int getCardId(const char* suit, const char* rank);
+    void renderCardById(float x, float y, float width, float height, int cardId, bool faceUp);
+    // A whole hand or table in one call, e.g. straight from a Java direct buffer
+    void renderCards(const CardRecord* records, size_t count);
+    
+    // Sprites: cards, particles and these quads share one batcher that sorts
+    // by layer, then blend, shader and texture. Higher layers cover lower
+    // ones (SpriteBatcher::LAYER_*); within a layer draw order is not kept
+    // across different textures.
+    void drawSprite(const Sprite& sprite);
+    // A streamed texture in layout units, tinted by an ARGB color. Skipped
+    // until its first mip level is uploaded.
+    void drawTexture(TextureHandle handle, float x, float y, float width, float height,
+                     uint32_t argb, BlendMode blend, int layer);
+    BatchStats getSpriteBatchStats();
+    
+    // Distance field text and pips, sharp at any size. (x, y) is the left
+    // end of the baseline; capHeight is the height of a digit or pip.
+    // Text covers ranks, digits and "+-.:/x" plus the suit symbols; returns
+    // the advance.
+    float drawText(const char* text, float x, float y, float capHeight, uint32_t argb, int layer);
+    float measureText(const char* text, float capHeight);
+    // suit as in card ids (id / 13), anything else draws the sheriff star
+    void drawSuitPip(int suit, float x, float y, float size, uint32_t argb, int layer);
+    
+    // Retained scene: nodes are created once and updated with deltas, see
+    // SceneGraph. Positions are layout units relative to the parent
+    // (SceneGraph::ROOT for the table); ids are 0 on failure.
+    int createSceneGroup(int parent, float x, float y);
+    int createSceneCard(int parent, float x, float y, float width, float height, int cardId, bool faceUp);
+    int createSceneEffect(int parent, float x, float y, int emitterHandle);
+    void setSceneNodePosition(int id, float x, float y);
+    void setSceneNodeSize(int id, float width, float height);
+    void setSceneCard(int id, int cardId, bool faceUp);
+    void setSceneNodeVisible(int id, bool visible);
+    void setSceneNodeOrder(int id, int order);
+    void destroySceneNode(int id);
+    void clearScene();
+    // Redraws the whole scene on the next frame
+    void invalidateScene();
+    SceneStats getSceneStats();
+    
+    // Scene node animation, advanced natively at the start of each frame; see
+    // TweenEngine. Animation ids are 0 on failure.
+    int animateSceneNode(int id, TweenChannel channel, const TweenKey* keys, size_t keyCount,
+                         float delay);
+    int moveSceneNode(int id, float x, float y, float duration, float delay, Easing easing);
+    // Narrows the card to its edge, turns it over and widens it again
+    int flipSceneCard(int id, int cardId, bool faceUp, float duration, float delay);
+    void cancelAnimation(int animation, bool finish);
+    bool isAnimationActive(int animation);
+    TweenStats getAnimationStats();
+    // Fixed seconds per frame for reproducible captures; 0 follows the clock
+    void setAnimationTimeStep(float seconds);
+    
     // Effects
     void addParticleEffect(const char* effectType, float x, float y);
     void updateParticles(float deltaTime);
+    bool loadParticleEmitters(const char* json, size_t length);
+    int findParticleEmitter(const char* name);
+    void spawnParticleEmitter(int emitterHandle, float x, float y);
+    int startParticleEmitter(int emitterHandle, float x, float y);
+    void moveParticleEmitter(int emitterId, float x, float y);
+    void stopParticleEmitter(int emitterId);
+    bool setParticleBackend(ParticleBackend backend);
+    ParticleValidationResult validateParticleBackend(int sampleCount, int steps);
+    
+    // A/V sync. Times are CLOCK_MONOTONIC nanoseconds (System.nanoTime()),
+    // the clock the audio engine reports presentation on.
+    // getNextPresentTimeNanos is the earliest a visual requested now can be
+    // on screen; a scheduled effect spawns in the frame predicted to reach
+    // the display closest to its time, so a sound played for the same time
+    // lands with it.
+    int64_t getNextPresentTimeNanos();
+    void addParticleEffectAt(const char* effectType, float x, float y, int64_t presentTimeNanos);
+    SyncStats getSyncStats();
+    
+    // Compressed textures (KTX), streamed in across frames
+    TextureHandle loadTexture(const char* path);
+    TextureHandle loadTextureFromFd(int fd, int64_t offset, int64_t length);
+    void releaseTexture(TextureHandle handle);
+    GLuint getTexture(TextureHandle handle);
+    TextureState getTextureState(TextureHandle handle);
+    TextureMemoryStats getTextureMemoryStats();
+    void setTextureUploadBudget(size_t bytesPerFrame);
     
     // Shaders
     void loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc);
     void useShader(const char* name);
+    bool isShaderReady(const char* name);
+    ShaderCacheStats getShaderCacheStats();
+    StartupTiming getStartupTiming();
+    
+    // Frame profiling: CPU and GPU scopes recorded while enabled, exported
+    // as Chrome trace JSON; see Profiler
+    void setProfilingEnabled(bool enabled);
+    void clearProfile();
+    bool exportProfile(const char* path);
+    ProfilerStats getProfilerStats();
+    
+    // Native memory held by the tagged subsystems, and the frame arena
+    GraphicsMemoryStats getMemoryStats();
     
     // Wild West theme
     void setWildWestTheme();
@@ -51,20 +229,61 @@ public:
 private:
     GraphicsEngine();
     ~GraphicsEngine();
-    GraphicsEngine(const GraphicsEngine&amp;) = delete;
-    GraphicsEngine&amp; operator=(const GraphicsEngine&amp;) = delete;
+    GraphicsEngine(const GraphicsEngine&) = delete;
+    GraphicsEngine& operator=(const GraphicsEngine&) = delete;
+    
+    void pollShaderWarmup();
+    void advanceAnimations();
+    void prepareAnimation();
+    bool restoreContext();
+    void releaseScheduledEffects();
     
     // Components
-    std::unique_ptr&lt;Renderer&gt; mRenderer;
-    std::unique_ptr&lt;ShaderManager&gt; mShaderManager;
-    std::unique_ptr&lt;CardRenderer&gt; mCardRenderer;
-    std::unique_ptr&lt;ParticleEffect&gt; mParticleEffect;
+    std::unique_ptr<Renderer> mRenderer;
+    std::unique_ptr<ShaderManager> mShaderManager;
+    std::unique_ptr<SpriteBatcher> mSprites;
+    std::unique_ptr<CardRenderer> mCardRenderer;
+    std::unique_ptr<TextRenderer> mTextRenderer;
+    std::unique_ptr<ParticleEffect> mParticleEffect;
+    std::unique_ptr<TextureLoader> mTextureLoader;
+    std::unique_ptr<SceneGraph> mScene;
+    std::unique_ptr<TweenEngine> mTweens;
+    // Transient data of the current frame; reset as each frame begins
+    FrameArena mFrameArena;
     
     // State
     GraphicsConfig mConfig;
+    std::string mCacheDirectory;
+    StartupTiming mStartupTiming = {};
+    std::chrono::steady_clock::time_point mInitializeStart;
+    bool mShadersPending = false;
+    bool mImmediateDrawn = false;   // cards drawn outside the scene this frame
+    std::vector<int> mStoppedEmitters;
+    
+    struct ScheduledEffect {
+        std::string effectType;
+        float x;
+        float y;
+        int64_t presentNanos;
+    };
+    std::vector<ScheduledEffect> mScheduledEffects;
+    uint64_t mScheduledEffectCount = 0;
+    uint64_t mLateEffectCount = 0;
+    double mAverageSyncErrorMilliseconds = 0.0;
+    std::chrono::steady_clock::time_point mLastAnimationTime;
+    float mAnimationTimeStep = 0.0f;
+    int64_t mFrameStartNanos = 0;
+    int mFrameGpuScope = -1;
+    double mContextRestoreMilliseconds = 0.0;
+    size_t mTextureUploadBudget = DEFAULT_TEXTURE_UPLOAD_BUDGET;
     bool mInitialized = false;
     bool mWoodGrainEnabled = false;
     bool mVintageEffectEnabled = false;
+    
+    // About 1 ms of upload bandwidth on mid-range devices
+    static const size_t DEFAULT_TEXTURE_UPLOAD_BUDGET = 2 * 1024 * 1024;
+    // Longest step an animation takes after a stall, so cards glide rather than jump
+    static constexpr float MAX_ANIMATION_STEP = 0.1f;
 };
 
 } // namespace graphics
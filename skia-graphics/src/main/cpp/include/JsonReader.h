@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace trashapp {
+namespace graphics {
+
+// Minimal read-only JSON document used for asset definitions (particle
+// emitters, atlas metadata). Only parsed at load time, never per frame.
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    JsonValue() = default;
+
+    Type type() const { return mType; }
+    bool isNull() const { return mType == Type::Null; }
+    bool isNumber() const { return mType == Type::Number; }
+    bool isString() const { return mType == Type::String; }
+    bool isArray() const { return mType == Type::Array; }
+    bool isObject() const { return mType == Type::Object; }
+
+    double asNumber(double fallback = 0.0) const;
+    bool asBool(bool fallback = false) const;
+    const std::string& asString() const { return mString; }
+
+    // Arrays
+    size_t size() const { return mType == Type::Array ? mElements.size() : mMembers.size(); }
+    const JsonValue& operator[](size_t index) const { return mElements[index]; }
+
+    // Objects
+    const JsonValue* find(const char* key) const;
+    const std::vector<std::pair<std::string, JsonValue>>& members() const { return mMembers; }
+
+private:
+    friend class JsonReader;
+
+    Type mType = Type::Null;
+    bool mBool = false;
+    double mNumber = 0.0;
+    std::string mString;
+    std::vector<JsonValue> mElements;
+    std::vector<std::pair<std::string, JsonValue>> mMembers;
+};
+
+class JsonReader {
+public:
+    // Parses a complete JSON document. On failure returns false and fills
+    // error with a short description including the byte offset.
+    static bool parse(const char* text, size_t length, JsonValue& out, std::string& error);
+
+private:
+    JsonReader(const char* text, size_t length) : mText(text), mLength(length) {}
+
+    bool parseValue(JsonValue& out, int depth);
+    bool parseObject(JsonValue& out, int depth);
+    bool parseArray(JsonValue& out, int depth);
+    bool parseString(std::string& out);
+    bool parseNumber(JsonValue& out);
+    bool parseLiteral(const char* literal, JsonValue& out, JsonValue::Type type, bool value);
+    void skipWhitespace();
+    bool fail(const char* message);
+
+    const char* mText;
+    size_t mLength;
+    size_t mPos = 0;
+    std::string mError;
+
+    static const int MAX_DEPTH = 32;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "TaggedMemory.h"
+
+namespace trashapp {
+namespace graphics {
+
+// Subsystems whose containers report what they hold
+enum class MemoryTag {
+    Particles,
+    Sprites,
+    Scene,
+    Animation,
+    FrameArena,
+    Count
+};
+
+using MemoryTagStats = TaggedMemoryStats;
+
+// Heap held by the graphics subsystems; the counting is TaggedMemory's
+class MemoryTracker : public TaggedMemory<MemoryTag> {
+public:
+    static const char* tagName(MemoryTag tag);
+};
+
+template <typename T, MemoryTag Tag>
+using TrackedAllocator = TaggedAllocator<T, Tag>;
+
+template <typename T, MemoryTag Tag>
+using TrackedVector = TaggedVector<T, Tag>;
+
+template <typename Key, typename Value, MemoryTag Tag>
+using TrackedMap = TaggedMap<Key, Value, Tag>;
+
+} // namespace graphics
+} // namespace trashapp
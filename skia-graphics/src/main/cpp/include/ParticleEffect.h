@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include "EmitterLibrary.h"
+#include "MemoryTracker.h"
 
 namespace trashapp {
 namespace graphics {
@@ -17,33 +19,112 @@ struct Particle {
     float r, g, b, a;
 };
 
+enum class ParticleBackend {
+    Cpu,
+    GpuTransformFeedback
+};
+
+// Outcome of running the same particles through both backends
+struct ParticleValidationResult {
+    uint32_t particleCount;
+    float maxPositionError;
+    float maxColorError;
+    double cpuMilliseconds;
+    double gpuMilliseconds;
+    bool passed;
+};
+
+using ParticleVector = TrackedVector<Particle, MemoryTag::Particles>;
+
+class GpuParticleSystem;
+class ShaderManager;
+class SpriteBatcher;
+
+// Running continuous emitter started with startEmitter()
+struct EmitterInstance {
+    int id;
+    EmitterHandle handle;
+    float x, y;
+    float elapsed;
+    float pending;   // fractional particles carried to the next update
+    bool active;
+};
+
 class ParticleEffect {
 public:
     ParticleEffect();
     ~ParticleEffect();
     
-    void initialize();
+    // Programs are owned by the shader manager, which must outlive release().
+    // CPU particles are drawn as sprites on the effects layer.
+    void initialize(ShaderManager& shaders, SpriteBatcher& sprites);
     void release();
     
+    // Context loss: onContextLost() forgets GL handles (GPU-simulated
+    // particles are lost with them); restoreAfterContextLoss() rebuilds
+    // the selected backend once a new context is current
+    void onContextLost();
+    void restoreAfterContextLoss();
+    
+    // Emitter definitions
+    bool loadEmitters(const char* json, size_t length);
+    EmitterHandle findEmitter(const char* name) const;
+    
+    // Burst emission; the name overload resolves the handle on every call
     void spawn(const char* effectType, float x, float y);
+    void spawn(EmitterHandle handle, float x, float y);
+    
+    // Continuous emission at the emitter's rate until stopped or expired
+    int startEmitter(EmitterHandle handle, float x, float y);
+    void moveEmitter(int emitterId, float x, float y);
+    void stopEmitter(int emitterId);
+    
     void update(float deltaTime);
     void render();
     
+    // Selects where particles are simulated. Switching migrates live
+    // particles; returns false (and stays on the CPU) if the GPU path is
+    // unavailable on this device.
+    bool setBackend(ParticleBackend backend);
+    ParticleBackend getBackend() const { return mBackend; }
+    
+    // Simulates the same burst on both backends and compares the results
+    ParticleValidationResult validateGpuBackend(EmitterHandle handle, uint32_t count,
+                                                int steps, float deltaTime);
+    
+    // On the GPU backend this counts occupied ring slots, which includes
+    // particles that have died since they were spawned
+    size_t getParticleCount() const;
+    
+    // True while particles are alive or emitters are running. Frames with
+    // nothing else changing can be skipped otherwise.
+    bool isAnimating() const;
+    
 private:
-    void createParticleGeometry();
-    void updateParticle(Particle&amp; p, float deltaTime);
+    void submitParticleShader();
+    void updateParticle(Particle& p, float deltaTime);
+    void emit(const EmitterDescriptor& emitter, float x, float y, uint32_t count);
+    void emitInto(ParticleVector& out, const EmitterDescriptor& emitter,
+                  float x, float y, uint32_t count);
+    void updateEmitters(float deltaTime);
+    void handOffToGpu();
+    
+    ParticleVector mParticles;
+    TrackedVector<EmitterInstance, MemoryTag::Particles> mEmitters;
+    EmitterLibrary mLibrary;
+    uint32_t mSpawnCounter = 0;
+    int mNextEmitterId = 1;
     
-    std::vector<Particle> mParticles;
+    // On the GPU backend mParticles only stages new spawns until update()
+    std::unique_ptr<GpuParticleSystem> mGpuParticles;
+    ParticleBackend mBackend = ParticleBackend::Cpu;
+    bool mRestoreGpuBackend = false;
     
-    // OpenGL objects
-    GLuint mVertexArray = 0;
-    GLuint mVertexBuffer = 0;
-    GLuint mShaderProgram = 0;
+    ShaderManager* mShaders = nullptr;
+    SpriteBatcher* mSprites = nullptr;
+    int mSpriteShader = -1;
     
-    // Wild West particle types
-    void spawnGoldCoin(float x, float y);
-    void spawnDust(float x, float y);
-    void spawnFireSpark(float x, float y);
+    static constexpr size_t MAX_PARTICLES = 16384;
     
     bool mInitialized = false;
 };
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace trashapp {
+namespace graphics {
+
+struct ProfilerStats {
+    uint32_t threads;           // threads that recorded a scope
+    uint64_t cpuScopes;         // recorded since the last clear
+    uint64_t gpuScopes;         // GPU timings resolved since the last clear
+    uint64_t overwritten;       // older scopes the rings no longer hold
+    uint32_t gpuDiscarded;      // GPU timings voided by disjoint events
+    bool gpuTimerSupported;
+    bool atraceEnabled;
+};
+
+// Frame profiler. Scopes mark spans of work with RAII objects:
+//
+//     PROFILE_SCOPE("particles.update");
+//     PROFILE_GPU_SCOPE("scene.layer");   // render thread, inside a frame
+//
+// While recording, each thread writes finished CPU scopes into its own ring
+// without locks; GPU scopes are EXT_disjoint_timer_query timestamp pairs read
+// back a few frames later and placed on the CPU timeline. While a system
+// trace (atrace, Perfetto) is capturing, CPU scopes also become ATrace
+// sections. The rings export as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+// With recording off and no trace capturing, a scope costs one relaxed load.
+// Scope names must outlive the profiler: use string literals.
+class Profiler {
+public:
+    static Profiler& getInstance();
+
+    // Flag bits: whether scopes record, and whether they emit ATrace sections
+    static const uint32_t RECORD = 1u;
+    static const uint32_t ATRACE = 2u;
+    static uint32_t flags() { return sFlags.load(std::memory_order_relaxed); }
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return (flags() & RECORD) != 0; }
+
+    // Adds a finished scope on the calling thread, for spans that do not fit
+    // one C++ scope
+    void record(const char* name, int64_t startNanos, int64_t endNanos);
+    // Names the calling thread in exported traces; a string literal
+    void setThreadName(const char* name);
+
+    // GPU timing needs a current context; call around every frame on the
+    // render thread. beginFrame also notices a system trace starting or stopping.
+    void initializeGpu();
+    void releaseGpu();
+    // After context loss: forgets the queries without deleting them
+    void abandonGpu();
+    void beginFrame();
+    void endFrame();
+    // -1 when the scope is not timed
+    int beginGpuScope(const char* name);
+    void endGpuScope(int scope);
+
+    // Forgets recorded scopes; safe while other threads record
+    void clear();
+    bool exportChromeTrace(const std::string& path) const;
+    std::string chromeTraceJson() const;
+    ProfilerStats getStats() const;
+
+    static int64_t nowNanos();
+
+private:
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    struct Event {
+        const char* name;
+        int64_t startNanos;
+        int64_t endNanos;
+    };
+
+    // Written by one thread only. head counts every event ever written; the
+    // reader takes a snapshot and drops whatever was overwritten meanwhile.
+    struct ThreadRing {
+        static const uint32_t CAPACITY = 4096;
+
+        std::atomic<uint64_t> head{0};
+        std::atomic<uint64_t> cleared{0};  // events before this were cleared
+        int threadId = 0;
+        char name[32] = {};
+        Event events[CAPACITY];
+
+        void push(const Event& event);
+    };
+
+    struct GpuScope {
+        const char* name;
+        GLuint begin;
+        GLuint end;
+        bool ended;             // false if the frame ended first
+    };
+
+    // Scopes of one frame; results are read a few frames later so the GPU
+    // never stalls
+    struct GpuFrame {
+        static const int MAX_SCOPES = 32;
+
+        GLuint queries[MAX_SCOPES * 2] = {};
+        GpuScope scopes[MAX_SCOPES] = {};
+        int scopeCount = 0;
+        GLuint lastQuery = 0;
+        int64_t cpuBase = 0;    // CPU and GPU clocks read together
+        int64_t gpuBase = 0;
+        bool pending = false;
+    };
+
+    ThreadRing* threadRing();
+    void collectGpuFrames();
+    void appendEvents(const ThreadRing& ring, std::string& json, bool& first) const;
+
+    static std::atomic<uint32_t> sFlags;
+
+    static const int MAX_THREADS = 32;
+    std::atomic<ThreadRing*> mRings[MAX_THREADS] = {};
+    std::atomic<int> mRingCount{0};
+    ThreadRing mGpuRing;
+    int64_t mEpochNanos = 0;
+
+    static const int GPU_FRAMES = 4;
+    GpuFrame mGpuFrames[GPU_FRAMES];
+    int mGpuFrame = 0;
+    bool mGpuFrameActive = false;
+    bool mGpuSupported = false;
+    PFNGLQUERYCOUNTEREXTPROC mQueryCounter = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC mGetQueryObjectui64v = nullptr;
+    std::atomic<uint64_t> mGpuScopes{0};
+    std::atomic<uint32_t> mGpuDiscarded{0};
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) {
+        uint32_t flags = Profiler::flags();
+        mName = flags != 0 ? name : nullptr;
+        if (mName != nullptr) begin(flags);
+    }
+    ~ProfileScope() {
+        if (mName != nullptr) end();
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    void begin(uint32_t flags);
+    void end();
+
+    const char* mName;
+    int64_t mStartNanos = 0;
+    uint32_t mFlags = 0;
+};
+
+// Render thread only, between Profiler::beginFrame and endFrame
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name)
+        : mScope((Profiler::flags() & Profiler::RECORD) != 0
+                     ? Profiler::getInstance().beginGpuScope(name) : -1) {}
+    ~GpuProfileScope() {
+        if (mScope >= 0) Profiler::getInstance().endGpuScope(mScope);
+    }
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    int mScope;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+    ::trashapp::graphics::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) \
+    ::trashapp::graphics::GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+
+} // namespace graphics
+} // namespace trashapp
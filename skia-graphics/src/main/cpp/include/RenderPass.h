@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+namespace trashapp {
+namespace graphics {
+
+// What happens to an attachment's previous contents when a pass starts.
+// Clear and DontCare let a tiled GPU skip reading it from memory.
+enum class LoadAction {
+    Clear,
+    Load,
+    DontCare
+};
+
+// Whether an attachment is written back when the pass ends. DontCare
+// attachments are invalidated so tiled GPUs drop them on chip.
+enum class StoreAction {
+    Store,
+    DontCare
+};
+
+struct RenderPassDescriptor {
+    LoadAction colorLoad = LoadAction::Clear;
+    StoreAction colorStore = StoreAction::Store;
+    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+    // 2D content draws in painter's order; passes that need depth opt in.
+    // Without it depth and stencil are neither loaded nor stored.
+    bool useDepth = false;
+    LoadAction depthLoad = LoadAction::Clear;
+    StoreAction depthStore = StoreAction::DontCare;
+    float clearDepth = 1.0f;
+};
+
+struct RenderPassStats {
+    uint32_t passesPerFrame;
+    uint32_t invalidatesPerFrame;
+    uint64_t bytesPerFrame;         // estimated attachment loads and stores still made
+    uint64_t bytesSavedPerFrame;    // against loading and storing every attachment
+    uint64_t bytesSavedTotal;
+};
+
+// Estimated attachment memory traffic of one pass over width x height
+// pixels: RGBA8 color and D24S8 depth/stencil, per sample
+struct PassTraffic {
+    uint64_t bytes;
+    uint64_t bytesSaved;
+};
+
+PassTraffic estimatePassTraffic(const RenderPassDescriptor& pass, int width, int height, int samples);
+
+} // namespace graphics
+} // namespace trashapp
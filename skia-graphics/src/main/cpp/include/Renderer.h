@@ -1,45 +1,218 @@
 #pragma once
 
-#include &lt;GLES3/gl3.h&gt;
-#include &lt;EGL/egl.h&gt;
-#include &lt;EGL/eglext.h&gt;
-#include &lt;memory&gt;
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <android/native_window.h>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "Camera.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "RenderPass.h"
 
 namespace trashapp {
 namespace graphics {
 
+struct SurfaceStats {
+    uint32_t windowAttachCount;
+    uint32_t contextLossCount;
+    double firstFrameMilliseconds;     // attachWindow to the first swap, most recent attach
+    double contextRestoreMilliseconds; // rebuilding GPU state after the last context loss
+    bool hasWindow;
+};
+
+// What one MSAA setting costs at the current render size. Memory and
+// traffic are estimates; times are measured while the setting was active.
+struct MsaaSettingCost {
+    int samples;
+    bool supported;
+    uint64_t targetBytes;            // scene color + depth/stencil storage
+    uint64_t resolveBytesPerFrame;   // memory traffic of the resolve and upscale
+    double averageCpuMilliseconds;
+    double averageGpuMilliseconds;   // -1 until measured
+    uint32_t frames;
+};
+
+struct MsaaStats {
+    static const int SETTING_COUNT = 3;   // none, 2x, 4x
+
+    int requestedSamples;
+    int activeSamples;       // after fallback
+    int maxSamples;          // GL_MAX_SAMPLES
+    MsaaSettingCost settings[SETTING_COUNT];
+};
+
+// Owns the EGL context for the life of the engine. Window surfaces come and
+// go with the activity (attachWindow / detachWindow); while there is none a
+// 1x1 pbuffer keeps the context current so GPU resources survive pause.
+// Offscreen renderers draw into a framebuffer object instead and need no
+// window system (Mesa's surfaceless platform when available), for host
+// benchmarks and golden-image tests.
+//
+// Multisampling and reduced render scale both draw the scene into its own
+// framebuffer, which endFrame resolves into the output with a blit. The EGL
+// config never asks for samples: many drivers reject multisampled window
+// configs, while multisampled renderbuffers are always available in ES 3.
+
 class Renderer {
 public:
     Renderer();
     ~Renderer();
     
-    bool initialize(int width, int height, int msaaSamples);
+    bool initialize(int width, int height, int msaaSamples, bool vsync = true, bool offscreen = false);
     void resize(int width, int height);
     void release();
     
+    // Surface lifecycle, on the thread that owns the context. The renderer
+    // takes its own reference to the window.
+    bool attachWindow(ANativeWindow* window);
+    void detachWindow();
+    bool hasWindow() const { return mSurface != EGL_NO_SURFACE; }
+    bool isOffscreen() const { return mOffscreen; }
+    // True when frames have somewhere to go
+    bool hasTarget() const { return mOffscreen || hasWindow(); }
+    
+    // Reads the current target back as tightly packed RGBA, top row first
+    bool readPixels(std::vector<uint8_t>& rgba);
+    
+    // Set when EGL reports EGL_CONTEXT_LOST. Every GL object is gone; callers
+    // forget their handles, then recoverContext() makes a fresh context current.
+    bool isContextLost() const { return mContextLost; }
+    bool recoverContext();
+    
+    int getWidth() const { return mWidth; }
+    int getHeight() const { return mHeight; }
+    SurfaceStats getSurfaceStats() const;
+    
+    // beginFrame opens the frame pass on the scene target; endFrame closes
+    // it and resolves. Other passes go between frames or inside one after
+    // endPass(), on any framebuffer (0 is the window).
     void beginFrame();
     void endFrame();
     void present();
+    // beginFrame in two steps, for offscreen passes at this frame's render
+    // size that must run before the frame pass opens
+    void prepareFrame();
+    void beginFramePass(const RenderPassDescriptor& pass);
+    
+    void setFramePass(const RenderPassDescriptor& pass) { mFramePass = pass; }
+    const RenderPassDescriptor& getFramePass() const { return mFramePass; }
+    void beginPass(const RenderPassDescriptor& pass, GLuint framebuffer, int width, int height, int samples = 0);
+    void endPass();
+    bool isInPass() const { return mInPass; }
+    RenderPassStats getRenderPassStats() const { return mPassStats; }
+    // Samples of this frame's scene target; 0 when single-sampled
+    int getSceneSamples() const { return mSceneFramebuffer != 0 ? mSceneSamples : 0; }
     
+    // Sets the frame pass clear color; inside a pass it also clears now
     void clear(float r, float g, float b, float a);
     
+    // Frame pacing
+    void setVSync(bool enabled) { mPacer.setVSync(enabled); }
+    void setTargetFrameRate(int framesPerSecond) { mPacer.setTargetFrameRate(framesPerSecond); }
+    void setDisplayRefreshRate(float hz) { mPacer.setDisplayRefreshRate(hz); }
+    void onVsync(int64_t frameTimeNanos) { mPacer.onVsync(frameTimeNanos); }
+    FrameTimingStats getFrameTiming() const { return mPacer.getStats(); }
+    int64_t getFramePresentNanos() const { return mPacer.getFramePresentNanos(); }
+    int64_t predictNextPresentNanos() const { return mPacer.predictNextPresentNanos(); }
+    bool framePresentsBy(int64_t presentNanos) const { return mPacer.presentsBy(presentNanos); }
+    int64_t getFramePeriodNanos() const { return mPacer.getFramePeriodNanos(); }
+    
+    // Resolution: the camera block is updated on resize and scale changes.
+    // A fixed scale applies until dynamic mode is turned on, which then
+    // moves between minScale and 1 to hold the frame budget.
+    const Camera& getCamera() const { return mCamera; }
+    void setRenderScale(float scale) { mResolution.setScale(scale); }
+    void setDynamicResolution(bool enabled, float minScale) { mResolution.setDynamic(enabled, minScale); }
+    RenderScaleStats getRenderScaleStats() const { return mResolution.getStats(); }
+    
+    // MSAA: 4 falls back to 2, then to none, when the driver cannot provide it
+    void setMsaaSamples(int samples);
+    MsaaStats getMsaaStats() const;
+    
 private:
     bool initializeEGL();
     bool initializeGL();
+    bool createOffscreenTarget();
+    void destroyOffscreenTarget();
+    bool allocateTarget(GLuint& framebuffer, GLuint& color, GLuint& depth,
+                        int width, int height, int samples = 0);
+    void deleteTarget(GLuint& framebuffer, GLuint& color, GLuint& depth);
+    void querySampleSupport();
+    int chooseSamples(int requested) const;
+    void updateSceneTarget();
+    bool allocateSceneTarget(int width, int height, int samples);
+    void destroySceneTarget();
+    void resolveScene();
+    void recordMsaaCost(const FrameTimingStats& timing);
+    void invalidateAttachments(GLenum target, GLuint framebuffer, bool color, bool depth);
+    static int settingIndex(int samples);
+    GLuint outputFramebuffer() const { return mOffscreen ? mFramebuffer : 0; }
+    double frameBudgetMilliseconds() const;
+    EGLDisplay getOffscreenDisplay();
+    bool createContext();
+    bool makeCurrent();
+    void destroyWindowSurface();
+    void checkContextLost(const char* operation);
     void cleanupEGL();
     
     // EGL
     EGLDisplay mDisplay = EGL_NO_DISPLAY;
     EGLContext mContext = EGL_NO_CONTEXT;
     EGLSurface mSurface = EGL_NO_SURFACE;
+    EGLSurface mPbuffer = EGL_NO_SURFACE;
     EGLConfig mConfig = nullptr;
+    ANativeWindow* mWindow = nullptr;
     
-    // OpenGL state
+    // OpenGL state; the framebuffer is the offscreen target
     GLuint mFramebuffer = 0;
     GLuint mRenderbuffer = 0;
+    GLuint mDepthRenderbuffer = 0;
+    bool mOffscreen = false;
+    // Scene target, only while multisampling or below full render scale.
+    // Multisampled and scaled frames resolve through a single-sample copy,
+    // since ES 3 blits cannot resolve and scale at once.
+    GLuint mSceneFramebuffer = 0;
+    GLuint mSceneColor = 0;
+    GLuint mSceneDepth = 0;
+    GLuint mResolveFramebuffer = 0;
+    GLuint mResolveColor = 0;
+    GLuint mResolveDepth = 0;
+    int mSceneWidth = 0;
+    int mSceneHeight = 0;
+    int mSceneSamples = 0;
     int mWidth = 0;
     int mHeight = 0;
-    int mMSAASamples = 4;
+    
+    // MSAA
+    int mMSAASamples = 4;          // requested
+    int mActiveSamples = 0;        // in use after fallback
+    int mMaxSamples = 0;
+    bool mSampleSupport[MsaaStats::SETTING_COUNT] = {};
+    MsaaSettingCost mMsaaCosts[MsaaStats::SETTING_COUNT] = {};
+    
+    // Render passes
+    RenderPassDescriptor mFramePass;
+    RenderPassDescriptor mPass;
+    GLuint mPassFramebuffer = 0;
+    int mPassWidth = 0;
+    int mPassHeight = 0;
+    int mPassSamples = 0;
+    bool mInPass = false;
+    RenderPassStats mFrameStats = {};   // accumulating for the current frame
+    RenderPassStats mPassStats = {};    // last completed frame
+    
+    FramePacer mPacer;
+    Camera mCamera;
+    DynamicResolution mResolution;
+    
+    // Lifecycle
+    std::chrono::steady_clock::time_point mAttachTime;
+    bool mAwaitingFirstFrame = false;
+    bool mContextLost = false;
+    SurfaceStats mSurfaceStats = {};
     
     bool mInitialized = false;
 };
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include <GLES3/gl3.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+class CardRenderer;
+class Renderer;
+class ShaderManager;
+class SpriteBatcher;
+
+enum class SceneNodeType {
+    Group,    // positions its children: a pile, a hand
+    Card,
+    Effect    // anchors a running particle emitter
+};
+
+// Render pixels, y up, max edges exclusive
+struct PixelRect {
+    int x0, y0, x1, y1;
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    int64_t area() const { return empty() ? 0 : static_cast<int64_t>(x1 - x0) * (y1 - y0); }
+};
+
+struct SceneStats {
+    uint32_t nodeCount;
+    uint32_t layerUpdates;      // frames that redrew some of the layer
+    uint32_t fullRedraws;
+    uint32_t framesSkipped;     // render() calls with nothing to redraw
+    uint32_t lastDirtyRects;
+    uint32_t lastCardsDrawn;
+    float lastDirtyFraction;    // of the layer covered by the last update
+};
+
+// A node's own placement, relative to its parent. scaleX narrows a card
+// about its vertical centre line, for flips.
+struct SceneTransform {
+    float x, y;
+    float width, height;
+    float scaleX;
+};
+
+// An effect node whose position changed, so its emitter can follow
+struct SceneEffectMove {
+    int emitterId;
+    float x, y;
+};
+
+// Retained card table. Java creates nodes once and sends only changes; the
+// cards are drawn into a persistent layer at render resolution, and each
+// change redraws just the pixels it touched (old and new bounds) under a
+// scissor. Every frame copies the layer into the frame pass, so nothing is
+// drawn card by card unless something moved, and with nothing changed and
+// no particles alive the frame is skipped altogether.
+//
+// Positions are relative to the parent in layout units (y up). Children draw
+// after their parent, siblings by order and then by creation.
+class SceneGraph {
+public:
+    static const int ROOT = 0;
+
+    SceneGraph();
+    ~SceneGraph();
+
+    // The composite program is owned by shaders
+    void initialize(ShaderManager& shaders);
+    void release();
+    // After context loss: forgets the layer; the next update redraws it whole
+    void onContextLost();
+
+    // Ids are never reused; 0 means the parent does not exist
+    int createNode(SceneNodeType type, int parent);
+    // Also destroys descendants; their emitter ids are appended to stoppedEmitters
+    void destroyNode(int id, std::vector<int>& stoppedEmitters);
+    void clear(std::vector<int>& stoppedEmitters);
+
+    void setPosition(int id, float x, float y);
+    void setSize(int id, float width, float height);
+    void setCard(int id, int cardId, bool faceUp);
+    void setVisible(int id, bool visible);
+    void setOrder(int id, int order);
+    void setEmitter(int id, int emitterId);
+    bool getWorldPosition(int id, float& x, float& y) const;
+    // All of the above at once, for animation
+    bool getTransform(int id, SceneTransform& transform) const;
+    void setTransform(int id, const SceneTransform& transform);
+
+    bool hasContent() const { return !mNodes.empty(); }
+    // True when the next frame would change the layer or move an effect
+    bool isDirty() const { return mFullRedraw || !mStale.empty(); }
+    // Everything is redrawn on the next update: resize, context loss, theme
+    void invalidate() { mFullRedraw = true; }
+
+    // Brings the layer up to date at this frame's render size. Runs its own
+    // pass, so call between Renderer::prepareFrame and beginFramePass. Returns
+    // false when the layer cannot be shown yet; draw the cards with
+    // drawDirect instead. Cards queued on sprites are flushed before the
+    // pass ends.
+    bool updateLayer(Renderer& renderer, CardRenderer& cards, SpriteBatcher& sprites,
+                     bool vintage, bool woodGrain);
+    // Replaces the frame pass contents with the layer
+    void composite();
+    void drawDirect(CardRenderer& cards, bool vintage, bool woodGrain);
+
+    // Effect nodes moved since the last call
+    std::vector<SceneEffectMove>& getEffectMoves() { return mEffectMoves; }
+
+    void noteSkippedFrame() { mStats.framesSkipped++; }
+    SceneStats getStats() const;
+
+private:
+    using NodeList = TrackedVector<int, MemoryTag::Scene>;
+
+    struct Node {
+        SceneNodeType type;
+        int parent;
+        NodeList children;           // draw order
+        float x, y;
+        float width, height;
+        float scaleX;
+        int cardId;
+        int order;
+        int emitterId;
+        bool faceUp;
+        bool visible;
+        bool stale;
+        bool drawn;                  // bounds below are on the layer
+        float left, bottom, right, top;
+    };
+
+    Node* find(int id);
+    const Node* find(int id) const;
+    NodeList& childrenOf(int parent);
+    void insertChild(int parent, int id);
+    void markStale(int id);
+    void removeSubtree(int id, std::vector<int>& stoppedEmitters);
+    void resolveStale();
+    void computeWorld(const Node& node, float& x, float& y, bool& visible) const;
+    void addDirty(float left, float bottom, float right, float top);
+    PixelRect toPixels(float left, float bottom, float right, float top) const;
+    void mergeDirtyRects();
+    void drawNodes(const NodeList& ids, CardRenderer& cards, bool vintage, bool woodGrain,
+                   const PixelRect* clip);
+    bool allocateLayer(int width, int height, int samples);
+    void destroyLayer();
+
+    TrackedMap<int, Node, MemoryTag::Scene> mNodes;
+    NodeList mRootChildren;
+    NodeList mStale;
+    std::vector<SceneEffectMove> mEffectMoves;
+    int mNextId = 1;
+
+    // Pending redraw, in render pixels of the current layer
+    TrackedVector<PixelRect, MemoryTag::Scene> mDirty;
+    bool mFullRedraw = true;
+
+    // Layout to render pixels for the layer's current size
+    float mVisibleLeft = 0.0f;
+    float mVisibleBottom = 0.0f;
+    float mPixelsPerUnit = 1.0f;
+
+    // Layer: a texture, drawn through a multisampled renderbuffer when the
+    // frame is multisampled so cards keep their antialiasing
+    GLuint mLayerFramebuffer = 0;
+    GLuint mLayerTexture = 0;
+    GLuint mMsaaFramebuffer = 0;
+    GLuint mMsaaColor = 0;
+    int mLayerWidth = 0;
+    int mLayerHeight = 0;
+    int mLayerSamples = 0;
+    float mBackground[4] = {};
+
+    GLuint mCompositeProgram = 0;
+    GLint mLayerLoc = -1;
+    ShaderManager* mShaders = nullptr;
+
+    SceneStats mStats = {};
+    uint32_t mCardsDrawn = 0;
+
+    // Merged until at most this many scissored redraws per update
+    static const size_t MAX_DIRTY_RECTS = 8;
+    // Above this share of the layer one unscissored redraw is cheaper
+    static constexpr float FULL_REDRAW_FRACTION = 0.5f;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+
+namespace trashapp {
+namespace graphics {
+
+struct ShaderCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t rejected;          // binaries the driver refused, recompiled from source
+    double compileMilliseconds; // GL thread time spent compiling and linking this launch
+    double loadMilliseconds;    // spent in glProgramBinary this launch
+    double savedMilliseconds;   // recorded compile time of hits minus their load time
+};
+
+// Persists linked program binaries so later launches (and context loss
+// recovery) skip GLSL compilation. Entries are keyed by a hash of the
+// shader sources, transform feedback varyings and the driver identity, so a
+// driver update or shader edit simply misses and recompiles.
+class ShaderCache {
+public:
+    ShaderCache();
+    ~ShaderCache();
+
+    // Needs a current GL context. An empty directory disables the cache.
+    void initialize(const std::string& directory);
+
+    uint64_t computeKey(const char* vertexSrc, const char* fragmentSrc,
+                        const char* const* feedbackVaryings, int varyingCount) const;
+
+    // Returns a linked program, or 0 if there is no usable binary
+    GLuint load(uint64_t key);
+    void store(uint64_t key, GLuint program, double compileMilliseconds);
+
+    // Records a compile that happened on a miss
+    void recordCompile(double milliseconds);
+
+    bool isEnabled() const { return mEnabled; }
+    const ShaderCacheStats& getStats() const { return mStats; }
+
+private:
+    std::string pathFor(uint64_t key) const;
+
+    std::string mDirectory;
+    uint64_t mDriverHash = 0;
+    ShaderCacheStats mStats = {};
+    bool mEnabled = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
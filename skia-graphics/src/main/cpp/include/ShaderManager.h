@@ -4,6 +4,8 @@
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <vector>
+#include "ShaderCache.h"
 
 namespace trashapp {
 namespace graphics {
@@ -12,6 +14,14 @@ struct ShaderProgram {
     GLuint vertexShader = 0;
     GLuint fragmentShader = 0;
     GLuint program = 0;
+    uint64_t cacheKey = 0;    // hash of the sources the program was built from
+    bool ready = false;       // linked and checked; false while the driver is compiling
+    double buildMilliseconds = 0.0;   // GL thread time spent submitting and checking
+    
+    // Kept so the program can be rebuilt after context loss
+    std::string vertexSource;
+    std::string fragmentSource;
+    std::vector<std::string> feedbackVaryings;
     
     void use() const;
     void cleanup();
@@ -22,19 +32,52 @@ public:
     ShaderManager();
     ~ShaderManager();
     
-    void initialize();
+    // Program binaries are cached under cacheDirectory when it is set
+    void initialize(const std::string& cacheDirectory = std::string());
     void release();
     
+    // After context loss: forgets every GL handle without deleting it
+    void onContextLost();
+    // With the new context current, resubmits every program from its
+    // retained sources. Owners pick the new ids up through getProgram().
+    void restorePrograms();
+    
+    // Compiles and links immediately. Loading an existing name replaces its program.
     bool loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc);
+    bool loadShader(const char* name, const char* vertexSrc, const char* fragmentSrc,
+                    const char* const* feedbackVaryings, int varyingCount);
+    
+    // Queues compile and link without waiting for the result. Submit every
+    // program first, then poll, so the driver can build them concurrently.
+    bool submitShader(const char* name, const char* vertexSrc, const char* fragmentSrc,
+                      const char* const* feedbackVaryings = nullptr, int varyingCount = 0);
+    // Never blocks when KHR_parallel_shader_compile is available; otherwise
+    // the first query waits for that program. Failed programs are dropped.
+    bool isShaderReady(const char* name);
+    // Finishes every submitted program that is done (or all of them when
+    // block is set) and returns how many are still compiling
+    size_t pollShaders(bool block);
+    bool isParallelCompileSupported() const { return mParallelCompile; }
+    
     void useShader(const char* name);
     
     ShaderProgram* getShader(const char* name);
+    // 0 while the program is still compiling
+    GLuint getProgram(const char* name);
+    
+    const ShaderCacheStats& getCacheStats() const { return mCache.getStats(); }
     
 private:
+    void configureParallelCompile();
     GLuint compileShader(GLenum type, const char* source);
-    bool linkProgram(ShaderProgram&amp; shader);
+    void linkProgram(ShaderProgram& shader, const char* const* feedbackVaryings, int varyingCount);
+    bool checkCompileStatus(GLuint shader, const char* name);
+    bool checkLinkStatus(GLuint program, const char* name);
+    bool finishShader(const char* name, bool block);
     
     std::unordered_map<std::string, std::unique_ptr<ShaderProgram>> mShaders;
+    ShaderCache mCache;
+    bool mParallelCompile = false;
     bool mInitialized = false;
 };
 
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include <GLES3/gl3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+class ShaderManager;
+
+enum class BlendMode {
+    Alpha,           // straight alpha, the renderer's default
+    Premultiplied,
+    Additive,
+    Opaque           // blending off
+};
+
+// One textured quad in layout units. The layer decides what covers what;
+// within a layer sprites are reordered to group texture, shader and blend
+// changes, so overlapping sprites that must keep their order need
+// different layers.
+struct Sprite {
+    float x = 0.0f;                 // bottom-left corner
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    float u0 = 0.0f;                // texture coordinates at the bottom-left
+    float v0 = 0.0f;
+    float u1 = 1.0f;                // and at the top-right
+    float v1 = 1.0f;
+    uint32_t color = 0xffffffffu;   // RGBA8, red in the low byte; multiplies the texture
+    GLuint texture = 0;
+    int shader = 0;                 // from registerShader; 0 is the textured default
+    BlendMode blend = BlendMode::Alpha;
+    int layer = 0;
+};
+
+struct BatchStats {
+    uint32_t sprites;               // drawn last frame
+    uint32_t batches;               // draw calls
+    uint32_t stateChanges;          // program, texture and blend switches
+    uint32_t flushes;
+    uint32_t skippedSprites;        // their program was still compiling
+    uint32_t largestBatch;
+};
+
+// Collects quads from every 2D renderer and draws them in as few calls as
+// possible. Each flush sorts the queue by a 64-bit key (layer, blend,
+// shader, texture, submission order), writes the vertices into one stream
+// buffer and issues a draw per run of equal state.
+//
+// Flush before anything else draws or changes the target: a scissor, the
+// end of a pass, another renderer's own GL calls.
+class SpriteBatcher {
+public:
+    static const int DEFAULT_SHADER = 0;
+    // Larger queues flush early; 16-bit indices cover four vertices each
+    static const uint32_t MAX_SPRITES = 16384;
+
+    // Layers used by the engine's renderers
+    static const int LAYER_TABLE = 0;
+    static const int LAYER_EFFECTS = 100;
+    static const int LAYER_UI = 200;
+
+    // Vertex stage every sprite program shares. It passes vTexCoord and
+    // vColor (texture coordinates and the sprite color) to the fragment stage.
+    static const char* const VERTEX_SHADER;
+
+    SpriteBatcher();
+    ~SpriteBatcher();
+
+    // Submits the default program; programs are owned by shaders
+    void initialize(ShaderManager& shaders);
+    void release();
+    // After context loss: forgets GL handles; buffers come back on the next flush
+    void onContextLost();
+
+    // Sprites name a program by the index returned here. Its vertex stage
+    // must be VERTEX_SHADER; the texture is bound to uTexture. Returns -1
+    // once the key has no room for more programs.
+    int registerShader(const char* name);
+
+    void draw(const Sprite& sprite);
+    void flush();
+
+    // Scratch space for flushes; without one they use the heap
+    void setFrameArena(FrameArena* arena) { mFrameArena = arena; }
+
+    // Per-frame statistics
+    void beginFrame();
+    void endFrame();
+    BatchStats getStats() const { return mStats; }
+
+    static uint32_t packColor(float r, float g, float b, float a);
+    static uint64_t sortKey(const Sprite& sprite, uint32_t textureSlot, uint32_t sequence);
+
+private:
+    struct SpriteVertex {
+        float x, y;
+        float u, v;
+        uint32_t color;
+    };
+
+    struct ShaderEntry {
+        std::string name;
+        GLuint program;
+        GLint textureLoc;
+    };
+
+    void createBuffers();
+    bool resolveShader(ShaderEntry& entry);
+    uint32_t textureSlot(GLuint texture);
+    void applyBlend(BlendMode blend);
+
+    TrackedVector<Sprite, MemoryTag::Sprites> mQueue;
+    TrackedVector<uint64_t, MemoryTag::Sprites> mKeys;
+    TrackedVector<SpriteVertex, MemoryTag::Sprites> mVertices;
+    TrackedVector<GLuint, MemoryTag::Sprites> mTextureSlots;    // this flush's textures, in first-use order
+    std::vector<ShaderEntry> mShaderEntries;
+
+    GLuint mVertexArray = 0;
+    GLuint mVertexBuffer = 0;
+    GLuint mIndexBuffer = 0;
+    ShaderManager* mShaders = nullptr;
+    FrameArena* mFrameArena = nullptr;
+
+    BatchStats mFrame = {};
+    BatchStats mStats = {};
+
+    bool mInitialized = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "GlyphAtlas.h"
+
+namespace trashapp {
+namespace graphics {
+
+class ShaderManager;
+class SpriteBatcher;
+
+// Ranks, pips and UI numbers from the signed distance field glyph atlas.
+// Glyphs are sprites with their own program, so a line of text is one batch
+// and text on the same layer as cards batches after them.
+class TextRenderer {
+public:
+    TextRenderer();
+    ~TextRenderer();
+
+    // The atlas is cached under cacheDirectory like the card atlas. The
+    // glyph program is owned by shaders.
+    void initialize(ShaderManager& shaders, SpriteBatcher& sprites,
+                    const std::string& cacheDirectory = std::string());
+    void release();
+    // After context loss: the atlas texture is rebuilt from memory on the next draw
+    void onContextLost();
+
+    // UTF-8 from the pen at (x, y) on the baseline, in layout units. Glyphs
+    // missing from the atlas advance like a space. color is RGBA8 as in
+    // Sprite. Returns the advance.
+    float drawText(const char* text, float x, float y, float capHeight, uint32_t color, int layer);
+    // One glyph whose cap height (a pip's full height) is capHeight
+    void drawGlyph(uint32_t codepoint, float x, float y, float capHeight, uint32_t color, int layer);
+    float measureText(const char* text, float capHeight) const;
+
+private:
+    const GlyphMetrics* resolve(uint32_t codepoint) const;
+    float spaceAdvance() const;
+    bool bindAtlas();
+    void queueGlyph(const GlyphMetrics& metrics, float x, float y, float capHeight,
+                    uint32_t color, int layer);
+
+    GlyphAtlas mAtlas;
+    SpriteBatcher* mSprites = nullptr;
+    int mShader = -1;
+
+    bool mInitialized = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+using TextureHandle = int32_t;
+constexpr TextureHandle INVALID_TEXTURE = -1;
+
+enum class TextureState {
+    Pending,    // queued for the worker to map and parse
+    Ready,      // header parsed, waiting for its first upload slice
+    Uploading,  // some mip levels are on the GPU and the texture is usable
+    Resident,   // every level uploaded
+    Failed
+};
+
+struct TextureMemoryStats {
+    size_t residentBytes;      // GPU storage allocated for loaded textures
+    size_t peakResidentBytes;
+    size_t pendingUploadBytes; // mip data still waiting to be uploaded
+    size_t mappedBytes;        // KTX files memory mapped, kept for context loss recovery
+    uint32_t textureCount;
+    uint32_t residentCount;
+};
+
+// Loads ETC2 / ASTC textures from KTX (v1) files. Files are memory mapped and
+// parsed on a worker thread; mip levels are uploaded on the GL thread from
+// processUploads(), smallest first, within a per-call byte budget so large
+// textures stream in over several frames instead of stalling one. Mappings
+// outlive the upload (clean, reclaimable pages), so after context loss the
+// textures stream in again without reopening or parsing their files.
+class TextureLoader {
+public:
+    TextureLoader();
+    ~TextureLoader();
+
+    // Needs a current GL context to query format support
+    void initialize();
+    void release();
+
+    TextureHandle load(const std::string& path);
+    // The descriptor is duplicated, so the caller may close its copy
+    TextureHandle loadFromFd(int fd, int64_t offset, int64_t length);
+    void releaseTexture(TextureHandle handle);
+    
+    // After context loss: forgets every texture id and queues all parsed
+    // textures to upload again. Ids from getTexture() must be fetched again.
+    void onContextLost();
+
+    // Call once per frame on the GL thread. At least one mip level is
+    // uploaded per call even if it exceeds the budget. Returns bytes uploaded.
+    size_t processUploads(size_t byteBudget);
+
+    // 0 until the first (smallest) mip level has been uploaded
+    GLuint getTexture(TextureHandle handle) const;
+    TextureState getState(TextureHandle handle) const;
+    TextureMemoryStats getMemoryStats() const;
+
+    bool isAstcSupported() const { return mAstcSupported; }
+
+private:
+    struct MipLevel {
+        uint32_t width, height;
+        size_t offset;
+        size_t size;
+    };
+
+    struct Entry {
+        TextureHandle handle = INVALID_TEXTURE;
+        std::string path;
+        int fd = -1;
+        int64_t fileOffset = 0;
+        int64_t fileLength = 0;
+
+        void* mapping = nullptr;
+        size_t mappingSize = 0;
+        const uint8_t* data = nullptr;
+
+        GLenum internalFormat = 0;
+        uint32_t width = 0, height = 0;
+        std::vector<MipLevel> levels;
+        int nextLevel = -1;        // counts down to 0, smallest level uploads first
+        size_t storageBytes = 0;
+        size_t uploadedBytes = 0;
+
+        GLuint texture = 0;
+        TextureState state = TextureState::Pending;
+        bool releaseRequested = false;
+    };
+
+    TextureHandle enqueue(std::unique_ptr<Entry> entry);
+    void workerLoop();
+    bool mapEntry(Entry& entry);
+    bool parseKtx(Entry& entry);
+    bool isFormatSupported(GLenum internalFormat) const;
+    void destroyEntry(Entry& entry);
+    static void unmapEntry(Entry& entry);
+
+    std::unordered_map<TextureHandle, std::unique_ptr<Entry>> mEntries;
+    std::deque<Entry*> mParseQueue;
+    std::vector<TextureHandle> mUploadQueue;
+    TextureHandle mNextHandle = 1;
+
+    size_t mResidentBytes = 0;
+    size_t mPeakResidentBytes = 0;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mWorker;
+    bool mRunning = false;
+    bool mAstcSupported = false;
+    // Largest width or height a file may declare; the GLES 3.0 minimum
+    // until initialize() asks the driver
+    uint32_t mMaxTextureSize = 2048;
+    bool mInitialized = false;
+};
+
+} // namespace graphics
+} // namespace trashapp
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "MemoryTracker.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace trashapp {
+namespace graphics {
+
+class SceneGraph;
+
+// Every curve is a cubic through (0, 0) and (1, 1), so all of them evaluate
+// with the same three coefficients and no per-segment branch
+enum class Easing {
+    Linear,
+    QuadIn,
+    QuadOut,
+    SmoothStep,     // ease in and out
+    CubicIn,
+    CubicOut,
+    BackOut         // overshoots slightly before settling
+};
+
+// What a track animates on a scene node
+enum class TweenChannel {
+    X,
+    Y,
+    Width,
+    Height,
+    ScaleX
+};
+
+// A keyframe. Times are seconds from the start of the track; the easing
+// shapes the segment that ends at this key.
+struct TweenKey {
+    float time;
+    float value;
+    Easing easing;
+};
+
+struct TweenStats {
+    uint32_t animations;        // running or waiting on a delay
+    uint32_t segments;          // keyframe segments in the pool
+    uint32_t evaluated;         // segments evaluated by the last update
+    uint32_t completed;         // animations finished or cancelled
+    double updateMicroseconds;  // last update, including writing the scene
+};
+
+// Keyframe animation of scene nodes, evaluated natively each frame so Java
+// only starts, cancels and polls animations. Each pair of adjacent keys is a
+// segment; segments of every animation live together in parallel arrays and
+// are evaluated in straight loops the compiler vectorizes, then written to
+// the scene graph, which redraws only what moved.
+//
+// The newest animation on a node channel wins: when one of its segments
+// starts, older animations' segments on that channel are dropped.
+class TweenEngine {
+public:
+    // As the first key's value: start from wherever the channel is when the
+    // track begins, after its delay
+    static constexpr float CURRENT = std::numeric_limits<float>::quiet_NaN();
+
+    TweenEngine();
+    ~TweenEngine();
+
+    // Animation 0 starts a new animation; otherwise the track joins a running
+    // one. Returns the animation id, or 0 when the animation has ended or the
+    // keys are unusable. Ids are never reused. Needs at least two keys, times
+    // ascending.
+    int addTrack(int animation, int node, TweenChannel channel, const TweenKey* keys,
+                 size_t keyCount, float delay);
+    // Turns the card over after the given time, e.g. halfway through a flip
+    int addCardChange(int animation, int node, float time, int cardId, bool faceUp);
+
+    // With finish, the animation's nodes jump to their final values first
+    void cancel(int animation, bool finish, SceneGraph& scene);
+    void clear();
+
+    bool isActive(int animation) const { return mLive.count(animation) != 0; }
+    bool isAnimating() const { return !mLive.empty(); }
+
+    // Advances every animation and writes the results to the scene
+    void update(float deltaTime, SceneGraph& scene);
+
+    TweenStats getStats() const;
+
+private:
+    struct SegmentInfo {
+        int animation;
+        int node;
+        TweenChannel channel;
+        bool captureFrom;       // from is CURRENT, read when the segment starts
+        bool started;
+        bool finishing;         // last segment of its track
+        bool removed;
+    };
+
+    struct CardChange {
+        int animation;
+        int node;
+        float time;
+        int cardId;
+        bool faceUp;
+    };
+
+    int resolveAnimation(int animation);
+    void addSegment(int animation, int node, TweenChannel channel, float start, float duration,
+                    float from, float to, Easing easing, bool captureFrom, bool finishing);
+    void startSegment(size_t index, SceneGraph& scene);
+    void removeSegment(size_t index);
+    void release(int animation);
+    void apply(size_t index, float value, SceneGraph& scene);
+
+    static float readChannel(SceneGraph& scene, int node, TweenChannel channel, float fallback);
+
+    // Segment pool, one entry per array; removal swaps the last entry in
+    using FloatPool = TrackedVector<float, MemoryTag::Animation>;
+    FloatPool mStart;
+    FloatPool mInvDuration;
+    FloatPool mFrom;
+    FloatPool mDelta;
+    FloatPool mCurveA;
+    FloatPool mCurveB;
+    FloatPool mCurveC;
+    FloatPool mProgress;                // scratch: 0..1 this update
+    FloatPool mValue;                   // scratch: eased value this update
+    TrackedVector<SegmentInfo, MemoryTag::Animation> mInfo;
+
+    TrackedVector<CardChange, MemoryTag::Animation> mCardChanges;
+    // Segments plus card changes left, by animation
+    TrackedMap<int, uint32_t, MemoryTag::Animation> mLive;
+
+    // Seconds since the pool was last empty; kept small for float precision
+    float mClock = 0.0f;
+    int mNextId = 1;
+    uint32_t mEvaluated = 0;
+    uint32_t mCompleted = 0;
+    double mUpdateMicroseconds = 0.0;
+};
+
+} // namespace graphics
+} // namespace trashapp
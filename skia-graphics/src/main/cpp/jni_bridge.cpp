@@ -1,12 +1,16 @@
-#include &lt;jni.h&gt;
-#include &lt;android/log.h&gt;
-#include &quot;GraphicsEngine.h&quot;
+#include <jni.h>
+#include <android/log.h>
+#include <android/native_window_jni.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "GraphicsEngine.h"
 
-#define TAG &quot;GraphicsJNI&quot;
+#define TAG "GraphicsJNI"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
 
-extern &quot;C&quot; {
+extern "C" {
 
 JNIEXPORT void JNICALL
 Java_com_trashapp_skia_GraphicsEngine_nativeInitialize(
@@ -14,18 +18,20 @@ Java_com_trashapp_skia_GraphicsEngine_nativeInitialize(
     jobject thiz,
     jint width,
     jint height,
-    jint msaaSamples
+    jint msaaSamples,
+    jboolean enableVSync
 ) {
     try {
         trashapp::graphics::GraphicsConfig config;
         config.width = width;
         config.height = height;
-        config.enableVSync = true;
+        config.enableVSync = enableVSync == JNI_TRUE;
         config.msaaSamples = msaaSamples;
+        config.offscreen = false;
         
         trashapp::graphics::GraphicsEngine::getInstance().initialize(config);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeInitialize: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeInitialize: %s", e.what());
     }
 }
 
@@ -38,20 +44,80 @@ Java_com_trashapp_skia_GraphicsEngine_nativeResize(
 ) {
     try {
         trashapp::graphics::GraphicsEngine::getInstance().resize(width, height);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeResize: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeResize: %s", e.what());
     }
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSurfaceCreated(
+    JNIEnv* env,
+    jobject thiz,
+    jobject surface
+) {
+    try {
+        ANativeWindow* window = ANativeWindow_fromSurface(env, surface);
+        if (window == nullptr) {
+            LOGE("nativeSurfaceCreated: no native window for surface");
+            return JNI_FALSE;
+        }
+        // The renderer holds its own reference
+        bool attached = trashapp::graphics::GraphicsEngine::getInstance().attachWindow(window);
+        ANativeWindow_release(window);
+        return attached ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSurfaceCreated: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSurfaceDestroyed(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().detachWindow();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSurfaceDestroyed: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetSurfaceStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getSurfaceStats();
+        jdouble values[5] = {
+            static_cast<jdouble>(stats.windowAttachCount),
+            static_cast<jdouble>(stats.contextLossCount),
+            stats.firstFrameMilliseconds,
+            stats.contextRestoreMilliseconds,
+            stats.hasWindow ? 1.0 : 0.0
+        };
+        jdoubleArray result = env->NewDoubleArray(5);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 5, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetSurfaceStats: %s", e.what());
+    }
+    return nullptr;
+}
+
 JNIEXPORT void JNICALL
 Java_com_trashapp_skia_GraphicsEngine_nativeRender(
     JNIEnv* env,
     jobject thiz
 ) {
     try {
+        PROFILE_SCOPE("jni.render");
         trashapp::graphics::GraphicsEngine::getInstance().render();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeRender: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRender: %s", e.what());
     }
 }
 
@@ -66,8 +132,8 @@ Java_com_trashapp_skia_GraphicsEngine_nativeClearScreen(
 ) {
     try {
         trashapp::graphics::GraphicsEngine::getInstance().clearScreen(r, g, b, a);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeClearScreen: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeClearScreen: %s", e.what());
     }
 }
 
@@ -84,17 +150,18 @@ Java_com_trashapp_skia_GraphicsEngine_nativeRenderCard(
     jboolean faceUp
 ) {
     try {
-        const char* suitChars = env-&gt;GetStringUTFChars(suit, nullptr);
-        const char* rankChars = env-&gt;GetStringUTFChars(rank, nullptr);
+        PROFILE_SCOPE("jni.renderCard");
+        const char* suitChars = env->GetStringUTFChars(suit, nullptr);
+        const char* rankChars = env->GetStringUTFChars(rank, nullptr);
         
         trashapp::graphics::GraphicsEngine::getInstance().renderCard(
             x, y, width, height, suitChars, rankChars, faceUp
         );
         
-        env-&gt;ReleaseStringUTFChars(suit, suitChars);
-        env-&gt;ReleaseStringUTFChars(rank, rankChars);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeRenderCard: %s&quot;, e.what());
+        env->ReleaseStringUTFChars(suit, suitChars);
+        env->ReleaseStringUTFChars(rank, rankChars);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRenderCard: %s", e.what());
     }
 }
 
@@ -109,8 +176,411 @@ Java_com_trashapp_skia_GraphicsEngine_nativeRenderCardBack(
 ) {
     try {
         trashapp::graphics::GraphicsEngine::getInstance().renderCardBack(x, y, width, height);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeRenderCardBack: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRenderCardBack: %s", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetCardId(
+    JNIEnv* env,
+    jobject thiz,
+    jstring suit,
+    jstring rank
+) {
+    try {
+        const char* suitChars = env->GetStringUTFChars(suit, nullptr);
+        const char* rankChars = env->GetStringUTFChars(rank, nullptr);
+        
+        jint cardId = trashapp::graphics::GraphicsEngine::getInstance().getCardId(suitChars, rankChars);
+        
+        env->ReleaseStringUTFChars(suit, suitChars);
+        env->ReleaseStringUTFChars(rank, rankChars);
+        return cardId;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetCardId: %s", e.what());
+        return -1;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeRenderCardById(
+    JNIEnv* env,
+    jobject thiz,
+    jfloat x,
+    jfloat y,
+    jfloat width,
+    jfloat height,
+    jint cardId,
+    jboolean faceUp
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().renderCardById(
+            x, y, width, height, cardId, faceUp
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRenderCardById: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeRenderCards(
+    JNIEnv* env,
+    jobject thiz,
+    jobject records,
+    jint count
+) {
+    try {
+        PROFILE_SCOPE("jni.renderCards");
+        // Read in place: no copy and no per-card call
+        void* address = env->GetDirectBufferAddress(records);
+        jlong capacity = env->GetDirectBufferCapacity(records);
+        if (address == nullptr || capacity < 0) {
+            LOGE("nativeRenderCards needs a direct buffer");
+            return;
+        }
+        if (reinterpret_cast<uintptr_t>(address) % alignof(trashapp::graphics::CardRecord) != 0) {
+            LOGE("nativeRenderCards: misaligned buffer");
+            return;
+        }
+        size_t available = static_cast<size_t>(capacity) / sizeof(trashapp::graphics::CardRecord);
+        size_t cards = count > 0 ? std::min(static_cast<size_t>(count), available) : 0;
+        trashapp::graphics::GraphicsEngine::getInstance().renderCards(
+            static_cast<const trashapp::graphics::CardRecord*>(address), cards
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeRenderCards: %s", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeNeedsRender(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().needsRender();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeNeedsRender: %s", e.what());
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeCreateSceneGroup(
+    JNIEnv* env,
+    jobject thiz,
+    jint parent,
+    jfloat x,
+    jfloat y
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().createSceneGroup(parent, x, y);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeCreateSceneGroup: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeCreateSceneCard(
+    JNIEnv* env,
+    jobject thiz,
+    jint parent,
+    jfloat x,
+    jfloat y,
+    jfloat width,
+    jfloat height,
+    jint cardId,
+    jboolean faceUp
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().createSceneCard(
+            parent, x, y, width, height, cardId, faceUp
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeCreateSceneCard: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeCreateSceneEffect(
+    JNIEnv* env,
+    jobject thiz,
+    jint parent,
+    jfloat x,
+    jfloat y,
+    jint emitterHandle
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().createSceneEffect(parent, x, y, emitterHandle);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeCreateSceneEffect: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetSceneNodePosition(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jfloat x,
+    jfloat y
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setSceneNodePosition(node, x, y);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetSceneNodePosition: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetSceneNodeSize(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jfloat width,
+    jfloat height
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setSceneNodeSize(node, width, height);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetSceneNodeSize: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetSceneCard(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jint cardId,
+    jboolean faceUp
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setSceneCard(node, cardId, faceUp);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetSceneCard: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetSceneNodeVisible(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jboolean visible
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setSceneNodeVisible(node, visible);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetSceneNodeVisible: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetSceneNodeOrder(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jint order
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setSceneNodeOrder(node, order);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetSceneNodeOrder: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeDestroySceneNode(
+    JNIEnv* env,
+    jobject thiz,
+    jint node
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().destroySceneNode(node);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeDestroySceneNode: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeClearScene(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().clearScene();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeClearScene: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetSceneStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getSceneStats();
+        const int count = 7;
+        jdouble values[count] = {
+            static_cast<jdouble>(stats.nodeCount),
+            static_cast<jdouble>(stats.layerUpdates),
+            static_cast<jdouble>(stats.fullRedraws),
+            static_cast<jdouble>(stats.framesSkipped),
+            static_cast<jdouble>(stats.lastDirtyRects),
+            static_cast<jdouble>(stats.lastCardsDrawn),
+            stats.lastDirtyFraction
+        };
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetSceneStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeAnimateSceneNode(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jint channel,
+    jfloatArray keys,
+    jfloat delay
+) {
+    try {
+        if (keys == nullptr) return 0;
+        // Flat (time, value, easing) triples
+        jsize length = env->GetArrayLength(keys);
+        std::vector<jfloat> values(static_cast<size_t>(length));
+        env->GetFloatArrayRegion(keys, 0, length, values.data());
+        std::vector<trashapp::graphics::TweenKey> tweenKeys;
+        for (jsize i = 0; i + 2 < length; i += 3) {
+            tweenKeys.push_back({values[i], values[i + 1],
+                                 static_cast<trashapp::graphics::Easing>(static_cast<int>(values[i + 2]))});
+        }
+        return trashapp::graphics::GraphicsEngine::getInstance().animateSceneNode(
+            node, static_cast<trashapp::graphics::TweenChannel>(channel), tweenKeys.data(),
+            tweenKeys.size(), delay);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeAnimateSceneNode: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeMoveSceneNode(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jfloat x,
+    jfloat y,
+    jfloat duration,
+    jfloat delay,
+    jint easing
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().moveSceneNode(
+            node, x, y, duration, delay, static_cast<trashapp::graphics::Easing>(easing));
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeMoveSceneNode: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeFlipSceneCard(
+    JNIEnv* env,
+    jobject thiz,
+    jint node,
+    jint cardId,
+    jboolean faceUp,
+    jfloat duration,
+    jfloat delay
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().flipSceneCard(node, cardId, faceUp,
+                                                                              duration, delay);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeFlipSceneCard: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeCancelAnimation(
+    JNIEnv* env,
+    jobject thiz,
+    jint animation,
+    jboolean finish
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().cancelAnimation(animation, finish);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeCancelAnimation: %s", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeIsAnimationActive(
+    JNIEnv* env,
+    jobject thiz,
+    jint animation
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().isAnimationActive(animation);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeIsAnimationActive: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetAnimationStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getAnimationStats();
+        const int count = 5;
+        jdouble values[count] = {
+            static_cast<jdouble>(stats.animations),
+            static_cast<jdouble>(stats.segments),
+            static_cast<jdouble>(stats.evaluated),
+            static_cast<jdouble>(stats.completed),
+            stats.updateMicroseconds
+        };
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetAnimationStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetCacheDirectory(
+    JNIEnv* env,
+    jobject thiz,
+    jstring path
+) {
+    try {
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        trashapp::graphics::GraphicsEngine::getInstance().setCacheDirectory(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetCacheDirectory: %s", e.what());
     }
 }
 
@@ -123,14 +593,71 @@ Java_com_trashapp_skia_GraphicsEngine_nativeAddParticleEffect(
     jfloat y
 ) {
     try {
-        const char* effectTypeChars = env-&gt;GetStringUTFChars(effectType, nullptr);
+        const char* effectTypeChars = env->GetStringUTFChars(effectType, nullptr);
         trashapp::graphics::GraphicsEngine::getInstance().addParticleEffect(effectTypeChars, x, y);
-        env-&gt;ReleaseStringUTFChars(effectType, effectTypeChars);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeAddParticleEffect: %s&quot;, e.what());
+        env->ReleaseStringUTFChars(effectType, effectTypeChars);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeAddParticleEffect: %s", e.what());
+    }
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetNextPresentTimeNanos(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        return static_cast<jlong>(trashapp::graphics::GraphicsEngine::getInstance().getNextPresentTimeNanos());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetNextPresentTimeNanos: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeAddParticleEffectAt(
+    JNIEnv* env,
+    jobject thiz,
+    jstring effectType,
+    jfloat x,
+    jfloat y,
+    jlong presentTimeNanos
+) {
+    try {
+        const char* effectTypeChars = env->GetStringUTFChars(effectType, nullptr);
+        trashapp::graphics::GraphicsEngine::getInstance().addParticleEffectAt(effectTypeChars, x, y,
+                                                                               presentTimeNanos);
+        env->ReleaseStringUTFChars(effectType, effectTypeChars);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeAddParticleEffectAt: %s", e.what());
     }
 }
 
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetSyncStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getSyncStats();
+        jdouble values[5] = {
+            stats.presentLatencyMilliseconds,
+            static_cast<jdouble>(stats.pendingEffects),
+            static_cast<jdouble>(stats.scheduledEffects),
+            static_cast<jdouble>(stats.lateEffects),
+            stats.averageErrorMilliseconds
+        };
+        jdoubleArray result = env->NewDoubleArray(5);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 5, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetSyncStats: %s", e.what());
+    }
+    return nullptr;
+}
+
 JNIEXPORT void JNICALL
 Java_com_trashapp_skia_GraphicsEngine_nativeUpdateParticles(
     JNIEnv* env,
@@ -138,48 +665,793 @@ Java_com_trashapp_skia_GraphicsEngine_nativeUpdateParticles(
     jfloat deltaTime
 ) {
     try {
+        PROFILE_SCOPE("jni.updateParticles");
         trashapp::graphics::GraphicsEngine::getInstance().updateParticles(deltaTime);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeUpdateParticles: %s&quot;, e.what());
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeUpdateParticles: %s", e.what());
     }
 }
 
-JNIEXPORT void JNICALL
-Java_com_trashapp_skia_GraphicsEngine_nativeSetWildWestTheme(
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeLoadParticleEmitters(
     JNIEnv* env,
-    jobject thiz
+    jobject thiz,
+    jstring json
 ) {
     try {
-        trashapp::graphics::GraphicsEngine::getInstance().setWildWestTheme();
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeSetWildWestTheme: %s&quot;, e.what());
+        const char* jsonChars = env->GetStringUTFChars(json, nullptr);
+        jsize length = env->GetStringUTFLength(json);
+        bool loaded = trashapp::graphics::GraphicsEngine::getInstance().loadParticleEmitters(
+            jsonChars, static_cast<size_t>(length)
+        );
+        env->ReleaseStringUTFChars(json, jsonChars);
+        return loaded ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeLoadParticleEmitters: %s", e.what());
     }
+    return JNI_FALSE;
 }
 
-JNIEXPORT void JNICALL
-Java_com_trashapp_skia_GraphicsEngine_nativeEnableWoodGrainEffect(
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeFindParticleEmitter(
     JNIEnv* env,
     jobject thiz,
-    jboolean enable
+    jstring name
 ) {
     try {
-        trashapp::graphics::GraphicsEngine::getInstance().enableWoodGrainEffect(enable);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeEnableWoodGrainEffect: %s&quot;, e.what());
+        const char* nameChars = env->GetStringUTFChars(name, nullptr);
+        int handle = trashapp::graphics::GraphicsEngine::getInstance().findParticleEmitter(nameChars);
+        env->ReleaseStringUTFChars(name, nameChars);
+        return handle;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeFindParticleEmitter: %s", e.what());
     }
+    return -1;
 }
 
 JNIEXPORT void JNICALL
-Java_com_trashapp_skia_GraphicsEngine_nativeEnableVintageEffect(
+Java_com_trashapp_skia_GraphicsEngine_nativeSpawnParticleEmitter(
     JNIEnv* env,
     jobject thiz,
-    jboolean enable
+    jint emitterHandle,
+    jfloat x,
+    jfloat y
 ) {
     try {
-        trashapp::graphics::GraphicsEngine::getInstance().enableVintageEffect(enable);
-    } catch (const std::exception&amp; e) {
-        LOGE(&quot;Exception in nativeEnableVintageEffect: %s&quot;, e.what());
+        trashapp::graphics::GraphicsEngine::getInstance().spawnParticleEmitter(emitterHandle, x, y);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSpawnParticleEmitter: %s", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeStartParticleEmitter(
+    JNIEnv* env,
+    jobject thiz,
+    jint emitterHandle,
+    jfloat x,
+    jfloat y
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().startParticleEmitter(emitterHandle, x, y);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeStartParticleEmitter: %s", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeMoveParticleEmitter(
+    JNIEnv* env,
+    jobject thiz,
+    jint emitterId,
+    jfloat x,
+    jfloat y
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().moveParticleEmitter(emitterId, x, y);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeMoveParticleEmitter: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeStopParticleEmitter(
+    JNIEnv* env,
+    jobject thiz,
+    jint emitterId
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().stopParticleEmitter(emitterId);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeStopParticleEmitter: %s", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetParticleBackend(
+    JNIEnv* env,
+    jobject thiz,
+    jint backend
+) {
+    try {
+        auto selected = backend == 1
+            ? trashapp::graphics::ParticleBackend::GpuTransformFeedback
+            : trashapp::graphics::ParticleBackend::Cpu;
+        return trashapp::graphics::GraphicsEngine::getInstance().setParticleBackend(selected)
+            ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetParticleBackend: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeValidateParticleBackend(
+    JNIEnv* env,
+    jobject thiz,
+    jint sampleCount,
+    jint steps
+) {
+    try {
+        auto result = trashapp::graphics::GraphicsEngine::getInstance().validateParticleBackend(
+            sampleCount, steps
+        );
+        return result.passed ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeValidateParticleBackend: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeLoadTexture(
+    JNIEnv* env,
+    jobject thiz,
+    jstring path
+) {
+    try {
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        jint handle = trashapp::graphics::GraphicsEngine::getInstance().loadTexture(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        return handle;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeLoadTexture: %s", e.what());
+    }
+    return trashapp::graphics::INVALID_TEXTURE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeLoadTextureFd(
+    JNIEnv* env,
+    jobject thiz,
+    jint fd,
+    jlong offset,
+    jlong length
+) {
+    try {
+        return trashapp::graphics::GraphicsEngine::getInstance().loadTextureFromFd(fd, offset, length);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeLoadTextureFd: %s", e.what());
+    }
+    return trashapp::graphics::INVALID_TEXTURE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeReleaseTexture(
+    JNIEnv* env,
+    jobject thiz,
+    jint handle
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().releaseTexture(handle);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeReleaseTexture: %s", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetTextureState(
+    JNIEnv* env,
+    jobject thiz,
+    jint handle
+) {
+    try {
+        return static_cast<jint>(trashapp::graphics::GraphicsEngine::getInstance().getTextureState(handle));
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetTextureState: %s", e.what());
+    }
+    return static_cast<jint>(trashapp::graphics::TextureState::Failed);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetTextureMemoryStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getTextureMemoryStats();
+        jlong values[6] = {
+            static_cast<jlong>(stats.residentBytes),
+            static_cast<jlong>(stats.peakResidentBytes),
+            static_cast<jlong>(stats.pendingUploadBytes),
+            static_cast<jlong>(stats.mappedBytes),
+            static_cast<jlong>(stats.textureCount),
+            static_cast<jlong>(stats.residentCount)
+        };
+        jlongArray result = env->NewLongArray(6);
+        if (result != nullptr) {
+            env->SetLongArrayRegion(result, 0, 6, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetTextureMemoryStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetTextureUploadBudget(
+    JNIEnv* env,
+    jobject thiz,
+    jint bytesPerFrame
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setTextureUploadBudget(
+            static_cast<size_t>(bytesPerFrame > 0 ? bytesPerFrame : 0)
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetTextureUploadBudget: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeDrawTexture(
+    JNIEnv* env,
+    jobject thiz,
+    jint handle,
+    jfloat x,
+    jfloat y,
+    jfloat width,
+    jfloat height,
+    jint argb,
+    jint blend,
+    jint layer
+) {
+    try {
+        auto mode = trashapp::graphics::BlendMode::Alpha;
+        if (blend >= 0 && blend <= static_cast<jint>(trashapp::graphics::BlendMode::Opaque)) {
+            mode = static_cast<trashapp::graphics::BlendMode>(blend);
+        }
+        trashapp::graphics::GraphicsEngine::getInstance().drawTexture(
+            handle, x, y, width, height, static_cast<uint32_t>(argb), mode, layer
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeDrawTexture: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetSpriteBatchStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getSpriteBatchStats();
+        const int count = 6;
+        jdouble values[count] = {
+            static_cast<jdouble>(stats.sprites),
+            static_cast<jdouble>(stats.batches),
+            static_cast<jdouble>(stats.stateChanges),
+            static_cast<jdouble>(stats.flushes),
+            static_cast<jdouble>(stats.skippedSprites),
+            static_cast<jdouble>(stats.largestBatch)
+        };
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetSpriteBatchStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeDrawText(
+    JNIEnv* env,
+    jobject thiz,
+    jstring text,
+    jfloat x,
+    jfloat y,
+    jfloat capHeight,
+    jint argb,
+    jint layer
+) {
+    try {
+        const char* textChars = env->GetStringUTFChars(text, nullptr);
+        jfloat advance = trashapp::graphics::GraphicsEngine::getInstance().drawText(
+            textChars, x, y, capHeight, static_cast<uint32_t>(argb), layer
+        );
+        env->ReleaseStringUTFChars(text, textChars);
+        return advance;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeDrawText: %s", e.what());
+    }
+    return 0.0f;
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeMeasureText(
+    JNIEnv* env,
+    jobject thiz,
+    jstring text,
+    jfloat capHeight
+) {
+    try {
+        const char* textChars = env->GetStringUTFChars(text, nullptr);
+        jfloat width = trashapp::graphics::GraphicsEngine::getInstance().measureText(textChars, capHeight);
+        env->ReleaseStringUTFChars(text, textChars);
+        return width;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeMeasureText: %s", e.what());
+    }
+    return 0.0f;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeDrawSuitPip(
+    JNIEnv* env,
+    jobject thiz,
+    jint suit,
+    jfloat x,
+    jfloat y,
+    jfloat size,
+    jint argb,
+    jint layer
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().drawSuitPip(
+            suit, x, y, size, static_cast<uint32_t>(argb), layer
+        );
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeDrawSuitPip: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetShaderCacheStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getShaderCacheStats();
+        jdouble values[6] = {
+            static_cast<jdouble>(stats.hits),
+            static_cast<jdouble>(stats.misses),
+            static_cast<jdouble>(stats.rejected),
+            stats.compileMilliseconds,
+            stats.loadMilliseconds,
+            stats.savedMilliseconds
+        };
+        jdoubleArray result = env->NewDoubleArray(6);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 6, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetShaderCacheStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeIsShaderReady(
+    JNIEnv* env,
+    jobject thiz,
+    jstring name
+) {
+    try {
+        const char* nameChars = env->GetStringUTFChars(name, nullptr);
+        bool ready = trashapp::graphics::GraphicsEngine::getInstance().isShaderReady(nameChars);
+        env->ReleaseStringUTFChars(name, nameChars);
+        return ready ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeIsShaderReady: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetStartupTiming(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto timing = trashapp::graphics::GraphicsEngine::getInstance().getStartupTiming();
+        jdouble values[7] = {
+            timing.rendererMilliseconds,
+            timing.shaderSubmitMilliseconds,
+            timing.cardRendererMilliseconds,
+            timing.textureLoaderMilliseconds,
+            timing.initializeMilliseconds,
+            timing.shadersReadyMilliseconds,
+            static_cast<jdouble>(timing.pendingShaders)
+        };
+        jdoubleArray result = env->NewDoubleArray(7);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 7, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetStartupTiming: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetVSync(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enabled
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setVSync(enabled == JNI_TRUE);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetVSync: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetTargetFrameRate(
+    JNIEnv* env,
+    jobject thiz,
+    jint framesPerSecond
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setTargetFrameRate(framesPerSecond);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetTargetFrameRate: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetDisplayRefreshRate(
+    JNIEnv* env,
+    jobject thiz,
+    jfloat hz
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setDisplayRefreshRate(hz);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetDisplayRefreshRate: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeOnVsync(
+    JNIEnv* env,
+    jobject thiz,
+    jlong frameTimeNanos
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().onVsync(frameTimeNanos);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeOnVsync: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetFrameTiming(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getFrameTiming();
+        jdouble values[13] = {
+            stats.cpuMilliseconds,
+            stats.gpuMilliseconds,
+            stats.frameIntervalMilliseconds,
+            stats.averageCpuMilliseconds,
+            stats.averageGpuMilliseconds,
+            stats.averageIntervalMilliseconds,
+            stats.vsyncPeriodMilliseconds,
+            static_cast<jdouble>(stats.targetFrameRate),
+            static_cast<jdouble>(stats.swapInterval),
+            stats.presentationTimeSupported ? 1.0 : 0.0,
+            stats.gpuTimerSupported ? 1.0 : 0.0,
+            stats.presentLatencyMilliseconds,
+            stats.presentTimestampsSupported ? 1.0 : 0.0
+        };
+        jdoubleArray result = env->NewDoubleArray(13);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 13, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetFrameTiming: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetRenderScale(
+    JNIEnv* env,
+    jobject thiz,
+    jfloat scale
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setRenderScale(scale);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetRenderScale: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetDynamicResolution(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enabled,
+    jfloat minScale
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setDynamicResolution(enabled == JNI_TRUE, minScale);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetDynamicResolution: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetViewport(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto& engine = trashapp::graphics::GraphicsEngine::getInstance();
+        auto camera = engine.getCameraState();
+        auto scale = engine.getRenderScaleStats();
+        jdouble values[15] = {
+            static_cast<jdouble>(camera.outputWidth),
+            static_cast<jdouble>(camera.outputHeight),
+            static_cast<jdouble>(camera.renderWidth),
+            static_cast<jdouble>(camera.renderHeight),
+            camera.renderScale,
+            camera.visibleLeft,
+            camera.visibleBottom,
+            camera.visibleWidth,
+            camera.visibleHeight,
+            camera.pixelsPerUnit,
+            scale.dynamic ? 1.0 : 0.0,
+            scale.minScale,
+            scale.budgetMilliseconds,
+            scale.frameMilliseconds,
+            static_cast<jdouble>(scale.scaleChanges)
+        };
+        jdoubleArray result = env->NewDoubleArray(15);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, 15, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetViewport: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetMsaaSamples(
+    JNIEnv* env,
+    jobject thiz,
+    jint samples
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setMsaaSamples(samples);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetMsaaSamples: %s", e.what());
+    }
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetMsaaStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getMsaaStats();
+        // Three header values, then six per setting (none, 2x, 4x)
+        const int settingValues = 6;
+        const int count = 3 + trashapp::graphics::MsaaStats::SETTING_COUNT * settingValues;
+        jdouble values[count];
+        values[0] = stats.requestedSamples;
+        values[1] = stats.activeSamples;
+        values[2] = stats.maxSamples;
+        for (int i = 0; i < trashapp::graphics::MsaaStats::SETTING_COUNT; i++) {
+            const auto& cost = stats.settings[i];
+            jdouble* out = values + 3 + i * settingValues;
+            out[0] = cost.supported ? 1.0 : 0.0;
+            out[1] = static_cast<jdouble>(cost.targetBytes);
+            out[2] = static_cast<jdouble>(cost.resolveBytesPerFrame);
+            out[3] = cost.averageCpuMilliseconds;
+            out[4] = cost.averageGpuMilliseconds;
+            out[5] = static_cast<jdouble>(cost.frames);
+        }
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetMsaaStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetRenderPassStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getRenderPassStats();
+        const int count = 5;
+        jdouble values[count] = {
+            static_cast<jdouble>(stats.passesPerFrame),
+            static_cast<jdouble>(stats.invalidatesPerFrame),
+            static_cast<jdouble>(stats.bytesPerFrame),
+            static_cast<jdouble>(stats.bytesSavedPerFrame),
+            static_cast<jdouble>(stats.bytesSavedTotal)
+        };
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetRenderPassStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetWildWestTheme(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setWildWestTheme();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetWildWestTheme: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeEnableWoodGrainEffect(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enable
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().enableWoodGrainEffect(enable);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeEnableWoodGrainEffect: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeEnableVintageEffect(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enable
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().enableVintageEffect(enable);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeEnableVintageEffect: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeSetProfilingEnabled(
+    JNIEnv* env,
+    jobject thiz,
+    jboolean enabled
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().setProfilingEnabled(enabled);
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeSetProfilingEnabled: %s", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeClearProfile(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        trashapp::graphics::GraphicsEngine::getInstance().clearProfile();
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeClearProfile: %s", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeExportProfile(
+    JNIEnv* env,
+    jobject thiz,
+    jstring path
+) {
+    try {
+        const char* pathChars = env->GetStringUTFChars(path, nullptr);
+        bool exported = trashapp::graphics::GraphicsEngine::getInstance().exportProfile(pathChars);
+        env->ReleaseStringUTFChars(path, pathChars);
+        return exported;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeExportProfile: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetProfilerStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getProfilerStats();
+        const int count = 7;
+        jdouble values[count] = {
+            static_cast<jdouble>(stats.threads),
+            static_cast<jdouble>(stats.cpuScopes),
+            static_cast<jdouble>(stats.gpuScopes),
+            static_cast<jdouble>(stats.overwritten),
+            static_cast<jdouble>(stats.gpuDiscarded),
+            stats.gpuTimerSupported ? 1.0 : 0.0,
+            stats.atraceEnabled ? 1.0 : 0.0
+        };
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetProfilerStats: %s", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_com_trashapp_skia_GraphicsEngine_nativeGetMemoryStats(
+    JNIEnv* env,
+    jobject thiz
+) {
+    try {
+        auto stats = trashapp::graphics::GraphicsEngine::getInstance().getMemoryStats();
+        // Bytes, peak bytes and allocations per tag, then the frame arena
+        const int tagCount = static_cast<int>(trashapp::graphics::MemoryTag::Count);
+        const int count = tagCount * 3 + 5;
+        jdouble values[count];
+        for (int tag = 0; tag < tagCount; tag++) {
+            values[tag * 3] = static_cast<jdouble>(stats.tags[tag].bytes);
+            values[tag * 3 + 1] = static_cast<jdouble>(stats.tags[tag].peakBytes);
+            values[tag * 3 + 2] = static_cast<jdouble>(stats.tags[tag].allocations);
+        }
+        jdouble* arena = values + tagCount * 3;
+        arena[0] = static_cast<jdouble>(stats.frameArena.capacityBytes);
+        arena[1] = static_cast<jdouble>(stats.frameArena.usedBytes);
+        arena[2] = static_cast<jdouble>(stats.frameArena.peakBytes);
+        arena[3] = static_cast<jdouble>(stats.frameArena.chunks);
+        arena[4] = static_cast<jdouble>(stats.frameArena.overflows);
+        jdoubleArray result = env->NewDoubleArray(count);
+        if (result != nullptr) {
+            env->SetDoubleArrayRegion(result, 0, count, values);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeGetMemoryStats: %s", e.what());
     }
+    return nullptr;
 }
 
-} // extern &quot;C&quot;
\ No newline at end of file
+} // extern "C"
\ No newline at end of file
@@ -1,16 +1,239 @@
 package com.trashapp.skia;
 
+import android.content.Context;
+import android.content.res.AssetFileDescriptor;
+import android.content.res.AssetManager;
+import android.view.Choreographer;
+import android.view.Surface;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+
 /**
  * Java wrapper for Skia Graphics Engine
  * Provides JNI bridge to native C++ graphics engine
  */
 public class GraphicsEngine {
     static {
-        System.loadLibrary(&quot;trashgraphics&quot;);
+        System.loadLibrary("trashgraphics");
     }
     
+    // Particle simulation backends, see nativeSetParticleBackend
+    public static final int PARTICLE_BACKEND_CPU = 0;
+    public static final int PARTICLE_BACKEND_GPU = 1;
+    
+    // Texture streaming states, see nativeGetTextureState
+    public static final int TEXTURE_PENDING = 0;
+    public static final int TEXTURE_READY = 1;
+    public static final int TEXTURE_UPLOADING = 2;
+    public static final int TEXTURE_RESIDENT = 3;
+    public static final int TEXTURE_FAILED = 4;
+    
+    // Indices into getTextureMemoryStats()
+    public static final int TEXTURE_STAT_RESIDENT_BYTES = 0;
+    public static final int TEXTURE_STAT_PEAK_RESIDENT_BYTES = 1;
+    public static final int TEXTURE_STAT_PENDING_UPLOAD_BYTES = 2;
+    public static final int TEXTURE_STAT_MAPPED_BYTES = 3;
+    public static final int TEXTURE_STAT_TEXTURE_COUNT = 4;
+    public static final int TEXTURE_STAT_RESIDENT_COUNT = 5;
+    
+    // Indices into getShaderCacheStats()
+    public static final int SHADER_STAT_HITS = 0;
+    public static final int SHADER_STAT_MISSES = 1;
+    public static final int SHADER_STAT_REJECTED = 2;
+    public static final int SHADER_STAT_COMPILE_MS = 3;
+    public static final int SHADER_STAT_LOAD_MS = 4;
+    public static final int SHADER_STAT_SAVED_MS = 5;
+    
+    // Indices into getStartupTiming()
+    public static final int STARTUP_RENDERER_MS = 0;
+    public static final int STARTUP_SHADER_SUBMIT_MS = 1;
+    public static final int STARTUP_CARD_RENDERER_MS = 2;
+    public static final int STARTUP_TEXTURE_LOADER_MS = 3;
+    public static final int STARTUP_INITIALIZE_MS = 4;
+    public static final int STARTUP_SHADERS_READY_MS = 5;
+    public static final int STARTUP_PENDING_SHADERS = 6;
+    
+    // Indices into getFrameTiming()
+    public static final int FRAME_CPU_MS = 0;
+    public static final int FRAME_GPU_MS = 1;
+    public static final int FRAME_INTERVAL_MS = 2;
+    public static final int FRAME_AVERAGE_CPU_MS = 3;
+    public static final int FRAME_AVERAGE_GPU_MS = 4;
+    public static final int FRAME_AVERAGE_INTERVAL_MS = 5;
+    public static final int FRAME_VSYNC_PERIOD_MS = 6;
+    public static final int FRAME_TARGET_RATE = 7;
+    public static final int FRAME_SWAP_INTERVAL = 8;
+    public static final int FRAME_PRESENTATION_TIME_SUPPORTED = 9;
+    public static final int FRAME_GPU_TIMER_SUPPORTED = 10;
+    public static final int FRAME_PRESENT_LATENCY_MS = 11;
+    public static final int FRAME_PRESENT_TIMESTAMPS_SUPPORTED = 12;
+    
+    // Indices into getSurfaceStats()
+    public static final int SURFACE_ATTACH_COUNT = 0;
+    public static final int SURFACE_CONTEXT_LOSS_COUNT = 1;
+    public static final int SURFACE_FIRST_FRAME_MS = 2;
+    public static final int SURFACE_CONTEXT_RESTORE_MS = 3;
+    public static final int SURFACE_HAS_WINDOW = 4;
+    
+    // Indices into getViewport(); the visible area is in 1920x1080 layout units
+    public static final int VIEWPORT_OUTPUT_WIDTH = 0;
+    public static final int VIEWPORT_OUTPUT_HEIGHT = 1;
+    public static final int VIEWPORT_RENDER_WIDTH = 2;
+    public static final int VIEWPORT_RENDER_HEIGHT = 3;
+    public static final int VIEWPORT_RENDER_SCALE = 4;
+    public static final int VIEWPORT_VISIBLE_LEFT = 5;
+    public static final int VIEWPORT_VISIBLE_BOTTOM = 6;
+    public static final int VIEWPORT_VISIBLE_WIDTH = 7;
+    public static final int VIEWPORT_VISIBLE_HEIGHT = 8;
+    public static final int VIEWPORT_PIXELS_PER_UNIT = 9;
+    public static final int VIEWPORT_DYNAMIC = 10;
+    public static final int VIEWPORT_MIN_SCALE = 11;
+    public static final int VIEWPORT_BUDGET_MS = 12;
+    public static final int VIEWPORT_FRAME_MS = 13;
+    public static final int VIEWPORT_SCALE_CHANGES = 14;
+    
+    // Indices into getMsaaStats(), followed by one block per setting
+    public static final int MSAA_REQUESTED_SAMPLES = 0;
+    public static final int MSAA_ACTIVE_SAMPLES = 1;
+    public static final int MSAA_MAX_SAMPLES = 2;
+    
+    // Offsets into the blocks returned by getMsaaCost()
+    public static final int MSAA_COST_SUPPORTED = 0;
+    public static final int MSAA_COST_TARGET_BYTES = 1;
+    public static final int MSAA_COST_RESOLVE_BYTES = 2;
+    public static final int MSAA_COST_CPU_MS = 3;
+    public static final int MSAA_COST_GPU_MS = 4;
+    public static final int MSAA_COST_FRAMES = 5;
+    
+    private static final int MSAA_HEADER_SIZE = 3;
+    private static final int MSAA_COST_SIZE = 6;
+    
+    // Indices into getRenderPassStats(); byte counts are estimates
+    public static final int RENDER_PASS_COUNT = 0;
+    public static final int RENDER_PASS_INVALIDATES = 1;
+    public static final int RENDER_PASS_BYTES = 2;
+    public static final int RENDER_PASS_BYTES_SAVED = 3;
+    public static final int RENDER_PASS_BYTES_SAVED_TOTAL = 4;
+    
+    // Parent for top-level scene nodes
+    public static final int SCENE_ROOT = 0;
+    
+    // Indices into getSceneStats()
+    public static final int SCENE_STAT_NODES = 0;
+    public static final int SCENE_STAT_LAYER_UPDATES = 1;
+    public static final int SCENE_STAT_FULL_REDRAWS = 2;
+    public static final int SCENE_STAT_FRAMES_SKIPPED = 3;
+    public static final int SCENE_STAT_LAST_DIRTY_RECTS = 4;
+    public static final int SCENE_STAT_LAST_CARDS_DRAWN = 5;
+    public static final int SCENE_STAT_LAST_DIRTY_FRACTION = 6;
+    
+    // Easing curves for scene animations
+    public static final int EASE_LINEAR = 0;
+    public static final int EASE_QUAD_IN = 1;
+    public static final int EASE_QUAD_OUT = 2;
+    public static final int EASE_SMOOTH_STEP = 3;
+    public static final int EASE_CUBIC_IN = 4;
+    public static final int EASE_CUBIC_OUT = 5;
+    public static final int EASE_BACK_OUT = 6;
+    
+    // Scene node properties animateSceneNode can drive
+    public static final int CHANNEL_X = 0;
+    public static final int CHANNEL_Y = 1;
+    public static final int CHANNEL_WIDTH = 2;
+    public static final int CHANNEL_HEIGHT = 3;
+    public static final int CHANNEL_SCALE_X = 4;
+    
+    // As a key value: start from the node's value when the animation begins
+    public static final float FROM_CURRENT = Float.NaN;
+    
+    // Indices into getAnimationStats()
+    public static final int ANIMATION_STAT_ACTIVE = 0;
+    public static final int ANIMATION_STAT_SEGMENTS = 1;
+    public static final int ANIMATION_STAT_EVALUATED = 2;
+    public static final int ANIMATION_STAT_COMPLETED = 3;
+    public static final int ANIMATION_STAT_UPDATE_MICROSECONDS = 4;
+    
+    // Indices into getSyncStats()
+    public static final int SYNC_PRESENT_LATENCY_MS = 0;
+    public static final int SYNC_PENDING_EFFECTS = 1;
+    public static final int SYNC_SCHEDULED_EFFECTS = 2;
+    public static final int SYNC_LATE_EFFECTS = 3;
+    public static final int SYNC_AVERAGE_ERROR_MS = 4;
+    
+    // Blend modes for drawTexture
+    public static final int BLEND_ALPHA = 0;
+    public static final int BLEND_PREMULTIPLIED = 1;
+    public static final int BLEND_ADDITIVE = 2;
+    public static final int BLEND_OPAQUE = 3;
+    
+    // Sprite layers used by the engine; higher layers cover lower ones
+    public static final int LAYER_TABLE = 0;
+    public static final int LAYER_EFFECTS = 100;
+    public static final int LAYER_UI = 200;
+    
+    // Indices into getSpriteBatchStats()
+    public static final int SPRITE_STAT_SPRITES = 0;
+    public static final int SPRITE_STAT_BATCHES = 1;
+    public static final int SPRITE_STAT_STATE_CHANGES = 2;
+    public static final int SPRITE_STAT_FLUSHES = 3;
+    public static final int SPRITE_STAT_SKIPPED = 4;
+    public static final int SPRITE_STAT_LARGEST_BATCH = 5;
+    
+    // Indices into benchmarkCardSubmission(): microseconds per frame
+    public static final int CARD_SUBMIT_BY_NAME = 0;
+    public static final int CARD_SUBMIT_BY_ID = 1;
+    public static final int CARD_SUBMIT_BATCH = 2;
+    
+    // Indices into getProfilerStats()
+    public static final int PROFILER_STAT_THREADS = 0;
+    public static final int PROFILER_STAT_CPU_SCOPES = 1;
+    public static final int PROFILER_STAT_GPU_SCOPES = 2;
+    public static final int PROFILER_STAT_OVERWRITTEN = 3;
+    public static final int PROFILER_STAT_GPU_DISCARDED = 4;
+    public static final int PROFILER_STAT_GPU_TIMER = 5;      // 1 when supported
+    public static final int PROFILER_STAT_ATRACE = 6;         // 1 while a system trace captures
+    
+    // getMemoryStats(): MEMORY_STATS_PER_TAG values per tag, at
+    // tag * MEMORY_STATS_PER_TAG + MEMORY_STAT_*, then the frame arena
+    public static final int MEMORY_TAG_PARTICLES = 0;
+    public static final int MEMORY_TAG_SPRITES = 1;
+    public static final int MEMORY_TAG_SCENE = 2;
+    public static final int MEMORY_TAG_ANIMATION = 3;
+    public static final int MEMORY_TAG_FRAME_ARENA = 4;
+    public static final int MEMORY_TAG_COUNT = 5;
+    public static final int MEMORY_STAT_BYTES = 0;
+    public static final int MEMORY_STAT_PEAK_BYTES = 1;
+    public static final int MEMORY_STAT_ALLOCATIONS = 2;      // since launch; flat once warm
+    public static final int MEMORY_STATS_PER_TAG = 3;
+    public static final int MEMORY_ARENA_CAPACITY = MEMORY_TAG_COUNT * MEMORY_STATS_PER_TAG;
+    public static final int MEMORY_ARENA_USED = MEMORY_ARENA_CAPACITY + 1;
+    public static final int MEMORY_ARENA_PEAK = MEMORY_ARENA_CAPACITY + 2;
+    public static final int MEMORY_ARENA_CHUNKS = MEMORY_ARENA_CAPACITY + 3;
+    public static final int MEMORY_ARENA_OVERFLOWS = MEMORY_ARENA_CAPACITY + 4;
+    
+    private static final String[] BENCHMARK_SUITS = { "HEARTS", "SPADES", "DIAMONDS", "CLUBS" };
+    private static final String[] BENCHMARK_RANKS = {
+        "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K"
+    };
+    
     private static GraphicsEngine instance;
     
+    private final Choreographer.FrameCallback vsyncCallback = new Choreographer.FrameCallback() {
+        @Override
+        public void doFrame(long frameTimeNanos) {
+            if (!vsyncTracking) return;
+            nativeOnVsync(frameTimeNanos);
+            Choreographer.getInstance().postFrameCallback(this);
+        }
+    };
+    private volatile boolean vsyncTracking = false;
+    
     private GraphicsEngine() {}
     
     public static synchronized GraphicsEngine getInstance() {
@@ -21,19 +244,104 @@ public class GraphicsEngine {
     }
     
     // Lifecycle methods
-    public native void nativeInitialize(int width, int height, int msaaSamples);
+    public native void nativeInitialize(int width, int height, int msaaSamples, boolean enableVSync);
     public native void nativeResize(int width, int height);
+    public native boolean nativeSurfaceCreated(Surface surface);
+    public native void nativeSurfaceDestroyed();
+    public native double[] nativeGetSurfaceStats();
     public native void nativeRender();
+    public native boolean nativeNeedsRender();
     public native void nativeClearScreen(float r, float g, float b, float a);
+    public native void nativeSetCacheDirectory(String path);
+    
+    // Frame pacing
+    public native void nativeSetVSync(boolean enabled);
+    public native void nativeSetTargetFrameRate(int framesPerSecond);
+    public native void nativeSetDisplayRefreshRate(float hz);
+    public native void nativeOnVsync(long frameTimeNanos);
+    public native double[] nativeGetFrameTiming();
+    
+    // Resolution
+    public native void nativeSetRenderScale(float scale);
+    public native void nativeSetDynamicResolution(boolean enabled, float minScale);
+    public native double[] nativeGetViewport();
+    public native void nativeSetMsaaSamples(int samples);
+    public native double[] nativeGetMsaaStats();
+    public native double[] nativeGetRenderPassStats();
     
     // Card rendering
     public native void nativeRenderCard(float x, float y, float width, float height,
                                         String suit, String rank, boolean faceUp);
     public native void nativeRenderCardBack(float x, float y, float width, float height);
+    public native int nativeGetCardId(String suit, String rank);
+    public native void nativeRenderCards(ByteBuffer records, int count);
+    public native void nativeRenderCardById(float x, float y, float width, float height,
+                                            int cardId, boolean faceUp);
+    
+    // Retained scene
+    public native int nativeCreateSceneGroup(int parent, float x, float y);
+    public native int nativeCreateSceneCard(int parent, float x, float y, float width, float height,
+                                            int cardId, boolean faceUp);
+    public native int nativeCreateSceneEffect(int parent, float x, float y, int emitterHandle);
+    public native void nativeSetSceneNodePosition(int node, float x, float y);
+    public native void nativeSetSceneNodeSize(int node, float width, float height);
+    public native void nativeSetSceneCard(int node, int cardId, boolean faceUp);
+    public native void nativeSetSceneNodeVisible(int node, boolean visible);
+    public native void nativeSetSceneNodeOrder(int node, int order);
+    public native void nativeDestroySceneNode(int node);
+    public native void nativeClearScene();
+    public native double[] nativeGetSceneStats();
+    public native int nativeAnimateSceneNode(int node, int channel, float[] keys, float delay);
+    public native int nativeMoveSceneNode(int node, float x, float y, float duration, float delay,
+                                          int easing);
+    public native int nativeFlipSceneCard(int node, int cardId, boolean faceUp, float duration,
+                                          float delay);
+    public native void nativeCancelAnimation(int animation, boolean finish);
+    public native boolean nativeIsAnimationActive(int animation);
+    public native double[] nativeGetAnimationStats();
     
     // Particle effects
     public native void nativeAddParticleEffect(String effectType, float x, float y);
+    public native long nativeGetNextPresentTimeNanos();
+    public native void nativeAddParticleEffectAt(String effectType, float x, float y, long presentTimeNanos);
+    public native double[] nativeGetSyncStats();
     public native void nativeUpdateParticles(float deltaTime);
+    public native boolean nativeLoadParticleEmitters(String json);
+    public native int nativeFindParticleEmitter(String name);
+    public native void nativeSpawnParticleEmitter(int emitterHandle, float x, float y);
+    public native int nativeStartParticleEmitter(int emitterHandle, float x, float y);
+    public native void nativeMoveParticleEmitter(int emitterId, float x, float y);
+    public native void nativeStopParticleEmitter(int emitterId);
+    public native boolean nativeSetParticleBackend(int backend);
+    public native boolean nativeValidateParticleBackend(int sampleCount, int steps);
+    
+    // Compressed textures
+    public native int nativeLoadTexture(String path);
+    public native int nativeLoadTextureFd(int fd, long offset, long length);
+    public native void nativeReleaseTexture(int handle);
+    public native int nativeGetTextureState(int handle);
+    public native long[] nativeGetTextureMemoryStats();
+    public native void nativeSetTextureUploadBudget(int bytesPerFrame);
+    public native void nativeDrawTexture(int handle, float x, float y, float width, float height,
+                                         int argb, int blend, int layer);
+    public native double[] nativeGetSpriteBatchStats();
+    
+    // Distance field text
+    public native float nativeDrawText(String text, float x, float y, float capHeight, int argb, int layer);
+    public native float nativeMeasureText(String text, float capHeight);
+    public native void nativeDrawSuitPip(int suit, float x, float y, float size, int argb, int layer);
+    
+    // Shader program cache
+    public native double[] nativeGetShaderCacheStats();
+    public native boolean nativeIsShaderReady(String name);
+    public native double[] nativeGetStartupTiming();
+    
+    // Frame profiler
+    public native void nativeSetProfilingEnabled(boolean enabled);
+    public native void nativeClearProfile();
+    public native boolean nativeExportProfile(String path);
+    public native double[] nativeGetProfilerStats();
+    public native double[] nativeGetMemoryStats();
     
     // Wild West theme
     public native void nativeSetWildWestTheme();
@@ -46,17 +354,42 @@ public class GraphicsEngine {
     }
     
     public void initialize(int width, int height, int msaaSamples) {
-        nativeInitialize(width, height, msaaSamples);
+        initialize(width, height, msaaSamples, true);
+    }
+    
+    public void initialize(int width, int height, int msaaSamples, boolean enableVSync) {
+        nativeInitialize(width, height, msaaSamples, enableVSync);
+    }
+    
+    /**
+     * Stores generated assets (the card atlas) in the app cache directory.
+     * Call before initialize() so the atlas is not rebuilt on every launch.
+     */
+    public void setCacheDirectory(Context context) {
+        nativeSetCacheDirectory(context.getCacheDir().getAbsolutePath());
     }
     
     public void resize(int width, int height) {
         nativeResize(width, height);
     }
     
+    /**
+     * Draws and presents a frame. With a retained scene the frame is skipped
+     * when nothing changed and no particles are alive.
+     */
     public void render() {
         nativeRender();
     }
     
+    /**
+     * False while the last frame is still on screen. Render-on-demand loops
+     * (libGDX non-continuous rendering) can stop requesting frames until
+     * the scene changes again.
+     */
+    public boolean needsRender() {
+        return nativeNeedsRender();
+    }
+    
     public void clearScreen(float r, float g, float b, float a) {
         nativeClearScreen(r, g, b, a);
     }
@@ -70,14 +403,519 @@ public class GraphicsEngine {
         nativeRenderCardBack(x, y, width, height);
     }
     
+    /**
+     * Atlas id for a card, or -1 if unknown. Resolve once per card and draw
+     * with renderCardById to skip string marshalling every frame.
+     */
+    public int getCardId(String suit, String rank) {
+        return nativeGetCardId(suit, rank);
+    }
+    
+    public void renderCardById(float x, float y, float width, float height,
+                               int cardId, boolean faceUp) {
+        nativeRenderCardById(x, y, width, height, cardId, faceUp);
+    }
+    
+    /**
+     * Draws every card in the batch with one JNI call; native code reads the
+     * records in place. Refill and reuse the same batch each frame.
+     */
+    public void renderCards(CardBatch batch) {
+        nativeRenderCards(batch.buffer, batch.count);
+    }
+    
+    /**
+     * Times submitting cardsPerFrame cards through renderCard (names),
+     * renderCardById and renderCards, rendering a frame after each so the
+     * queue stays one frame deep. Only the submission is timed. Call on the
+     * render thread with a window attached; indexed by CARD_SUBMIT_*.
+     */
+    public double[] benchmarkCardSubmission(int cardsPerFrame, int frames) {
+        String[] suits = new String[cardsPerFrame];
+        String[] ranks = new String[cardsPerFrame];
+        int[] ids = new int[cardsPerFrame];
+        for (int i = 0; i < cardsPerFrame; i++) {
+            suits[i] = BENCHMARK_SUITS[i % BENCHMARK_SUITS.length];
+            ranks[i] = BENCHMARK_RANKS[i % BENCHMARK_RANKS.length];
+            ids[i] = getCardId(suits[i], ranks[i]);
+        }
+        CardBatch batch = new CardBatch(cardsPerFrame);
+        
+        long[] totals = new long[3];
+        for (int frame = 0; frame < frames; frame++) {
+            long start = System.nanoTime();
+            for (int i = 0; i < cardsPerFrame; i++) {
+                nativeRenderCard(benchmarkX(i), benchmarkY(i), 90.0f, 126.0f, suits[i], ranks[i], true);
+            }
+            totals[CARD_SUBMIT_BY_NAME] += System.nanoTime() - start;
+            nativeRender();
+            
+            start = System.nanoTime();
+            for (int i = 0; i < cardsPerFrame; i++) {
+                nativeRenderCardById(benchmarkX(i), benchmarkY(i), 90.0f, 126.0f, ids[i], true);
+            }
+            totals[CARD_SUBMIT_BY_ID] += System.nanoTime() - start;
+            nativeRender();
+            
+            start = System.nanoTime();
+            batch.clear();
+            for (int i = 0; i < cardsPerFrame; i++) {
+                batch.add(benchmarkX(i), benchmarkY(i), 90.0f, 126.0f, ids[i], true);
+            }
+            renderCards(batch);
+            totals[CARD_SUBMIT_BATCH] += System.nanoTime() - start;
+            nativeRender();
+        }
+        
+        double[] microseconds = new double[3];
+        for (int i = 0; i < 3; i++) {
+            microseconds[i] = frames > 0 ? totals[i] / 1000.0 / frames : 0.0;
+        }
+        return microseconds;
+    }
+    
+    private static float benchmarkX(int i) {
+        return 40.0f + (i % 18) * 100.0f;
+    }
+    
+    private static float benchmarkY(int i) {
+        return 40.0f + (i / 18 % 7) * 140.0f;
+    }
+    
+    /**
+     * Retained scene: create nodes once and send only what changes. Cards
+     * are redrawn only where something moved, flipped or was removed.
+     * Positions are layout units (1920x1080, y up) relative to the parent;
+     * pass SCENE_ROOT for top-level nodes. Returns 0 if the parent is gone.
+     */
+    public int createSceneGroup(int parent, float x, float y) {
+        return nativeCreateSceneGroup(parent, x, y);
+    }
+    
+    public int createSceneCard(int parent, float x, float y, float width, float height,
+                               int cardId, boolean faceUp) {
+        return nativeCreateSceneCard(parent, x, y, width, height, cardId, faceUp);
+    }
+    
+    /** Starts the emitter at the node; it follows the node until destroyed */
+    public int createSceneEffect(int parent, float x, float y, int emitterHandle) {
+        return nativeCreateSceneEffect(parent, x, y, emitterHandle);
+    }
+    
+    public void setSceneNodePosition(int node, float x, float y) {
+        nativeSetSceneNodePosition(node, x, y);
+    }
+    
+    public void setSceneNodeSize(int node, float width, float height) {
+        nativeSetSceneNodeSize(node, width, height);
+    }
+    
+    public void setSceneCard(int node, int cardId, boolean faceUp) {
+        nativeSetSceneCard(node, cardId, faceUp);
+    }
+    
+    public void setSceneNodeVisible(int node, boolean visible) {
+        nativeSetSceneNodeVisible(node, visible);
+    }
+    
+    /** Siblings draw in ascending order, then in creation order */
+    public void setSceneNodeOrder(int node, int order) {
+        nativeSetSceneNodeOrder(node, order);
+    }
+    
+    /** Also destroys the node's children and stops their emitters */
+    public void destroySceneNode(int node) {
+        nativeDestroySceneNode(node);
+    }
+    
+    public void clearScene() {
+        nativeClearScene();
+    }
+    
+    /** Indexed by the SCENE_STAT_* constants */
+    public double[] getSceneStats() {
+        return nativeGetSceneStats();
+    }
+    
+    /**
+     * Animates one property of a scene node natively, frame by frame.
+     * keys holds (time, value, easing) triples: times in seconds from the
+     * start, ascending; each EASE_* shapes the segment ending at its key.
+     * The first value may be FROM_CURRENT. A newer animation of the same
+     * property takes over from an older one. Returns an animation id, or 0.
+     */
+    public int animateSceneNode(int node, int channel, float[] keys, float delay) {
+        return nativeAnimateSceneNode(node, channel, keys, delay);
+    }
+    
+    /** Slides a node from where it is to (x, y); one id covers both axes */
+    public int moveSceneNode(int node, float x, float y, float duration, float delay, int easing) {
+        return nativeMoveSceneNode(node, x, y, duration, delay, easing);
+    }
+    
+    /** Turns a card over, showing cardId/faceUp from the halfway point */
+    public int flipSceneCard(int node, int cardId, boolean faceUp, float duration, float delay) {
+        return nativeFlipSceneCard(node, cardId, faceUp, duration, delay);
+    }
+    
+    /** Stops an animation where it is, or with finish at its end state */
+    public void cancelAnimation(int animation, boolean finish) {
+        nativeCancelAnimation(animation, finish);
+    }
+    
+    /** False once the animation has finished or was cancelled or taken over */
+    public boolean isAnimationActive(int animation) {
+        return nativeIsAnimationActive(animation);
+    }
+    
+    /** Indexed by the ANIMATION_STAT_* constants */
+    public double[] getAnimationStats() {
+        return nativeGetAnimationStats();
+    }
+    
     public void addParticleEffect(String effectType, float x, float y) {
         nativeAddParticleEffect(effectType, x, y);
     }
     
+    /**
+     * When a visual requested now can first be on screen, on the
+     * System.nanoTime() clock shared with AudioEngine.getNextPresentTimeNanos()
+     */
+    public long getNextPresentTimeNanos() {
+        return nativeGetNextPresentTimeNanos();
+    }
+    
+    /**
+     * Spawns an effect in the frame predicted to reach the display closest
+     * to presentTimeNanos, so a sound scheduled for the same time lands with it
+     */
+    public void addParticleEffectAt(String effectType, float x, float y, long presentTimeNanos) {
+        nativeAddParticleEffectAt(effectType, x, y, presentTimeNanos);
+    }
+    
+    /** Indexed by the SYNC_* constants */
+    public double[] getSyncStats() {
+        return nativeGetSyncStats();
+    }
+    
     public void updateParticles(float deltaTime) {
         nativeUpdateParticles(deltaTime);
     }
     
+    /**
+     * Loads emitter definitions from an asset (e.g. "particles/emitters.json").
+     * Emitters are compiled once; resolve handles with findParticleEmitter
+     * and keep them instead of passing effect names every spawn.
+     */
+    public boolean loadParticleEmitters(AssetManager assets, String path) {
+        try (InputStream input = assets.open(path)) {
+            ByteArrayOutputStream buffer = new ByteArrayOutputStream();
+            byte[] chunk = new byte[4096];
+            int read;
+            while ((read = input.read(chunk)) != -1) {
+                buffer.write(chunk, 0, read);
+            }
+            return nativeLoadParticleEmitters(new String(buffer.toByteArray(), StandardCharsets.UTF_8));
+        } catch (IOException e) {
+            return false;
+        }
+    }
+    
+    public int findParticleEmitter(String name) {
+        return nativeFindParticleEmitter(name);
+    }
+    
+    public void spawnParticleEmitter(int emitterHandle, float x, float y) {
+        nativeSpawnParticleEmitter(emitterHandle, x, y);
+    }
+    
+    public int startParticleEmitter(int emitterHandle, float x, float y) {
+        return nativeStartParticleEmitter(emitterHandle, x, y);
+    }
+    
+    public void moveParticleEmitter(int emitterId, float x, float y) {
+        nativeMoveParticleEmitter(emitterId, x, y);
+    }
+    
+    public void stopParticleEmitter(int emitterId) {
+        nativeStopParticleEmitter(emitterId);
+    }
+    
+    /**
+     * Switches particle simulation between CPU and GPU (transform feedback).
+     * Returns false and stays on the CPU if the device cannot run the GPU path.
+     */
+    public boolean setParticleBackend(int backend) {
+        return nativeSetParticleBackend(backend);
+    }
+    
+    /**
+     * Runs the same burst through both backends and checks they agree.
+     * Intended for device QA before enabling the GPU backend by default.
+     */
+    public boolean validateParticleBackend(int sampleCount, int steps) {
+        return nativeValidateParticleBackend(sampleCount, steps);
+    }
+    
+    /**
+     * Starts streaming an ETC2/ASTC KTX texture from the APK. The asset must be
+     * stored uncompressed (noCompress in the app's build.gradle.kts) so it can be
+     * memory mapped. Returns a handle, or -1 on failure.
+     */
+    public int loadTexture(AssetManager assets, String path) {
+        try (AssetFileDescriptor descriptor = assets.openFd(path)) {
+            return nativeLoadTextureFd(descriptor.getParcelFileDescriptor().getFd(),
+                    descriptor.getStartOffset(), descriptor.getLength());
+        } catch (IOException e) {
+            return -1;
+        }
+    }
+    
+    public int loadTexture(String filePath) {
+        return nativeLoadTexture(filePath);
+    }
+    
+    public void releaseTexture(int handle) {
+        nativeReleaseTexture(handle);
+    }
+    
+    public int getTextureState(int handle) {
+        return nativeGetTextureState(handle);
+    }
+    
+    /** Indexed by the TEXTURE_STAT_* constants */
+    public long[] getTextureMemoryStats() {
+        return nativeGetTextureMemoryStats();
+    }
+    
+    /** Bytes of mip data uploaded per rendered frame while textures stream in */
+    public void setTextureUploadBudget(int bytesPerFrame) {
+        nativeSetTextureUploadBudget(bytesPerFrame);
+    }
+    
+    /**
+     * Draws a loaded texture in layout units, tinted by an ARGB color, with a
+     * BLEND_* mode on a sprite layer. Quads on the same layer are reordered
+     * to share draw calls, so overlapping ones that must keep their order
+     * belong on different layers. Nothing is drawn until the texture's first
+     * mip level has streamed in.
+     */
+    public void drawTexture(int handle, float x, float y, float width, float height,
+                            int argb, int blend, int layer) {
+        nativeDrawTexture(handle, x, y, width, height, argb, blend, layer);
+    }
+    
+    /** Last frame's batching of cards, particles and textures, indexed by SPRITE_STAT_* */
+    public double[] getSpriteBatchStats() {
+        return nativeGetSpriteBatchStats();
+    }
+    
+    /**
+     * Draws ranks, digits, "+-.:/x" and the suit symbols from the distance
+     * field glyph atlas, sharp at any size. (x, y) is the left end of the
+     * baseline in layout units and capHeight the height of a digit. Returns
+     * the width drawn.
+     */
+    public float drawText(String text, float x, float y, float capHeight, int argb, int layer) {
+        return nativeDrawText(text, x, y, capHeight, argb, layer);
+    }
+    
+    public float measureText(String text, float capHeight) {
+        return nativeMeasureText(text, capHeight);
+    }
+    
+    /** A suit pip size units tall; suit follows the Suit enum order, -1 for the star */
+    public void drawSuitPip(int suit, float x, float y, float size, int argb, int layer) {
+        nativeDrawSuitPip(suit, x, y, size, argb, layer);
+    }
+    
+    /**
+     * Program binary cache results for this launch, indexed by the
+     * SHADER_STAT_* constants. Requires setCacheDirectory() before initialize().
+     */
+    public double[] getShaderCacheStats() {
+        return nativeGetShaderCacheStats();
+    }
+    
+    /**
+     * Programs compile in the background after initialize(); draws that need
+     * a program that is not ready yet are skipped for that frame.
+     */
+    public boolean isShaderReady(String name) {
+        return nativeIsShaderReady(name);
+    }
+    
+    /** Indexed by the STARTUP_* constants */
+    public double[] getStartupTiming() {
+        return nativeGetStartupTiming();
+    }
+    
+    /**
+     * Records native CPU scopes (frame, particles, scene layer, sprite
+     * batches, swap, JNI entry points) and GPU timer queries until turned
+     * off. Scopes show up in systrace/Perfetto whenever a capture is running,
+     * recording or not.
+     */
+    public void setProfilingEnabled(boolean enabled) {
+        nativeSetProfilingEnabled(enabled);
+    }
+    
+    public void clearProfile() {
+        nativeClearProfile();
+    }
+    
+    /**
+     * Writes the recorded scopes as Chrome trace JSON, for chrome://tracing
+     * or ui.perfetto.dev, e.g. under getCacheDir()
+     */
+    public boolean exportProfile(String path) {
+        return nativeExportProfile(path);
+    }
+    
+    /** Indexed by the PROFILER_STAT_* constants */
+    public double[] getProfilerStats() {
+        return nativeGetProfilerStats();
+    }
+    
+    /**
+     * Native memory held by the particle, sprite, scene and animation
+     * containers and the per-frame arena, laid out as described at
+     * MEMORY_TAG_PARTICLES
+     */
+    public double[] getMemoryStats() {
+        return nativeGetMemoryStats();
+    }
+    
+    /**
+     * Attach the window from SurfaceHolder.Callback.surfaceCreated. Call on
+     * the render thread that called initialize(); nothing is drawn until a
+     * surface is attached.
+     */
+    public boolean onSurfaceCreated(Surface surface) {
+        return nativeSurfaceCreated(surface);
+    }
+    
+    /**
+     * Detach before returning from surfaceDestroyed. The GL context and all
+     * loaded resources are kept, so resuming only needs a new surface.
+     */
+    public void onSurfaceDestroyed() {
+        nativeSurfaceDestroyed();
+    }
+    
+    /** Indexed by the SURFACE_* constants */
+    public double[] getSurfaceStats() {
+        return nativeGetSurfaceStats();
+    }
+    
+    public void setVSync(boolean enabled) {
+        nativeSetVSync(enabled);
+    }
+    
+    /**
+     * Paces rendering to 30, 60, 90 or 120 fps, or 0 to present on every
+     * vsync. Drop to 30 in menus to save battery.
+     */
+    public void setTargetFrameRate(int framesPerSecond) {
+        nativeSetTargetFrameRate(framesPerSecond);
+    }
+    
+    /** Display.getRefreshRate(), used until vsync tracking has measured the period */
+    public void setDisplayRefreshRate(float hz) {
+        nativeSetDisplayRefreshRate(hz);
+    }
+    
+    /**
+     * Feeds Choreographer vsync timestamps to the frame pacer so presentation
+     * times line up with the display. Call from a Looper thread, usually main.
+     */
+    public void startVsyncTracking() {
+        if (vsyncTracking) return;
+        vsyncTracking = true;
+        Choreographer.getInstance().postFrameCallback(vsyncCallback);
+    }
+    
+    public void stopVsyncTracking() {
+        vsyncTracking = false;
+        Choreographer.getInstance().removeFrameCallback(vsyncCallback);
+    }
+    
+    /** Indexed by the FRAME_* constants; GPU times are -1 until measured */
+    public double[] getFrameTiming() {
+        return nativeGetFrameTiming();
+    }
+    
+    /**
+     * Renders the scene at a fraction (0.25 to 1) of the window resolution
+     * and upscales it. Layout coordinates are unaffected.
+     */
+    public void setRenderScale(float scale) {
+        nativeSetRenderScale(scale);
+    }
+    
+    /**
+     * Lowers the render scale, down to minScale, while frames run over the
+     * frame budget and raises it again once there is sustained headroom.
+     */
+    public void setDynamicResolution(boolean enabled, float minScale) {
+        nativeSetDynamicResolution(enabled, minScale);
+    }
+    
+    /**
+     * Indexed by the VIEWPORT_* constants. The 1920x1080 layout area is
+     * always fully visible; on other aspect ratios the visible area extends
+     * past it on the longer axis.
+     */
+    public double[] getViewport() {
+        return nativeGetViewport();
+    }
+    
+    /**
+     * Multisampled rendering through an offscreen target. Unsupported counts
+     * fall back from 4 to 2 to none; getMsaaStats() reports what is active.
+     */
+    public void setMsaaSamples(int samples) {
+        nativeSetMsaaSamples(samples);
+    }
+    
+    /** Indexed by the MSAA_* constants */
+    public double[] getMsaaStats() {
+        return nativeGetMsaaStats();
+    }
+    
+    /**
+     * Cost of one setting (0, 2 or 4 samples) at the current resolution,
+     * indexed by the MSAA_COST_* constants. Byte counts are estimates; times
+     * are averages measured while the setting was active, GPU -1 if never.
+     */
+    public double[] getMsaaCost(int samples) {
+        double[] stats = nativeGetMsaaStats();
+        if (stats == null) return null;
+        int setting = samples >= 4 ? 2 : samples >= 2 ? 1 : 0;
+        int start = MSAA_HEADER_SIZE + setting * MSAA_COST_SIZE;
+        return Arrays.copyOfRange(stats, start, start + MSAA_COST_SIZE);
+    }
+    
+    /**
+     * Last frame's render passes, indexed by the RENDER_PASS_* constants.
+     * Bytes saved compare against loading and storing every attachment.
+     */
+    public double[] getRenderPassStats() {
+        return nativeGetRenderPassStats();
+    }
+    
+    /** Maps a touch position in window pixels to layout coordinates (y up) */
+    public float[] screenToWorld(float screenX, float screenY) {
+        double[] viewport = nativeGetViewport();
+        if (viewport == null) return new float[] { screenX, screenY };
+        double u = screenX / viewport[VIEWPORT_OUTPUT_WIDTH];
+        double v = 1.0 - screenY / viewport[VIEWPORT_OUTPUT_HEIGHT];
+        return new float[] {
+            (float) (viewport[VIEWPORT_VISIBLE_LEFT] + u * viewport[VIEWPORT_VISIBLE_WIDTH]),
+            (float) (viewport[VIEWPORT_VISIBLE_BOTTOM] + v * viewport[VIEWPORT_VISIBLE_HEIGHT])
+        };
+    }
+    
     public void setWildWestTheme() {
         nativeSetWildWestTheme();
     }
@@ -89,4 +927,45 @@ public class GraphicsEngine {
     public void enableVintageEffect(boolean enable) {
         nativeEnableVintageEffect(enable);
     }
+    
+    /**
+     * Packed card records for renderCards: x, y, width, height, card id and
+     * flags per card, written straight into a direct buffer in native byte
+     * order so no per-card JNI call or string is needed.
+     */
+    public static final class CardBatch {
+        public static final int RECORD_BYTES = 24;
+        public static final int FLAG_FACE_UP = 1;
+        
+        final ByteBuffer buffer;
+        final int capacity;
+        int count;
+        
+        public CardBatch(int capacity) {
+            this.capacity = capacity;
+            buffer = ByteBuffer.allocateDirect(capacity * RECORD_BYTES).order(ByteOrder.nativeOrder());
+        }
+        
+        /** False when the batch is full */
+        public boolean add(float x, float y, float width, float height, int cardId, boolean faceUp) {
+            if (count == capacity) return false;
+            int offset = count * RECORD_BYTES;
+            buffer.putFloat(offset, x);
+            buffer.putFloat(offset + 4, y);
+            buffer.putFloat(offset + 8, width);
+            buffer.putFloat(offset + 12, height);
+            buffer.putInt(offset + 16, cardId);
+            buffer.putInt(offset + 20, faceUp ? FLAG_FACE_UP : 0);
+            count++;
+            return true;
+        }
+        
+        public void clear() {
+            count = 0;
+        }
+        
+        public int size() {
+            return count;
+        }
+    }
 }
\ No newline at end of file